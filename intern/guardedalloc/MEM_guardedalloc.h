@@ -266,6 +266,57 @@ void MEM_use_lockfree_allocator(void);
  */
 void MEM_use_guarded_allocator(void);
 
+/**
+ * Reuse small blocks of the lock-free allocator from a per-thread cache instead of allocating
+ * them with `malloc` every time. This reduces the time spent in the system allocator in code that
+ * allocates many small objects on many threads, at the cost of keeping some freed memory around.
+ *
+ * Reused blocks also hide memory errors from tools like Address Sanitizer and Valgrind, so this is
+ * disabled by default. It can be enabled and disabled at any time.
+ */
+void MEM_use_thread_cache(bool enabled);
+
+/** Sampling interval used by `--debug-memory-profile`. */
+#define MEM_SAMPLING_PROFILER_DEFAULT_INTERVAL 1024
+
+/**
+ * Start sampling allocations of the lock-free allocator, to find out which code uses memory
+ * without the overhead of the guarded allocator. About one in \a sample_interval allocations, and
+ * every allocation of at least 1 MB, is recorded with its name and a short backtrace until it is
+ * freed. The memory in use is estimated from these samples. Allocations from before sampling was
+ * enabled are not known.
+ *
+ * Passing zero stops sampling new allocations. Blocks that have been sampled are still tracked
+ * until they are freed.
+ */
+void MEM_sampling_profiler_enable(unsigned int sample_interval);
+bool MEM_sampling_profiler_is_enabled(void);
+
+typedef struct MEMSamplingStats {
+  /** Name of the allocations as passed to e.g. #MEM_mallocN. */
+  const char *name;
+  /** Estimated number of bytes in use. */
+  size_t bytes;
+  /** Estimated number of allocated blocks. */
+  size_t blocks;
+  /** Number of sampled blocks that the estimates are based on. */
+  size_t samples;
+} MEMSamplingStats;
+
+/**
+ * Call \a fn with the estimated memory usage of every allocation name, with the highest usage
+ * first. Names are compared by content, so allocations with the same name from different places
+ * are combined.
+ */
+void MEM_sampling_profiler_foreach_name(void (*fn)(const MEMSamplingStats *stats, void *user_data),
+                                        void *user_data);
+
+/**
+ * Print the estimated memory usage per allocation name, and the backtraces of the allocations
+ * that use most memory.
+ */
+void MEM_sampling_profiler_print_report(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
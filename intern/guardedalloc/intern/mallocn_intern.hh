@@ -78,6 +78,8 @@ size_t malloc_usable_size(void *ptr);
 /* Real pointer returned by the `malloc` or `aligned_alloc`. */
 #define MEMHEAD_REAL_PTR(memh) ((char *)memh - MEMHEAD_ALIGN_PADDING(memh->alignment))
 
+#include <atomic>
+
 #include "mallocn_inline.hh"
 
 #define ALIGNED_MALLOC_MINIMUM_ALIGNMENT sizeof(void *)
@@ -96,6 +98,38 @@ size_t memory_usage_current(void);
 size_t memory_usage_peak(void);
 void memory_usage_peak_reset(void);
 
+/** Non-zero while the sampling profiler is enabled, see #MEM_sampling_profiler_enable. */
+extern std::atomic<unsigned int> memory_sampling_interval;
+
+inline bool memory_sampling_is_enabled()
+{
+  return memory_sampling_interval.load(std::memory_order_relaxed) != 0;
+}
+/**
+ * Decide whether a new block is sampled, and record it if yes.
+ * \return True if the block is sampled and #memory_sampling_block_free has to be called for it.
+ */
+bool memory_sampling_block_alloc(const void *ptr, size_t len, const char *name);
+void memory_sampling_block_free(const void *ptr);
+
+/** Blocks up to this size, including their header, can be reused from a per-thread cache. */
+#define THREAD_CACHE_MAX_BLOCK_SIZE 256
+
+/** True while new blocks should come from the thread cache, see #MEM_use_thread_cache. */
+extern std::atomic<bool> thread_cache_enabled;
+
+inline bool thread_cache_is_enabled()
+{
+  return thread_cache_enabled.load(std::memory_order_relaxed);
+}
+/**
+ * Get a block of at least \a size bytes from the cache of the current thread. The block is
+ * allocated with `malloc` when the cache is empty.
+ */
+void *thread_cache_block_alloc(size_t size);
+/** Give a block back to the cache, \a size has to be the same as when it was allocated. */
+void thread_cache_block_free(void *ptr, size_t size);
+
 /**
  * Clear the listbase of allocated memory blocks.
  *
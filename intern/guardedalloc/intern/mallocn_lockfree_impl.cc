@@ -8,6 +8,7 @@
  * Memory allocation which keeps track on allocated memory counters
  */
 
+#include <cstddef> /* max_align_t */
 #include <stdarg.h>
 #include <stdio.h> /* printf */
 #include <stdlib.h>
@@ -67,12 +68,40 @@ enum {
   MEMHEAD_FLAG_MASK = (1 << 2) - 1
 };
 
+/**
+ * The block is tracked by the sampling profiler. Block lengths never use the highest bit, so it is
+ * used for this flag.
+ */
+#define MEMHEAD_FLAG_SAMPLED (size_t(1) << (sizeof(size_t) * 8 - 1))
+/** The block comes from the thread cache and has to be given back to it when freed. */
+#define MEMHEAD_FLAG_CACHED (size_t(1) << (sizeof(size_t) * 8 - 2))
+
 #define MEMHEAD_FROM_PTR(ptr) (((MemHead *)ptr) - 1)
 #define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
 #define MEMHEAD_ALIGNED_FROM_PTR(ptr) (((MemHeadAligned *)ptr) - 1)
 #define MEMHEAD_IS_ALIGNED(memhead) ((memhead)->len & size_t(MEMHEAD_FLAG_ALIGN))
 #define MEMHEAD_IS_FROM_CPP_NEW(memhead) ((memhead)->len & size_t(MEMHEAD_FLAG_FROM_CPP_NEW))
-#define MEMHEAD_LEN(memhead) ((memhead)->len & ~size_t(MEMHEAD_FLAG_MASK))
+#define MEMHEAD_IS_SAMPLED(memhead) ((memhead)->len & MEMHEAD_FLAG_SAMPLED)
+#define MEMHEAD_IS_CACHED(memhead) ((memhead)->len & MEMHEAD_FLAG_CACHED)
+#define MEMHEAD_LEN(memhead) \
+  ((memhead)->len & ~(size_t(MEMHEAD_FLAG_MASK) | MEMHEAD_FLAG_SAMPLED | MEMHEAD_FLAG_CACHED))
+
+/** Use the thread cache for a block of the given size, including its header. */
+static bool use_thread_cache(const size_t size)
+{
+  return UNLIKELY(thread_cache_is_enabled()) && size <= THREAD_CACHE_MAX_BLOCK_SIZE;
+}
+
+/** Pass new blocks to the sampling profiler, if it is enabled. */
+template<typename MemHeadT>
+static void memhead_sample(MemHeadT *memh, const size_t len, const char *str)
+{
+  if (UNLIKELY(memory_sampling_is_enabled()) &&
+      memory_sampling_block_alloc(PTR_FROM_MEMHEAD(memh), len, str))
+  {
+    memh->len |= MEMHEAD_FLAG_SAMPLED;
+  }
+}
 
 #ifdef __GNUC__
 __attribute__((format(printf, 1, 0)))
@@ -161,13 +190,26 @@ void MEM_lockfree_freeN(void *vmemh, AllocationType allocation_type)
   }
 
   memory_usage_block_free(len);
+  if (UNLIKELY(MEMHEAD_IS_SAMPLED(memh))) {
+    memory_sampling_block_free(vmemh);
+  }
 
   if (UNLIKELY(malloc_debug_memset && len)) {
     memset(memh + 1, 255, len);
   }
   if (UNLIKELY(MEMHEAD_IS_ALIGNED(memh))) {
     MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
-    aligned_free(MEMHEAD_REAL_PTR(memh_aligned));
+    if (UNLIKELY(MEMHEAD_IS_CACHED(memh))) {
+      thread_cache_block_free(
+          MEMHEAD_REAL_PTR(memh_aligned),
+          len + sizeof(MemHeadAligned) + MEMHEAD_ALIGN_PADDING(memh_aligned->alignment));
+    }
+    else {
+      aligned_free(MEMHEAD_REAL_PTR(memh_aligned));
+    }
+  }
+  else if (UNLIKELY(MEMHEAD_IS_CACHED(memh))) {
+    thread_cache_block_free(memh, len + sizeof(MemHead));
   }
   else {
     free(memh);
@@ -215,12 +257,14 @@ void *MEM_lockfree_reallocN_id(void *vmemh, size_t len, const char *str)
     }
 
     if (LIKELY(!MEMHEAD_IS_ALIGNED(memh))) {
-      newp = MEM_lockfree_mallocN(len, "realloc");
+      newp = MEM_lockfree_mallocN(len, str ? str : "realloc");
     }
     else {
       const MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
-      newp = MEM_lockfree_mallocN_aligned(
-          len, size_t(memh_aligned->alignment), "realloc", AllocationType::ALLOC_FREE);
+      newp = MEM_lockfree_mallocN_aligned(len,
+                                          size_t(memh_aligned->alignment),
+                                          str ? str : "realloc",
+                                          AllocationType::ALLOC_FREE);
     }
 
     if (newp) {
@@ -258,12 +302,14 @@ void *MEM_lockfree_recallocN_id(void *vmemh, size_t len, const char *str)
     }
 
     if (LIKELY(!MEMHEAD_IS_ALIGNED(memh))) {
-      newp = MEM_lockfree_mallocN(len, "recalloc");
+      newp = MEM_lockfree_mallocN(len, str ? str : "recalloc");
     }
     else {
       const MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
-      newp = MEM_lockfree_mallocN_aligned(
-          len, size_t(memh_aligned->alignment), "recalloc", AllocationType::ALLOC_FREE);
+      newp = MEM_lockfree_mallocN_aligned(len,
+                                          size_t(memh_aligned->alignment),
+                                          str ? str : "recalloc",
+                                          AllocationType::ALLOC_FREE);
     }
 
     if (newp) {
@@ -297,11 +343,21 @@ void *MEM_lockfree_callocN(size_t len, const char *str)
 
   len = SIZET_ALIGN_4(len);
 
-  memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+  const bool is_cached = use_thread_cache(len + sizeof(MemHead));
+  if (is_cached) {
+    memh = (MemHead *)thread_cache_block_alloc(len + sizeof(MemHead));
+    if (LIKELY(memh)) {
+      memset(memh + 1, 0, len);
+    }
+  }
+  else {
+    memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+  }
 
   if (LIKELY(memh)) {
-    memh->len = len;
+    memh->len = len | (is_cached ? MEMHEAD_FLAG_CACHED : 0);
     memory_usage_block_alloc(len);
+    memhead_sample(memh, len, str);
 
     return PTR_FROM_MEMHEAD(memh);
   }
@@ -339,7 +395,9 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
 #endif
   len = SIZET_ALIGN_4(len);
 
-  memh = (MemHead *)malloc(len + sizeof(MemHead));
+  const bool is_cached = use_thread_cache(len + sizeof(MemHead));
+  memh = (MemHead *)(is_cached ? thread_cache_block_alloc(len + sizeof(MemHead)) :
+                                 malloc(len + sizeof(MemHead)));
 
   if (LIKELY(memh)) {
 
@@ -357,8 +415,9 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
 #endif /* WITH_MEM_VALGRIND */
     }
 
-    memh->len = len;
+    memh->len = len | (is_cached ? MEMHEAD_FLAG_CACHED : 0);
     memory_usage_block_alloc(len);
+    memhead_sample(memh, len, str);
 
     return PTR_FROM_MEMHEAD(memh);
   }
@@ -417,8 +476,12 @@ void *MEM_lockfree_mallocN_aligned(size_t len,
 #endif
   len = SIZET_ALIGN_4(len);
 
-  MemHeadAligned *memh = (MemHeadAligned *)aligned_malloc(
-      len + extra_padding + sizeof(MemHeadAligned), alignment);
+  /* Blocks from the thread cache are allocated with `malloc`, which is aligned enough for small
+   * alignments. */
+  const size_t size = len + extra_padding + sizeof(MemHeadAligned);
+  const bool is_cached = alignment <= alignof(std::max_align_t) && use_thread_cache(size);
+  MemHeadAligned *memh = (MemHeadAligned *)(is_cached ? thread_cache_block_alloc(size) :
+                                                        aligned_malloc(size, alignment));
 
   if (LIKELY(memh)) {
     /* We keep padding in the beginning of MemHead,
@@ -443,9 +506,11 @@ void *MEM_lockfree_mallocN_aligned(size_t len,
 
     memh->len = len | size_t(MEMHEAD_FLAG_ALIGN) |
                 size_t(allocation_type == AllocationType::NEW_DELETE ? MEMHEAD_FLAG_FROM_CPP_NEW :
-                                                                       0);
+                                                                       0) |
+                (is_cached ? MEMHEAD_FLAG_CACHED : 0);
     memh->alignment = short(alignment);
     memory_usage_block_alloc(len);
+    memhead_sample(memh, len, str);
 
     return PTR_FROM_MEMHEAD(memh);
   }
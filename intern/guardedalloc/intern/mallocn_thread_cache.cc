@@ -0,0 +1,223 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup intern_mem
+ *
+ * Per-thread cache of small memory blocks for the lock-free allocator.
+ *
+ * Code that creates and frees many small objects is often limited by the system allocator,
+ * especially when many threads allocate at the same time. With the cache enabled, small blocks
+ * are sorted into size classes. Freed blocks are kept in a list per size class of the current
+ * thread and are reused by the next allocation of that class, without calling `malloc`.
+ *
+ * When a thread frees more blocks than it allocates, a batch of blocks is moved to a global pool,
+ * where other threads can take it from. This is the only time the threads have to synchronize.
+ * The global pool is bounded, blocks that don't fit into it are returned to the system.
+ *
+ * All cached blocks are allocated with `malloc`, so they can always be freed with `free`.
+ */
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+
+#include "MEM_guardedalloc.h"
+#include "mallocn_intern.hh"
+
+#include "../../source/blender/blenlib/BLI_strict_flags.h"
+
+namespace {
+
+/** Block sizes are rounded up to a multiple of this. */
+constexpr size_t size_class_step = 16;
+constexpr int size_classes_num = int(THREAD_CACHE_MAX_BLOCK_SIZE / size_class_step);
+/** Number of blocks that are moved between a thread and the global pool at once. */
+constexpr int batch_size = 32;
+/** A thread keeps at most this many free blocks per size class. */
+constexpr int thread_blocks_max = 2 * batch_size - 1;
+/** The global pool keeps at most this many batches per size class. */
+constexpr int pool_batches_max = 64;
+
+/** Stored in the memory of blocks that are not in use. */
+struct FreeBlock {
+  /** Next block in the same list or batch. */
+  FreeBlock *next;
+  /** Next batch in the global pool. Only set for the first block of a batch. */
+  FreeBlock *next_batch;
+};
+
+static_assert(sizeof(FreeBlock) <= size_class_step, "Free block does not fit into smallest class");
+
+/**
+ * Free blocks that can be used by any thread. It's owned by a `std::shared_ptr` which is owned by
+ * the static variable in #get_pool_ptr and all #ThreadCache, so that it outlives all threads.
+ */
+struct Pool {
+  std::mutex mutex;
+  FreeBlock *batches[size_classes_num] = {};
+  int batches_num[size_classes_num] = {};
+
+  ~Pool();
+};
+
+struct ThreadCache {
+  std::shared_ptr<Pool> pool;
+  FreeBlock *blocks[size_classes_num] = {};
+  int blocks_num[size_classes_num] = {};
+
+  ThreadCache();
+  ~ThreadCache();
+};
+
+}  // namespace
+
+std::atomic<bool> thread_cache_enabled = false;
+
+/**
+ * True when the cache of the current thread has been destructed. This happens when the thread
+ * exits. Blocks that are freed afterwards are returned to the system directly.
+ */
+static thread_local bool thread_cache_destructed = false;
+
+static std::shared_ptr<Pool> &get_pool_ptr()
+{
+  static std::shared_ptr<Pool> pool = std::make_shared<Pool>();
+  return pool;
+}
+
+static ThreadCache &get_thread_cache()
+{
+  static thread_local ThreadCache cache;
+  return cache;
+}
+
+static int size_class_index(const size_t size)
+{
+  assert(size > 0 && size <= THREAD_CACHE_MAX_BLOCK_SIZE);
+  return int((size - 1) / size_class_step);
+}
+
+static size_t size_class_size(const int class_index)
+{
+  return size_t(class_index + 1) * size_class_step;
+}
+
+static void free_blocks(FreeBlock *block)
+{
+  while (block) {
+    FreeBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+}
+
+Pool::~Pool()
+{
+  for (int class_index = 0; class_index < size_classes_num; class_index++) {
+    FreeBlock *batch = this->batches[class_index];
+    while (batch) {
+      FreeBlock *next_batch = batch->next_batch;
+      free_blocks(batch);
+      batch = next_batch;
+    }
+  }
+}
+
+/** Add a list of free blocks to the pool, or free it if the pool is full already. */
+static void pool_add_batch(Pool &pool, const int class_index, FreeBlock *batch)
+{
+  {
+    std::lock_guard lock{pool.mutex};
+    if (pool.batches_num[class_index] < pool_batches_max) {
+      batch->next_batch = pool.batches[class_index];
+      pool.batches[class_index] = batch;
+      pool.batches_num[class_index]++;
+      return;
+    }
+  }
+  free_blocks(batch);
+}
+
+static FreeBlock *pool_pop_batch(Pool &pool, const int class_index)
+{
+  std::lock_guard lock{pool.mutex};
+  FreeBlock *batch = pool.batches[class_index];
+  if (batch) {
+    pool.batches[class_index] = batch->next_batch;
+    pool.batches_num[class_index]--;
+  }
+  return batch;
+}
+
+ThreadCache::ThreadCache() : pool(get_pool_ptr()) {}
+
+ThreadCache::~ThreadCache()
+{
+  /* Give the remaining blocks to other threads. */
+  for (int class_index = 0; class_index < size_classes_num; class_index++) {
+    if (this->blocks[class_index]) {
+      pool_add_batch(*this->pool, class_index, this->blocks[class_index]);
+    }
+  }
+  thread_cache_destructed = true;
+}
+
+void *thread_cache_block_alloc(const size_t size)
+{
+  const int class_index = size_class_index(size);
+  if (UNLIKELY(thread_cache_destructed)) {
+    return malloc(size_class_size(class_index));
+  }
+  ThreadCache &cache = get_thread_cache();
+  FreeBlock *block = cache.blocks[class_index];
+  if (block == nullptr) {
+    block = pool_pop_batch(*cache.pool, class_index);
+    if (block == nullptr) {
+      return malloc(size_class_size(class_index));
+    }
+    int blocks_num = 0;
+    for (const FreeBlock *iter = block; iter; iter = iter->next) {
+      blocks_num++;
+    }
+    cache.blocks_num[class_index] = blocks_num;
+  }
+  cache.blocks[class_index] = block->next;
+  cache.blocks_num[class_index]--;
+  return block;
+}
+
+void thread_cache_block_free(void *ptr, const size_t size)
+{
+  if (UNLIKELY(thread_cache_destructed)) {
+    free(ptr);
+    return;
+  }
+  const int class_index = size_class_index(size);
+  ThreadCache &cache = get_thread_cache();
+  FreeBlock *block = static_cast<FreeBlock *>(ptr);
+  block->next = cache.blocks[class_index];
+  cache.blocks[class_index] = block;
+  cache.blocks_num[class_index]++;
+
+  if (cache.blocks_num[class_index] > thread_blocks_max) {
+    /* Keep the most recently freed blocks which are likely still in the CPU cache, and move the
+     * older ones to the pool. */
+    FreeBlock *last_kept = block;
+    for (int i = 1; i < batch_size; i++) {
+      last_kept = last_kept->next;
+    }
+    FreeBlock *batch = last_kept->next;
+    last_kept->next = nullptr;
+    cache.blocks_num[class_index] = batch_size;
+    pool_add_batch(*cache.pool, class_index, batch);
+  }
+}
+
+void MEM_use_thread_cache(const bool enabled)
+{
+  thread_cache_enabled.store(enabled, std::memory_order_relaxed);
+}
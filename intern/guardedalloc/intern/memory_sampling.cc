@@ -0,0 +1,304 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup intern_mem
+ *
+ * Sampling heap profiler for the lock-free allocator.
+ *
+ * Every thread counts down a random number of allocations (one in #memory_sampling_interval on
+ * average) before it samples the next one. A sampled block stands for that many allocations of
+ * its size, which gives an unbiased estimate of the memory in use per allocation name. Large
+ * blocks are always sampled, because few of them can use most of the memory.
+ *
+ * Sampled blocks are stored in a hash map that is protected by a mutex. This is fine, because
+ * only a small fraction of all allocations and frees have to access it.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef HAVE_EXECINFO_H
+#  include <execinfo.h>
+#  include <stdlib.h>
+#elif defined(_WIN32)
+#  include <windows.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+#include "mallocn_intern.hh"
+
+#include "../../source/blender/blenlib/BLI_strict_flags.h"
+
+namespace {
+
+/** Number of stack frames stored for every sample. */
+constexpr int sample_frames_max = 8;
+/** Blocks of at least this size are always sampled. */
+constexpr size_t always_sample_size = 1024 * 1024;
+
+struct Sample {
+  const char *name;
+  size_t len;
+  /** Number of blocks with the same size that this sample stands for. */
+  size_t weight;
+  int frames_num;
+  void *frames[sample_frames_max];
+};
+
+struct SamplingProfiler {
+  std::mutex mutex;
+  std::unordered_map<const void *, Sample> samples;
+};
+
+}  // namespace
+
+std::atomic<unsigned int> memory_sampling_interval = 0;
+
+/** Allocations until the current thread samples the next one. */
+static thread_local unsigned int allocations_until_sample = 0;
+static thread_local uint32_t sample_random_state = 0;
+/** Allocations done by the profiler itself must not be sampled. */
+static thread_local bool is_sampling = false;
+
+namespace {
+
+/** Disables sampling on the current thread while it is accessing the profiler. */
+class SamplingDisabledScope {
+ private:
+  bool was_sampling_;
+
+ public:
+  SamplingDisabledScope() : was_sampling_(is_sampling)
+  {
+    is_sampling = true;
+  }
+  ~SamplingDisabledScope()
+  {
+    is_sampling = was_sampling_;
+  }
+};
+
+}  // namespace
+
+static SamplingProfiler &get_profiler()
+{
+  static SamplingProfiler profiler;
+  return profiler;
+}
+
+/** Random number of allocations in [1, 2 * interval - 1], so that one in `interval` is sampled on
+ * average without being in sync with repeating allocation patterns. */
+static unsigned int random_allocations_until_sample(const unsigned int interval)
+{
+  if (sample_random_state == 0) {
+    sample_random_state = uint32_t(uintptr_t(&sample_random_state)) | 1u;
+  }
+  /* Xorshift. */
+  sample_random_state ^= sample_random_state << 13;
+  sample_random_state ^= sample_random_state >> 17;
+  sample_random_state ^= sample_random_state << 5;
+  return 1 + sample_random_state % (2 * interval - 1);
+}
+
+static int capture_backtrace(void **frames)
+{
+#ifdef HAVE_EXECINFO_H
+  return backtrace(frames, sample_frames_max);
+#elif defined(_WIN32)
+  return int(CaptureStackBackTrace(0, sample_frames_max, frames, nullptr));
+#else
+  (void)frames;
+  return 0;
+#endif
+}
+
+bool memory_sampling_block_alloc(const void *ptr, const size_t len, const char *name)
+{
+  const unsigned int interval = memory_sampling_interval.load(std::memory_order_relaxed);
+  if (interval == 0 || is_sampling) {
+    return false;
+  }
+  size_t weight = 1;
+  if (len < always_sample_size) {
+    if (allocations_until_sample > 1) {
+      allocations_until_sample--;
+      return false;
+    }
+    allocations_until_sample = random_allocations_until_sample(interval);
+    weight = interval;
+  }
+
+  const SamplingDisabledScope disabled_scope;
+  Sample sample;
+  sample.name = name;
+  sample.len = len;
+  sample.weight = weight;
+  sample.frames_num = capture_backtrace(sample.frames);
+
+  SamplingProfiler &profiler = get_profiler();
+  {
+    std::lock_guard lock{profiler.mutex};
+    profiler.samples[ptr] = sample;
+  }
+  return true;
+}
+
+void memory_sampling_block_free(const void *ptr)
+{
+  const SamplingDisabledScope disabled_scope;
+  SamplingProfiler &profiler = get_profiler();
+  std::lock_guard lock{profiler.mutex};
+  profiler.samples.erase(ptr);
+}
+
+void MEM_sampling_profiler_enable(const unsigned int sample_interval)
+{
+  memory_sampling_interval.store(sample_interval, std::memory_order_relaxed);
+}
+
+bool MEM_sampling_profiler_is_enabled()
+{
+  return memory_sampling_is_enabled();
+}
+
+/**
+ * Copy the samples, so that the report can be created without blocking other threads. Sampling
+ * has to be disabled by the caller, to avoid locking the mutex recursively.
+ */
+static std::vector<Sample> get_samples()
+{
+  std::vector<Sample> samples;
+  SamplingProfiler &profiler = get_profiler();
+  std::lock_guard lock{profiler.mutex};
+  samples.reserve(profiler.samples.size());
+  for (const auto &item : profiler.samples) {
+    samples.push_back(item.second);
+  }
+  return samples;
+}
+
+namespace {
+
+struct NameStats {
+  std::string name;
+  MEMSamplingStats stats;
+};
+
+}  // namespace
+
+static std::vector<NameStats> stats_by_name(const std::vector<Sample> &samples)
+{
+  std::map<std::string, MEMSamplingStats> stats_map;
+  for (const Sample &sample : samples) {
+    MEMSamplingStats &stats = stats_map[sample.name ? sample.name : "unknown"];
+    stats.bytes += sample.len * sample.weight;
+    stats.blocks += sample.weight;
+    stats.samples++;
+  }
+  std::vector<NameStats> result;
+  for (const auto &item : stats_map) {
+    result.push_back({item.first, item.second});
+  }
+  std::sort(result.begin(), result.end(), [](const NameStats &a, const NameStats &b) {
+    return a.stats.bytes > b.stats.bytes;
+  });
+  for (NameStats &item : result) {
+    item.stats.name = item.name.c_str();
+  }
+  return result;
+}
+
+void MEM_sampling_profiler_foreach_name(void (*fn)(const MEMSamplingStats *stats,
+                                                   void *user_data),
+                                        void *user_data)
+{
+  const SamplingDisabledScope disabled_scope;
+  const std::vector<NameStats> stats = stats_by_name(get_samples());
+  for (const NameStats &item : stats) {
+    fn(&item.stats, user_data);
+  }
+}
+
+static void print_backtraces(const std::vector<Sample> &samples, const size_t max_num)
+{
+  struct BacktraceStats {
+    const Sample *sample;
+    size_t bytes;
+    size_t blocks;
+  };
+  std::map<std::vector<void *>, BacktraceStats> stats_map;
+  for (const Sample &sample : samples) {
+    if (sample.frames_num == 0) {
+      continue;
+    }
+    std::vector<void *> frames(sample.frames, sample.frames + sample.frames_num);
+    BacktraceStats &stats =
+        stats_map.try_emplace(std::move(frames), BacktraceStats{&sample, 0, 0}).first->second;
+    stats.bytes += sample.len * sample.weight;
+    stats.blocks += sample.weight;
+  }
+  std::vector<BacktraceStats> sorted_stats;
+  for (const auto &item : stats_map) {
+    sorted_stats.push_back(item.second);
+  }
+  std::sort(sorted_stats.begin(),
+            sorted_stats.end(),
+            [](const BacktraceStats &a, const BacktraceStats &b) { return a.bytes > b.bytes; });
+
+  for (size_t i = 0; i < std::min(max_num, sorted_stats.size()); i++) {
+    const BacktraceStats &stats = sorted_stats[i];
+    printf("\n%10.3f MB %10zu blocks  %s\n",
+           double(stats.bytes) / (1024.0 * 1024.0),
+           stats.blocks,
+           stats.sample->name ? stats.sample->name : "unknown");
+#ifdef HAVE_EXECINFO_H
+    char **symbols = backtrace_symbols(stats.sample->frames, stats.sample->frames_num);
+    for (int frame = 0; frame < stats.sample->frames_num; frame++) {
+      printf("    %s\n", symbols ? symbols[frame] : "?");
+    }
+    free(symbols);
+#else
+    for (int frame = 0; frame < stats.sample->frames_num; frame++) {
+      printf("    %p\n", stats.sample->frames[frame]);
+    }
+#endif
+  }
+}
+
+void MEM_sampling_profiler_print_report()
+{
+  const SamplingDisabledScope disabled_scope;
+  const std::vector<Sample> samples = get_samples();
+  const std::vector<NameStats> stats = stats_by_name(samples);
+
+  size_t total_bytes = 0;
+  for (const NameStats &item : stats) {
+    total_bytes += item.stats.bytes;
+  }
+  printf("\nSampled memory usage: %.3f MB estimated from %zu samples (in use: %.3f MB)\n",
+         double(total_bytes) / (1024.0 * 1024.0),
+         samples.size(),
+         double(memory_usage_current()) / (1024.0 * 1024.0));
+  printf("%10s %10s %10s  %s\n", "MB", "blocks", "samples", "name");
+  for (size_t i = 0; i < std::min<size_t>(stats.size(), 50); i++) {
+    const MEMSamplingStats &item = stats[i].stats;
+    printf("%10.3f %10zu %10zu  %s\n",
+           double(item.bytes) / (1024.0 * 1024.0),
+           item.blocks,
+           item.samples,
+           item.name);
+  }
+
+  printf("\nBacktraces with the highest memory usage:\n");
+  print_backtraces(samples, 10);
+}
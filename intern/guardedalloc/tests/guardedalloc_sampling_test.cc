@@ -0,0 +1,107 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "guardedalloc_test_base.h"
+
+namespace {
+
+struct NameStats {
+  std::string name;
+  MEMSamplingStats stats;
+};
+
+std::vector<NameStats> get_stats()
+{
+  std::vector<NameStats> result;
+  MEM_sampling_profiler_foreach_name(
+      [](const MEMSamplingStats *stats, void *user_data) {
+        static_cast<std::vector<NameStats> *>(user_data)->push_back({stats->name, *stats});
+      },
+      &result);
+  return result;
+}
+
+const NameStats *find_stats(const std::vector<NameStats> &stats, const char *name)
+{
+  for (const NameStats &item : stats) {
+    if (item.name == name) {
+      return &item;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+TEST_F(LockFreeAllocatorTest, SamplingLargeBlocks)
+{
+  MEM_sampling_profiler_enable(MEM_SAMPLING_PROFILER_DEFAULT_INTERVAL);
+  EXPECT_TRUE(MEM_sampling_profiler_is_enabled());
+
+  /* Large blocks are always sampled. */
+  const size_t size = 4 * 1024 * 1024;
+  void *a = MEM_mallocN(size, "SamplingLargeBlocks");
+  void *b = MEM_mallocN_aligned(size, 64, "SamplingLargeBlocks");
+  std::vector<NameStats> stats = get_stats();
+  const NameStats *item = find_stats(stats, "SamplingLargeBlocks");
+  ASSERT_NE(item, nullptr);
+  EXPECT_EQ(item->stats.bytes, 2 * size);
+  EXPECT_EQ(item->stats.blocks, 2);
+  EXPECT_EQ(item->stats.samples, 2);
+  EXPECT_EQ(MEM_allocN_len(a), size);
+  EXPECT_EQ(MEM_allocN_len(b), size);
+
+  /* The name of the caller is kept when the block is reallocated. */
+  a = MEM_reallocN_id(a, 2 * size, "SamplingLargeBlocksRealloc");
+  stats = get_stats();
+  item = find_stats(stats, "SamplingLargeBlocksRealloc");
+  ASSERT_NE(item, nullptr);
+  EXPECT_EQ(item->stats.bytes, 2 * size);
+
+  MEM_freeN(a);
+  MEM_freeN(b);
+  stats = get_stats();
+  EXPECT_EQ(find_stats(stats, "SamplingLargeBlocks"), nullptr);
+  EXPECT_EQ(find_stats(stats, "SamplingLargeBlocksRealloc"), nullptr);
+
+  MEM_sampling_profiler_enable(0);
+  EXPECT_FALSE(MEM_sampling_profiler_is_enabled());
+}
+
+TEST_F(LockFreeAllocatorTest, SamplingSmallBlocks)
+{
+  const unsigned int interval = 16;
+  MEM_sampling_profiler_enable(interval);
+
+  const int blocks_num = 10000;
+  std::vector<void *> blocks;
+  for (int i = 0; i < blocks_num; i++) {
+    blocks.push_back(MEM_mallocN(32, "SamplingSmallBlocks"));
+  }
+  MEM_sampling_profiler_enable(0);
+
+  /* Sampled blocks are still tracked after sampling has been disabled. */
+  std::vector<NameStats> stats = get_stats();
+  const NameStats *item = find_stats(stats, "SamplingSmallBlocks");
+  ASSERT_NE(item, nullptr);
+  EXPECT_EQ(item->stats.blocks, item->stats.samples * interval);
+  EXPECT_EQ(item->stats.bytes, item->stats.blocks * 32);
+  /* The estimate is random, but should be well within these bounds. */
+  EXPECT_GT(item->stats.blocks, blocks_num / 2);
+  EXPECT_LT(item->stats.blocks, blocks_num * 2);
+
+  for (void *block : blocks) {
+    MEM_freeN(block);
+  }
+  stats = get_stats();
+  EXPECT_EQ(find_stats(stats, "SamplingSmallBlocks"), nullptr);
+}
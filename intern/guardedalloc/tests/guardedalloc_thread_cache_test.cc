@@ -0,0 +1,134 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+#include "guardedalloc_test_base.h"
+
+namespace {
+
+class ThreadCacheTest : public LockFreeAllocatorTest {
+ protected:
+  void SetUp() override
+  {
+    LockFreeAllocatorTest::SetUp();
+    MEM_use_thread_cache(true);
+  }
+  void TearDown() override
+  {
+    MEM_use_thread_cache(false);
+  }
+};
+
+}  // namespace
+
+TEST_F(ThreadCacheTest, ReuseBlocks)
+{
+  void *a = MEM_mallocN(40, __func__);
+  EXPECT_EQ(MEM_allocN_len(a), 40);
+  memset(a, 1, 40);
+  MEM_freeN(a);
+  /* The block that was freed last is reused. */
+  void *b = MEM_mallocN(36, __func__);
+  EXPECT_EQ(b, a);
+  EXPECT_EQ(MEM_allocN_len(b), 36);
+  MEM_freeN(b);
+
+  /* Reused blocks are cleared when they are allocated with calloc. */
+  char *c = static_cast<char *>(MEM_callocN(40, __func__));
+  EXPECT_EQ(static_cast<void *>(c), a);
+  for (int i = 0; i < 40; i++) {
+    EXPECT_EQ(c[i], 0);
+  }
+  MEM_freeN(c);
+}
+
+TEST_F(ThreadCacheTest, Aligned)
+{
+  for (const size_t alignment : {size_t(1), size_t(8), size_t(16), size_t(64)}) {
+    std::vector<void *> blocks;
+    for (int i = 0; i < 100; i++) {
+      void *ptr = MEM_mallocN_aligned(size_t(i), alignment, __func__);
+      EXPECT_EQ(uintptr_t(ptr) % alignment, 0);
+      EXPECT_EQ(MEM_allocN_len(ptr), size_t((i + 3) & ~3));
+      memset(ptr, 1, size_t(i));
+      blocks.push_back(ptr);
+    }
+    for (void *ptr : blocks) {
+      MEM_freeN(ptr);
+    }
+  }
+}
+
+TEST_F(ThreadCacheTest, LargeBlocks)
+{
+  /* Blocks that are too large for the cache are allocated as usual. */
+  void *a = MEM_mallocN(1024, __func__);
+  memset(a, 1, 1024);
+  a = MEM_reallocN(a, 16);
+  a = MEM_reallocN(a, 4096);
+  EXPECT_EQ(MEM_allocN_len(a), 4096);
+  MEM_freeN(a);
+}
+
+TEST_F(ThreadCacheTest, FreeAfterDisable)
+{
+  std::vector<void *> blocks;
+  for (int i = 0; i < 1000; i++) {
+    blocks.push_back(MEM_mallocN(size_t(i % 200), __func__));
+  }
+  MEM_use_thread_cache(false);
+  /* Blocks from the cache are given back to it even when it's not used for new blocks. */
+  for (void *ptr : blocks) {
+    MEM_freeN(ptr);
+  }
+}
+
+TEST_F(ThreadCacheTest, FreeOnOtherThreads)
+{
+  const int threads_num = 8;
+  const int blocks_num = 10000;
+  std::vector<std::vector<void *>> blocks_by_thread(threads_num);
+  std::vector<std::thread> threads;
+
+  /* Every thread allocates blocks, which are freed by the next thread. */
+  for (int thread = 0; thread < threads_num; thread++) {
+    threads.emplace_back([&, thread]() {
+      std::vector<void *> &blocks = blocks_by_thread[size_t(thread)];
+      for (int i = 0; i < blocks_num; i++) {
+        int *ptr = static_cast<int *>(MEM_mallocN(sizeof(int) * size_t(1 + i % 50), __func__));
+        *ptr = thread;
+        blocks.push_back(ptr);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+
+  for (int thread = 0; thread < threads_num; thread++) {
+    threads.emplace_back([&, thread]() {
+      const int other_thread = (thread + 1) % threads_num;
+      for (void *ptr : blocks_by_thread[size_t(other_thread)]) {
+        EXPECT_EQ(*static_cast<int *>(ptr), other_thread);
+        MEM_freeN(ptr);
+      }
+      /* Reuse some of the freed blocks. */
+      for (int i = 0; i < blocks_num; i++) {
+        MEM_freeN(MEM_mallocN(sizeof(int) * size_t(1 + i % 50), __func__));
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
@@ -790,6 +790,12 @@ class USERPREF_PT_system_memory(SystemPanel, CenterAlignMixIn, Panel):
         col.prop(edit, "undo_steps", text="Undo Steps")
         col.prop(edit, "undo_memory_limit", text="Undo Memory Limit")
         col.prop(edit, "use_global_undo")
+        sub = col.column()
+        sub.active = edit.use_global_undo
+        sub.prop(edit, "undo_memory_mode", text="Memory Mode")
+        subsub = sub.column()
+        subsub.active = edit.undo_memory_mode == 'COMPRESSED'
+        subsub.prop(edit, "undo_compressed_memory_limit", text="Compressed Limit")
 
         layout.separator()
 
@@ -2884,6 +2890,7 @@ class USERPREF_PT_experimental_debugging(ExperimentalPanel, Panel):
                 ({"property": "override_auto_resync"}, ("blender/blender/issues/83811", "#83811")),
                 ({"property": "use_all_linked_data_direct"}, None),
                 ({"property": "use_recompute_usercount_on_save_debug"}, None),
+                ({"property": "use_delta_save"}, None),
                 ({"property": "use_cycles_debug"}, None),
                 ({"property": "show_asset_debug_info"}, None),
                 ({"property": "use_asset_indexing"}, None),
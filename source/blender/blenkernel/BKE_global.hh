@@ -271,6 +271,8 @@ enum {
 
   G_DEBUG_GHOST = (1 << 23),  /* Debug GHOST module. */
   G_DEBUG_WINTAB = (1 << 24), /* Debug Wintab. */
+
+  G_DEBUG_IO_PROFILE = (1 << 25), /* Timing of blend file read & write phases. */
 };
 
 #define G_DEBUG_ALL \
@@ -3,10 +3,13 @@
  * SPDX-License-Identifier: GPL-2.0-or-later */
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 
 #include "BLI_array.hh"
+#include "BLI_map.hh"
 
 /** \file
  * \ingroup bke
@@ -21,6 +24,24 @@ struct Main;
 struct Mesh;
 struct Object;
 
+namespace blender::bke {
+
+struct KeyBlockSparseDeltas;
+
+struct KeyRuntime {
+  /**
+   * The elements that relative key-blocks move, used to skip unchanged elements when blending.
+   * Only used for evaluated copies of the key: the depsgraph makes a new copy whenever the
+   * original key data changes, but not when only the animated key-block values change.
+   */
+  std::mutex sparse_deltas_mutex;
+  Map<const KeyBlock *, std::shared_ptr<const KeyBlockSparseDeltas>> sparse_deltas;
+
+  MEM_CXX_CLASS_ALLOC_FUNCS("KeyRuntime");
+};
+
+}  // namespace blender::bke
+
 /**
  * Free (or release) any data used by this shape-key (does not free the key itself).
  */
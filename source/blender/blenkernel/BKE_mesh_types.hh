@@ -15,6 +15,7 @@
 #include "BLI_bit_vector.hh"
 #include "BLI_bounds_types.hh"
 #include "BLI_implicit_sharing.hh"
+#include "BLI_implicit_sharing_ptr.hh"
 #include "BLI_kdopbvh.hh"
 #include "BLI_math_vector_types.hh"
 #include "BLI_shared_cache.hh"
@@ -108,6 +109,71 @@ struct TrianglesCache {
   void tag_dirty();
 };
 
+/**
+ * BVH trees from before the positions of a mesh changed. When the trees are needed again, their
+ * bounds can be refit to the new positions, which is much cheaper than building new trees. The
+ * topology of the mesh must not have changed for that, so this is shared between meshes with the
+ * same topology and replaced when the topology changes.
+ *
+ * Only trees that were built because something queried them are stored, but a stored tree keeps
+ * using as much memory as while it was in use. To release the memory of trees that are not
+ * queried anymore, e.g. after the modifier that used them was removed, a tree is freed when it
+ * wasn't used for a while, see #Entry::age. Until then, up to one tree of every kind per topology
+ * is kept in addition to the trees in use.
+ */
+struct BVHRefitCache {
+  struct Entry {
+    std::unique_ptr<BVHTree, BVHTreeDeleter> tree;
+    /** Surface area cost of the tree when it was built, see #BLI_bvhtree_surface_area_cost. */
+    float build_cost = 0.0f;
+    /**
+     * Number of times a mesh sharing this cache was freed or had its positions changed without
+     * having used this kind of tree since the tree was stored.
+     */
+    int age = 0;
+  };
+  /**
+   * Free stored trees that are older. Evaluated copies that aren't queried, like intermediate
+   * copies in the modifier stack, also age the trees, so this can't be too small.
+   */
+  static constexpr int max_age = 8;
+  std::mutex mutex;
+  Entry verts;
+  Entry edges;
+  Entry corner_tris;
+};
+
+/**
+ * Vertex group weights in a fixed-width layout for fast armature deformation, see
+ * `armature_deform.cc`. Every vertex has the same number of slots, and the slots are stored slot
+ * after slot (`slot * verts_num + vert`), so that consecutive vertices are next to each other.
+ */
+struct SkinningWeights {
+  static constexpr int slots_num = 4;
+  /** Vertex group index of every slot. Unused slots have group zero and a zero weight. */
+  Array<int> groups;
+  Array<float> weights;
+  /** One more than the largest vertex group index used in #groups. */
+  int groups_num = 0;
+  /**
+   * Vertices with more non-zero weights than slots. All their weights are zero in the tables,
+   * they have to be deformed separately.
+   */
+  Array<int> overflow_verts;
+};
+
+/**
+ * Cache of #SkinningWeights that is shared between copies of a mesh. Instead of relying on update
+ * tags, the vertex group layer is checked for changes with its implicit sharing version.
+ */
+struct SkinningWeightsCache {
+  std::mutex mutex;
+  /** The vertex group layer data that the weights were built from. */
+  WeakImplicitSharingPtr dverts_sharing_info;
+  int64_t dverts_version = 0;
+  std::shared_ptr<const SkinningWeights> weights;
+};
+
 struct MeshRuntime {
   /**
    * "Evaluated" mesh owned by this mesh. Used for objects which don't have effective modifiers, so
@@ -168,6 +234,11 @@ struct MeshRuntime {
   SharedCache<std::unique_ptr<BVHTree, BVHTreeDeleter>> bvh_cache_loose_verts_no_hidden;
   SharedCache<std::unique_ptr<BVHTree, BVHTreeDeleter>> bvh_cache_loose_edges;
   SharedCache<std::unique_ptr<BVHTree, BVHTreeDeleter>> bvh_cache_loose_edges_no_hidden;
+  /** Trees from the BVH caches above that can be refit after positions changed. */
+  std::shared_ptr<BVHRefitCache> bvh_refit_cache = std::make_shared<BVHRefitCache>();
+  /** Vertex group weights prepared for armature deformation. */
+  std::shared_ptr<SkinningWeightsCache> skinning_weights_cache =
+      std::make_shared<SkinningWeightsCache>();
 
   /** Needed in case we need to lazily initialize the mesh. */
   CustomData_MeshMasks cd_mask_extra = {};
@@ -202,6 +273,11 @@ struct MeshRuntime {
 
   /** Lazily computed vertex normals (#Mesh::vert_normals()). */
   SharedCache<Vector<float3>> vert_normals_cache;
+  /**
+   * The cached vertex normals were set with #mesh_vert_normals_assign instead of calculated from
+   * the faces, so they can't be updated partially from the face normals.
+   */
+  bool vert_normals_assigned = false;
   /** Lazily computed face normals (#Mesh::face_normals()). */
   SharedCache<Vector<float3>> face_normals_cache;
   /** Lazily computed face corner normals (#Mesh::corner_normals()). */
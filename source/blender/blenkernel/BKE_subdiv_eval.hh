@@ -15,6 +15,7 @@
 struct Mesh;
 struct OpenSubdiv_EvaluatorCache;
 struct OpenSubdiv_EvaluatorSettings;
+struct OpenSubdiv_PatchCoord;
 
 namespace blender::bke::subdiv {
 
@@ -61,6 +62,16 @@ void eval_limit_point_and_derivatives(Subdiv *subdiv,
 void eval_limit_point_and_normal(
     Subdiv *subdiv, int ptex_face_index, float u, float v, float r_P[3], float r_N[3]);
 
+/* Batched queries. */
+
+/* Evaluate points at the limit surface for many patch coordinates at once. This is multi-threaded
+ * and avoids the per-point overhead of #eval_limit_point, the results are the same.
+ * There is no batched variant for limit normals: meshes created by #subdiv_to_mesh get their
+ * normals from the regular mesh normal calculation, as with per-point evaluation. */
+void eval_limit_points(Subdiv *subdiv,
+                       Span<OpenSubdiv_PatchCoord> patch_coords,
+                       MutableSpan<float3> r_positions);
+
 /* Evaluate smoothly interpolated vertex data (such as ORCO). */
 void eval_vertex_data(Subdiv *subdiv,
                       const int ptex_face_index,
@@ -8,6 +8,7 @@
  * Deform coordinates by a armature object (used by modifier).
  */
 
+#include <atomic>
 #include <cctype>
 #include <cfloat>
 #include <cmath>
@@ -19,9 +20,13 @@
 
 #include "BLI_listbase.h"
 #include "BLI_math_matrix.h"
+#include "BLI_math_matrix.hh"
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
+#include "BLI_simd.hh"
+#include "BLI_system.h"
 #include "BLI_task.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 
 #include "DNA_armature_types.h"
@@ -45,6 +50,8 @@
 
 #include "CLG_log.h"
 
+#include "armature_deform_skinning_kernels.hh"
+
 static CLG_LogRef LOG = {"bke.armature_deform"};
 
 /* -------------------------------------------------------------------- */
@@ -479,6 +486,287 @@ static void armature_vert_task_editmesh_no_dvert(void *__restrict userdata,
   armature_vert_task_with_dvert(data, BM_elem_index_get(v), nullptr);
 }
 
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Armature Deform Skinning Kernels
+ *
+ * Faster deformation for the common case of meshes with a few vertex group weights per vertex
+ * that are deformed by simple bones. The weights are converted to the fixed-width tables of
+ * #SkinningWeights, which are cached on the mesh, and processed with SIMD kernels.
+ * \{ */
+
+namespace blender::bke {
+
+namespace skinning_kernels {
+namespace {
+
+#if BLI_HAVE_SSE2
+struct SimdSSE {
+  using V = __m128;
+  static constexpr int lanes = 1;
+
+  static V zero()
+  {
+    return _mm_setzero_ps();
+  }
+  /** `a * b + c` */
+  static V madd(const V a, const V b, const V c)
+  {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+  }
+  static V load(const float *const data[lanes], const int offset)
+  {
+    return _mm_loadu_ps(data[0] + offset);
+  }
+  static V broadcast(const float values[lanes])
+  {
+    return _mm_set1_ps(values[0]);
+  }
+  static V dot4(const V a, const V b)
+  {
+    const V products = _mm_mul_ps(a, b);
+    const V sums = _mm_add_ps(products, _mm_shuffle_ps(products, products, 0b10110001));
+    return _mm_add_ps(sums, _mm_shuffle_ps(sums, sums, 0b01001110));
+  }
+  /** `b < 0 ? -a : a` */
+  static V negate_if_negative(const V a, const V b)
+  {
+    const V mask = _mm_cmplt_ps(b, _mm_setzero_ps());
+    return _mm_xor_ps(a, _mm_and_ps(mask, _mm_set1_ps(-0.0f)));
+  }
+  static void store(float *dst, const V a)
+  {
+    _mm_storeu_ps(dst, a);
+  }
+};
+#endif
+
+using KernelFn = int64_t (*)(const SkinningParams &params, int64_t start, int64_t end);
+
+struct Kernels {
+  KernelFn linear;
+  KernelFn dual_quat;
+};
+
+Kernels kernels_for_type(const KernelType type)
+{
+  switch (type) {
+    case KernelType::Best: {
+      const Kernels kernels = kernels_for_type(KernelType::AVX2);
+      return kernels.linear ? kernels : kernels_for_type(KernelType::SSE);
+    }
+    case KernelType::None:
+      break;
+    case KernelType::SSE:
+#if BLI_HAVE_SSE2
+      return {skin_linear<SimdSSE>, skin_dual_quat<SimdSSE>};
+#else
+      break;
+#endif
+    case KernelType::AVX2:
+#ifdef WITH_SKINNING_AVX2_KERNELS
+      if (BLI_cpu_support_avx2()) {
+        return {skin_linear_avx2, skin_dual_quat_avx2};
+      }
+#endif
+      break;
+  }
+  return {nullptr, nullptr};
+}
+
+std::atomic<KernelType> kernel_type = KernelType::Best;
+
+Kernels get_kernels()
+{
+  static const Kernels best_kernels = kernels_for_type(KernelType::Best);
+  const KernelType type = kernel_type.load(std::memory_order_relaxed);
+  return type == KernelType::Best ? best_kernels : kernels_for_type(type);
+}
+
+}  // namespace
+
+bool set_kernel_type(const KernelType type)
+{
+  if (!ELEM(type, KernelType::Best, KernelType::None) &&
+      kernels_for_type(type).linear == nullptr)
+  {
+    return false;
+  }
+  kernel_type.store(type, std::memory_order_relaxed);
+  return true;
+}
+
+}  // namespace skinning_kernels
+
+static SkinningWeights build_skinning_weights(const Span<MDeformVert> dverts)
+{
+  constexpr int slots_num = SkinningWeights::slots_num;
+  static_assert(slots_num == skinning_kernels::slots_num);
+  const int64_t verts_num = dverts.size();
+  SkinningWeights skinning;
+  skinning.groups.reinitialize(slots_num * verts_num);
+  skinning.weights.reinitialize(slots_num * verts_num);
+  Array<bool> is_overflow(verts_num);
+  const int groups_num = threading::parallel_reduce(
+      dverts.index_range(),
+      1024,
+      0,
+      [&](const IndexRange range, int groups_num) {
+        for (const int64_t vert : range) {
+          int slot = 0;
+          for (const MDeformWeight &dw : Span(dverts[vert].dw, dverts[vert].totweight)) {
+            const int group = int(dw.def_nr);
+            if (dw.weight == 0.0f || group < 0) {
+              continue;
+            }
+            if (slot == slots_num) {
+              slot = slots_num + 1;
+              break;
+            }
+            skinning.groups[slot * verts_num + vert] = group;
+            skinning.weights[slot * verts_num + vert] = dw.weight;
+            groups_num = std::max(groups_num, group + 1);
+            slot++;
+          }
+          is_overflow[vert] = slot > slots_num;
+          for (slot = is_overflow[vert] ? 0 : slot; slot < slots_num; slot++) {
+            skinning.groups[slot * verts_num + vert] = 0;
+            skinning.weights[slot * verts_num + vert] = 0.0f;
+          }
+        }
+        return groups_num;
+      },
+      [](const int a, const int b) { return std::max(a, b); });
+  /* Unused slots refer to the first group. */
+  skinning.groups_num = std::max(groups_num, 1);
+
+  IndexMaskMemory memory;
+  const IndexMask overflow_verts = IndexMask::from_bools(is_overflow, memory);
+  skinning.overflow_verts.reinitialize(overflow_verts.size());
+  overflow_verts.to_indices<int>(skinning.overflow_verts);
+  return skinning;
+}
+
+/** Get the cached weight tables of the mesh, or build them when the vertex groups changed. */
+static std::shared_ptr<const SkinningWeights> ensure_skinning_weights(const Mesh &mesh)
+{
+  const int layer_index = CustomData_get_layer_index(&mesh.vert_data, CD_MDEFORMVERT);
+  if (layer_index == -1) {
+    return nullptr;
+  }
+  const ImplicitSharingInfo *sharing_info = mesh.vert_data.layers[layer_index].sharing_info;
+  if (sharing_info == nullptr) {
+    return nullptr;
+  }
+  SkinningWeightsCache &cache = *mesh.runtime->skinning_weights_cache;
+  std::lock_guard lock{cache.mutex};
+  /* The weak user keeps the sharing info alive, so a different layer can't have the same one. */
+  if (cache.weights && cache.dverts_sharing_info.get() == sharing_info &&
+      cache.dverts_version == sharing_info->version() &&
+      cache.weights->weights.size() == int64_t(mesh.verts_num) * SkinningWeights::slots_num)
+  {
+    return cache.weights;
+  }
+  cache.weights = std::make_shared<const SkinningWeights>(
+      build_skinning_weights(mesh.deform_verts()));
+  sharing_info->add_weak_user();
+  cache.dverts_sharing_info = WeakImplicitSharingPtr(sharing_info);
+  cache.dverts_version = sharing_info->version();
+  return cache.weights;
+}
+
+/**
+ * Deform the mesh with the skinning kernels if it and the armature only use features they
+ * support. Returns false if the generic code has to be used instead.
+ */
+static bool armature_deform_skinning(const ArmatureUserdata &data,
+                                     const Mesh &mesh,
+                                     const int verts_num)
+{
+  using namespace skinning_kernels;
+  const Kernels kernels = get_kernels();
+  const KernelFn kernel = data.use_quaternion ? kernels.dual_quat : kernels.linear;
+  if (kernel == nullptr || !data.use_dverts || data.use_envelope ||
+      data.armature_def_nr != -1 || data.vert_coords_prev != nullptr ||
+      data.vert_deform_mats != nullptr || verts_num != mesh.verts_num)
+  {
+    return false;
+  }
+  for (const int group : IndexRange(data.defbase_len)) {
+    const bPoseChannel *pchan = data.pchan_from_defbase[group];
+    if (pchan == nullptr) {
+      continue;
+    }
+    const Bone *bone = pchan->bone;
+    if (bone->segments > 1 && pchan->runtime.bbone_segments == bone->segments) {
+      return false;
+    }
+    if (bone->flag & BONE_MULT_VG_ENV) {
+      return false;
+    }
+    if (data.use_quaternion && pchan->runtime.deform_dual_quat.scale_weight != 0.0f) {
+      return false;
+    }
+  }
+
+  const std::shared_ptr<const SkinningWeights> skinning = ensure_skinning_weights(mesh);
+  if (!skinning) {
+    return false;
+  }
+
+  const float4x4 premat(data.premat);
+  const float4x4 postmat(data.postmat);
+  Array<float4x4> group_data(skinning->groups_num, float4x4::zero());
+  for (const int group : IndexRange(std::min(skinning->groups_num, data.defbase_len))) {
+    const bPoseChannel *pchan = data.pchan_from_defbase[group];
+    if (pchan == nullptr) {
+      continue;
+    }
+    if (data.use_quaternion) {
+      const DualQuat &dq = pchan->runtime.deform_dual_quat;
+      float *dst = group_data[group].base_ptr();
+      copy_v4_v4(dst, dq.quat);
+      copy_v4_v4(dst + 4, dq.trans);
+      dst[8] = 1.0f;
+    }
+    else {
+      group_data[group] = postmat * float4x4(pchan->chan_mat) * premat;
+    }
+  }
+
+  const SkinningParams params{data.vert_coords,
+                              skinning->groups.data(),
+                              skinning->weights.data(),
+                              verts_num,
+                              group_data.as_span().cast<float>().data(),
+                              premat.base_ptr(),
+                              postmat.base_ptr()};
+  const Span<int> overflow_verts = skinning->overflow_verts;
+  threading::parallel_for(IndexRange(verts_num), 1024, [&](const IndexRange range) {
+    const int64_t end = kernel(params, range.start(), range.one_after_last());
+    for (const int64_t i : IndexRange::from_begin_end(end, range.one_after_last())) {
+      if (!std::binary_search(overflow_verts.begin(), overflow_verts.end(), int(i))) {
+        armature_vert_task_with_dvert(&data, int(i), data.dverts + i);
+      }
+    }
+  });
+  threading::parallel_for(overflow_verts.index_range(), 512, [&](const IndexRange range) {
+    for (const int i : overflow_verts.slice(range)) {
+      armature_vert_task_with_dvert(&data, i, data.dverts + i);
+    }
+  });
+  return true;
+}
+
+}  // namespace blender::bke
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Armature Deform #BKE_armature_deform_coords Implementation
+ * \{ */
+
 static void armature_deform_coords_impl(const Object *ob_arm,
                                         const Object *ob_target,
                                         const ListBase *defbase,
@@ -594,6 +882,11 @@ static void armature_deform_coords_impl(const Object *ob_arm,
           em_target->bm->vpool, &data, armature_vert_task_editmesh_no_dvert, &settings);
     }
   }
+  else if (me_target != nullptr &&
+           blender::bke::armature_deform_skinning(data, *me_target, vert_coords_len))
+  {
+    /* Deformed with the skinning kernels. */
+  }
   else {
     TaskParallelSettings settings;
     BLI_parallel_range_settings_defaults(&settings);
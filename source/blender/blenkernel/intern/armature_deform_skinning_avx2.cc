@@ -0,0 +1,77 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bke
+ *
+ * AVX2 versions of the armature skinning kernels. This file is compiled with AVX2 and FMA enabled,
+ * so it must only use the kernels header and intrinsics, see
+ * `armature_deform_skinning_kernels.hh`.
+ */
+
+#include <immintrin.h>
+
+#include "armature_deform_skinning_kernels.hh"
+
+namespace blender::bke::skinning_kernels {
+
+namespace {
+
+struct SimdAVX2 {
+  using V = __m256;
+  static constexpr int lanes = 2;
+
+  static V zero()
+  {
+    return _mm256_setzero_ps();
+  }
+  /** `a * b + c` */
+  static V madd(const V a, const V b, const V c)
+  {
+    return _mm256_fmadd_ps(a, b, c);
+  }
+  /** Load four values starting at `offset` from the pointer of every lane. */
+  static V load(const float *const data[lanes], const int offset)
+  {
+    const __m256 result = _mm256_castps128_ps256(_mm_loadu_ps(data[0] + offset));
+    return _mm256_insertf128_ps(result, _mm_loadu_ps(data[1] + offset), 1);
+  }
+  /** Fill every lane with its value. */
+  static V broadcast(const float values[lanes])
+  {
+    const __m256 result = _mm256_castps128_ps256(_mm_set1_ps(values[0]));
+    return _mm256_insertf128_ps(result, _mm_set1_ps(values[1]), 1);
+  }
+  /** The dot product of the four values in a lane, in all four values of the lane. */
+  static V dot4(const V a, const V b)
+  {
+    const V products = _mm256_mul_ps(a, b);
+    const V sums = _mm256_add_ps(products, _mm256_shuffle_ps(products, products, 0b10110001));
+    return _mm256_add_ps(sums, _mm256_shuffle_ps(sums, sums, 0b01001110));
+  }
+  /** `b < 0 ? -a : a` */
+  static V negate_if_negative(const V a, const V b)
+  {
+    const V mask = _mm256_cmp_ps(b, _mm256_setzero_ps(), _CMP_LT_OQ);
+    return _mm256_xor_ps(a, _mm256_and_ps(mask, _mm256_set1_ps(-0.0f)));
+  }
+  static void store(float *dst, const V a)
+  {
+    _mm256_storeu_ps(dst, a);
+  }
+};
+
+}  // namespace
+
+int64_t skin_linear_avx2(const SkinningParams &params, const int64_t start, const int64_t end)
+{
+  return skin_linear<SimdAVX2>(params, start, end);
+}
+
+int64_t skin_dual_quat_avx2(const SkinningParams &params, const int64_t start, const int64_t end)
+{
+  return skin_dual_quat<SimdAVX2>(params, start, end);
+}
+
+}  // namespace blender::bke::skinning_kernels
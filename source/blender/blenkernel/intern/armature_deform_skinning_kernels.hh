@@ -0,0 +1,229 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bke
+ *
+ * Kernels for armature deformation with the fixed-width vertex group tables of
+ * #blender::bke::SkinningWeights. This header is included by translation units that are compiled
+ * for different instruction sets, so it must not use any other BLI code. Everything except the
+ * parameter struct is in an anonymous namespace, otherwise the linker could use a version of a
+ * function that contains instructions which are not supported by the CPU.
+ *
+ * The kernels are generic over a `Simd` type that wraps the intrinsics of an instruction set.
+ * Every 128-bit lane of a register accumulates the data of one vertex, so a register of the SSE
+ * type handles one vertex and a register of the AVX2 type handles two vertices at the same time.
+ * The kernels only process full registers and return the index of the first vertex they didn't
+ * process, the remaining vertices are handled by the caller.
+ */
+
+#include <cstdint>
+
+namespace blender::bke::skinning_kernels {
+
+/** Same as #SkinningWeights::slots_num. */
+constexpr int slots_num = 4;
+
+/** Vertices with a smaller total weight are not deformed, same as the generic code. */
+constexpr float min_contribution = 0.0001f;
+
+struct SkinningParams {
+  /** Positions in the object space of the deformed object, deformed in place. */
+  float (*positions)[3];
+  /** The slot tables of #SkinningWeights. */
+  const int *groups;
+  const float *weights;
+  int64_t verts_num;
+  /**
+   * 16 floats for every vertex group, which are all zero for groups that don't belong to a
+   * deforming bone.
+   *
+   * For linear blending this is a column major 4x4 matrix that combines the bone deformation with
+   * the transform between the armature and the object. The last row is (0, 0, 0, 1), so blending
+   * the matrices also sums the weights of the bones.
+   *
+   * For dual quaternion blending this is the rotation quaternion, the translation quaternion and
+   * (1, 0, 0, 0) followed by four unused values.
+   */
+  const float *group_data;
+  /** Column major transforms from the object space to the armature space and back. */
+  const float *premat;
+  const float *postmat;
+};
+
+enum class KernelType {
+  /** The fastest kernels the CPU supports. */
+  Best,
+  /** Don't use the kernels, all vertices are deformed by the generic code. */
+  None,
+  SSE,
+  AVX2,
+};
+
+/**
+ * Choose the kernels used by armature deformation, only meant for tests comparing them with the
+ * generic code. Returns false and keeps the current choice when the kernels are not available in
+ * this build or on this CPU. Defined in `armature_deform.cc`.
+ */
+bool set_kernel_type(KernelType type);
+
+namespace {
+
+/** `r = m * v` for a column major affine 4x4 matrix. */
+inline void transform_point(const float *m, const float v[3], float r[3])
+{
+  const float x = v[0], y = v[1], z = v[2];
+  r[0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+  r[1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+  r[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+}
+
+/**
+ * Same as #mul_v3m3_dq for dual quaternions without scale. The dual quaternion doesn't have to be
+ * normalized, because the result is divided by the squared length of the rotation quaternion.
+ */
+inline void dual_quat_transform(const float q[4], const float t[4], float r[3])
+{
+  const float w = q[0], x = q[1], y = q[2], z = q[3];
+  const float t0 = t[0], t1 = t[1], t2 = t[2], t3 = t[3];
+  float len2 = w * w + x * x + y * y + z * z;
+  if (len2 > 0.0f) {
+    len2 = 1.0f / len2;
+  }
+  const float tx = 2 * (-t0 * x + w * t1 - t2 * z + y * t3);
+  const float ty = 2 * (-t0 * y + t1 * z - x * t3 + w * t2);
+  const float tz = 2 * (-t0 * z + x * t2 + w * t3 - t1 * y);
+  const float px = r[0], py = r[1], pz = r[2];
+  r[0] = ((w * w + x * x - y * y - z * z) * px + 2 * (x * y - w * z) * py +
+          2 * (x * z + w * y) * pz + tx) *
+         len2;
+  r[1] = (2 * (x * y + w * z) * px + (w * w + y * y - x * x - z * z) * py +
+          2 * (y * z - w * x) * pz + ty) *
+         len2;
+  r[2] = (2 * (x * z - w * y) * px + 2 * (y * z + w * x) * py +
+          (w * w + z * z - x * x - y * y) * pz + tz) *
+         len2;
+}
+
+/** Collect the group data pointers and broadcast the weights of a slot for every lane. */
+template<typename Simd, typename V = typename Simd::V>
+inline V load_slot(const SkinningParams &params,
+                   const int64_t offset,
+                   const float *(&r_data)[Simd::lanes])
+{
+  for (int lane = 0; lane < Simd::lanes; lane++) {
+    r_data[lane] = params.group_data + int64_t(params.groups[offset + lane]) * 16;
+  }
+  return Simd::broadcast(params.weights + offset);
+}
+
+/** Linear blend skinning, see #SkinningParams::group_data. */
+template<typename Simd>
+int64_t skin_linear(const SkinningParams &params, const int64_t start, const int64_t end)
+{
+  using V = typename Simd::V;
+  constexpr int lanes = Simd::lanes;
+  int64_t i = start;
+  for (; i + lanes <= end; i += lanes) {
+    V col0 = Simd::zero(), col1 = Simd::zero(), col2 = Simd::zero(), col3 = Simd::zero();
+    for (int slot = 0; slot < slots_num; slot++) {
+      const float *data[lanes];
+      const V weight = load_slot<Simd>(params, slot * params.verts_num + i, data);
+      col0 = Simd::madd(weight, Simd::load(data, 0), col0);
+      col1 = Simd::madd(weight, Simd::load(data, 4), col1);
+      col2 = Simd::madd(weight, Simd::load(data, 8), col2);
+      col3 = Simd::madd(weight, Simd::load(data, 12), col3);
+    }
+
+    float xs[lanes], ys[lanes], zs[lanes];
+    for (int lane = 0; lane < lanes; lane++) {
+      xs[lane] = params.positions[i + lane][0];
+      ys[lane] = params.positions[i + lane][1];
+      zs[lane] = params.positions[i + lane][2];
+    }
+    V result = Simd::madd(col2, Simd::broadcast(zs), col3);
+    result = Simd::madd(col1, Simd::broadcast(ys), result);
+    result = Simd::madd(col0, Simd::broadcast(xs), result);
+
+    /* Every lane contains the sum of the weighted positions and the sum of the weights. */
+    float sums[lanes * 4];
+    Simd::store(sums, result);
+    for (int lane = 0; lane < lanes; lane++) {
+      const float *sum = sums + lane * 4;
+      if (sum[3] > min_contribution) {
+        const float factor = 1.0f / sum[3];
+        params.positions[i + lane][0] = sum[0] * factor;
+        params.positions[i + lane][1] = sum[1] * factor;
+        params.positions[i + lane][2] = sum[2] * factor;
+      }
+    }
+  }
+  return i;
+}
+
+/**
+ * Dual quaternion skinning, see #SkinningParams::group_data. The sign of every weight depends on
+ * the sum of the previous slots, so the slots of a vertex have to be processed one after another.
+ * To hide that latency, multiple registers are processed at the same time.
+ */
+template<typename Simd>
+int64_t skin_dual_quat(const SkinningParams &params, const int64_t start, const int64_t end)
+{
+  using V = typename Simd::V;
+  constexpr int lanes = Simd::lanes;
+  constexpr int regs = 2;
+  int64_t i = start;
+  for (; i + lanes * regs <= end; i += lanes * regs) {
+    V quat[regs], trans[regs], contribution[regs];
+    for (int reg = 0; reg < regs; reg++) {
+      quat[reg] = Simd::zero();
+      trans[reg] = Simd::zero();
+      contribution[reg] = Simd::zero();
+    }
+    for (int slot = 0; slot < slots_num; slot++) {
+      for (int reg = 0; reg < regs; reg++) {
+        const float *data[lanes];
+        const V weight = load_slot<Simd>(
+            params, slot * params.verts_num + i + reg * lanes, data);
+        const V group_quat = Simd::load(data, 0);
+        /* Interpolate the rotations in the right direction, like #add_weighted_dq_dq. */
+        const V signed_weight = Simd::negate_if_negative(weight,
+                                                         Simd::dot4(group_quat, quat[reg]));
+        quat[reg] = Simd::madd(signed_weight, group_quat, quat[reg]);
+        trans[reg] = Simd::madd(signed_weight, Simd::load(data, 4), trans[reg]);
+        contribution[reg] = Simd::madd(weight, Simd::load(data, 8), contribution[reg]);
+      }
+    }
+
+    for (int reg = 0; reg < regs; reg++) {
+      float quats[lanes * 4], transs[lanes * 4], contributions[lanes * 4];
+      Simd::store(quats, quat[reg]);
+      Simd::store(transs, trans[reg]);
+      Simd::store(contributions, contribution[reg]);
+      for (int lane = 0; lane < lanes; lane++) {
+        if (contributions[lane * 4] > min_contribution) {
+          float *position = params.positions[i + reg * lanes + lane];
+          float co[3];
+          transform_point(params.premat, position, co);
+          dual_quat_transform(quats + lane * 4, transs + lane * 4, co);
+          transform_point(params.postmat, co, position);
+        }
+      }
+    }
+  }
+  return i;
+}
+
+}  // namespace
+
+#ifdef WITH_SKINNING_AVX2_KERNELS
+/* Defined in `armature_deform_skinning_avx2.cc`. Only call these when #BLI_cpu_support_avx2 is
+ * true. */
+int64_t skin_linear_avx2(const SkinningParams &params, int64_t start, int64_t end);
+int64_t skin_dual_quat_avx2(const SkinningParams &params, int64_t start, int64_t end);
+#endif
+
+}  // namespace blender::bke::skinning_kernels
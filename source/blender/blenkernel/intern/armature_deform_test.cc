@@ -0,0 +1,183 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_listbase.h"
+#include "BLI_math_matrix.h"
+#include "BLI_math_rotation.h"
+#include "BLI_string.h"
+
+#include "DNA_action_types.h"
+#include "DNA_armature_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_action.hh"
+#include "BKE_armature.hh"
+#include "BKE_deform.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_mesh.hh"
+#include "BKE_mesh_types.hh"
+#include "BKE_object_types.hh"
+
+#include "armature_deform_skinning_kernels.hh"
+
+namespace blender::bke::tests {
+
+/**
+ * Vertex groups of the test mesh. The last two groups don't deform: one belongs to a bone with
+ * #BONE_NO_DEFORM and the other one doesn't have a bone at all.
+ */
+constexpr int deform_bones_num = 4;
+constexpr int groups_num = 6;
+/** Not a multiple of the vertices processed at once, so the kernels leave a tail. */
+constexpr int verts_num = 1003;
+
+class ArmatureDeformSkinningTest : public testing::Test {
+ protected:
+  Bone bones_[deform_bones_num + 1] = {};
+  bArmature *armature_ = nullptr;
+  Object *ob_arm_ = nullptr;
+  Mesh *mesh_ = nullptr;
+  Object *ob_mesh_ = nullptr;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    armature_ = static_cast<bArmature *>(BKE_id_new_nomain(ID_AR, "Armature"));
+    ob_arm_ = static_cast<Object *>(BKE_id_new_nomain(ID_OB, "ArmatureObject"));
+    ob_arm_->type = OB_ARMATURE;
+    ob_arm_->data = armature_;
+    ob_arm_->pose = MEM_cnew<bPose>(__func__);
+    ob_arm_->runtime->object_to_world.location() = float3(0.5f, -1.0f, 2.0f);
+
+    for (const int i : IndexRange(deform_bones_num + 1)) {
+      Bone &bone = bones_[i];
+      SNPRINTF(bone.name, "Bone%d", i);
+      bone.segments = 1;
+      unit_m4(bone.arm_mat);
+      bone.arm_mat[3][0] = float(i);
+      if (i == deform_bones_num) {
+        bone.flag |= BONE_NO_DEFORM;
+      }
+
+      bPoseChannel *pchan = BKE_pose_channel_ensure(ob_arm_->pose, bone.name);
+      pchan->bone = &bone;
+      /* Only rotations and translations, scaled bones use the generic code for dual quaternions.
+       */
+      const float loc[3] = {0.3f * i, -0.2f, 0.1f * i};
+      const float eul[3] = {0.2f * i, 0.5f - 0.1f * i, 0.3f};
+      const float size[3] = {1.0f, 1.0f, 1.0f};
+      loc_eul_size_to_mat4(pchan->chan_mat, loc, eul, size);
+      mat4_to_dquat(&pchan->runtime.deform_dual_quat, bone.arm_mat, pchan->chan_mat);
+    }
+
+    mesh_ = BKE_mesh_new_nomain(verts_num, 0, 0, 0);
+    for (const int i : IndexRange(groups_num)) {
+      bDeformGroup *dg = MEM_cnew<bDeformGroup>(__func__);
+      if (i <= deform_bones_num) {
+        STRNCPY(dg->name, bones_[i].name);
+      }
+      else {
+        STRNCPY(dg->name, "NoBone");
+      }
+      BLI_addtail(&mesh_->vertex_group_names, dg);
+    }
+    MutableSpan<float3> positions = mesh_->vert_positions_for_write();
+    MutableSpan<MDeformVert> dverts = mesh_->deform_verts_for_write();
+    for (const int i : IndexRange(verts_num)) {
+      positions[i] = float3(i % 10, (i / 10) % 10, i / 100) * 0.5f;
+      /* Between zero and six influences, so some vertices don't fit in the four slots. */
+      const int influences_num = i % 7;
+      for (const int j : IndexRange(influences_num)) {
+        const int group = (i + j) % groups_num;
+        const float weight = (j == 1 && i % 3 == 0) ? 0.0f :
+                                                      0.1f * float(1 + (i * 13 + j * 7) % 10);
+        BKE_defvert_add_index_notest(&dverts[i], group, weight);
+      }
+    }
+
+    ob_mesh_ = static_cast<Object *>(BKE_id_new_nomain(ID_OB, "MeshObject"));
+    ob_mesh_->type = OB_MESH;
+    ob_mesh_->data = mesh_;
+    ob_mesh_->runtime->object_to_world.location() = float3(-1.0f, 0.25f, 0.0f);
+  }
+
+  void TearDown() override
+  {
+    skinning_kernels::set_kernel_type(skinning_kernels::KernelType::Best);
+    BKE_id_free(nullptr, ob_mesh_);
+    BKE_id_free(nullptr, mesh_);
+    BKE_id_free(nullptr, ob_arm_);
+    BKE_id_free(nullptr, armature_);
+  }
+
+  Array<float3> deform(const bool use_quaternion)
+  {
+    Array<float3> positions(mesh_->vert_positions());
+    const int deformflag = ARM_DEF_VGROUP | (use_quaternion ? ARM_DEF_QUATERNION : 0);
+    BKE_armature_deform_coords_with_mesh(ob_arm_,
+                                         ob_mesh_,
+                                         reinterpret_cast<float(*)[3]>(positions.data()),
+                                         nullptr,
+                                         verts_num,
+                                         deformflag,
+                                         nullptr,
+                                         "",
+                                         mesh_);
+    return positions;
+  }
+
+  /** Compare the kernels with the generic code, which deforms one vertex at a time. */
+  void expect_kernels_match_generic(const skinning_kernels::KernelType type,
+                                    const bool use_quaternion)
+  {
+    ASSERT_TRUE(skinning_kernels::set_kernel_type(skinning_kernels::KernelType::None));
+    const Array<float3> expected = this->deform(use_quaternion);
+    EXPECT_EQ(mesh_->runtime->skinning_weights_cache->weights, nullptr);
+
+    if (!skinning_kernels::set_kernel_type(type)) {
+      GTEST_SKIP() << "Skinning kernels are not supported";
+    }
+    const Array<float3> result = this->deform(use_quaternion);
+    /* Make sure the kernels were used. */
+    EXPECT_NE(mesh_->runtime->skinning_weights_cache->weights, nullptr);
+
+    for (const int i : IndexRange(verts_num)) {
+      EXPECT_V3_NEAR(result[i], expected[i], 1e-4f);
+    }
+  }
+};
+
+TEST_F(ArmatureDeformSkinningTest, linear_sse)
+{
+  this->expect_kernels_match_generic(skinning_kernels::KernelType::SSE, false);
+}
+
+TEST_F(ArmatureDeformSkinningTest, linear_avx2)
+{
+  this->expect_kernels_match_generic(skinning_kernels::KernelType::AVX2, false);
+}
+
+TEST_F(ArmatureDeformSkinningTest, dual_quat_sse)
+{
+  this->expect_kernels_match_generic(skinning_kernels::KernelType::SSE, true);
+}
+
+TEST_F(ArmatureDeformSkinningTest, dual_quat_avx2)
+{
+  this->expect_kernels_match_generic(skinning_kernels::KernelType::AVX2, true);
+}
+
+}  // namespace blender::bke::tests
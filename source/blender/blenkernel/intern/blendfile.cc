@@ -63,6 +63,7 @@
 #include "BKE_undo_system.hh"
 #include "BKE_workspace.hh"
 
+#include "BLO_io_profile.hh"
 #include "BLO_read_write.hh"
 #include "BLO_readfile.hh"
 #include "BLO_userdef_default.h"
@@ -1204,6 +1205,7 @@ static void setup_app_data(bContext *C,
   BLI_assert(BKE_main_namemap_validate(bmain));
 
   if (mode != LOAD_UNDO && liboverride::is_auto_resync_enabled()) {
+    BLOIOProfileScope profile("Lib Override Resync");
     reports->duration.lib_overrides_resync = BLI_time_now_seconds();
 
     BKE_lib_override_library_main_resync(
@@ -1291,7 +1293,10 @@ void BKE_blendfile_read_setup_readfile(bContext *C,
       BLO_update_defaults_startup_blend(bfd->main, startup_app_template);
     }
   }
-  setup_app_blend_file_data(C, bfd, params, wm_setup_data, reports);
+  {
+    BLOIOProfileScope profile("Setup App Data");
+    setup_app_blend_file_data(C, bfd, params, wm_setup_data, reports);
+  }
   BLO_blendfiledata_free(bfd);
 }
 
@@ -1314,6 +1319,8 @@ BlendFileData *BKE_blendfile_read(const char *filepath,
     }
   }
 
+  BLOIOProfileFileScope profile_file(filepath, false);
+
   BlendFileData *bfd = BLO_read_from_file(filepath, eBLOReadSkip(params->skip_flags), reports);
   if (bfd && bfd->main->is_read_invalid) {
     BLO_blendfiledata_free(bfd);
@@ -11,6 +11,7 @@
 
 #include "BLI_math_geom.h"
 #include "BLI_task.h"
+#include "BLI_task.hh"
 
 #include "BKE_attribute.hh"
 #include "BKE_bvhutils.hh"
@@ -516,6 +517,19 @@ static std::unique_ptr<BVHTree, BVHTreeDeleter> create_tree_from_tris(const Span
   return tree;
 }
 
+/**
+ * Most users of the triangle trees cast rays, which is faster with the wide layout. It is refit
+ * together with the binary nodes, so it works with #refit_or_create_tree as well.
+ */
+static std::unique_ptr<BVHTree, BVHTreeDeleter> wide_tree_build(
+    std::unique_ptr<BVHTree, BVHTreeDeleter> tree)
+{
+  if (tree) {
+    BLI_bvhtree_build_wide(tree.get());
+  }
+  return tree;
+}
+
 static std::unique_ptr<BVHTree, BVHTreeDeleter> create_tree_from_tris(
     const Span<float3> positions,
     const OffsetIndices<int> faces,
@@ -549,6 +563,47 @@ static std::unique_ptr<BVHTree, BVHTreeDeleter> create_tree_from_tris(
   return tree;
 }
 
+/**
+ * Refit trees instead of building them again as long as their surface area cost stays below this
+ * factor of the cost of a newly built tree.
+ */
+static constexpr float max_refit_cost_factor = 1.5f;
+
+/**
+ * Reuse the tree stored in the refit cache when the number of elements didn't change. Leaf `i` of
+ * the tree must contain element `i`, which is only the case for trees that contain all elements.
+ */
+static std::unique_ptr<BVHTree, BVHTreeDeleter> refit_or_create_tree(
+    BVHRefitCache &refit_cache,
+    BVHRefitCache::Entry &entry,
+    const int elems_num,
+    const FunctionRef<void(BVHTree &tree, IndexRange range)> refit_leaves,
+    const FunctionRef<std::unique_ptr<BVHTree, BVHTreeDeleter>()> create_tree)
+{
+  std::unique_ptr<BVHTree, BVHTreeDeleter> tree;
+  float build_cost;
+  {
+    std::lock_guard lock{refit_cache.mutex};
+    tree = std::move(entry.tree);
+    build_cost = entry.build_cost;
+  }
+  if (tree && BLI_bvhtree_get_len(tree.get()) == elems_num) {
+    threading::parallel_for(IndexRange(elems_num), 4096, [&](const IndexRange range) {
+      refit_leaves(*tree, range);
+    });
+    BLI_bvhtree_update_tree(tree.get());
+    if (BLI_bvhtree_surface_area_cost(tree.get()) <= build_cost * max_refit_cost_factor) {
+      return tree;
+    }
+  }
+  tree = create_tree();
+  if (tree) {
+    std::lock_guard lock{refit_cache.mutex};
+    entry.build_cost = BLI_bvhtree_surface_area_cost(tree.get());
+  }
+  return tree;
+}
+
 BVHTreeFromMesh bvhtree_from_mesh_corner_tris_ex(const Span<float3> vert_positions,
                                                  const OffsetIndices<int> faces,
                                                  const Span<int> corner_verts,
@@ -670,7 +725,17 @@ blender::bke::BVHTreeFromMesh Mesh::bvh_verts() const
   using namespace blender::bke;
   const Span<float3> positions = this->vert_positions();
   this->runtime->bvh_cache_verts.ensure([&](std::unique_ptr<BVHTree, BVHTreeDeleter> &data) {
-    data = create_tree_from_verts(positions, positions.index_range());
+    BVHRefitCache &refit_cache = *this->runtime->bvh_refit_cache;
+    data = refit_or_create_tree(
+        refit_cache,
+        refit_cache.verts,
+        positions.size(),
+        [&](BVHTree &tree, const IndexRange range) {
+          for (const int i : range) {
+            BLI_bvhtree_update_node(&tree, i, positions[i], nullptr, 1);
+          }
+        },
+        [&]() { return create_tree_from_verts(positions, positions.index_range()); });
   });
   return create_verts_tree_data(this->runtime->bvh_cache_verts.data().get(), positions);
 }
@@ -714,7 +779,20 @@ blender::bke::BVHTreeFromMesh Mesh::bvh_edges() const
   const Span<float3> positions = this->vert_positions();
   const Span<int2> edges = this->edges();
   this->runtime->bvh_cache_edges.ensure([&](std::unique_ptr<BVHTree, BVHTreeDeleter> &data) {
-    data = create_tree_from_edges(positions, edges, edges.index_range());
+    BVHRefitCache &refit_cache = *this->runtime->bvh_refit_cache;
+    data = refit_or_create_tree(
+        refit_cache,
+        refit_cache.edges,
+        edges.size(),
+        [&](BVHTree &tree, const IndexRange range) {
+          for (const int i : range) {
+            float co[2][3];
+            copy_v3_v3(co[0], positions[edges[i][0]]);
+            copy_v3_v3(co[1], positions[edges[i][1]]);
+            BLI_bvhtree_update_node(&tree, i, co[0], nullptr, 2);
+          }
+        },
+        [&]() { return create_tree_from_edges(positions, edges, edges.index_range()); });
   });
   return create_edges_tree_data(this->runtime->bvh_cache_edges.data().get(), positions, edges);
 }
@@ -753,7 +831,8 @@ blender::bke::BVHTreeFromMesh Mesh::bvh_corner_tris_no_hidden() const
         IndexMaskMemory memory;
         const IndexMask visible_faces = IndexMask::from_bools_inverse(
             faces.index_range(), VArraySpan(hide_poly), memory);
-        data = create_tree_from_tris(positions, faces, corner_verts, corner_tris, visible_faces);
+        data = wide_tree_build(
+            create_tree_from_tris(positions, faces, corner_verts, corner_tris, visible_faces));
       });
   return create_tris_tree_data(this->runtime->bvh_cache_corner_tris_no_hidden.data().get(),
                                positions,
@@ -769,7 +848,23 @@ blender::bke::BVHTreeFromMesh Mesh::bvh_corner_tris() const
   const Span<int> corner_verts = this->corner_verts();
   const Span<int3> corner_tris = this->corner_tris();
   this->runtime->bvh_cache_corner_tris.ensure([&](std::unique_ptr<BVHTree, BVHTreeDeleter> &data) {
-    data = create_tree_from_tris(positions, corner_verts, corner_tris);
+    BVHRefitCache &refit_cache = *this->runtime->bvh_refit_cache;
+    data = refit_or_create_tree(
+        refit_cache,
+        refit_cache.corner_tris,
+        corner_tris.size(),
+        [&](BVHTree &tree, const IndexRange range) {
+          for (const int i : range) {
+            float co[3][3];
+            copy_v3_v3(co[0], positions[corner_verts[corner_tris[i][0]]]);
+            copy_v3_v3(co[1], positions[corner_verts[corner_tris[i][1]]]);
+            copy_v3_v3(co[2], positions[corner_verts[corner_tris[i][2]]]);
+            BLI_bvhtree_update_node(&tree, i, co[0], nullptr, 3);
+          }
+        },
+        [&]() {
+          return wide_tree_build(create_tree_from_tris(positions, corner_verts, corner_tris));
+        });
   });
   return create_tris_tree_data(
       this->runtime->bvh_cache_corner_tris.data().get(), positions, corner_verts, corner_tris);
@@ -0,0 +1,212 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include <limits>
+
+#include "BLI_kdopbvh.hh"
+#include "BLI_math_geom.h"
+#include "BLI_math_vector.hh"
+
+#include "BKE_bvhutils.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_mesh.hh"
+#include "BKE_mesh_types.hh"
+
+namespace blender::bke::tests {
+
+class BVHRefitTest : public testing::Test {
+ protected:
+  static constexpr int size = 32;
+  Mesh *mesh_ = nullptr;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+
+  /** Create a grid of `size` by `size` quads with a wavy surface. */
+  void SetUp() override
+  {
+    const int verts_x = size + 1;
+    mesh_ = BKE_mesh_new_nomain(verts_x * verts_x, 0, size * size, size * size * 4);
+    MutableSpan<float3> positions = mesh_->vert_positions_for_write();
+    for (const int y : IndexRange(verts_x)) {
+      for (const int x : IndexRange(verts_x)) {
+        positions[y * verts_x + x] = float3(x, y, 0.0f);
+      }
+    }
+    MutableSpan<int> face_offsets = mesh_->face_offsets_for_write();
+    MutableSpan<int> corner_verts = mesh_->corner_verts_for_write();
+    for (const int y : IndexRange(size)) {
+      for (const int x : IndexRange(size)) {
+        const int face = y * size + x;
+        face_offsets[face] = face * 4;
+        corner_verts[face * 4 + 0] = y * verts_x + x;
+        corner_verts[face * 4 + 1] = y * verts_x + x + 1;
+        corner_verts[face * 4 + 2] = (y + 1) * verts_x + x + 1;
+        corner_verts[face * 4 + 3] = (y + 1) * verts_x + x;
+      }
+    }
+    face_offsets.last() = size * size * 4;
+    mesh_calc_edges(*mesh_, false, false);
+    this->deform(0.0f);
+  }
+
+  void TearDown() override
+  {
+    BKE_id_free(nullptr, mesh_);
+  }
+
+  /** Move the vertices up and down like a deforming surface and tag the change. */
+  void deform(const float time)
+  {
+    MutableSpan<float3> positions = mesh_->vert_positions_for_write();
+    for (const int i : positions.index_range()) {
+      const float3 co = positions[i];
+      positions[i].z = 0.5f * std::sin(co.x * 0.3f + time) * std::cos(co.y * 0.2f - time);
+    }
+    mesh_->tag_positions_changed();
+  }
+
+  const BVHTree *corner_tris_tree()
+  {
+    return mesh_->bvh_corner_tris().tree;
+  }
+
+  /** Compare ray-casts and nearest point queries with testing every triangle. */
+  void expect_queries_match_brute_force()
+  {
+    const BVHTreeFromMesh tree_data = mesh_->bvh_corner_tris();
+    ASSERT_NE(tree_data.tree, nullptr);
+    const Span<float3> positions = mesh_->vert_positions();
+    const Span<int> corner_verts = mesh_->corner_verts();
+    const Span<int3> corner_tris = mesh_->corner_tris();
+    auto tri_positions = [&](const int tri, float3 &a, float3 &b, float3 &c) {
+      a = positions[corner_verts[corner_tris[tri][0]]];
+      b = positions[corner_verts[corner_tris[tri][1]]];
+      c = positions[corner_verts[corner_tris[tri][2]]];
+    };
+
+    for (const int i : IndexRange(64)) {
+      const float3 point(float(i % 8) * 4.3f + 0.2f, float(i / 8) * 4.1f + 0.3f, 2.0f);
+
+      const float3 dir(0.0f, 0.0f, -1.0f);
+      float expected_dist = std::numeric_limits<float>::max();
+      for (const int tri : corner_tris.index_range()) {
+        float3 a, b, c;
+        tri_positions(tri, a, b, c);
+        float dist;
+        if (isect_ray_tri_v3(point, dir, a, b, c, &dist, nullptr) && dist < expected_dist) {
+          expected_dist = dist;
+        }
+      }
+      const bool expect_hit = expected_dist != std::numeric_limits<float>::max();
+      BVHTreeRayHit hit;
+      hit.index = -1;
+      hit.dist = std::numeric_limits<float>::max();
+      BLI_bvhtree_ray_cast(tree_data.tree,
+                           point,
+                           dir,
+                           0.0f,
+                           &hit,
+                           tree_data.raycast_callback,
+                           const_cast<BVHTreeFromMesh *>(&tree_data));
+      EXPECT_EQ(hit.index != -1, expect_hit);
+      if (expect_hit) {
+        EXPECT_NEAR(hit.dist, expected_dist, 1e-4f);
+      }
+
+      float expected_dist_sq = std::numeric_limits<float>::max();
+      for (const int tri : corner_tris.index_range()) {
+        float3 a, b, c;
+        tri_positions(tri, a, b, c);
+        float3 closest;
+        closest_on_tri_to_point_v3(closest, point, a, b, c);
+        expected_dist_sq = std::min(expected_dist_sq, math::distance_squared(closest, point));
+      }
+      BVHTreeNearest nearest;
+      nearest.index = -1;
+      nearest.dist_sq = std::numeric_limits<float>::max();
+      BLI_bvhtree_find_nearest(tree_data.tree,
+                               point,
+                               &nearest,
+                               tree_data.nearest_callback,
+                               const_cast<BVHTreeFromMesh *>(&tree_data));
+      ASSERT_NE(nearest.index, -1);
+      EXPECT_NEAR(nearest.dist_sq, expected_dist_sq, 1e-4f);
+    }
+  }
+};
+
+TEST_F(BVHRefitTest, RefitAfterPositionsChanged)
+{
+  const BVHTree *tree = this->corner_tris_tree();
+  this->expect_queries_match_brute_force();
+  for (const int frame : IndexRange(1, 5)) {
+    this->deform(float(frame) * 0.2f);
+    /* The same tree is refit to the new positions. */
+    EXPECT_EQ(this->corner_tris_tree(), tree);
+    this->expect_queries_match_brute_force();
+  }
+}
+
+TEST_F(BVHRefitTest, TopologyChangeDropsCache)
+{
+  this->corner_tris_tree();
+  this->deform(0.2f);
+  const std::shared_ptr<BVHRefitCache> refit_cache = mesh_->runtime->bvh_refit_cache;
+  EXPECT_NE(refit_cache->corner_tris.tree, nullptr);
+
+  mesh_->tag_topology_changed();
+  EXPECT_NE(mesh_->runtime->bvh_refit_cache, refit_cache);
+  EXPECT_EQ(mesh_->runtime->bvh_refit_cache->corner_tris.tree, nullptr);
+  this->expect_queries_match_brute_force();
+}
+
+TEST_F(BVHRefitTest, RebuildWhenCostGrows)
+{
+  const BVHTree *tree = this->corner_tris_tree();
+
+  /* Fold the grid in half twice. The four layers overlap, so the branches of the old tree that
+   * were next to each other overlap as well, while a new tree can separate the layers. */
+  MutableSpan<float3> positions = mesh_->vert_positions_for_write();
+  for (float3 &position : positions) {
+    if (position.x > size / 2) {
+      position.x = float(size) - position.x;
+      position.z += 0.2f;
+    }
+    if (position.y > size / 2) {
+      position.y = float(size) - position.y;
+      position.z += 0.4f;
+    }
+  }
+  mesh_->tag_positions_changed();
+
+  EXPECT_NE(this->corner_tris_tree(), tree);
+  this->expect_queries_match_brute_force();
+}
+
+TEST_F(BVHRefitTest, UnusedTreesAreFreed)
+{
+  this->corner_tris_tree();
+  this->deform(0.0f);
+  const BVHRefitCache &refit_cache = *mesh_->runtime->bvh_refit_cache;
+  ASSERT_NE(refit_cache.corner_tris.tree, nullptr);
+
+  /* Every change of positions without a query of the tree makes it older. */
+  for (const int frame : IndexRange(BVHRefitCache::max_age)) {
+    this->deform(float(frame + 1) * 0.1f);
+    EXPECT_NE(refit_cache.corner_tris.tree, nullptr);
+  }
+  this->deform(1.0f);
+  EXPECT_EQ(refit_cache.corner_tris.tree, nullptr);
+
+  /* A new tree is built when it is needed again. */
+  this->expect_queries_match_brute_force();
+}
+
+}  // namespace blender::bke::tests
@@ -1101,23 +1101,10 @@ static void translate_positions(MutableSpan<float3> positions, const float3 &tra
   });
 }
 
-static void transform_positions(MutableSpan<float3> positions, const float4x4 &matrix)
-{
-  threading::parallel_for(positions.index_range(), 1024, [&](const IndexRange range) {
-    for (float3 &position : positions.slice(range)) {
-      position = math::transform_point(matrix, position);
-    }
-  });
-}
-
 static void transform_normals(MutableSpan<float3> normals, const float4x4 &matrix)
 {
   const float3x3 normal_transform = math::transpose(math::invert(float3x3(matrix)));
-  threading::parallel_for(normals.index_range(), 1024, [&](const IndexRange range) {
-    for (float3 &normal : normals.slice(range)) {
-      normal = normal_transform * normal;
-    }
-  });
+  math::transform_directions(normals, normal_transform);
 }
 
 void CurvesGeometry::calculate_bezier_auto_handles()
@@ -1181,12 +1168,12 @@ void CurvesGeometry::translate(const float3 &translation)
 
 void CurvesGeometry::transform(const float4x4 &matrix)
 {
-  transform_positions(this->positions_for_write(), matrix);
+  math::transform_points(this->positions_for_write(), matrix);
   if (!this->handle_positions_left().is_empty()) {
-    transform_positions(this->handle_positions_left_for_write(), matrix);
+    math::transform_points(this->handle_positions_left_for_write(), matrix);
   }
   if (!this->handle_positions_right().is_empty()) {
-    transform_positions(this->handle_positions_right_for_write(), matrix);
+    math::transform_points(this->handle_positions_right_for_write(), matrix);
   }
   MutableAttributeAccessor attributes = this->attributes_for_write();
   if (SpanAttributeWriter normals = attributes.lookup_for_write_span<float3>("custom_normal")) {
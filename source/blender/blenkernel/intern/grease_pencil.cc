@@ -3155,19 +3155,6 @@ blender::bke::greasepencil::Drawing *GreasePencil::get_eval_drawing(
   return this->get_drawing_at(layer, this->runtime->eval_frame);
 }
 
-static void transform_positions(const Span<blender::float3> src,
-                                const blender::float4x4 &transform,
-                                blender::MutableSpan<blender::float3> dst)
-{
-  BLI_assert(src.size() == dst.size());
-
-  blender::threading::parallel_for(src.index_range(), 4096, [&](const blender::IndexRange range) {
-    for (const int i : range) {
-      dst[i] = blender::math::transform_point(transform, src[i]);
-    }
-  });
-}
-
 std::optional<blender::Bounds<blender::float3>> GreasePencil::bounds_min_max(const int frame) const
 {
   using namespace blender;
@@ -3183,7 +3170,7 @@ std::optional<blender::Bounds<blender::float3>> GreasePencil::bounds_min_max(con
       const bke::CurvesGeometry &curves = drawing->strokes();
 
       Array<float3> world_pos(curves.evaluated_positions().size());
-      transform_positions(curves.evaluated_positions(), layer_to_object, world_pos);
+      math::transform_points(curves.evaluated_positions(), layer_to_object, world_pos);
       bounds = bounds::merge(bounds, bounds::min_max(world_pos.as_span()));
     }
   }
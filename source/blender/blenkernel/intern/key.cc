@@ -6,6 +6,7 @@
  * \ingroup bke
  */
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <cstring>
@@ -17,7 +18,9 @@
 #include "BLI_endian_switch.h"
 #include "BLI_math_matrix.h"
 #include "BLI_math_vector.h"
+#include "BLI_math_vector_types.hh"
 #include "BLI_string_utils.hh"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.hh"
@@ -55,6 +58,12 @@
 
 #include "BLO_read_write.hh"
 
+static void shapekey_init_data(ID *id)
+{
+  Key *key = (Key *)id;
+  key->runtime = new blender::bke::KeyRuntime();
+}
+
 static void shapekey_copy_data(Main * /*bmain*/,
                                std::optional<Library *> /*owner_library*/,
                                ID *id_dst,
@@ -78,6 +87,9 @@ static void shapekey_copy_data(Main * /*bmain*/,
       key_dst->refkey = kb_dst;
     }
   }
+
+  /* The sparse deltas reference the key-blocks of the source. */
+  key_dst->runtime = new blender::bke::KeyRuntime();
 }
 
 static void shapekey_free_data(ID *id)
@@ -89,6 +101,8 @@ static void shapekey_free_data(ID *id)
     }
     MEM_freeN(kb);
   }
+  delete key->runtime;
+  key->runtime = nullptr;
 }
 
 static void shapekey_foreach_id(ID *id, LibraryForeachIDData *data)
@@ -185,6 +199,8 @@ static void shapekey_blend_read_data(BlendDataReader *reader, ID *id)
       switch_endian_keyblock(key, kb);
     }
   }
+
+  key->runtime = new blender::bke::KeyRuntime();
 }
 
 static void shapekey_blend_read_after_liblink(BlendLibReader * /*reader*/, ID *id)
@@ -208,7 +224,7 @@ IDTypeInfo IDType_ID_KE = {
     /*flags*/ IDTYPE_FLAGS_NO_LIBLINKING,
     /*asset_type_info*/ nullptr,
 
-    /*init_data*/ nullptr,
+    /*init_data*/ shapekey_init_data,
     /*copy_data*/ shapekey_copy_data,
     /*free_data*/ shapekey_free_data,
     /*make_local*/ nullptr,
@@ -866,6 +882,218 @@ static void cp_cu_key(Curve *cu,
   }
 }
 
+namespace blender::bke {
+
+struct KeyBlockSparseDeltas {
+  /** The data the deltas were computed from, to detect changes. */
+  const void *data;
+  const void *ref_data;
+  int totelem;
+  /** True when too many elements move, then the deltas are not stored. */
+  bool is_dense;
+  /** Sorted indices of the elements that differ from the reference key-block. */
+  Array<int> indices;
+  /** The difference to the reference key-block for every index. */
+  Array<float3> deltas;
+};
+
+/**
+ * Sparse deltas are not worth it when most elements move, then the dense loop which doesn't
+ * need the indirection through the indices is faster.
+ */
+static bool key_block_use_sparse_deltas(const int64_t moved_num, const int64_t totelem)
+{
+  return moved_num < totelem / 2;
+}
+
+static std::shared_ptr<const KeyBlockSparseDeltas> key_block_sparse_deltas_build(
+    const KeyBlock &kb, const KeyBlock &refb)
+{
+  const Span<float3> positions(static_cast<const float3 *>(kb.data), kb.totelem);
+  const Span<float3> ref_positions(static_cast<const float3 *>(refb.data), kb.totelem);
+
+  auto sparse = std::make_shared<KeyBlockSparseDeltas>();
+  sparse->data = kb.data;
+  sparse->ref_data = refb.data;
+  sparse->totelem = kb.totelem;
+  sparse->is_dense = false;
+
+  Vector<int> indices;
+  for (const int i : positions.index_range()) {
+    if (positions[i] != ref_positions[i]) {
+      indices.append(i);
+      if (!key_block_use_sparse_deltas(indices.size(), positions.size())) {
+        sparse->is_dense = true;
+        return sparse;
+      }
+    }
+  }
+
+  sparse->indices = indices.as_span();
+  sparse->deltas.reinitialize(indices.size());
+  for (const int64_t i : indices.index_range()) {
+    sparse->deltas[i] = positions[indices[i]] - ref_positions[indices[i]];
+  }
+  return sparse;
+}
+
+static bool key_block_sparse_deltas_valid(const KeyBlockSparseDeltas &sparse,
+                                          const KeyBlock &kb,
+                                          const KeyBlock &refb)
+{
+  return sparse.data == kb.data && sparse.ref_data == refb.data && sparse.totelem == kb.totelem;
+}
+
+/**
+ * Get the sparse deltas of the given key-blocks relative to their reference key-blocks, which
+ * are built when they don't exist yet. The result is null for keys that don't cache the deltas.
+ */
+static Vector<std::shared_ptr<const KeyBlockSparseDeltas>> key_sparse_deltas_ensure(
+    Key &key, const Span<const KeyBlock *> key_blocks, const Span<const KeyBlock *> ref_blocks)
+{
+  Vector<std::shared_ptr<const KeyBlockSparseDeltas>> result(key_blocks.size());
+  if (key.runtime == nullptr || (key.id.tag & ID_TAG_COPIED_ON_EVAL) == 0) {
+    return result;
+  }
+  KeyRuntime &runtime = *key.runtime;
+  std::lock_guard lock{runtime.sparse_deltas_mutex};
+
+  Vector<int> blocks_to_build;
+  for (const int i : key_blocks.index_range()) {
+    const KeyBlock &kb = *key_blocks[i];
+    const KeyBlock &refb = *ref_blocks[i];
+    if (refb.totelem != kb.totelem) {
+      continue;
+    }
+    const std::shared_ptr<const KeyBlockSparseDeltas> *sparse = runtime.sparse_deltas.lookup_ptr(
+        &kb);
+    if (sparse && key_block_sparse_deltas_valid(**sparse, kb, refb)) {
+      result[i] = *sparse;
+    }
+    else {
+      blocks_to_build.append(i);
+    }
+  }
+  if (blocks_to_build.is_empty()) {
+    return result;
+  }
+
+  /* Isolate because a mutex is locked. */
+  threading::isolate_task([&]() {
+    threading::parallel_for(blocks_to_build.index_range(), 1, [&](const IndexRange range) {
+      for (const int i : blocks_to_build.as_span().slice(range)) {
+        result[i] = key_block_sparse_deltas_build(*key_blocks[i], *ref_blocks[i]);
+      }
+    });
+  });
+  for (const int i : blocks_to_build) {
+    runtime.sparse_deltas.add_overwrite(key_blocks[i], result[i]);
+  }
+  return result;
+}
+
+struct RelativeKeyBlock {
+  const float3 *positions;
+  const float3 *ref_positions;
+  /** Optional vertex group weights. */
+  const float *weights;
+  float influence;
+  const KeyBlockSparseDeltas *sparse;
+};
+
+/**
+ * Version of #key_evaluate_relative for meshes and lattices, where every element is a position.
+ * The elements are processed in parallel and unchanged elements of key-blocks are skipped. The
+ * key-blocks are still added in the same order for every element, so the result is the same.
+ */
+static void key_evaluate_relative_positions(const int start,
+                                            const int end,
+                                            const int tot,
+                                            float3 *positions,
+                                            Key *key,
+                                            KeyBlock *actkb,
+                                            float **per_keyblock_weights)
+{
+  Vector<RelativeKeyBlock> blocks;
+  /* The key-blocks that can use cached sparse deltas and their index in #blocks. */
+  Vector<const KeyBlock *> key_blocks;
+  Vector<const KeyBlock *> ref_blocks;
+  Vector<int> key_block_indices;
+  Vector<char *> data_to_free;
+  int keyblock_index;
+  LISTBASE_FOREACH_INDEX (KeyBlock *, kb, &key->block, keyblock_index) {
+    if (kb == key->refkey || (kb->flag & KEYBLOCK_MUTE) || kb->curval == 0.0f ||
+        kb->totelem != tot)
+    {
+      continue;
+    }
+    /* Reference now can be any block. */
+    const KeyBlock *refb = static_cast<const KeyBlock *>(BLI_findlink(&key->block, kb->relative));
+    if (refb == nullptr) {
+      continue;
+    }
+    char *freefrom = nullptr;
+    const char *from = key_block_get_data(key, actkb, kb, &freefrom);
+    if (freefrom) {
+      data_to_free.append(freefrom);
+    }
+
+    RelativeKeyBlock block;
+    block.positions = reinterpret_cast<const float3 *>(from);
+    /* For meshes, use the original values instead of the bmesh values to
+     * maintain a constant offset. */
+    block.ref_positions = static_cast<const float3 *>(refb->data);
+    block.weights = per_keyblock_weights ? per_keyblock_weights[keyblock_index] : nullptr;
+    block.influence = kb->curval;
+    block.sparse = nullptr;
+    blocks.append(block);
+
+    /* Edit-mode positions of the active key-block change all the time, don't cache them. */
+    if (freefrom == nullptr) {
+      key_blocks.append(kb);
+      ref_blocks.append(refb);
+      key_block_indices.append(blocks.size() - 1);
+    }
+  }
+
+  const Vector<std::shared_ptr<const KeyBlockSparseDeltas>> sparse_deltas =
+      key_sparse_deltas_ensure(*key, key_blocks, ref_blocks);
+  for (const int i : key_blocks.index_range()) {
+    if (sparse_deltas[i] && !sparse_deltas[i]->is_dense) {
+      blocks[key_block_indices[i]].sparse = sparse_deltas[i].get();
+    }
+  }
+
+  threading::parallel_for(IndexRange::from_begin_end(start, end), 1024, [&](IndexRange range) {
+    for (const RelativeKeyBlock &block : blocks) {
+      if (block.sparse) {
+        const Span<int> indices = block.sparse->indices;
+        const int *first = std::lower_bound(indices.begin(), indices.end(), range.first());
+        const int *last = std::lower_bound(first, indices.end(), range.one_after_last());
+        for (const int64_t i : IndexRange(first - indices.begin(), last - first)) {
+          const int vert = indices[i];
+          const float weight = block.weights ? block.weights[vert] * block.influence :
+                                               block.influence;
+          positions[vert] += weight * block.sparse->deltas[i];
+        }
+      }
+      else {
+        for (const int vert : range) {
+          const float weight = block.weights ? block.weights[vert] * block.influence :
+                                               block.influence;
+          positions[vert] -= weight * (block.ref_positions[vert] - block.positions[vert]);
+        }
+      }
+    }
+  });
+
+  for (char *data : data_to_free) {
+    MEM_freeN(data);
+  }
+}
+
+}  // namespace blender::bke
+
 static void key_evaluate_relative(const int start,
                                   int end,
                                   const int tot,
@@ -902,6 +1130,17 @@ static void key_evaluate_relative(const int start,
   /* step 1 init */
   cp_key(start, end, tot, basispoin, key, actkb, key->refkey, nullptr, mode);
 
+  if (ELEM(GS(key->from->name), ID_ME, ID_LT)) {
+    blender::bke::key_evaluate_relative_positions(start,
+                                                  end,
+                                                  tot,
+                                                  reinterpret_cast<blender::float3 *>(basispoin),
+                                                  key,
+                                                  actkb,
+                                                  per_keyblock_weights);
+    return;
+  }
+
   /* step 2: do it */
 
   for (kb = static_cast<KeyBlock *>(key->block.first), keyblock_index = 0; kb;
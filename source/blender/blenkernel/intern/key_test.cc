@@ -0,0 +1,235 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_array.hh"
+#include "BLI_listbase.h"
+#include "BLI_map.hh"
+#include "BLI_string.h"
+
+#include "DNA_key_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_deform.hh"
+#include "BKE_idtype.hh"
+#include "BKE_key.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+#include "BKE_mesh.hh"
+
+namespace blender::bke::tests {
+
+/** More than one chunk of the parallel loop, and not a multiple of its grain size. */
+constexpr int verts_num = 3001;
+
+class KeyRelativeTest : public testing::Test {
+ protected:
+  Main *bmain_ = nullptr;
+  Mesh *mesh_ = nullptr;
+  Object *ob_ = nullptr;
+  Key *key_ = nullptr;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    bmain_ = BKE_main_new();
+    mesh_ = BKE_mesh_new_nomain(verts_num, 0, 0, 0);
+    MutableSpan<float3> positions = mesh_->vert_positions_for_write();
+    for (const int i : positions.index_range()) {
+      positions[i] = float3(i % 10, (i / 10) % 10, i / 100) * 0.5f;
+    }
+
+    bDeformGroup *dg = MEM_cnew<bDeformGroup>(__func__);
+    STRNCPY(dg->name, "Group");
+    BLI_addtail(&mesh_->vertex_group_names, dg);
+    MutableSpan<MDeformVert> dverts = mesh_->deform_verts_for_write();
+    for (const int i : dverts.index_range()) {
+      /* Some vertices are not in the group at all. */
+      if (i % 3 != 0) {
+        BKE_defvert_add_index_notest(&dverts[i], 0, 0.1f * float(1 + i % 10));
+      }
+    }
+
+    ob_ = static_cast<Object *>(BKE_id_new_nomain(ID_OB, "Object"));
+    ob_->type = OB_MESH;
+    ob_->data = mesh_;
+
+    key_ = BKE_key_add(bmain_, &mesh_->id);
+    key_->type = KEY_RELATIVE;
+    mesh_->key = key_;
+
+    /* Key-blocks after the basis key, see #add_key_block for how they move the positions. */
+    this->add_key_block("Basis", 0, 0.0f);
+    KeyBlock *sparse = this->add_key_block("Sparse", 10, 0.7f);
+    KeyBlock *weighted = this->add_key_block("Weighted", 7, 0.5f);
+    STRNCPY(weighted->vgroup, "Group");
+    KeyBlock *muted = this->add_key_block("Muted", 1, 1.0f);
+    muted->flag |= KEYBLOCK_MUTE;
+    /* Relative to a non-basis key-block, so the deltas are relative to its positions. */
+    KeyBlock *relative = this->add_key_block("Relative", 0, 0.8f);
+    relative->relative = BLI_findindex(&key_->block, sparse);
+    memcpy(relative->data, sparse->data, sizeof(float3) * verts_num);
+    float3 *relative_positions = static_cast<float3 *>(relative->data);
+    for (int i = 0; i < verts_num; i += 5) {
+      relative_positions[i] += float3(0.0f, 0.0f, 0.25f);
+    }
+    /* Moves 60% of the vertices, more than the sparse deltas are used for. */
+    KeyBlock *dense = this->add_key_block("Dense", 0, 0.3f);
+    float3 *dense_positions = static_cast<float3 *>(dense->data);
+    for (const int i : IndexRange(verts_num)) {
+      if (i % 5 >= 2) {
+        dense_positions[i] += float3(0.1f, -0.2f, 0.3f);
+      }
+    }
+  }
+
+  void TearDown() override
+  {
+    mesh_->key = nullptr;
+    BKE_id_free(nullptr, ob_);
+    BKE_id_free(nullptr, mesh_);
+    BKE_main_free(bmain_);
+  }
+
+  /**
+   * Add a key-block with the mesh positions, where every vertex with an index that is a multiple
+   * of \a step is moved. Nothing is moved when \a step is zero.
+   */
+  KeyBlock *add_key_block(const char *name, const int step, const float value)
+  {
+    KeyBlock *kb = BKE_keyblock_add(key_, name);
+    BKE_keyblock_convert_from_mesh(mesh_, key_, kb);
+    kb->curval = value;
+    if (step > 0) {
+      float3 *positions = static_cast<float3 *>(kb->data);
+      for (int i = 0; i < verts_num; i += step) {
+        positions[i] += float3(0.5f * float(i % 3), -0.25f, 1.0f);
+      }
+    }
+    return kb;
+  }
+
+  KeyBlock *find_key_block(const char *name)
+  {
+    return static_cast<KeyBlock *>(
+        BLI_findstring(&key_->block, name, offsetof(KeyBlock, name)));
+  }
+
+  /** The blending of relative keys as it was done before the sparse deltas, for every element. */
+  Array<float3> evaluate_dense_reference()
+  {
+    const Span<MDeformVert> dverts = mesh_->deform_verts();
+    Array<float3> result(Span(static_cast<const float3 *>(key_->refkey->data), verts_num));
+    LISTBASE_FOREACH (const KeyBlock *, kb, &key_->block) {
+      if (kb == key_->refkey || (kb->flag & KEYBLOCK_MUTE) || kb->curval == 0.0f) {
+        continue;
+      }
+      const KeyBlock *refb = static_cast<const KeyBlock *>(
+          BLI_findlink(&key_->block, kb->relative));
+      const float3 *from = static_cast<const float3 *>(kb->data);
+      const float3 *ref = static_cast<const float3 *>(refb->data);
+      for (const int i : IndexRange(verts_num)) {
+        const float weight = kb->vgroup[0] ? BKE_defvert_find_weight(&dverts[i], 0) * kb->curval :
+                                             kb->curval;
+        result[i] -= weight * (ref[i] - from[i]);
+      }
+    }
+    return result;
+  }
+
+  Array<float3> evaluate()
+  {
+    int totelem = 0;
+    float *data = BKE_key_evaluate_object(ob_, &totelem);
+    EXPECT_EQ(totelem, verts_num);
+    Array<float3> result(Span(reinterpret_cast<const float3 *>(data), verts_num));
+    MEM_freeN(data);
+    return result;
+  }
+
+  void expect_matches_dense_reference()
+  {
+    const Array<float3> expected = this->evaluate_dense_reference();
+    const Array<float3> result = this->evaluate();
+    for (const int i : IndexRange(verts_num)) {
+      EXPECT_V3_NEAR(result[i], expected[i], 1e-5f);
+    }
+  }
+
+  Map<const KeyBlock *, const void *> cached_sparse_deltas()
+  {
+    Map<const KeyBlock *, const void *> result;
+    for (const auto item : key_->runtime->sparse_deltas.items()) {
+      result.add(item.key, item.value.get());
+    }
+    return result;
+  }
+};
+
+TEST_F(KeyRelativeTest, original_key_matches_dense)
+{
+  this->expect_matches_dense_reference();
+  /* Original keys are edited directly, so they never cache the deltas. */
+  EXPECT_TRUE(key_->runtime->sparse_deltas.is_empty());
+}
+
+TEST_F(KeyRelativeTest, sparse_deltas_match_dense)
+{
+  key_->id.tag |= ID_TAG_COPIED_ON_EVAL;
+  this->expect_matches_dense_reference();
+
+  const Map<const KeyBlock *, const void *> cached = this->cached_sparse_deltas();
+  EXPECT_EQ(cached.size(), 4);
+  EXPECT_TRUE(cached.contains(this->find_key_block("Sparse")));
+  EXPECT_TRUE(cached.contains(this->find_key_block("Weighted")));
+  EXPECT_TRUE(cached.contains(this->find_key_block("Relative")));
+  EXPECT_TRUE(cached.contains(this->find_key_block("Dense")));
+  EXPECT_FALSE(cached.contains(this->find_key_block("Muted")));
+}
+
+TEST_F(KeyRelativeTest, sparse_deltas_reused)
+{
+  key_->id.tag |= ID_TAG_COPIED_ON_EVAL;
+  this->expect_matches_dense_reference();
+  const Map<const KeyBlock *, const void *> cached = this->cached_sparse_deltas();
+
+  /* Changing the values like animation does keeps the deltas. */
+  LISTBASE_FOREACH (KeyBlock *, kb, &key_->block) {
+    kb->curval *= 0.5f;
+  }
+  this->find_key_block("Muted")->flag &= ~KEYBLOCK_MUTE;
+  this->expect_matches_dense_reference();
+
+  const Map<const KeyBlock *, const void *> cached_again = this->cached_sparse_deltas();
+  EXPECT_EQ(cached_again.size(), 5);
+  for (const auto item : cached.items()) {
+    EXPECT_EQ(cached_again.lookup_default(item.key, nullptr), item.value);
+  }
+}
+
+TEST_F(KeyRelativeTest, sparse_deltas_rebuilt_for_new_data)
+{
+  key_->id.tag |= ID_TAG_COPIED_ON_EVAL;
+  this->expect_matches_dense_reference();
+
+  /* New data, as when the original key was edited. */
+  KeyBlock *kb = this->find_key_block("Sparse");
+  void *old_data = kb->data;
+  kb->data = MEM_dupallocN(old_data);
+  static_cast<float3 *>(kb->data)[1] += float3(1.0f);
+  /* Keep the old allocation until the end so that the new one can't reuse its address. */
+  this->expect_matches_dense_reference();
+  MEM_freeN(old_data);
+}
+
+}  // namespace blender::bke::tests
@@ -305,18 +305,6 @@ static Array<int> create_reverse_offsets(const Span<int> indices, const int item
   return offsets;
 }
 
-static void sort_small_groups(const OffsetIndices<int> groups,
-                              const int grain_size,
-                              MutableSpan<int> indices)
-{
-  threading::parallel_for(groups.index_range(), grain_size, [&](const IndexRange range) {
-    for (const int64_t index : range) {
-      MutableSpan<int> group = indices.slice(groups[index]);
-      std::sort(group.begin(), group.end());
-    }
-  });
-}
-
 static Array<int> reverse_indices_in_groups(const Span<int> group_indices,
                                             const OffsetIndices<int> offsets)
 {
@@ -325,22 +313,8 @@ static Array<int> reverse_indices_in_groups(const Span<int> group_indices,
   }
   BLI_assert(*std::max_element(group_indices.begin(), group_indices.end()) < offsets.size());
   BLI_assert(*std::min_element(group_indices.begin(), group_indices.end()) >= 0);
-
-  /* `counts` keeps track of how many elements have been added to each group, and is incremented
-   * atomically by many threads in parallel. `calloc` can be measurably faster than a parallel fill
-   * of zero. Alternatively the offsets could be copied and incremented directly, but the cost of
-   * the copy is slightly higher than the cost of `calloc`. */
-  int *counts = MEM_cnew_array<int>(size_t(offsets.size()), __func__);
-  BLI_SCOPED_DEFER([&]() { MEM_freeN(counts); })
   Array<int> results(group_indices.size());
-  threading::parallel_for(group_indices.index_range(), 1024, [&](const IndexRange range) {
-    for (const int64_t i : range) {
-      const int group_index = group_indices[i];
-      const int index_in_group = atomic_fetch_and_add_int32(&counts[group_index], 1);
-      results[offsets[group_index][index_in_group]] = int(i);
-    }
-  });
-  sort_small_groups(offsets, 1024, results);
+  offset_indices::build_reverse_indices(group_indices, offsets, results);
   return results;
 }
 
@@ -360,7 +334,7 @@ static void reverse_group_indices_in_groups(const OffsetIndices<int> groups,
       }
     }
   });
-  sort_small_groups(offsets, 1024, results);
+  offset_indices::sort_small_groups(offsets, results);
 }
 
 static GroupedSpan<int> gather_groups(const Span<int> group_indices,
@@ -400,7 +374,7 @@ GroupedSpan<int> build_vert_to_edge_map(const Span<int2> edges,
       }
     }
   });
-  sort_small_groups(offsets, 1024, r_indices);
+  offset_indices::sort_small_groups(offsets, r_indices);
   return {offsets, r_indices};
 }
 
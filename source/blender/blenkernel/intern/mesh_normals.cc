@@ -19,6 +19,7 @@
 
 #include "BLI_array_utils.hh"
 #include "BLI_bit_vector.hh"
+#include "BLI_index_mask.hh"
 #include "BLI_linklist.h"
 #include "BLI_math_base.hh"
 #include "BLI_math_vector.hh"
@@ -49,13 +50,18 @@ namespace blender::bke {
 
 void mesh_vert_normals_assign(Mesh &mesh, Span<float3> vert_normals)
 {
-  mesh.runtime->vert_normals_cache.ensure([&](Vector<float3> &r_data) { r_data = vert_normals; });
+  mesh.runtime->vert_normals_cache.ensure([&](Vector<float3> &r_data) {
+    r_data = vert_normals;
+    mesh.runtime->vert_normals_assigned = true;
+  });
 }
 
 void mesh_vert_normals_assign(Mesh &mesh, Vector<float3> vert_normals)
 {
-  mesh.runtime->vert_normals_cache.ensure(
-      [&](Vector<float3> &r_data) { r_data = std::move(vert_normals); });
+  mesh.runtime->vert_normals_cache.ensure([&](Vector<float3> &r_data) {
+    r_data = std::move(vert_normals);
+    mesh.runtime->vert_normals_assigned = true;
+  });
 }
 
 }  // namespace blender::bke
@@ -145,47 +151,69 @@ float3 face_normal_calc(const Span<float3> vert_positions, const Span<int> face_
 void normals_calc_faces(const Span<float3> positions,
                         const OffsetIndices<int> faces,
                         const Span<int> corner_verts,
+                        const IndexMask &mask,
                         MutableSpan<float3> face_normals)
 {
   BLI_assert(faces.size() == face_normals.size());
-  threading::parallel_for(faces.index_range(), 1024, [&](const IndexRange range) {
-    for (const int i : range) {
-      face_normals[i] = normal_calc_ngon(positions, corner_verts.slice(faces[i]));
-    }
+  mask.foreach_index(GrainSize(1024), [&](const int i) {
+    face_normals[i] = normal_calc_ngon(positions, corner_verts.slice(faces[i]));
   });
 }
 
+void normals_calc_faces(const Span<float3> positions,
+                        const OffsetIndices<int> faces,
+                        const Span<int> corner_verts,
+                        MutableSpan<float3> face_normals)
+{
+  normals_calc_faces(positions, faces, corner_verts, faces.index_range(), face_normals);
+}
+
 void normals_calc_verts(const Span<float3> vert_positions,
                         const OffsetIndices<int> faces,
                         const Span<int> corner_verts,
                         const GroupedSpan<int> vert_to_face_map,
                         const Span<float3> face_normals,
+                        const IndexMask &mask,
                         MutableSpan<float3> vert_normals)
 {
   const Span<float3> positions = vert_positions;
-  threading::parallel_for(positions.index_range(), 1024, [&](const IndexRange range) {
-    for (const int vert : range) {
-      const Span<int> vert_faces = vert_to_face_map[vert];
-      if (vert_faces.is_empty()) {
-        vert_normals[vert] = math::normalize(positions[vert]);
-        continue;
-      }
-
-      float3 vert_normal(0);
-      for (const int face : vert_faces) {
-        const int2 adjacent_verts = face_find_adjacent_verts(faces[face], corner_verts, vert);
-        const float3 dir_prev = math::normalize(positions[adjacent_verts[0]] - positions[vert]);
-        const float3 dir_next = math::normalize(positions[adjacent_verts[1]] - positions[vert]);
-        const float factor = math::safe_acos_approx(math::dot(dir_prev, dir_next));
+  mask.foreach_index(GrainSize(1024), [&](const int vert) {
+    const Span<int> vert_faces = vert_to_face_map[vert];
+    if (vert_faces.is_empty()) {
+      vert_normals[vert] = math::normalize(positions[vert]);
+      return;
+    }
 
-        vert_normal += face_normals[face] * factor;
-      }
+    float3 vert_normal(0);
+    for (const int face : vert_faces) {
+      const int2 adjacent_verts = face_find_adjacent_verts(faces[face], corner_verts, vert);
+      const float3 dir_prev = math::normalize(positions[adjacent_verts[0]] - positions[vert]);
+      const float3 dir_next = math::normalize(positions[adjacent_verts[1]] - positions[vert]);
+      const float factor = math::safe_acos_approx(math::dot(dir_prev, dir_next));
 
-      vert_normals[vert] = math::normalize(vert_normal);
+      vert_normal += face_normals[face] * factor;
     }
+
+    vert_normals[vert] = math::normalize(vert_normal);
   });
 }
 
+void normals_calc_verts(const Span<float3> vert_positions,
+                        const OffsetIndices<int> faces,
+                        const Span<int> corner_verts,
+                        const GroupedSpan<int> vert_to_face_map,
+                        const Span<float3> face_normals,
+                        MutableSpan<float3> vert_normals)
+{
+  normals_calc_verts(vert_positions,
+                     faces,
+                     corner_verts,
+                     vert_to_face_map,
+                     face_normals,
+                     vert_positions.index_range(),
+                     vert_normals);
+}
+
 /** \} */
 
 }  // namespace blender::bke::mesh
@@ -257,6 +285,7 @@ blender::Span<blender::float3> Mesh::vert_normals() const
   this->runtime->vert_normals_cache.ensure([&](Vector<float3> &r_data) {
     r_data.reinitialize(positions.size());
     mesh::normals_calc_verts(positions, faces, corner_verts, vert_to_face, face_normals, r_data);
+    this->runtime->vert_normals_assigned = false;
   });
   return this->runtime->vert_normals_cache.data();
 }
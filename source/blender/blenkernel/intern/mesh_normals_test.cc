@@ -0,0 +1,148 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_index_mask.hh"
+
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_mesh.hh"
+
+namespace blender::bke::tests {
+
+/** Create a grid of `size` by `size` quads with a bumpy surface. */
+static Mesh *create_grid_mesh(const int size)
+{
+  const int verts_x = size + 1;
+  Mesh *mesh = BKE_mesh_new_nomain(verts_x * verts_x, 0, size * size, size * size * 4);
+  MutableSpan<float3> positions = mesh->vert_positions_for_write();
+  for (const int y : IndexRange(verts_x)) {
+    for (const int x : IndexRange(verts_x)) {
+      positions[y * verts_x + x] = float3(x, y, float((x * 7 + y * 3) % 5) * 0.1f);
+    }
+  }
+  MutableSpan<int> face_offsets = mesh->face_offsets_for_write();
+  MutableSpan<int> corner_verts = mesh->corner_verts_for_write();
+  for (const int y : IndexRange(size)) {
+    for (const int x : IndexRange(size)) {
+      const int face = y * size + x;
+      face_offsets[face] = face * 4;
+      corner_verts[face * 4 + 0] = y * verts_x + x;
+      corner_verts[face * 4 + 1] = y * verts_x + x + 1;
+      corner_verts[face * 4 + 2] = (y + 1) * verts_x + x + 1;
+      corner_verts[face * 4 + 3] = (y + 1) * verts_x + x;
+    }
+  }
+  face_offsets.last() = size * size * 4;
+  mesh_calc_edges(*mesh, false, false);
+  return mesh;
+}
+
+static void expect_normals_match_full_calculation(const Mesh &mesh)
+{
+  Array<float3> face_normals(mesh.faces_num);
+  mesh::normals_calc_faces(mesh.vert_positions(), mesh.faces(), mesh.corner_verts(), face_normals);
+  Array<float3> vert_normals(mesh.verts_num);
+  mesh::normals_calc_verts(mesh.vert_positions(),
+                           mesh.faces(),
+                           mesh.corner_verts(),
+                           mesh.vert_to_face_map(),
+                           face_normals,
+                           vert_normals);
+  const Span<float3> cached_face_normals = mesh.face_normals();
+  for (const int i : face_normals.index_range()) {
+    EXPECT_V3_NEAR(cached_face_normals[i], face_normals[i], 1e-6f);
+  }
+  const Span<float3> cached_vert_normals = mesh.vert_normals();
+  for (const int i : vert_normals.index_range()) {
+    EXPECT_V3_NEAR(cached_vert_normals[i], vert_normals[i], 1e-6f);
+  }
+}
+
+TEST(mesh_normals, PartialUpdate)
+{
+  BKE_idtype_init();
+  Mesh *mesh = create_grid_mesh(20);
+  mesh->vert_normals();
+
+  IndexMaskMemory memory;
+  const IndexMask changed_verts = IndexMask::from_indices<int>({0, 50, 51, 200}, memory);
+  MutableSpan<float3> positions = mesh->vert_positions_for_write();
+  changed_verts.foreach_index([&](const int i) { positions[i].z += 1.5f; });
+  mesh->tag_positions_changed(changed_verts);
+
+  /* The normals were updated without being tagged dirty. */
+  EXPECT_FALSE(BKE_mesh_face_normals_are_dirty(mesh));
+  EXPECT_FALSE(BKE_mesh_vert_normals_are_dirty(mesh));
+  expect_normals_match_full_calculation(*mesh);
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST(mesh_normals, PartialUpdateShared)
+{
+  BKE_idtype_init();
+  Mesh *mesh = create_grid_mesh(20);
+  mesh->vert_normals();
+  Mesh *copy = BKE_mesh_copy_for_eval(*mesh);
+
+  IndexMaskMemory memory;
+  const IndexMask changed_verts = IndexMask::from_indices<int>({30, 31}, memory);
+  MutableSpan<float3> positions = copy->vert_positions_for_write();
+  changed_verts.foreach_index([&](const int i) { positions[i] += float3(0.3f, -0.2f, 1.0f); });
+  copy->tag_positions_changed(changed_verts);
+
+  /* The normals of the original mesh are unchanged. */
+  expect_normals_match_full_calculation(*copy);
+  expect_normals_match_full_calculation(*mesh);
+
+  BKE_id_free(nullptr, copy);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST(mesh_normals, PartialUpdateLargeChange)
+{
+  BKE_idtype_init();
+  Mesh *mesh = create_grid_mesh(4);
+  mesh->vert_normals();
+
+  /* Changing many vertices falls back to recalculating all normals. */
+  MutableSpan<float3> positions = mesh->vert_positions_for_write();
+  for (float3 &position : positions) {
+    position.z *= 2.0f;
+  }
+  mesh->tag_positions_changed(positions.index_range());
+  EXPECT_TRUE(BKE_mesh_vert_normals_are_dirty(mesh));
+  expect_normals_match_full_calculation(*mesh);
+
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST(mesh_normals, PartialUpdateAssignedNormals)
+{
+  BKE_idtype_init();
+  Mesh *mesh = create_grid_mesh(20);
+  mesh->face_normals();
+  mesh_vert_normals_assign(*mesh, Array<float3>(mesh->verts_num, float3(0.0f, 0.0f, 1.0f)));
+
+  /* Assigned normals don't match the face normals, so they are all recalculated. */
+  IndexMaskMemory memory;
+  const IndexMask changed_verts = IndexMask::from_indices<int>({50}, memory);
+  mesh->vert_positions_for_write()[50].z += 1.0f;
+  mesh->tag_positions_changed(changed_verts);
+  EXPECT_TRUE(BKE_mesh_vert_normals_are_dirty(mesh));
+  expect_normals_match_full_calculation(*mesh);
+
+  /* Calculated normals can be updated partially again. */
+  mesh->vert_positions_for_write()[50].z -= 0.5f;
+  mesh->tag_positions_changed(changed_verts);
+  EXPECT_FALSE(BKE_mesh_vert_normals_are_dirty(mesh));
+  expect_normals_match_full_calculation(*mesh);
+
+  BKE_id_free(nullptr, mesh);
+}
+
+}  // namespace blender::bke::tests
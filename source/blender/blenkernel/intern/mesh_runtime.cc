@@ -9,6 +9,8 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_array_utils.hh"
+#include "BLI_bit_vector.hh"
+#include "BLI_index_mask.hh"
 #include "BLI_math_geom.h"
 #include "BLI_task.hh"
 
@@ -62,12 +64,43 @@ static void free_bvh_caches(MeshRuntime &mesh_runtime)
   mesh_runtime.bvh_cache_loose_edges_no_hidden.tag_dirty();
 }
 
+static void store_bvh_tree_for_refit(BVHRefitCache::Entry &entry,
+                                     std::unique_ptr<BVHTree, BVHTreeDeleter> tree)
+{
+  if (tree) {
+    entry.tree = std::move(tree);
+    entry.age = 0;
+  }
+  else if (entry.tree && ++entry.age > BVHRefitCache::max_age) {
+    entry.tree.reset();
+  }
+}
+
+/**
+ * Keep the trees that aren't shared with other meshes to refit them to new positions later,
+ * instead of freeing them. Stored trees of kinds this mesh didn't use get older and are freed
+ * eventually. Call before #free_bvh_caches when the topology doesn't change.
+ */
+static void store_bvh_trees_for_refit(MeshRuntime &mesh_runtime)
+{
+  BVHRefitCache &refit_cache = *mesh_runtime.bvh_refit_cache;
+  std::lock_guard lock{refit_cache.mutex};
+  store_bvh_tree_for_refit(refit_cache.verts, mesh_runtime.bvh_cache_verts.release());
+  store_bvh_tree_for_refit(refit_cache.edges, mesh_runtime.bvh_cache_edges.release());
+  store_bvh_tree_for_refit(refit_cache.corner_tris, mesh_runtime.bvh_cache_corner_tris.release());
+}
+
 MeshRuntime::MeshRuntime() = default;
 
 MeshRuntime::~MeshRuntime()
 {
   free_mesh_eval(*this);
   free_batch_cache(*this);
+  /* Evaluated copies are usually freed and created again from the same original mesh, which
+   * shares the refit cache. */
+  if (this->bvh_refit_cache.use_count() > 1) {
+    store_bvh_trees_for_refit(*this);
+  }
 }
 
 static int reset_bits_and_count(MutableBitSpan bits, const Span<int> indices_to_reset)
@@ -317,6 +350,7 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
 {
   /* Tagging shared caches dirty will free the allocated data if there is only one user. */
   free_bvh_caches(*mesh->runtime);
+  mesh->runtime->bvh_refit_cache = std::make_shared<blender::bke::BVHRefitCache>();
   mesh->runtime->subdiv_ccg.reset();
   mesh->runtime->bounds_cache.tag_dirty();
   mesh->runtime->vert_to_face_offset_cache.tag_dirty();
@@ -394,8 +428,69 @@ void Mesh::tag_positions_changed()
   this->tag_positions_changed_no_normals();
 }
 
+void Mesh::tag_positions_changed(const blender::IndexMask &changed_verts)
+{
+  using namespace blender;
+  using namespace blender::bke;
+  MeshRuntime &runtime = *this->runtime;
+  /* Updating the normals around the changed vertices has more overhead per element than
+   * recalculating all normals, so it is only worth it when a small part of the mesh changed.
+   * Assigned vertex normals may not match the face normals, which a partial update would mix
+   * with normals calculated from the faces. */
+  if (changed_verts.size() > this->verts_num / 8 || !runtime.face_normals_cache.is_cached() ||
+      (runtime.vert_normals_assigned && runtime.vert_normals_cache.is_cached()))
+  {
+    this->tag_positions_changed();
+    return;
+  }
+  if (changed_verts.is_empty()) {
+    return;
+  }
+
+  const Span<float3> positions = this->vert_positions();
+  const OffsetIndices faces = this->faces();
+  const Span<int> corner_verts = this->corner_verts();
+  const GroupedSpan<int> vert_to_face_map = this->vert_to_face_map();
+
+  IndexMaskMemory memory;
+  BitVector<> affected_faces(faces.size());
+  changed_verts.foreach_index([&](const int vert) {
+    for (const int face : vert_to_face_map[vert]) {
+      affected_faces[face].set();
+    }
+  });
+  const IndexMask face_mask = IndexMask::from_bits(affected_faces, memory);
+
+  runtime.face_normals_cache.update([&](Vector<float3> &r_data) {
+    mesh::normals_calc_faces(positions, faces, corner_verts, face_mask, r_data);
+  });
+
+  if (runtime.vert_normals_cache.is_cached()) {
+    /* Vertex normals depend on the normals of all faces that use them and on the positions of
+     * their neighbors, so the normals of every vertex of the changed faces must be updated. */
+    BitVector<> affected_verts(positions.size());
+    changed_verts.foreach_index([&](const int vert) { affected_verts[vert].set(); });
+    face_mask.foreach_index([&](const int face) {
+      for (const int vert : corner_verts.slice(faces[face])) {
+        affected_verts[vert].set();
+      }
+    });
+    const IndexMask vert_mask = IndexMask::from_bits(affected_verts, memory);
+    const Span<float3> face_normals = runtime.face_normals_cache.data();
+    runtime.vert_normals_cache.update([&](Vector<float3> &r_data) {
+      mesh::normals_calc_verts(
+          positions, faces, corner_verts, vert_to_face_map, face_normals, vert_mask, r_data);
+    });
+  }
+
+  runtime.corner_normals_cache.tag_dirty();
+  runtime.shrinkwrap_boundary_cache.tag_dirty();
+  this->tag_positions_changed_no_normals();
+}
+
 void Mesh::tag_positions_changed_no_normals()
 {
+  store_bvh_trees_for_refit(*this->runtime);
   free_bvh_caches(*this->runtime);
   this->runtime->corner_tris_cache.tag_dirty();
   this->runtime->bounds_cache.tag_dirty();
@@ -405,6 +500,7 @@ void Mesh::tag_positions_changed_no_normals()
 void Mesh::tag_positions_changed_uniformly()
 {
   /* The normals and triangulation didn't change, since all verts moved by the same amount. */
+  store_bvh_trees_for_refit(*this->runtime);
   free_bvh_caches(*this->runtime);
   this->runtime->bounds_cache.tag_dirty();
 }
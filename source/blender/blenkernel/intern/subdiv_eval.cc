@@ -10,6 +10,7 @@
 
 #include "BLI_math_vector.h"
 #include "BLI_task.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 
 #include "BKE_customdata.hh"
@@ -18,6 +19,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.hh"
 #include "opensubdiv_evaluator_capi.hh"
 #ifdef WITH_OPENSUBDIV
 #  include "opensubdiv_evaluator.hh"
@@ -396,4 +398,29 @@ void eval_final_point(
   }
 }
 
+/* --------------------------------------------------------------------
+ * Batched queries.
+ */
+
+void eval_limit_points(Subdiv *subdiv,
+                       const Span<OpenSubdiv_PatchCoord> patch_coords,
+                       MutableSpan<float3> r_positions)
+{
+  BLI_assert(patch_coords.size() == r_positions.size());
+#ifdef WITH_OPENSUBDIV
+  /* Every chunk is evaluated with a single call. Chunks of this size don't need a heap allocation
+   * for the patch lookup in the evaluator. */
+  threading::parallel_for(patch_coords.index_range(), 1024, [&](const IndexRange range) {
+    subdiv->evaluator->eval_output->evaluatePatchesLimit(
+        patch_coords.slice(range).data(),
+        int(range.size()),
+        reinterpret_cast<float *>(r_positions.slice(range).data()),
+        nullptr,
+        nullptr);
+  });
+#else
+  UNUSED_VARS(subdiv, patch_coords, r_positions);
+#endif
+}
+
 }  // namespace blender::bke::subdiv
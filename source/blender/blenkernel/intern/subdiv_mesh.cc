@@ -12,6 +12,8 @@
 #include "DNA_mesh_types.h"
 
 #include "BLI_array.hh"
+#include "BLI_array_utils.hh"
+#include "BLI_index_mask.hh"
 #include "BLI_math_vector.h"
 #include "BLI_math_vector.hh"
 #include "BLI_math_vector_types.hh"
@@ -29,6 +31,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_capi_type.hh"
+
 namespace blender::bke::subdiv {
 
 /* -------------------------------------------------------------------- */
@@ -79,6 +83,14 @@ struct SubdivMeshContext {
   int *accumulated_counters;
   bool have_displacement;
 
+  /**
+   * Without displacement the traversal only stores the patch coordinate of every vertex, and the
+   * positions of all vertices are evaluated at once afterwards. Vertices of loose geometry are
+   * not on the limit surface, their ptex face index is negative.
+   */
+  bool use_batched_evaluation;
+  Array<OpenSubdiv_PatchCoord> vert_patch_coords;
+
   /* Write optimal display edge tags into a boolean array rather than the final bit vector
    * to avoid race conditions when setting bits. */
   Array<bool> subdiv_display_edges;
@@ -124,6 +136,18 @@ static void subdiv_mesh_ctx_cache_custom_data_layers(SubdivMeshContext *ctx)
       &subdiv_mesh->vert_data, CD_CLOTH_ORCO, subdiv_mesh->verts_num));
 }
 
+static void subdiv_mesh_prepare_batched_evaluation(SubdivMeshContext *ctx, int num_vertices)
+{
+  if (!ctx->use_batched_evaluation) {
+    return;
+  }
+  OpenSubdiv_PatchCoord no_patch_coord;
+  no_patch_coord.ptex_face = -1;
+  no_patch_coord.u = 0.0f;
+  no_patch_coord.v = 0.0f;
+  ctx->vert_patch_coords = Array<OpenSubdiv_PatchCoord>(num_vertices, no_patch_coord);
+}
+
 static void subdiv_mesh_prepare_accumulator(SubdivMeshContext *ctx, int num_vertices)
 {
   if (!ctx->have_displacement) {
@@ -495,6 +519,48 @@ static void subdiv_vertex_orco_evaluate(const SubdivMeshContext *ctx,
   }
 }
 
+/**
+ * Evaluate the position of a vertex on the limit surface, or only store its patch coordinate
+ * with batched evaluation.
+ */
+static void subdiv_mesh_eval_limit_point(SubdivMeshContext *ctx,
+                                         const int ptex_face_index,
+                                         const float u,
+                                         const float v,
+                                         const int subdiv_vertex_index)
+{
+  if (ctx->use_batched_evaluation) {
+    OpenSubdiv_PatchCoord &patch_coord = ctx->vert_patch_coords[subdiv_vertex_index];
+    patch_coord.ptex_face = ptex_face_index;
+    patch_coord.u = u;
+    patch_coord.v = v;
+  }
+  else {
+    eval_limit_point(
+        ctx->subdiv, ptex_face_index, u, v, ctx->subdiv_positions[subdiv_vertex_index]);
+  }
+}
+
+/** Evaluate the positions of all vertices with a stored patch coordinate. */
+static void subdiv_mesh_eval_limit_points_batched(SubdivMeshContext *ctx)
+{
+  const Span<OpenSubdiv_PatchCoord> patch_coords = ctx->vert_patch_coords;
+  IndexMaskMemory memory;
+  const IndexMask mask = IndexMask::from_predicate(
+      patch_coords.index_range(), GrainSize(4096), memory, [&](const int64_t i) {
+        return patch_coords[i].ptex_face >= 0;
+      });
+  if (mask.size() == patch_coords.size()) {
+    eval_limit_points(ctx->subdiv, patch_coords, ctx->subdiv_positions);
+    return;
+  }
+  Array<OpenSubdiv_PatchCoord> masked_patch_coords(mask.size());
+  array_utils::gather(patch_coords, mask, masked_patch_coords.as_mutable_span());
+  Array<float3> positions(mask.size());
+  eval_limit_points(ctx->subdiv, masked_patch_coords, positions);
+  array_utils::scatter(positions.as_span(), mask, ctx->subdiv_positions);
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -585,6 +651,7 @@ static bool subdiv_mesh_topology_info(const ForeachContext *foreach_context,
 
   subdiv_mesh_ctx_cache_custom_data_layers(subdiv_context);
   subdiv_mesh_prepare_accumulator(subdiv_context, num_vertices);
+  subdiv_mesh_prepare_batched_evaluation(subdiv_context, num_vertices);
   subdiv_mesh.runtime->subsurf_face_dot_tags.clear();
   subdiv_mesh.runtime->subsurf_face_dot_tags.resize(num_vertices);
   if (subdiv_context->settings->use_optimal_display) {
@@ -630,7 +697,7 @@ static void subdiv_vertex_data_interpolate(const SubdivMeshContext *ctx,
   }
 }
 
-static void evaluate_vertex_and_apply_displacement_copy(const SubdivMeshContext *ctx,
+static void evaluate_vertex_and_apply_displacement_copy(SubdivMeshContext *ctx,
                                                         const int ptex_face_index,
                                                         const float u,
                                                         const float v,
@@ -648,9 +715,12 @@ static void evaluate_vertex_and_apply_displacement_copy(const SubdivMeshContext
   }
   /* Copy custom data and evaluate position. */
   subdiv_vertex_data_copy(ctx, coarse_vertex_index, subdiv_vertex_index);
-  eval_limit_point(ctx->subdiv, ptex_face_index, u, v, subdiv_position);
-  /* Apply displacement. */
-  subdiv_position += D;
+  subdiv_mesh_eval_limit_point(ctx, ptex_face_index, u, v, subdiv_vertex_index);
+  /* Apply displacement. With batched evaluation the position is only written later and there is
+   * no displacement, so it must not be read here. */
+  if (!ctx->use_batched_evaluation) {
+    subdiv_position += D;
+  }
   /* Evaluate undeformed texture coordinate. */
   subdiv_vertex_orco_evaluate(ctx, ptex_face_index, u, v, subdiv_vertex_index);
   /* Remove face-dot flag. This can happen if there is more than one subsurf modifier. */
@@ -658,7 +728,7 @@ static void evaluate_vertex_and_apply_displacement_copy(const SubdivMeshContext
 }
 
 static void evaluate_vertex_and_apply_displacement_interpolate(
-    const SubdivMeshContext *ctx,
+    SubdivMeshContext *ctx,
     const int ptex_face_index,
     const float u,
     const float v,
@@ -676,9 +746,11 @@ static void evaluate_vertex_and_apply_displacement_interpolate(
   }
   /* Interpolate custom data and evaluate position. */
   subdiv_vertex_data_interpolate(ctx, subdiv_vertex_index, vertex_interpolation, u, v);
-  eval_limit_point(ctx->subdiv, ptex_face_index, u, v, subdiv_position);
-  /* Apply displacement. */
-  add_v3_v3(subdiv_position, D);
+  subdiv_mesh_eval_limit_point(ctx, ptex_face_index, u, v, subdiv_vertex_index);
+  /* Apply displacement, see #evaluate_vertex_and_apply_displacement_copy. */
+  if (!ctx->use_batched_evaluation) {
+    add_v3_v3(subdiv_position, D);
+  }
   /* Evaluate undeformed texture coordinate. */
   subdiv_vertex_orco_evaluate(ctx, ptex_face_index, u, v, subdiv_vertex_index);
 }
@@ -832,7 +904,12 @@ static void subdiv_mesh_vertex_inner(const ForeachContext *foreach_context,
   float3 &subdiv_position = ctx->subdiv_positions[subdiv_vertex_index];
   subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_face_index, coarse_corner);
   subdiv_vertex_data_interpolate(ctx, subdiv_vertex_index, &tls->vertex_interpolation, u, v);
-  eval_final_point(subdiv, ptex_face_index, u, v, subdiv_position);
+  if (ctx->have_displacement) {
+    eval_final_point(subdiv, ptex_face_index, u, v, subdiv_position);
+  }
+  else {
+    subdiv_mesh_eval_limit_point(ctx, ptex_face_index, u, v, subdiv_vertex_index);
+  }
   subdiv_mesh_tag_center_vertex(coarse_face, subdiv_vertex_index, u, v, subdiv_mesh);
   subdiv_vertex_orco_evaluate(ctx, ptex_face_index, u, v, subdiv_vertex_index);
 }
@@ -1192,6 +1269,8 @@ Mesh *subdiv_to_mesh(Subdiv *subdiv, const ToMeshSettings *settings, const Mesh
 
   subdiv_context.subdiv = subdiv;
   subdiv_context.have_displacement = (subdiv->displacement_evaluator != nullptr);
+  subdiv_context.use_batched_evaluation = !subdiv_context.have_displacement &&
+                                          coarse_mesh->faces_num != 0;
   /* Multi-threaded traversal/evaluation. */
   stats_begin(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
   ForeachContext foreach_context;
@@ -1201,6 +1280,9 @@ Mesh *subdiv_to_mesh(Subdiv *subdiv, const ToMeshSettings *settings, const Mesh
   foreach_context.user_data_tls_size = sizeof(SubdivMeshTLS);
   foreach_context.user_data_tls = &tls;
   foreach_subdiv_geometry(subdiv, &foreach_context, settings, coarse_mesh);
+  if (subdiv_context.use_batched_evaluation) {
+    subdiv_mesh_eval_limit_points_batched(&subdiv_context);
+  }
   stats_end(&subdiv->stats, SUBDIV_STATS_SUBDIV_TO_MESH_GEOMETRY);
   Mesh *result = subdiv_context.subdiv_mesh;
 
@@ -0,0 +1,257 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_mesh.hh"
+#include "BKE_mesh_mapping.hh"
+#include "BKE_subdiv.hh"
+#include "BKE_subdiv_eval.hh"
+#include "BKE_subdiv_foreach.hh"
+#include "BKE_subdiv_mesh.hh"
+
+#include "opensubdiv_capi_type.hh"
+
+namespace blender::bke::subdiv::tests {
+
+/**
+ * Create a bumpy grid of `size` by `size` quads, followed by one loose vertex and one loose edge
+ * so that all kinds of subdivided vertices are created.
+ */
+static Mesh *create_mesh_with_loose_geometry(const int size)
+{
+  const int verts_x = size + 1;
+  const int grid_verts_num = verts_x * verts_x;
+  Mesh *mesh = BKE_mesh_new_nomain(grid_verts_num + 3, 1, size * size, size * size * 4);
+  MutableSpan<float3> positions = mesh->vert_positions_for_write();
+  for (const int y : IndexRange(verts_x)) {
+    for (const int x : IndexRange(verts_x)) {
+      positions[y * verts_x + x] = float3(x, y, float((x * 7 + y * 3) % 5) * 0.1f);
+    }
+  }
+  positions[grid_verts_num + 0] = float3(-2.0f, -2.0f, 1.0f);
+  positions[grid_verts_num + 1] = float3(-3.0f, 0.0f, 0.5f);
+  positions[grid_verts_num + 2] = float3(-3.0f, 2.0f, -0.5f);
+  mesh->edges_for_write().first() = int2(grid_verts_num + 1, grid_verts_num + 2);
+  MutableSpan<int> face_offsets = mesh->face_offsets_for_write();
+  MutableSpan<int> corner_verts = mesh->corner_verts_for_write();
+  for (const int y : IndexRange(size)) {
+    for (const int x : IndexRange(size)) {
+      const int face = y * size + x;
+      face_offsets[face] = face * 4;
+      corner_verts[face * 4 + 0] = y * verts_x + x;
+      corner_verts[face * 4 + 1] = y * verts_x + x + 1;
+      corner_verts[face * 4 + 2] = (y + 1) * verts_x + x + 1;
+      corner_verts[face * 4 + 3] = (y + 1) * verts_x + x;
+    }
+  }
+  face_offsets.last() = size * size * 4;
+  mesh_calc_edges(*mesh, true, false);
+  return mesh;
+}
+
+/** Where a subdivided vertex comes from, recorded by a geometry traversal. */
+struct VertexSource {
+  Vector<OpenSubdiv_PatchCoord> patch_coords;
+  /** Index of the coarse vertex for loose vertices, -1 otherwise. */
+  Vector<int> loose_verts;
+  /** Coarse edge index and parameter for vertices created on loose edges. */
+  Vector<int> loose_edges;
+  Vector<float> loose_edge_factors;
+};
+
+static bool record_topology_info(const ForeachContext *context,
+                                 const int num_vertices,
+                                 const int /*num_edges*/,
+                                 const int /*num_loops*/,
+                                 const int /*num_faces*/,
+                                 const int * /*subdiv_face_offset*/)
+{
+  VertexSource &source = *static_cast<VertexSource *>(context->user_data);
+  source.patch_coords.resize(num_vertices, OpenSubdiv_PatchCoord{-1, 0.0f, 0.0f});
+  source.loose_verts.resize(num_vertices, -1);
+  source.loose_edges.resize(num_vertices, -1);
+  source.loose_edge_factors.resize(num_vertices, 0.0f);
+  return true;
+}
+
+static void record_patch_coord(const ForeachContext *context,
+                               const int ptex_face_index,
+                               const float u,
+                               const float v,
+                               const int subdiv_vertex_index)
+{
+  VertexSource &source = *static_cast<VertexSource *>(context->user_data);
+  source.patch_coords[subdiv_vertex_index] = OpenSubdiv_PatchCoord{ptex_face_index, u, v};
+}
+
+static void record_vertex_corner(const ForeachContext *context,
+                                 void * /*tls*/,
+                                 const int ptex_face_index,
+                                 const float u,
+                                 const float v,
+                                 const int /*coarse_vertex_index*/,
+                                 const int /*coarse_face_index*/,
+                                 const int /*coarse_corner*/,
+                                 const int subdiv_vertex_index)
+{
+  record_patch_coord(context, ptex_face_index, u, v, subdiv_vertex_index);
+}
+
+static void record_vertex_edge(const ForeachContext *context,
+                               void * /*tls*/,
+                               const int ptex_face_index,
+                               const float u,
+                               const float v,
+                               const int /*coarse_edge_index*/,
+                               const int /*coarse_face_index*/,
+                               const int /*coarse_corner*/,
+                               const int subdiv_vertex_index)
+{
+  record_patch_coord(context, ptex_face_index, u, v, subdiv_vertex_index);
+}
+
+static void record_vertex_inner(const ForeachContext *context,
+                                void * /*tls*/,
+                                const int ptex_face_index,
+                                const float u,
+                                const float v,
+                                const int /*coarse_face_index*/,
+                                const int /*coarse_corner*/,
+                                const int subdiv_vertex_index)
+{
+  record_patch_coord(context, ptex_face_index, u, v, subdiv_vertex_index);
+}
+
+static void record_vertex_loose(const ForeachContext *context,
+                                void * /*tls*/,
+                                const int coarse_vertex_index,
+                                const int subdiv_vertex_index)
+{
+  VertexSource &source = *static_cast<VertexSource *>(context->user_data);
+  source.loose_verts[subdiv_vertex_index] = coarse_vertex_index;
+}
+
+static void record_vertex_of_loose_edge(const ForeachContext *context,
+                                        void * /*tls*/,
+                                        const int coarse_edge_index,
+                                        const float u,
+                                        const int subdiv_vertex_index)
+{
+  VertexSource &source = *static_cast<VertexSource *>(context->user_data);
+  source.loose_edges[subdiv_vertex_index] = coarse_edge_index;
+  source.loose_edge_factors[subdiv_vertex_index] = u;
+}
+
+static Settings create_settings()
+{
+  Settings settings{};
+  settings.is_simple = false;
+  settings.is_adaptive = false;
+  settings.level = 3;
+  settings.use_creases = false;
+  settings.vtx_boundary_interpolation = SUBDIV_VTX_BOUNDARY_EDGE_ONLY;
+  settings.fvar_linear_interpolation = SUBDIV_FVAR_LINEAR_INTERPOLATION_BOUNDARIES;
+  return settings;
+}
+
+/**
+ * The subdivided mesh evaluates all limit positions in one batch, compare them against separate
+ * per-point evaluation of the same patch coordinates.
+ */
+TEST(subdiv_mesh, batched_positions_match_per_point)
+{
+  BKE_idtype_init();
+  Mesh *coarse_mesh = create_mesh_with_loose_geometry(4);
+  const Settings settings = create_settings();
+  Subdiv *subdiv = new_from_mesh(&settings, coarse_mesh);
+  if (subdiv == nullptr) {
+    BKE_id_free(nullptr, coarse_mesh);
+    GTEST_SKIP() << "Subdivision surfaces are not available without OpenSubdiv";
+  }
+  ToMeshSettings mesh_settings{};
+  mesh_settings.resolution = (1 << settings.level) + 1;
+  mesh_settings.use_optimal_display = false;
+  Mesh *result = subdiv_to_mesh(subdiv, &mesh_settings, coarse_mesh);
+  ASSERT_NE(result, nullptr);
+
+  VertexSource source;
+  ForeachContext foreach_context{};
+  foreach_context.topology_info = record_topology_info;
+  foreach_context.vertex_corner = record_vertex_corner;
+  foreach_context.vertex_edge = record_vertex_edge;
+  foreach_context.vertex_inner = record_vertex_inner;
+  foreach_context.vertex_loose = record_vertex_loose;
+  foreach_context.vertex_of_loose_edge = record_vertex_of_loose_edge;
+  foreach_context.user_data = &source;
+  EXPECT_TRUE(foreach_subdiv_geometry(subdiv, &foreach_context, &mesh_settings, coarse_mesh));
+  ASSERT_EQ(source.patch_coords.size(), result->verts_num);
+
+  const Span<float3> coarse_positions = coarse_mesh->vert_positions();
+  const Span<int2> coarse_edges = coarse_mesh->edges();
+  Array<int> vert_to_edge_offsets;
+  Array<int> vert_to_edge_indices;
+  const GroupedSpan<int> vert_to_edge_map = mesh::build_vert_to_edge_map(
+      coarse_edges, coarse_mesh->verts_num, vert_to_edge_offsets, vert_to_edge_indices);
+
+  const Span<float3> positions = result->vert_positions();
+  int face_verts_num = 0;
+  int loose_verts_num = 0;
+  int loose_edge_verts_num = 0;
+  for (const int i : positions.index_range()) {
+    const OpenSubdiv_PatchCoord &patch_coord = source.patch_coords[i];
+    if (patch_coord.ptex_face >= 0) {
+      float3 expected;
+      eval_limit_point(subdiv, patch_coord.ptex_face, patch_coord.u, patch_coord.v, expected);
+      EXPECT_V3_NEAR(positions[i], expected, 1e-5f);
+      face_verts_num++;
+    }
+    else if (source.loose_edges[i] != -1) {
+      const float3 expected = mesh_interpolate_position_on_edge(coarse_positions,
+                                                                coarse_edges,
+                                                                vert_to_edge_map,
+                                                                source.loose_edges[i],
+                                                                settings.is_simple,
+                                                                source.loose_edge_factors[i]);
+      EXPECT_V3_NEAR(positions[i], expected, 1e-5f);
+      loose_edge_verts_num++;
+    }
+    else {
+      ASSERT_NE(source.loose_verts[i], -1);
+      EXPECT_V3_NEAR(positions[i], coarse_positions[source.loose_verts[i]], 1e-6f);
+      loose_verts_num++;
+    }
+  }
+  EXPECT_GT(face_verts_num, 0);
+  /* The loose vertex and both ends of the loose edge. */
+  EXPECT_EQ(loose_verts_num, 3);
+  EXPECT_GT(loose_edge_verts_num, 0);
+
+  /* Batched evaluation of arbitrary coordinates in the order they were traversed. */
+  Vector<OpenSubdiv_PatchCoord> patch_coords;
+  for (const OpenSubdiv_PatchCoord &patch_coord : source.patch_coords) {
+    if (patch_coord.ptex_face >= 0) {
+      patch_coords.append(patch_coord);
+    }
+  }
+  Array<float3> batched_positions(patch_coords.size());
+  eval_limit_points(subdiv, patch_coords, batched_positions);
+  for (const int i : patch_coords.index_range()) {
+    float3 expected;
+    eval_limit_point(
+        subdiv, patch_coords[i].ptex_face, patch_coords[i].u, patch_coords[i].v, expected);
+    EXPECT_V3_NEAR(batched_positions[i], expected, 1e-6f);
+  }
+
+  BKE_id_free(nullptr, result);
+  free(subdiv);
+  BKE_id_free(nullptr, coarse_mesh);
+}
+
+}  // namespace blender::bke::subdiv::tests
@@ -155,6 +155,11 @@ class GridReadKey : public GenericKey {
   {
     return std::make_unique<GridReadKey>(*this);
   }
+
+  const char *type_name() const override
+  {
+    return "Volume Grid";
+  }
 };
 
 class GridReadValue : public memory_cache::CachedValue {
@@ -376,7 +376,7 @@ class Array {
    * Get the value of the InlineBufferCapacity template argument. This is the number of elements
    * that can be stored without doing an allocation.
    */
-  static int64_t inline_buffer_capacity()
+  static constexpr int64_t inline_buffer_capacity()
   {
     return InlineBufferCapacity;
   }
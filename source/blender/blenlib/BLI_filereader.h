@@ -32,12 +32,27 @@ struct FileReader;
 typedef int64_t (*FileReaderReadFn)(struct FileReader *reader, void *buffer, size_t size);
 typedef off64_t (*FileReaderSeekFn)(struct FileReader *reader, off64_t offset, int whence);
 typedef void (*FileReaderCloseFn)(struct FileReader *reader);
+typedef const void *(*FileReaderPeekFn)(struct FileReader *reader, off64_t offset, size_t size);
+typedef bool (*FileReaderPeekHasErrorFn)(struct FileReader *reader);
 
 /** General structure for all #FileReaders, implementations add custom fields at the end. */
 typedef struct FileReader {
   FileReaderReadFn read;
   FileReaderSeekFn seek;
   FileReaderCloseFn close;
+  /**
+   * Optional: access `size` bytes at `offset` without copying them, for readers that have the
+   * whole file available in memory (memory buffers and memory-mapped files).
+   * The returned pointer stays valid until the reader is closed.
+   * Returns NULL when the data can't be accessed directly, callers then fall back to #read.
+   */
+  FileReaderPeekFn peek;
+  /**
+   * Optional, for readers with #peek where accessing the returned memory can fail later, e.g. an
+   * IO error while reading a memory-mapped file, which replaces the data with zeroes. Data that
+   * was used directly from peeked memory is only valid if this still returns false afterwards.
+   */
+  FileReaderPeekHasErrorFn peek_has_error;
 
   off64_t offset;
 } FileReader;
@@ -59,6 +74,14 @@ FileReader *BLI_filereader_new_memory(const void *data, size_t len) ATTR_WARN_UN
     ATTR_NONNULL();
 /** Create #FileReader from applying `Zstd` decompression on an underlying file. */
 FileReader *BLI_filereader_new_zstd(FileReader *base) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+/**
+ * Same as #BLI_filereader_new_zstd, but when the file uses the seekable format and frames are
+ * read in order, they are decompressed in parallel on the task scheduler ahead of the read
+ * position. Seeking to another frame decompresses only that frame until reading is sequential
+ * again. Memory use is bounded by a fixed read-ahead window of frames.
+ */
+FileReader *BLI_filereader_new_zstd_parallel(FileReader *base) ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL();
 /** Create #FileReader from applying `Gzip` decompression on an underlying file. */
 FileReader *BLI_filereader_new_gzip(FileReader *base) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
 
@@ -9,6 +9,7 @@
  */
 
 #include <memory>
+#include <typeinfo>
 
 #include "BLI_utildefines.h"
 
@@ -42,6 +43,15 @@ class GenericKey {
    */
   virtual std::unique_ptr<GenericKey> to_storable() const = 0;
 
+  /**
+   * Name of the kind of key, used to group statistics of keys with the same type. Subclasses
+   * should return a human readable name, the default is the (compiler specific) C++ type name.
+   */
+  virtual const char *type_name() const
+  {
+    return typeid(*this).name();
+  }
+
   friend bool operator==(const GenericKey &a, const GenericKey &b)
   {
     const bool are_equal = a.equal_to(b);
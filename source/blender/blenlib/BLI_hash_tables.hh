@@ -12,7 +12,10 @@
 
 #include <algorithm>
 
+#include "BLI_array.hh"
+#include "BLI_math_bits.h"
 #include "BLI_memory_utils.hh"
+#include "BLI_simd.hh"
 #include "BLI_utildefines.h"
 #include "BLI_vector.hh"
 
@@ -111,6 +114,238 @@ class LoadFactor {
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Group Control Bytes
+ *
+ * Hash tables using #GroupProbingStrategy store one control byte per slot next to the slot array.
+ * The byte is #GroupControlBytes::empty or #GroupControlBytes::removed, or it contains 7 bits of
+ * the hash when the slot is occupied. Slots are probed in aligned groups of 16, whose control
+ * bytes are compared with a single SSE2 instruction. Only slots whose control byte matches the
+ * hash have to be compared with the key.
+ *
+ * The slots themselves still keep track of their state, so that iteration and the slot types
+ * don't have to change.
+ *
+ * \{ */
+
+class GroupProbingSequence {
+ public:
+  static constexpr int64_t group_size = 16;
+  static constexpr uint8_t empty = 0x80;
+  /** Also used to pad the control bytes when there are fewer slots than a group. */
+  static constexpr uint8_t removed = 0xFE;
+
+ private:
+  const uint8_t *control_bytes_;
+  uint64_t group_mask_;
+  uint64_t group_;
+  uint64_t step_ = 0;
+  uint8_t hash_bits_;
+
+ public:
+  class CandidateIterator {
+   private:
+    int64_t group_start_;
+    uint32_t candidates_;
+
+   public:
+    CandidateIterator(const int64_t group_start, const uint32_t candidates)
+        : group_start_(group_start), candidates_(candidates)
+    {
+    }
+
+    int64_t operator*() const
+    {
+      return group_start_ + int64_t(bitscan_forward_uint(candidates_));
+    }
+
+    CandidateIterator &operator++()
+    {
+      /* Clear the lowest set bit. */
+      candidates_ &= candidates_ - 1;
+      return *this;
+    }
+
+    friend bool operator!=(const CandidateIterator &a, const CandidateIterator &b)
+    {
+      return a.candidates_ != b.candidates_;
+    }
+  };
+
+  struct Candidates {
+    CandidateIterator begin_;
+    CandidateIterator end_;
+
+    CandidateIterator begin() const
+    {
+      return begin_;
+    }
+    CandidateIterator end() const
+    {
+      return end_;
+    }
+  };
+
+  GroupProbingSequence(const uint8_t *control_bytes,
+                       const uint64_t group_mask,
+                       const uint64_t hash)
+      : control_bytes_(control_bytes), group_mask_(group_mask)
+  {
+    const uint64_t mixed_hash = mix_hash(hash);
+    group_ = (mixed_hash ^ (mixed_hash >> 32)) & group_mask;
+    hash_bits_ = control_byte_from_mixed_hash(mixed_hash);
+  }
+
+  /**
+   * The candidates of a group are the slots whose control byte matches the hash and the first
+   * empty slot. Since keys are always added to the first empty slot of the sequence and slots
+   * never become empty again, matching slots after the first empty slot can't contain the key.
+   */
+  Candidates candidates() const
+  {
+    const uint8_t *group = control_bytes_ + group_ * group_size;
+    uint32_t candidates = match_byte(group, hash_bits_);
+    const uint32_t empty_slots = match_byte(group, empty);
+    if (empty_slots != 0) {
+      const uint32_t first_empty_slot = empty_slots & (~empty_slots + 1);
+      candidates = (candidates & (first_empty_slot - 1)) | first_empty_slot;
+    }
+    const int64_t group_start = int64_t(group_ * group_size);
+    return {CandidateIterator(group_start, candidates), CandidateIterator(group_start, 0)};
+  }
+
+  /** Return the first empty slot of the current group or -1. */
+  int64_t first_empty_slot() const
+  {
+    const uint32_t empty_slots = match_byte(control_bytes_ + group_ * group_size, empty);
+    if (empty_slots == 0) {
+      return -1;
+    }
+    return int64_t(group_ * group_size + bitscan_forward_uint(empty_slots));
+  }
+
+  /**
+   * Triangular number steps visit every group when the number of groups is a power of two.
+   */
+  void next()
+  {
+    step_++;
+    group_ = (group_ + step_) & group_mask_;
+  }
+
+  /**
+   * Many hash functions in Blender are trivial (e.g. for integers), so the hash is mixed before
+   * the group index and control byte are extracted from it.
+   */
+  static uint64_t mix_hash(const uint64_t hash)
+  {
+    return hash * 0x9E3779B97F4A7C15;
+  }
+
+  static uint8_t control_byte_from_mixed_hash(const uint64_t mixed_hash)
+  {
+    return uint8_t(mixed_hash >> 57);
+  }
+
+  /** Return a bit mask of the bytes in the group that are equal to the given value. */
+  static uint32_t match_byte(const uint8_t *group, const uint8_t value)
+  {
+#if BLI_HAVE_SSE2
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+    return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(char(value)))));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < group_size; i++) {
+      mask |= uint32_t(group[i] == value) << i;
+    }
+    return mask;
+#endif
+  }
+};
+
+/**
+ * The control bytes of a hash table using #GroupProbingStrategy. There are at least as many bytes
+ * as in a group, so that small hash tables don't need special handling.
+ */
+template<int64_t InlineBufferCapacity, typename Allocator> class GroupControlBytes {
+ private:
+  static constexpr int64_t group_size = GroupProbingSequence::group_size;
+
+  Array<uint8_t, std::max(InlineBufferCapacity, group_size), Allocator> bytes_;
+  uint64_t group_mask_ = 0;
+
+ public:
+  GroupControlBytes(Allocator allocator = {}) noexcept : bytes_(allocator)
+  {
+    this->reset(1);
+  }
+
+  /** Mark all slots as empty. This only allocates when the number of slots changed. */
+  void reset(const int64_t total_slots)
+  {
+    const int64_t bytes_num = std::max(total_slots, group_size);
+    if (bytes_.size() != bytes_num) {
+      bytes_.reinitialize(bytes_num);
+    }
+    bytes_.as_mutable_span().take_front(total_slots).fill(GroupProbingSequence::empty);
+    bytes_.as_mutable_span().drop_front(total_slots).fill(GroupProbingSequence::removed);
+    group_mask_ = uint64_t(bytes_num / group_size) - 1;
+  }
+
+  void set_occupied(const int64_t slot_index, const uint64_t hash)
+  {
+    bytes_[slot_index] = GroupProbingSequence::control_byte_from_mixed_hash(
+        GroupProbingSequence::mix_hash(hash));
+  }
+
+  void set_removed(const int64_t slot_index)
+  {
+    bytes_[slot_index] = GroupProbingSequence::removed;
+  }
+
+  GroupProbingSequence probe(const uint64_t hash) const
+  {
+    return GroupProbingSequence(bytes_.data(), group_mask_, hash);
+  }
+
+  /** Find the slot that a new key with the given hash is added to. */
+  int64_t find_empty_slot(const uint64_t hash) const
+  {
+    GroupProbingSequence probing_sequence = this->probe(hash);
+    while (true) {
+      const int64_t slot_index = probing_sequence.first_empty_slot();
+      if (slot_index != -1) {
+        return slot_index;
+      }
+      probing_sequence.next();
+    }
+  }
+
+  int64_t size_in_bytes() const
+  {
+    return bytes_.size();
+  }
+};
+
+/**
+ * Used instead of #GroupControlBytes when a hash table doesn't use #GroupProbingStrategy. All
+ * methods do nothing, so that the hash tables don't need special cases for this.
+ */
+template<typename Allocator> class NoGroupControlBytes {
+ public:
+  NoGroupControlBytes(Allocator /*allocator*/ = {}) noexcept {}
+
+  void reset(const int64_t /*total_slots*/) {}
+  void set_occupied(const int64_t /*slot_index*/, const uint64_t /*hash*/) {}
+  void set_removed(const int64_t /*slot_index*/) {}
+  int64_t size_in_bytes() const
+  {
+    return 0;
+  }
+};
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Intrusive Key Info
  *
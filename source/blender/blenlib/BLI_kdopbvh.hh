@@ -10,6 +10,7 @@
 
 #include "BLI_function_ref.hh"
 #include "BLI_math_vector.hh"
+#include "BLI_span.hh"
 #include "BLI_sys_types.h"
 
 struct BVHTree;
@@ -160,6 +161,30 @@ bool BLI_bvhtree_update_node(
  */
 void BLI_bvhtree_update_tree(BVHTree *tree);
 
+/**
+ * Sum of the surface areas of all branches relative to the surface area of the root, which is
+ * proportional to the expected cost of a query. Comparing it after #BLI_bvhtree_update_tree with
+ * the value after #BLI_bvhtree_balance tells how much the tree degraded and whether it should be
+ * built again. Returns zero for trees without the X, Y and Z axes.
+ */
+float BLI_bvhtree_surface_area_cost(const BVHTree *tree);
+
+/**
+ * Build an additional layout of the balanced tree with four or eight children per node, which
+ * lets #BLI_bvhtree_ray_cast, #BLI_bvhtree_ray_cast_all and #BLI_bvhtree_find_nearest test all
+ * children of a node at once with SIMD instructions. It uses about a third of the memory of
+ * the tree itself and is refit by #BLI_bvhtree_update_tree.
+ *
+ * Call after #BLI_bvhtree_balance().
+ *
+ * \param width: The number of children per node. Eight children are tested with AVX2, so they
+ * are only supported on CPUs with AVX2. Zero uses the widest layout supported by the CPU.
+ *
+ * \return false when the tree doesn't support the wide layout, which is the case for trees with
+ * more children per node than \a width or k-DOPs that don't include the X, Y and Z axes.
+ */
+bool BLI_bvhtree_build_wide(BVHTree *tree, int width = 0);
+
 /**
  * Use to check the total number of threads #BLI_bvhtree_overlap will use.
  *
@@ -310,6 +335,36 @@ extern const float bvhtree_kdop_axes[13][3];
 
 namespace blender {
 
+/**
+ * Cast many rays in parallel, see #BLI_bvhtree_ray_cast_ex.
+ *
+ * \param r_hits: Must be initialized by the caller like the hit passed to a single ray-cast,
+ * usually with an index of -1 and the maximum distance.
+ * \param callback: Must be thread-safe.
+ */
+void BLI_bvhtree_ray_cast_batch(const BVHTree &tree,
+                                Span<float3> origins,
+                                Span<float3> directions,
+                                float radius,
+                                MutableSpan<BVHTreeRayHit> r_hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag = BVH_RAYCAST_DEFAULT);
+
+/**
+ * Find the nearest elements of many positions in parallel, see #BLI_bvhtree_find_nearest_ex.
+ *
+ * \param r_nearest: Must be initialized by the caller like the nearest data passed to a single
+ * query, usually with an index of -1 and the maximum squared distance.
+ * \param callback: Must be thread-safe.
+ */
+void BLI_bvhtree_find_nearest_batch(const BVHTree &tree,
+                                    Span<float3> positions,
+                                    MutableSpan<BVHTreeNearest> r_nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    int flag = 0);
+
 using BVHTree_RayCastCallback_CPP =
     FunctionRef<void(int index, const BVHTreeRay &ray, BVHTreeRayHit &hit)>;
 
@@ -0,0 +1,298 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * A #LockFreeMap is a hash map that many threads can add keys to and look keys up in at the same
+ * time, without taking any locks. It is meant for parallel deduplication, where every thread
+ * looks up or adds many keys and the map is only read afterwards.
+ *
+ * Compared to #ConcurrentMap, it has these restrictions:
+ * - The maximum number of keys has to be known when the map is created. The map never grows, but
+ *   #try_lookup_or_add reports when it is full, so that callers can start over with a larger map
+ *   when the number of keys can only be estimated.
+ * - Keys can't be removed.
+ * - Values are not protected by the map. If multiple threads modify the same value, it has to be
+ *   synchronized separately, e.g. by using an atomic value type.
+ * - Constructing keys and values must not throw.
+ *
+ * The map uses open addressing with linear probing. Every slot has an atomic state byte that is
+ * empty, busy (while a thread is constructing the key and value), or 7 bits of the hash when the
+ * slot is occupied. A thread adding a key claims an empty slot with a single compare-and-swap. A
+ * thread that finds a busy slot waits until the key is constructed. This is very short, because
+ * no other code runs while a slot is busy.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <tuple>
+#include <utility>
+
+#include "BLI_array.hh"
+#include "BLI_hash.hh"
+#include "BLI_hash_tables.hh"
+#include "BLI_memory_utils.hh"
+#include "BLI_simd.hh"
+
+namespace blender {
+
+template<typename Key,
+         typename Value,
+         typename Hash = DefaultHash<Key>,
+         typename IsEqual = DefaultEquality<Key>,
+         typename Allocator = GuardedAllocator>
+class LockFreeMap {
+ public:
+  using size_type = int64_t;
+  using Item = std::pair<const Key, Value>;
+
+ private:
+  static constexpr uint8_t state_empty = 0x80;
+  static constexpr uint8_t state_busy = 0x81;
+
+  struct Slot {
+    std::atomic<uint8_t> state{state_empty};
+    TypedBuffer<Item> item;
+
+    ~Slot()
+    {
+      if (this->is_occupied(state.load(std::memory_order_relaxed))) {
+        item.ptr()->~Item();
+      }
+    }
+
+    static bool is_occupied(const uint8_t state)
+    {
+      return state < state_empty;
+    }
+  };
+
+  Array<Slot, 0, Allocator> slots_;
+  uint64_t slot_mask_;
+  int64_t max_size_;
+  /** Number of added keys. Only changed when a thread claims an empty slot. */
+  std::atomic<int64_t> size_ = 0;
+
+  BLI_NO_UNIQUE_ADDRESS Hash hash_;
+  BLI_NO_UNIQUE_ADDRESS IsEqual is_equal_;
+
+  template<typename ItemT> class BaseAccessor {
+   private:
+    ItemT *item_ = nullptr;
+
+    friend LockFreeMap;
+
+   public:
+    ItemT *operator->() const
+    {
+      return item_;
+    }
+  };
+
+ public:
+  /** Gives access to the key and value. Compatible with #ConcurrentMap::MutableAccessor. */
+  using MutableAccessor = BaseAccessor<Item>;
+  /** Gives access to the key and value. Compatible with #ConcurrentMap::ConstAccessor. */
+  using ConstAccessor = BaseAccessor<const Item>;
+
+  /**
+   * Create a map that can hold up to \a max_size keys. Only #try_lookup_or_add may be used to add
+   * more keys than that, all other functions assert.
+   */
+  explicit LockFreeMap(const int64_t max_size, Allocator allocator = {})
+      : slots_(total_slot_amount_for_usable_slots(std::max<int64_t>(max_size, 1), 1, 2),
+               allocator),
+        slot_mask_(uint64_t(slots_.size()) - 1),
+        max_size_(std::max<int64_t>(max_size, 1))
+  {
+  }
+
+  LockFreeMap(const LockFreeMap &other) = delete;
+  LockFreeMap &operator=(const LockFreeMap &other) = delete;
+
+  /**
+   * Add the key to the map if it does not exist yet. The value is default constructed in that
+   * case. The key-value-pair can be accessed through the accessor afterwards.
+   *
+   * \return True if the key was newly added.
+   */
+  bool add(MutableAccessor &accessor, const Key &key)
+  {
+    const std::pair<Item *, bool> result = this->lookup_or_add__impl(key, hash_(key));
+    BLI_assert(result.first != nullptr);
+    accessor.item_ = result.first;
+    return result.second;
+  }
+
+  /**
+   * Find the key-value-pair for the given key.
+   *
+   * \return True if the key was found.
+   */
+  bool lookup(MutableAccessor &accessor, const Key &key)
+  {
+    accessor.item_ = const_cast<Item *>(this->lookup_item__impl(key, hash_(key)));
+    return accessor.item_ != nullptr;
+  }
+  bool lookup(ConstAccessor &accessor, const Key &key) const
+  {
+    accessor.item_ = this->lookup_item__impl(key, hash_(key));
+    return accessor.item_ != nullptr;
+  }
+
+  /**
+   * Get the value for the key. If the key does not exist yet, it is added with a value that is
+   * constructed from the given arguments. Only the thread that adds the key constructs a value.
+   */
+  template<typename... ForwardValue>
+  Value &lookup_or_add(const Key &key, ForwardValue &&...value)
+  {
+    Value *result = this->try_lookup_or_add(key, std::forward<ForwardValue>(value)...);
+    BLI_assert(result != nullptr);
+    return *result;
+  }
+
+  /**
+   * Same as #lookup_or_add, but returns null instead of adding the key when the map already has
+   * as many keys as it was created for.
+   */
+  template<typename... ForwardValue>
+  Value *try_lookup_or_add(const Key &key, ForwardValue &&...value)
+  {
+    Item *item =
+        this->lookup_or_add__impl(key, hash_(key), std::forward<ForwardValue>(value)...).first;
+    return item ? &item->second : nullptr;
+  }
+
+  /** Get a pointer to the value of the key or null if the key doesn't exist. */
+  const Value *lookup_ptr(const Key &key) const
+  {
+    const Item *item = this->lookup_item__impl(key, hash_(key));
+    return item ? &item->second : nullptr;
+  }
+  Value *lookup_ptr(const Key &key)
+  {
+    Item *item = const_cast<Item *>(this->lookup_item__impl(key, hash_(key)));
+    return item ? &item->second : nullptr;
+  }
+
+  bool contains(const Key &key) const
+  {
+    return this->lookup_item__impl(key, hash_(key)) != nullptr;
+  }
+
+  /**
+   * Call the function for every key-value-pair. This must not be called while other threads add
+   * keys.
+   */
+  template<typename Fn> void foreach_item(const Fn &fn) const
+  {
+    for (const Slot &slot : slots_) {
+      if (Slot::is_occupied(slot.state.load(std::memory_order_acquire))) {
+        fn(slot.item.ptr()->first, slot.item.ptr()->second);
+      }
+    }
+  }
+
+  /** Number of stored keys. Keys that other threads add at the same time may be missing. */
+  int64_t count() const
+  {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  int64_t capacity() const
+  {
+    return slots_.size();
+  }
+
+ private:
+  static uint64_t mix_hash(const uint64_t hash)
+  {
+    return hash * 0x9E3779B97F4A7C15;
+  }
+
+  static uint8_t state_from_mixed_hash(const uint64_t mixed_hash)
+  {
+    return uint8_t(mixed_hash >> 57);
+  }
+
+  uint64_t first_slot_index(const uint64_t mixed_hash) const
+  {
+    return (mixed_hash ^ (mixed_hash >> 32)) & slot_mask_;
+  }
+
+  static uint8_t wait_while_busy(const Slot &slot, uint8_t state)
+  {
+    while (state == state_busy) {
+#if BLI_HAVE_SSE2
+      /* Let the other hyper-thread of the core run, it may be the one constructing the key. */
+      _mm_pause();
+#endif
+      state = slot.state.load(std::memory_order_acquire);
+    }
+    return state;
+  }
+
+  template<typename... ForwardValue>
+  std::pair<Item *, bool> lookup_or_add__impl(const Key &key,
+                                              const uint64_t hash,
+                                              ForwardValue &&...value)
+  {
+    const uint64_t mixed_hash = mix_hash(hash);
+    const uint8_t occupied_state = state_from_mixed_hash(mixed_hash);
+    uint64_t slot_index = this->first_slot_index(mixed_hash);
+    for ([[maybe_unused]] const int64_t i : slots_.index_range()) {
+      Slot &slot = slots_[int64_t(slot_index)];
+      uint8_t state = slot.state.load(std::memory_order_acquire);
+      if (state == state_empty) {
+        /* The key is not in the map, because it would be in a slot before the empty one. */
+        if (size_.fetch_add(1, std::memory_order_relaxed) >= max_size_) {
+          size_.fetch_sub(1, std::memory_order_relaxed);
+          return {nullptr, false};
+        }
+        if (slot.state.compare_exchange_strong(state, state_busy, std::memory_order_acquire)) {
+          new (slot.item.ptr()) Item(std::piecewise_construct,
+                                     std::forward_as_tuple(key),
+                                     std::forward_as_tuple(std::forward<ForwardValue>(value)...));
+          slot.state.store(occupied_state, std::memory_order_release);
+          return {slot.item.ptr(), true};
+        }
+        /* Another thread claimed the slot first, the current state has been loaded. */
+        size_.fetch_sub(1, std::memory_order_relaxed);
+      }
+      state = wait_while_busy(slot, state);
+      if (state == occupied_state && is_equal_(key, slot.item.ptr()->first)) {
+        return {slot.item.ptr(), false};
+      }
+      slot_index = (slot_index + 1) & slot_mask_;
+    }
+    /* Not reachable, the size limit keeps half of the slots empty. */
+    BLI_assert_unreachable();
+    return {nullptr, false};
+  }
+
+  const Item *lookup_item__impl(const Key &key, const uint64_t hash) const
+  {
+    const uint64_t mixed_hash = mix_hash(hash);
+    const uint8_t occupied_state = state_from_mixed_hash(mixed_hash);
+    uint64_t slot_index = this->first_slot_index(mixed_hash);
+    for ([[maybe_unused]] const int64_t i : slots_.index_range()) {
+      const Slot &slot = slots_[int64_t(slot_index)];
+      const uint8_t state = wait_while_busy(slot, slot.state.load(std::memory_order_acquire));
+      if (state == state_empty) {
+        return nullptr;
+      }
+      if (state == occupied_state && is_equal_(key, slot.item.ptr()->first)) {
+        return slot.item.ptr();
+      }
+      slot_index = (slot_index + 1) & slot_mask_;
+    }
+    return nullptr;
+  }
+};
+
+}  // namespace blender
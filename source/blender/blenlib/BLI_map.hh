@@ -33,6 +33,8 @@
  * - Pointers to keys and values might be invalidated when the map is changed or moved.
  * - The hash function can be customized. See BLI_hash.hh for details.
  * - The probing strategy can be customized. See BLI_probing_strategies.hh for details.
+ * - A Swiss-table style layout with SIMD group probing can be selected with
+ *   #GroupProbingStrategy. This can be faster for maps with millions of elements.
  * - The slot type can be customized. See BLI_map_slots.hh for details.
  * - Small buffer optimization is enabled by default, if Key and Value are not too large.
  * - The methods `add_new` and `remove_contained` should be used instead of `add` and `remove`
@@ -171,11 +173,20 @@ class Map {
    */
   SlotArray slots_;
 
+  using ControlBytes =
+      std::conditional_t<is_group_probing_strategy_v<ProbingStrategy>,
+                         GroupControlBytes<SlotArray::inline_buffer_capacity(), Allocator>,
+                         NoGroupControlBytes<Allocator>>;
+
+  /** One byte per slot when #GroupProbingStrategy is used, otherwise this is empty. */
+  BLI_NO_UNIQUE_ADDRESS ControlBytes control_bytes_;
+
   /** Iterate over a slot index sequence for a given hash. */
 #define MAP_SLOT_PROBING_BEGIN(HASH, R_SLOT) \
-  SLOT_PROBING_BEGIN (ProbingStrategy, HASH, slot_mask_, SLOT_INDEX) \
+  auto probing_sequence = this->probing_sequence(HASH); \
+  SLOT_SEQUENCE_PROBING_BEGIN (probing_sequence, SLOT_INDEX) \
     auto &R_SLOT = slots_[SLOT_INDEX];
-#define MAP_SLOT_PROBING_END() SLOT_PROBING_END()
+#define MAP_SLOT_PROBING_END() SLOT_SEQUENCE_PROBING_END(probing_sequence)
 
  public:
   /**
@@ -190,7 +201,8 @@ class Map {
         slot_mask_(0),
         hash_(),
         is_equal_(),
-        slots_(1, allocator)
+        slots_(1, allocator),
+        control_bytes_(allocator)
   {
   }
 
@@ -215,6 +227,7 @@ class Map {
         throw;
       }
     }
+    control_bytes_ = std::move(other.control_bytes_);
     removed_slots_ = other.removed_slots_;
     occupied_and_removed_slots_ = other.occupied_and_removed_slots_;
     usable_slots_ = other.usable_slots_;
@@ -376,6 +389,7 @@ class Map {
       return false;
     }
     slot->remove();
+    control_bytes_.set_removed(slot - slots_.data());
     removed_slots_++;
     return true;
   }
@@ -392,6 +406,7 @@ class Map {
   {
     Slot &slot = this->lookup_slot(key, hash_(key));
     slot.remove();
+    control_bytes_.set_removed(&slot - slots_.data());
     removed_slots_++;
   }
 
@@ -408,6 +423,7 @@ class Map {
     Slot &slot = this->lookup_slot(key, hash_(key));
     Value value = std::move(*slot.value());
     slot.remove();
+    control_bytes_.set_removed(&slot - slots_.data());
     removed_slots_++;
     return value;
   }
@@ -428,6 +444,7 @@ class Map {
     }
     std::optional<Value> value = std::move(*slot->value());
     slot->remove();
+    control_bytes_.set_removed(slot - slots_.data());
     removed_slots_++;
     return value;
   }
@@ -453,6 +470,7 @@ class Map {
     }
     Value value = std::move(*slot->value());
     slot->remove();
+    control_bytes_.set_removed(slot - slots_.data());
     removed_slots_++;
     return value;
   }
@@ -937,6 +955,7 @@ class Map {
     Slot &slot = iterator.current_slot();
     BLI_assert(slot.is_occupied());
     slot.remove();
+    control_bytes_.set_removed(&slot - slots_.data());
     removed_slots_++;
   }
 
@@ -949,12 +968,14 @@ class Map {
   template<typename Predicate> int64_t remove_if(Predicate &&predicate)
   {
     const int64_t prev_size = this->size();
-    for (Slot &slot : slots_) {
+    for (const int64_t i : slots_.index_range()) {
+      Slot &slot = slots_[i];
       if (slot.is_occupied()) {
         const Key &key = *slot.key();
         Value &value = *slot.value();
         if (predicate(MutableItem{key, value})) {
           slot.remove();
+          control_bytes_.set_removed(i);
           removed_slots_++;
         }
       }
@@ -1019,7 +1040,7 @@ class Map {
    */
   int64_t size_in_bytes() const
   {
-    return int64_t(sizeof(Slot) * slots_.size());
+    return int64_t(sizeof(Slot) * slots_.size()) + control_bytes_.size_in_bytes();
   }
 
   /**
@@ -1055,6 +1076,7 @@ class Map {
       slot.~Slot();
       new (&slot) Slot();
     }
+    control_bytes_.reset(slots_.size());
 
     removed_slots_ = 0;
     occupied_and_removed_slots_ = 0;
@@ -1111,6 +1133,7 @@ class Map {
     if (this->size() == 0) {
       try {
         slots_.reinitialize(total_slots);
+        control_bytes_.reset(total_slots);
       }
       catch (...) {
         this->noexcept_reset();
@@ -1126,13 +1149,16 @@ class Map {
     SlotArray new_slots(total_slots);
 
     try {
+      ControlBytes new_control_bytes(slots_.allocator());
+      new_control_bytes.reset(total_slots);
       for (Slot &slot : slots_) {
         if (slot.is_occupied()) {
-          this->add_after_grow(slot, new_slots, new_slot_mask);
+          this->add_after_grow(slot, new_slots, new_slot_mask, new_control_bytes);
           slot.remove();
         }
       }
       slots_ = std::move(new_slots);
+      control_bytes_ = std::move(new_control_bytes);
     }
     catch (...) {
       this->noexcept_reset();
@@ -1145,17 +1171,38 @@ class Map {
     slot_mask_ = new_slot_mask;
   }
 
-  void add_after_grow(Slot &old_slot, SlotArray &new_slots, uint64_t new_slot_mask)
+  void add_after_grow(Slot &old_slot,
+                      SlotArray &new_slots,
+                      uint64_t new_slot_mask,
+                      ControlBytes &new_control_bytes)
   {
     uint64_t hash = old_slot.get_hash(Hash());
-    SLOT_PROBING_BEGIN (ProbingStrategy, hash, new_slot_mask, slot_index) {
-      Slot &slot = new_slots[slot_index];
-      if (slot.is_empty()) {
-        slot.occupy(std::move(*old_slot.key()), hash, std::move(*old_slot.value()));
-        return;
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      const int64_t slot_index = new_control_bytes.find_empty_slot(hash);
+      new_slots[slot_index].occupy(
+          std::move(*old_slot.key()), hash, std::move(*old_slot.value()));
+      new_control_bytes.set_occupied(slot_index, hash);
+    }
+    else {
+      SLOT_PROBING_BEGIN (ProbingStrategy, hash, new_slot_mask, slot_index) {
+        Slot &slot = new_slots[slot_index];
+        if (slot.is_empty()) {
+          slot.occupy(std::move(*old_slot.key()), hash, std::move(*old_slot.value()));
+          return;
+        }
       }
+      SLOT_PROBING_END();
+    }
+  }
+
+  auto probing_sequence(const uint64_t hash) const
+  {
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      return control_bytes_.probe(hash);
+    }
+    else {
+      return LinearProbingSequence<ProbingStrategy>(hash, slot_mask_);
     }
-    SLOT_PROBING_END();
   }
 
   void noexcept_reset() noexcept
@@ -1175,6 +1222,7 @@ class Map {
     MAP_SLOT_PROBING_BEGIN (hash, slot) {
       if (slot.is_empty()) {
         slot.occupy(std::forward<ForwardKey>(key), hash, std::forward<ForwardValue>(value)...);
+        control_bytes_.set_occupied(SLOT_INDEX, hash);
         BLI_assert(hash_(*slot.key()) == hash);
         occupied_and_removed_slots_++;
         return;
@@ -1191,6 +1239,7 @@ class Map {
     MAP_SLOT_PROBING_BEGIN (hash, slot) {
       if (slot.is_empty()) {
         slot.occupy(std::forward<ForwardKey>(key), hash, std::forward<ForwardValue>(value)...);
+        control_bytes_.set_occupied(SLOT_INDEX, hash);
         BLI_assert(hash_(*slot.key()) == hash);
         occupied_and_removed_slots_++;
         return true;
@@ -1221,12 +1270,14 @@ class Map {
         if constexpr (std::is_void_v<CreateReturnT>) {
           create_value(value_ptr);
           slot.occupy_no_value(std::forward<ForwardKey>(key), hash);
+          control_bytes_.set_occupied(SLOT_INDEX, hash);
           occupied_and_removed_slots_++;
           return;
         }
         else {
           auto &&return_value = create_value(value_ptr);
           slot.occupy_no_value(std::forward<ForwardKey>(key), hash);
+          control_bytes_.set_occupied(SLOT_INDEX, hash);
           occupied_and_removed_slots_++;
           return return_value;
         }
@@ -1247,6 +1298,7 @@ class Map {
     MAP_SLOT_PROBING_BEGIN (hash, slot) {
       if (slot.is_empty()) {
         slot.occupy(std::forward<ForwardKey>(key), hash, create_value());
+        control_bytes_.set_occupied(SLOT_INDEX, hash);
         BLI_assert(hash_(*slot.key()) == hash);
         occupied_and_removed_slots_++;
         return *slot.value();
@@ -1266,6 +1318,7 @@ class Map {
     MAP_SLOT_PROBING_BEGIN (hash, slot) {
       if (slot.is_empty()) {
         slot.occupy(std::forward<ForwardKey>(key), hash, std::forward<ForwardValue>(value)...);
+        control_bytes_.set_occupied(SLOT_INDEX, hash);
         BLI_assert(hash_(*slot.key()) == hash);
         occupied_and_removed_slots_++;
         return *slot.value();
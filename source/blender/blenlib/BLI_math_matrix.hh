@@ -417,6 +417,53 @@ template<typename MatT, typename VectorT>
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Batch Transform Functions.
+ *
+ * Transform many vectors with the same matrix. This is much faster than calling
+ * #transform_point for every element, because it uses the widest SIMD instructions supported by
+ * the CPU (selected at run-time) and multiple threads for large spans. The results can differ
+ * from the single element functions in the last bits because of fused multiply-add instructions.
+ *
+ * The source and the destination may be the same span, but they must not overlap otherwise.
+ * Rotations like #Quaternion can be applied after converting them with #from_rotation.
+ * \{ */
+
+/**
+ * Transform 3d points using a 4x4 matrix (location & rotation & scale).
+ */
+void transform_points(Span<float3> src,
+                      const float4x4 &mat,
+                      MutableSpan<float3> dst,
+                      bool use_threading = true);
+void transform_points(MutableSpan<float3> points, const float4x4 &mat, bool use_threading = true);
+
+/**
+ * Transform 3d direction vectors using a 3x3 matrix (rotation & scale).
+ */
+void transform_directions(Span<float3> src,
+                          const float3x3 &mat,
+                          MutableSpan<float3> dst,
+                          bool use_threading = true);
+void transform_directions(MutableSpan<float3> directions,
+                          const float3x3 &mat,
+                          bool use_threading = true);
+
+/**
+ * Transform 3d direction vectors using a 3x3 matrix and normalize the result. Vectors that are
+ * too short to be normalized become zero, like with #normalize. For normals, the matrix is
+ * usually the inverse transpose of the matrix that is used for the positions.
+ */
+void transform_normals(Span<float3> src,
+                       const float3x3 &mat,
+                       MutableSpan<float3> dst,
+                       bool use_threading = true);
+void transform_normals(MutableSpan<float3> normals,
+                       const float3x3 &mat,
+                       bool use_threading = true);
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Projection Matrices.
  * \{ */
@@ -4,9 +4,12 @@
 
 #pragma once
 
+#include <string>
+
 #include "BLI_function_ref.hh"
 #include "BLI_generic_key.hh"
 #include "BLI_memory_counter_fwd.hh"
+#include "BLI_vector.hh"
 
 namespace blender::memory_cache {
 
@@ -25,11 +28,30 @@ class CachedValue {
   virtual void count_memory(MemoryCounter &memory) const = 0;
 };
 
+/**
+ * Usage statistics of all cached values whose keys have the same type (see
+ * #GenericKey::type_name).
+ */
+struct KeyTypeStatistics {
+  std::string key_type;
+  /** Number of lookups that found a cached value. */
+  int64_t hits = 0;
+  /** Number of lookups that had to compute the value. */
+  int64_t misses = 0;
+  /** Number of values that were freed because the cache was full. */
+  int64_t evictions = 0;
+  /** Number of values currently in the cache. */
+  int64_t values_num = 0;
+  /** Approximate memory used by the values currently in the cache. */
+  int64_t bytes = 0;
+};
+
 /**
  * Returns the value that corresponds to the given key. If it's not cached yet, #compute_fn is
  * called and its result is cached for the next time.
  *
- * If the cache is full, older values may be freed.
+ * If the cache is full, other values may be freed. Values that are cheap to recompute relative to
+ * their size and that have not been used in a while are freed first.
  */
 template<typename T>
 std::shared_ptr<const T> get(const GenericKey &key, FunctionRef<std::unique_ptr<T>()> compute_fn);
@@ -60,6 +82,11 @@ void clear();
  */
 void remove_if(FunctionRef<bool(const GenericKey &)> predicate);
 
+/**
+ * Get the statistics of all key types that have been used with the cache since the start.
+ */
+Vector<KeyTypeStatistics> get_statistics();
+
 /* -------------------------------------------------------------------- */
 /** \name Inline Functions
  * \{ */
@@ -0,0 +1,90 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <mutex>
+
+#include "BLI_enumerable_thread_specific.hh"
+#include "BLI_mempool.h"
+#include "BLI_utility_mixins.hh"
+
+namespace blender {
+
+/**
+ * A #BLI_mempool that elements can be allocated from and freed to by multiple threads at the same
+ * time.
+ *
+ * Every thread has its own cache of free elements, which is refilled from the shared pool and
+ * returned to it in batches. That way the lock protecting the shared pool is only taken once for
+ * many allocations. Elements may be freed by another thread than the one that allocated them.
+ *
+ * The underlying pool can still be used for iteration (when created with
+ * #BLI_MEMPOOL_ALLOW_ITER), including #BLI_task_parallel_mempool, as long as no elements are
+ * allocated or freed at the same time. Elements must only be allocated and freed through this
+ * class though, and #BLI_mempool_len is only correct after #flush.
+ */
+class ThreadSafeMempool : NonCopyable, NonMovable {
+ private:
+  struct LocalCache {
+    /** Free elements, linked through their first pointer. */
+    void *free = nullptr;
+    int64_t free_num = 0;
+    /** Change of the number of used elements that has not been added to the pool yet. */
+    int64_t used_num_delta = 0;
+  };
+
+  BLI_mempool *pool_;
+  /** Protects #pool_ when refilling or returning elements of a local cache. */
+  std::mutex mutex_;
+  threading::EnumerableThreadSpecific<LocalCache> local_caches_;
+  /** Number of elements moved between a local cache and the pool at once. */
+  int64_t batch_size_;
+
+ public:
+  /**
+   * See #BLI_mempool_create for the parameters.
+   *
+   * \param batch_size: Number of elements moved between the local caches and the shared pool at
+   * once. Larger batches reduce locking further, at the cost of more memory held by each thread.
+   */
+  ThreadSafeMempool(uint element_size,
+                    uint elements_num,
+                    uint elements_per_chunk,
+                    uint flag,
+                    int64_t batch_size = 64);
+  ~ThreadSafeMempool();
+
+  void *alloc();
+  void *calloc();
+  void free(void *elem);
+
+  /**
+   * Return the free elements of all thread local caches to the pool, and update the number of
+   * used elements of the pool. Must not be called while other threads allocate or free elements.
+   */
+  void flush();
+
+  /**
+   * Free all elements, see #BLI_mempool_clear. Must not be called while other threads allocate or
+   * free elements.
+   */
+  void clear();
+
+  /** The underlying pool, e.g. for iteration. */
+  BLI_mempool *pool()
+  {
+    return pool_;
+  }
+
+ private:
+  void refill(LocalCache &cache);
+  void return_batch(LocalCache &cache);
+};
+
+}  // namespace blender
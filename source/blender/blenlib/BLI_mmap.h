@@ -34,6 +34,9 @@ bool BLI_mmap_read(BLI_mmap_file *file, void *dest, size_t offset, size_t length
 
 void *BLI_mmap_get_pointer(BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT;
 size_t BLI_mmap_get_length(const BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT;
+/* Whether an IO error occurred while accessing the mapped memory. Only needed when accessing
+ * the memory returned by #BLI_mmap_get_pointer directly, #BLI_mmap_read checks this already. */
+bool BLI_mmap_has_io_error(const BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
 
 void BLI_mmap_free(BLI_mmap_file *file) ATTR_NONNULL(1);
 
@@ -145,6 +145,7 @@ template<typename T> struct GroupedSpan {
 
 /**
  * Turn an array of sizes into the offset at each index including all previous sizes.
+ * Large arrays are accumulated in parallel.
  */
 OffsetIndices<int> accumulate_counts_to_offsets(MutableSpan<int> counts_to_offsets,
                                                 int start_offset = 0);
@@ -188,6 +189,19 @@ void build_reverse_map(OffsetIndices<int> offsets, MutableSpan<int> r_map);
  */
 void build_reverse_offsets(Span<int> indices, MutableSpan<int> offsets);
 
+/**
+ * Parallel counting sort: fill \a r_indices with the index of every element of \a indices,
+ * grouped by the value it points to. The indices within every group are sorted.
+ *
+ * \param offsets: The groups of \a indices, usually built with #build_reverse_offsets.
+ */
+void build_reverse_indices(Span<int> indices,
+                           OffsetIndices<int> offsets,
+                           MutableSpan<int> r_indices);
+
+/** Sort the indices in every group, in parallel over the groups. */
+void sort_small_groups(OffsetIndices<int> offsets, MutableSpan<int> indices);
+
 }  // namespace blender::offset_indices
 
 namespace blender {
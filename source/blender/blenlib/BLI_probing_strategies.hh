@@ -30,6 +30,9 @@
  * The SLOT_PROBING_BEGIN and SLOT_PROBING_END macros can be used to implement a loop that iterates
  * over a probing sequence.
  *
+ * #GroupProbingStrategy is special, because it probes groups of slots based on additional control
+ * bytes stored in the hash table. It is supported by #Set and #Map.
+ *
  * Probing strategies can be evaluated with many different criteria. Different use cases often
  * have different optimal strategies. Examples:
  * - If the hash function generates a well distributed initial hash value, the constructor should
@@ -44,6 +47,7 @@
  */
 
 #include <limits>
+#include <type_traits>
 
 #include "BLI_sys_types.h"
 
@@ -202,6 +206,93 @@ template<uint64_t LinearSteps = 2, bool PreShuffle = false> class ShuffleProbing
  */
 using DefaultProbingStrategy = PythonProbingStrategy<>;
 
+/**
+ * Selects a Swiss-table style layout in #Set and #Map. Unlike the other strategies, this does not
+ * produce a sequence of slot indices based on the hash alone. Instead, the hash table additionally
+ * stores one control byte per slot in a separate array. The control byte of an occupied slot
+ * contains 7 bits of the hash. Lookups compare the control bytes of a group of 16 slots at once
+ * and only have to look at the slots whose control byte matches. See #GroupControlBytes.
+ *
+ * This is mostly beneficial for large hash tables, whose slots don't fit into the CPU cache, and
+ * for keys that are expensive to compare. It costs an additional byte per slot.
+ */
+class GroupProbingStrategy {};
+
+template<typename ProbingStrategy>
+inline constexpr bool is_group_probing_strategy_v =
+    std::is_same_v<ProbingStrategy, GroupProbingStrategy>;
+
+/**
+ * Adapts a probing strategy to the interface used by #SLOT_SEQUENCE_PROBING_BEGIN. Every step
+ * yields the slot indices of the linear probing steps of the strategy.
+ */
+template<typename ProbingStrategy> class LinearProbingSequence {
+ private:
+  ProbingStrategy probing_strategy_;
+  uint64_t mask_;
+
+ public:
+  class CandidateIterator {
+   private:
+    uint64_t hash_;
+    uint64_t mask_;
+    int64_t linear_offset_;
+
+   public:
+    CandidateIterator(const uint64_t hash, const uint64_t mask, const int64_t linear_offset)
+        : hash_(hash), mask_(mask), linear_offset_(linear_offset)
+    {
+    }
+
+    int64_t operator*() const
+    {
+      return int64_t((hash_ + uint64_t(linear_offset_)) & mask_);
+    }
+
+    CandidateIterator &operator++()
+    {
+      linear_offset_++;
+      return *this;
+    }
+
+    friend bool operator!=(const CandidateIterator &a, const CandidateIterator &b)
+    {
+      return a.linear_offset_ != b.linear_offset_;
+    }
+  };
+
+  struct Candidates {
+    CandidateIterator begin_;
+    CandidateIterator end_;
+
+    CandidateIterator begin() const
+    {
+      return begin_;
+    }
+    CandidateIterator end() const
+    {
+      return end_;
+    }
+  };
+
+  LinearProbingSequence(const uint64_t hash, const uint64_t mask)
+      : probing_strategy_(hash), mask_(mask)
+  {
+  }
+
+  Candidates candidates() const
+  {
+    const uint64_t hash = probing_strategy_.get();
+    return {CandidateIterator(hash, mask_, 0),
+            CandidateIterator(hash, mask_, probing_strategy_.linear_steps())};
+  }
+
+  void next()
+  {
+    probing_strategy_.next();
+  }
+};
+
 /* Turning off clang format here, because otherwise it will mess up the alignment between the
  * macros. */
 // clang-format off
@@ -232,6 +323,28 @@ using DefaultProbingStrategy = PythonProbingStrategy<>;
     probing_strategy.next(); \
   } while (true)
 
+/**
+ * Similar to #SLOT_PROBING_BEGIN, but iterates over the slot indices produced by a probing
+ * sequence like #LinearProbingSequence or #GroupProbingSequence. A probing sequence has to
+ * implement the following methods:
+ * - candidates() const -> Range of int64_t: The slot indices that have to be checked in the
+ *   current step.
+ * - next() -> void: Go to the next step of the sequence.
+ *
+ * The same rules as for #SLOT_PROBING_BEGIN apply.
+ *
+ * PROBING_SEQUENCE: Name of a probing sequence variable.
+ * R_SLOT_INDEX: Name of the variable that will contain the slot index.
+ */
+#define SLOT_SEQUENCE_PROBING_BEGIN(PROBING_SEQUENCE, R_SLOT_INDEX) \
+  do { \
+    for (const int64_t R_SLOT_INDEX : PROBING_SEQUENCE.candidates()) {
+
+#define SLOT_SEQUENCE_PROBING_END(PROBING_SEQUENCE) \
+    } \
+    PROBING_SEQUENCE.next(); \
+  } while (true)
+
 // clang-format on
 
 }  // namespace blender
@@ -0,0 +1,159 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Records the start and duration of scopes on every thread, to find out where time is spent in a
+ * single frame or operation without an external profiler. The recorded events are written in the
+ * Chrome trace event format, which can be opened in `chrome://tracing` or https://ui.perfetto.dev.
+ *
+ * Recording is started with `--profile-trace <filepath>` on the command line. Every thread that
+ * records events gets its own ring buffer, so recording does not need any synchronization between
+ * threads. When a buffer is full, the oldest events of that thread are overwritten.
+ *
+ * Scopes are marked with #PROFILE_TRACE_SCOPE and #PROFILE_TRACE_SCOPE_DYNAMIC. When not
+ * recording, a scope only checks a global flag. When Blender is built without
+ * `WITH_PROFILE_TRACE`, the macros don't generate any code.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "BLI_string_ref.hh"
+
+namespace blender::profile_trace {
+
+using Clock = std::chrono::steady_clock;
+using TimePoint = Clock::time_point;
+
+namespace detail {
+extern std::atomic<bool> is_recording;
+}
+
+/** True when events are recorded currently. */
+inline bool is_recording()
+{
+  return detail::is_recording.load(std::memory_order_relaxed);
+}
+
+/**
+ * Start recording events. Events that were recorded before are discarded.
+ * \param events_per_thread: Size of the ring buffer of every thread.
+ */
+void start_recording(int64_t events_per_thread = 1 << 16);
+
+/** Stop recording events. The recorded events are kept until they are written or cleared. */
+void stop_recording();
+
+/**
+ * Stop recording and free all recorded events. Waits until other threads have finished writing
+ * the event they are currently recording.
+ */
+void clear();
+
+/**
+ * Stop recording and write all recorded events as Chrome trace event JSON.
+ * \return False if the file could not be written.
+ */
+bool write_json(StringRefNull filepath);
+
+/**
+ * Number of events that are currently stored in all ring buffers. Only events of the given
+ * category are counted if it is not null. Must not be called while recording.
+ */
+int64_t recorded_events_num(const char *category = nullptr);
+
+/**
+ * Add an event that has been measured by the caller. The name is copied and truncated if it is
+ * longer than 63 bytes. The category is not copied and should be a string literal.
+ */
+void record_event(const char *category, StringRef name, TimePoint start, TimePoint end);
+
+/**
+ * Records the duration of its lifetime. When not recording, constructing and destructing it only
+ * checks the global flag, so it is cheap enough for hot paths like every task of a parallel loop.
+ */
+class ScopedEvent {
+ private:
+  const char *category_;
+  const char *name_;
+  TimePoint start_;
+  bool is_recording_;
+
+ public:
+  /** The name is not copied and should be a string literal. */
+  ScopedEvent(const char *category, const char *name)
+      : category_(category), name_(name), is_recording_(is_recording())
+  {
+    if (is_recording_) {
+      start_ = Clock::now();
+    }
+  }
+
+  ~ScopedEvent()
+  {
+    if (is_recording_) {
+      record_event(category_, name_, start_, Clock::now());
+    }
+  }
+
+  ScopedEvent(const ScopedEvent &other) = delete;
+  ScopedEvent &operator=(const ScopedEvent &other) = delete;
+};
+
+/** Like #ScopedEvent, but the name is built at run-time. */
+class ScopedEventDynamic {
+ private:
+  const char *category_;
+  std::string name_;
+  TimePoint start_;
+  bool is_recording_;
+
+ public:
+  /** The name is only created when recording, because it may be expensive to build. */
+  template<typename NameFn>
+  ScopedEventDynamic(const char *category, const NameFn &name_fn)
+      : category_(category), is_recording_(is_recording())
+  {
+    if (is_recording_) {
+      name_ = name_fn();
+      start_ = Clock::now();
+    }
+  }
+
+  ~ScopedEventDynamic()
+  {
+    if (is_recording_) {
+      record_event(category_, name_, start_, Clock::now());
+    }
+  }
+
+  ScopedEventDynamic(const ScopedEventDynamic &other) = delete;
+  ScopedEventDynamic &operator=(const ScopedEventDynamic &other) = delete;
+};
+
+}  // namespace blender::profile_trace
+
+#ifdef WITH_PROFILE_TRACE
+/**
+ * Record the duration of the current scope. Both arguments must be string literals or otherwise
+ * outlive the recording.
+ */
+#  define PROFILE_TRACE_SCOPE(category, name) \
+    const blender::profile_trace::ScopedEvent profile_trace_scope_(category, name)
+/**
+ * Like #PROFILE_TRACE_SCOPE, but the name is an expression that is only evaluated when recording
+ * and can return a temporary string.
+ */
+#  define PROFILE_TRACE_SCOPE_DYNAMIC(category, name_expr) \
+    const blender::profile_trace::ScopedEventDynamic profile_trace_scope_( \
+        category, [&]() { return std::string(name_expr); })
+#else
+#  define PROFILE_TRACE_SCOPE(category, name)
+#  define PROFILE_TRACE_SCOPE_DYNAMIC(category, name_expr)
+#endif
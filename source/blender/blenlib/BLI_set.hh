@@ -32,6 +32,8 @@
  * - Pointers to keys might be invalidated when the set is changed or moved.
  * - The hash function can be customized. See BLI_hash.hh for details.
  * - The probing strategy can be customized. See BLI_probing_stragies.hh for details.
+ * - A Swiss-table style layout with SIMD group probing can be selected with
+ *   #GroupProbingStrategy. This can be faster for sets with millions of elements.
  * - The slot type can be customized. See BLI_set_slots.hh for details.
  * - Small buffer optimization is enabled by default, if the key is not too large.
  * - The methods `add_new` and `remove_contained` should be used instead of `add` and `remove`
@@ -153,11 +155,20 @@ class Set {
    */
   SlotArray slots_;
 
+  using ControlBytes =
+      std::conditional_t<is_group_probing_strategy_v<ProbingStrategy>,
+                         GroupControlBytes<SlotArray::inline_buffer_capacity(), Allocator>,
+                         NoGroupControlBytes<Allocator>>;
+
+  /** One byte per slot when #GroupProbingStrategy is used, otherwise this is empty. */
+  BLI_NO_UNIQUE_ADDRESS ControlBytes control_bytes_;
+
   /** Iterate over a slot index sequence for a given hash. */
 #define SET_SLOT_PROBING_BEGIN(HASH, R_SLOT) \
-  SLOT_PROBING_BEGIN (ProbingStrategy, HASH, slot_mask_, SLOT_INDEX) \
+  auto probing_sequence = this->probing_sequence(HASH); \
+  SLOT_SEQUENCE_PROBING_BEGIN (probing_sequence, SLOT_INDEX) \
     auto &R_SLOT = slots_[SLOT_INDEX];
-#define SET_SLOT_PROBING_END() SLOT_PROBING_END()
+#define SET_SLOT_PROBING_END() SLOT_SEQUENCE_PROBING_END(probing_sequence)
 
  public:
   /**
@@ -170,7 +181,8 @@ class Set {
         occupied_and_removed_slots_(0),
         usable_slots_(0),
         slot_mask_(0),
-        slots_(1, allocator)
+        slots_(1, allocator),
+        control_bytes_(allocator)
   {
   }
 
@@ -206,6 +218,7 @@ class Set {
         throw;
       }
     }
+    control_bytes_ = std::move(other.control_bytes_);
     removed_slots_ = other.removed_slots_;
     occupied_and_removed_slots_ = other.occupied_and_removed_slots_;
     usable_slots_ = other.usable_slots_;
@@ -484,6 +497,7 @@ class Set {
     Slot &slot = const_cast<Slot &>(it.current_slot());
     BLI_assert(slot.is_occupied());
     slot.remove();
+    control_bytes_.set_removed(it.current_slot_);
     removed_slots_++;
   }
 
@@ -496,11 +510,13 @@ class Set {
   template<typename Predicate> int64_t remove_if(Predicate &&predicate)
   {
     const int64_t prev_size = this->size();
-    for (Slot &slot : slots_) {
+    for (const int64_t i : slots_.index_range()) {
+      Slot &slot = slots_[i];
       if (slot.is_occupied()) {
         const Key &key = *slot.key();
         if (predicate(key)) {
           slot.remove();
+          control_bytes_.set_removed(i);
           removed_slots_++;
         }
       }
@@ -548,6 +564,7 @@ class Set {
       slot.~Slot();
       new (&slot) Slot();
     }
+    control_bytes_.reset(slots_.size());
 
     removed_slots_ = 0;
     occupied_and_removed_slots_ = 0;
@@ -608,7 +625,7 @@ class Set {
    */
   int64_t size_in_bytes() const
   {
-    return sizeof(Slot) * slots_.size();
+    return sizeof(Slot) * slots_.size() + control_bytes_.size_in_bytes();
   }
 
   /**
@@ -681,6 +698,7 @@ class Set {
     if (this->size() == 0) {
       try {
         slots_.reinitialize(total_slots);
+        control_bytes_.reset(total_slots);
       }
       catch (...) {
         this->noexcept_reset();
@@ -697,13 +715,16 @@ class Set {
     SlotArray new_slots(total_slots);
 
     try {
+      ControlBytes new_control_bytes(slots_.allocator());
+      new_control_bytes.reset(total_slots);
       for (Slot &slot : slots_) {
         if (slot.is_occupied()) {
-          this->add_after_grow(slot, new_slots, new_slot_mask);
+          this->add_after_grow(slot, new_slots, new_slot_mask, new_control_bytes);
           slot.remove();
         }
       }
       slots_ = std::move(new_slots);
+      control_bytes_ = std::move(new_control_bytes);
     }
     catch (...) {
       this->noexcept_reset();
@@ -716,18 +737,38 @@ class Set {
     slot_mask_ = new_slot_mask;
   }
 
-  void add_after_grow(Slot &old_slot, SlotArray &new_slots, const uint64_t new_slot_mask)
+  void add_after_grow(Slot &old_slot,
+                      SlotArray &new_slots,
+                      const uint64_t new_slot_mask,
+                      ControlBytes &new_control_bytes)
   {
     const uint64_t hash = old_slot.get_hash(Hash());
 
-    SLOT_PROBING_BEGIN (ProbingStrategy, hash, new_slot_mask, slot_index) {
-      Slot &slot = new_slots[slot_index];
-      if (slot.is_empty()) {
-        slot.occupy(std::move(*old_slot.key()), hash);
-        return;
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      const int64_t slot_index = new_control_bytes.find_empty_slot(hash);
+      new_slots[slot_index].occupy(std::move(*old_slot.key()), hash);
+      new_control_bytes.set_occupied(slot_index, hash);
+    }
+    else {
+      SLOT_PROBING_BEGIN (ProbingStrategy, hash, new_slot_mask, slot_index) {
+        Slot &slot = new_slots[slot_index];
+        if (slot.is_empty()) {
+          slot.occupy(std::move(*old_slot.key()), hash);
+          return;
+        }
       }
+      SLOT_PROBING_END();
+    }
+  }
+
+  auto probing_sequence(const uint64_t hash) const
+  {
+    if constexpr (is_group_probing_strategy_v<ProbingStrategy>) {
+      return control_bytes_.probe(hash);
+    }
+    else {
+      return LinearProbingSequence<ProbingStrategy>(hash, slot_mask_);
     }
-    SLOT_PROBING_END();
   }
 
   /**
@@ -791,6 +832,7 @@ class Set {
     SET_SLOT_PROBING_BEGIN (hash, slot) {
       if (slot.is_empty()) {
         slot.occupy(std::forward<ForwardKey>(key), hash);
+        control_bytes_.set_occupied(SLOT_INDEX, hash);
         BLI_assert(hash_(*slot.key()) == hash);
         occupied_and_removed_slots_++;
         return;
@@ -806,6 +848,7 @@ class Set {
     SET_SLOT_PROBING_BEGIN (hash, slot) {
       if (slot.is_empty()) {
         slot.occupy(std::forward<ForwardKey>(key), hash);
+        control_bytes_.set_occupied(SLOT_INDEX, hash);
         BLI_assert(hash_(*slot.key()) == hash);
         occupied_and_removed_slots_++;
         return true;
@@ -822,6 +865,7 @@ class Set {
     SET_SLOT_PROBING_BEGIN (hash, slot) {
       if (slot.contains(key, is_equal_, hash)) {
         slot.remove();
+        control_bytes_.set_removed(SLOT_INDEX);
         removed_slots_++;
         return true;
       }
@@ -840,6 +884,7 @@ class Set {
     SET_SLOT_PROBING_BEGIN (hash, slot) {
       if (slot.contains(key, is_equal_, hash)) {
         slot.remove();
+        control_bytes_.set_removed(SLOT_INDEX);
         removed_slots_++;
         return;
       }
@@ -858,6 +903,7 @@ class Set {
       }
       if (slot.is_empty()) {
         slot.occupy(std::forward<ForwardKey>(key), hash);
+        control_bytes_.set_occupied(SLOT_INDEX, hash);
         BLI_assert(hash_(*slot.key()) == hash);
         occupied_and_removed_slots_++;
         return *slot.key();
@@ -79,6 +79,22 @@ template<typename T> class SharedCache {
     cache_->mutex.ensure([&]() { compute_cache(this->cache_->data); });
   }
 
+  /**
+   * Tag the data dirty like #tag_dirty(), but move the cached data out of the cache first when it
+   * is valid and not shared with other objects. This allows reusing the data as a starting point
+   * for the next computation. Otherwise a default constructed value is returned.
+   */
+  T release()
+  {
+    T data{};
+    if (cache_.use_count() == 1 && cache_->mutex.is_cached()) {
+      data = std::move(cache_->data);
+      cache_->data = T{};
+    }
+    this->tag_dirty();
+    return data;
+  }
+
   /** Retrieve the cached data. */
   const T &data() const
   {
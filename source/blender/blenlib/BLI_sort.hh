@@ -14,6 +14,8 @@
 #  include <algorithm>
 #endif
 
+#include "BLI_span.hh"
+
 namespace blender {
 
 #ifdef WITH_TBB
@@ -31,4 +33,18 @@ void parallel_sort(RandomAccessIterator begin, RandomAccessIterator end, const C
 }
 #endif
 
+/**
+ * Stable parallel radix sort, usually much faster than #parallel_sort for large arrays.
+ * Implemented for 32 and 64 bit integer and floating point types. Negative zero is sorted before
+ * positive zero and NaN values are sorted to the ends depending on their sign bit.
+ */
+template<typename T> void radix_sort(MutableSpan<T> values);
+
+/**
+ * Stable parallel radix sort of \a indices by `keys[index]`. Only the given indices have to be
+ * valid in \a keys, so this can also be used to sort a subset or a group of elements. Negative
+ * and positive zero are considered equal, so the result is the same as a stable comparison sort.
+ */
+template<typename T> void radix_sort_indices(Span<T> keys, MutableSpan<int> indices);
+
 }  // namespace blender
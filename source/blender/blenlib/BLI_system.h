@@ -16,6 +16,8 @@ extern "C" {
 
 int BLI_cpu_support_sse2(void);
 int BLI_cpu_support_sse42(void);
+/** True when the CPU and the operating system support AVX2 and FMA instructions. */
+int BLI_cpu_support_avx2(void);
 void BLI_system_backtrace_with_os_info(FILE *fp, const void *os_info);
 void BLI_system_backtrace(FILE *fp);
 
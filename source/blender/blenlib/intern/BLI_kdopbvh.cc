@@ -30,9 +30,15 @@
 #include "BLI_kdopbvh.hh"
 #include "BLI_math_geom.h"
 #include "BLI_math_vector_types.hh"
+#include "BLI_simd.hh"
 #include "BLI_stack.h"
+#include "BLI_system.h"
 #include "BLI_task.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
+
+#include "kdopbvh_wide_kernels.hh"
 
 #include "BLI_strict_flags.h" /* Keep last. */
 
@@ -74,6 +80,43 @@ struct BVHNode {
   char main_axis; /* Axis used to split this node */
 };
 
+/**
+ * Node of the optional wide layout, storing the axis aligned bounds of up to `Width` children so
+ * that they can be tested against a ray or point at once.
+ */
+template<int Width> struct BVHWideNode {
+  /** Child bounds by lane, in the same order as #BVHNode.bv: min/max X, min/max Y, min/max Z.
+   * Unused lanes have inverted bounds. */
+  alignas(Width * sizeof(float)) float bounds[6][size_t(Width)];
+  /** Index of the wide node of every inner child, -1 for leaves. */
+  int children[size_t(Width)];
+  /** Index of every child in #BVHTree.nodearray, used for leaf data and refitting. */
+  int nodes[size_t(Width)];
+  int children_num;
+};
+
+struct BVHWideTree {
+  /** Number of children per node, only the nodes of that width are used. */
+  int width;
+  /** The first node is the root. */
+  blender::Vector<BVHWideNode<4>> nodes_4;
+  blender::Vector<BVHWideNode<8>> nodes_8;
+
+  template<int Width> blender::Vector<BVHWideNode<Width>> &nodes()
+  {
+    if constexpr (Width == 4) {
+      return nodes_4;
+    }
+    else {
+      return nodes_8;
+    }
+  }
+  template<int Width> const blender::Vector<BVHWideNode<Width>> &nodes() const
+  {
+    return const_cast<BVHWideTree *>(this)->nodes<Width>();
+  }
+};
+
 /* keep under 26 bytes for speed purposes */
 struct BVHTree {
   BVHNode **nodes;
@@ -86,11 +129,12 @@ struct BVHTree {
   axis_t start_axis, stop_axis; /* bvhtree_kdop_axes array indices according to axis */
   axis_t axis;                  /* KDOP type (6 => OBB, 7 => AABB, ...) */
   char tree_type;               /* type of tree (4 => quad-tree). */
+  BVHWideTree *wide;            /* Optional, see #BLI_bvhtree_build_wide. */
 };
 
 /* optimization, ensure we stay small */
-BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 48) ||
-                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 32),
+BLI_STATIC_ASSERT((sizeof(void *) == 8 && sizeof(BVHTree) <= 56) ||
+                      (sizeof(void *) == 4 && sizeof(BVHTree) <= 36),
                   "over sized")
 
 /* avoid duplicating vars in BVHOverlapData_Thread */
@@ -137,6 +181,11 @@ struct BVHRayCastData {
   float ray_dot_axis[13];
   float idot_axis[13];
   int index[6];
+  /* Ray origin offset by the radius towards the near and far slab planes, for the wide layout. */
+  float origin_near[3];
+  float origin_far[3];
+  /* Lower bound of the hit distance, zero for rays with a radius like #ray_nearest_hit. */
+  float dist_min;
 
   BVHTreeRayHit hit;
 };
@@ -855,6 +904,175 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Wide Node Layout
+ *
+ * The binary (or quad) tree is collapsed into nodes with four or eight children, whose bounds
+ * are stored by lane so that a ray or point can be tested against all children with a few SIMD
+ * instructions. Only the X, Y and Z slabs are used, as for the regular ray-cast and nearest
+ * queries, so the wide nodes are only built for k-DOPs that start with those axes.
+ *
+ * Nodes with four children are tested with SSE2. Nodes with eight children are only built on
+ * CPUs with AVX2, where they are tested with the kernels from `kdopbvh_wide_avx2.cc`.
+ * \{ */
+
+static float bv_surface_area(const float *bv)
+{
+  const float x = bv[1] - bv[0];
+  const float y = bv[3] - bv[2];
+  const float z = bv[5] - bv[4];
+  return x * y + y * z + z * x;
+}
+
+template<int Width>
+static int bvhtree_wide_build_recursive(const BVHTree *tree,
+                                        blender::Vector<BVHWideNode<Width>> &wide_nodes,
+                                        const BVHNode *node)
+{
+  const BVHNode *lanes[size_t(Width)];
+  int lanes_num = node->node_num;
+  BLI_assert(lanes_num <= Width);
+  std::copy_n(node->children, lanes_num, lanes);
+
+  /* Pull up the children of inner nodes while they fit, largest first. */
+  while (true) {
+    int best_lane = -1;
+    float best_area = -1.0f;
+    for (int lane = 0; lane < lanes_num; lane++) {
+      const BVHNode *child = lanes[lane];
+      if (child->node_num == 0 || lanes_num - 1 + child->node_num > Width) {
+        continue;
+      }
+      const float area = bv_surface_area(child->bv);
+      if (area > best_area) {
+        best_lane = lane;
+        best_area = area;
+      }
+    }
+    if (best_lane == -1) {
+      break;
+    }
+    const BVHNode *child = lanes[best_lane];
+    lanes[best_lane] = child->children[0];
+    for (int i = 1; i < child->node_num; i++) {
+      lanes[lanes_num++] = child->children[i];
+    }
+  }
+
+  /* The vector may grow while building the children, so only access the node by index. */
+  const int wide_index = int(wide_nodes.append_and_get_index({}));
+  wide_nodes[wide_index].children_num = lanes_num;
+  for (int lane = 0; lane < lanes_num; lane++) {
+    const BVHNode *child = lanes[lane];
+    const int child_wide_index = (child->node_num == 0) ? -1 :
+                                                          bvhtree_wide_build_recursive<Width>(
+                                                              tree, wide_nodes, child);
+    wide_nodes[wide_index].nodes[lane] = int(child - tree->nodearray);
+    wide_nodes[wide_index].children[lane] = child_wide_index;
+  }
+  return wide_index;
+}
+
+template<int Width> static void bvhtree_wide_refit(const BVHTree *tree)
+{
+  blender::MutableSpan<BVHWideNode<Width>> wide_nodes = tree->wide->nodes<Width>();
+  blender::threading::parallel_for(
+      wide_nodes.index_range(), 1024, [&](const blender::IndexRange range) {
+        for (BVHWideNode<Width> &wide_node : wide_nodes.slice(range)) {
+          for (int lane = 0; lane < Width; lane++) {
+            if (lane < wide_node.children_num) {
+              const float *bv = tree->nodearray[wide_node.nodes[lane]].bv;
+              for (int i = 0; i < 6; i++) {
+                wide_node.bounds[i][lane] = bv[i];
+              }
+            }
+            else {
+              for (int i = 0; i < 6; i += 2) {
+                wide_node.bounds[i][lane] = FLT_MAX;
+                wide_node.bounds[i + 1][lane] = -FLT_MAX;
+              }
+            }
+          }
+        }
+      });
+}
+
+static void bvhtree_wide_refit(const BVHTree *tree)
+{
+  if (tree->wide->width == 8) {
+    bvhtree_wide_refit<8>(tree);
+  }
+  else {
+    bvhtree_wide_refit<4>(tree);
+  }
+}
+
+static bool bvhtree_wide_supports_avx2()
+{
+#ifdef WITH_BVH_AVX2_KERNELS
+  static const bool supported = BLI_cpu_support_avx2();
+  return supported;
+#else
+  return false;
+#endif
+}
+
+bool BLI_bvhtree_build_wide(BVHTree *tree, int width)
+{
+  MEM_delete(tree->wide);
+  tree->wide = nullptr;
+
+  if (width == 0) {
+    width = bvhtree_wide_supports_avx2() ? 8 : 4;
+  }
+  if (!ELEM(width, 4, 8) || (width == 8 && !bvhtree_wide_supports_avx2())) {
+    return false;
+  }
+  if (tree->leaf_num == 0 || tree->branch_num == 0 || tree->tree_type > width ||
+      tree->start_axis != 0)
+  {
+    return false;
+  }
+
+  tree->wide = MEM_new<BVHWideTree>(__func__);
+  tree->wide->width = width;
+  const BVHNode *root = tree->nodes[tree->leaf_num];
+  /* Collapsing a binary tree roughly results in a wide node for every `width - 1` inner nodes. */
+  if (width == 8) {
+    tree->wide->nodes_8.reserve(tree->branch_num / 7 + 1);
+    bvhtree_wide_build_recursive<8>(tree, tree->wide->nodes_8, root);
+  }
+  else {
+    tree->wide->nodes_4.reserve(tree->branch_num / 3 + 1);
+    bvhtree_wide_build_recursive<4>(tree, tree->wide->nodes_4, root);
+  }
+  bvhtree_wide_refit(tree);
+  return true;
+}
+
+/**
+ * Sort the lanes set in \a mask by ascending distance.
+ * \return the number of lanes written to \a r_order.
+ */
+template<int Width>
+static int wide_lanes_sort(int mask, const float dist[size_t(Width)], int r_order[size_t(Width)])
+{
+  int lanes_num = 0;
+  for (int lane = 0; mask; lane++, mask >>= 1) {
+    if ((mask & 1) == 0) {
+      continue;
+    }
+    int i = lanes_num++;
+    for (; i > 0 && dist[r_order[i - 1]] > dist[lane]; i--) {
+      r_order[i] = r_order[i - 1];
+    }
+    r_order[i] = lane;
+  }
+  return lanes_num;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
@@ -937,6 +1155,7 @@ void BLI_bvhtree_free(BVHTree *tree)
     MEM_SAFE_FREE(tree->nodearray);
     MEM_SAFE_FREE(tree->nodebv);
     MEM_SAFE_FREE(tree->nodechild);
+    MEM_delete(tree->wide);
     MEM_freeN(tree);
   }
 }
@@ -1031,13 +1250,65 @@ void BLI_bvhtree_update_tree(BVHTree *tree)
    * TRICKY: the way we build the tree all the children have an index greater than the parent
    * This allows us todo a bottom up update by starting on the bigger numbered branch. */
 
-  BVHNode **root = tree->nodes + tree->leaf_num;
-  BVHNode **index = tree->nodes + tree->leaf_num + tree->branch_num - 1;
+  if (tree->branch_num < KDOPBVH_THREAD_LEAF_THRESHOLD) {
+    BVHNode **root = tree->nodes + tree->leaf_num;
+    BVHNode **index = tree->nodes + tree->leaf_num + tree->branch_num - 1;
 
-  for (; index >= root; index--) {
-    node_join(tree, *index);
+    for (; index >= root; index--) {
+      node_join(tree, *index);
+    }
+  }
+  else {
+    /* The branches of every level of the implicit tree are stored next to each other and only
+     * depend on the levels below, so every level can be updated in parallel. */
+    blender::Vector<blender::IndexRange, 32> levels;
+    const int64_t tree_offset = 2 - tree->tree_type;
+    /* Implicit indices, where the root has index 1. */
+    int64_t level_begin = 1;
+    int64_t level_end = 2;
+    while (level_begin <= tree->branch_num) {
+      levels.append(blender::IndexRange::from_begin_end(
+          level_begin - 1, std::min<int64_t>(level_end, tree->branch_num + 1) - 1));
+      level_begin = level_begin * tree->tree_type + tree_offset;
+      level_end = level_end * tree->tree_type + tree_offset;
+    }
+    BVHNode **branches = tree->nodes + tree->leaf_num;
+    for (int64_t i = levels.size() - 1; i >= 0; i--) {
+      blender::threading::parallel_for(levels[i], 1024, [&](const blender::IndexRange range) {
+        for (const int64_t branch : range) {
+          node_join(tree, branches[branch]);
+        }
+      });
+    }
   }
+
+  if (tree->wide) {
+    bvhtree_wide_refit(tree);
+  }
+}
+
+float BLI_bvhtree_surface_area_cost(const BVHTree *tree)
+{
+  if (tree->branch_num == 0 || tree->start_axis != 0) {
+    return 0.0f;
+  }
+  const auto surface_area = [](const BVHNode *node) {
+    const float x = node->bv[1] - node->bv[0];
+    const float y = node->bv[3] - node->bv[2];
+    const float z = node->bv[5] - node->bv[4];
+    return x * y + y * z + z * x;
+  };
+  const float root_area = surface_area(tree->nodes[tree->leaf_num]);
+  if (root_area <= 0.0f) {
+    return 0.0f;
+  }
+  double area_sum = 0.0;
+  for (int i = 0; i < tree->branch_num; i++) {
+    area_sum += double(surface_area(tree->nodes[tree->leaf_num + i]));
+  }
+  return float(area_sum / double(root_area));
 }
+
 int BLI_bvhtree_get_len(const BVHTree *tree)
 {
   return tree->leaf_num;
@@ -1607,6 +1878,95 @@ static void dfs_find_nearest_begin(BVHNearestData *data, BVHNode *node)
   dfs_find_nearest_dfs(data, node);
 }
 
+/**
+ * Squared distances from \a co to the bounds of all lanes of \a node.
+ * \return the mask of lanes closer than \a dist_sq_max.
+ */
+template<int Width>
+static int wide_nearest_lanes_scalar(const float co[3],
+                                     const BVHWideNode<Width> &node,
+                                     const float dist_sq_max,
+                                     float r_dist_sq[size_t(Width)])
+{
+  int mask = 0;
+  for (int lane = 0; lane < Width; lane++) {
+    float dist_sq = 0.0f;
+    for (int i = 0; i < 3; i++) {
+      const float delta = max_fff(
+          node.bounds[2 * i][lane] - co[i], co[i] - node.bounds[2 * i + 1][lane], 0.0f);
+      dist_sq += delta * delta;
+    }
+    r_dist_sq[lane] = dist_sq;
+    mask |= (dist_sq < dist_sq_max) << lane;
+  }
+  return mask;
+}
+
+static int wide_nearest_lanes(const float co[3],
+                              const BVHWideNode<4> &node,
+                              const float dist_sq_max,
+                              float r_dist_sq[4])
+{
+#if BLI_HAVE_SSE2
+  const __m128 zero = _mm_setzero_ps();
+  __m128 dist_sq = zero;
+  for (int i = 0; i < 3; i++) {
+    const __m128 co_axis = _mm_set1_ps(co[i]);
+    const __m128 below = _mm_sub_ps(_mm_load_ps(node.bounds[2 * i]), co_axis);
+    const __m128 above = _mm_sub_ps(co_axis, _mm_load_ps(node.bounds[2 * i + 1]));
+    const __m128 delta = _mm_max_ps(_mm_max_ps(below, above), zero);
+    dist_sq = _mm_add_ps(dist_sq, _mm_mul_ps(delta, delta));
+  }
+  _mm_storeu_ps(r_dist_sq, dist_sq);
+  return _mm_movemask_ps(_mm_cmplt_ps(dist_sq, _mm_set1_ps(dist_sq_max)));
+#else
+  return wide_nearest_lanes_scalar(co, node, dist_sq_max, r_dist_sq);
+#endif
+}
+
+static int wide_nearest_lanes(const float co[3],
+                              const BVHWideNode<8> &node,
+                              const float dist_sq_max,
+                              float r_dist_sq[8])
+{
+#ifdef WITH_BVH_AVX2_KERNELS
+  return blender::kdopbvh_wide_kernels::nearest_lanes_avx2(
+      co, node.bounds, dist_sq_max, r_dist_sq);
+#else
+  return wide_nearest_lanes_scalar(co, node, dist_sq_max, r_dist_sq);
+#endif
+}
+
+/* Depth first search on the wide layout, visiting the closest children first. */
+template<int Width> static void dfs_find_nearest_wide(BVHNearestData *data, const int wide_index)
+{
+  const BVHWideNode<Width> &node = data->tree->wide->nodes<Width>()[wide_index];
+  float dist_sq[size_t(Width)];
+  int order[size_t(Width)];
+  const int mask = wide_nearest_lanes(data->proj, node, data->nearest.dist_sq, dist_sq) &
+                   ((1 << node.children_num) - 1);
+  const int lanes_num = wide_lanes_sort<Width>(mask, dist_sq, order);
+
+  for (int i = 0; i < lanes_num; i++) {
+    const int lane = order[i];
+    if (dist_sq[lane] >= data->nearest.dist_sq) {
+      continue;
+    }
+    if (node.children[lane] != -1) {
+      dfs_find_nearest_wide<Width>(data, node.children[lane]);
+      continue;
+    }
+    BVHNode *leaf = &data->tree->nodearray[node.nodes[lane]];
+    if (data->callback) {
+      data->callback(data->userdata, leaf->index, data->co, &data->nearest);
+    }
+    else {
+      data->nearest.index = leaf->index;
+      data->nearest.dist_sq = calc_nearest_point_squared(data->proj, leaf, data->nearest.co);
+    }
+  }
+}
+
 /* Priority queue method */
 static void heap_find_nearest_inner(BVHNearestData *data, HeapSimple *heap, BVHNode *node)
 {
@@ -1689,6 +2049,12 @@ int BLI_bvhtree_find_nearest_ex(const BVHTree *tree,
     if (flag & BVH_NEAREST_OPTIMAL_ORDER) {
       heap_find_nearest_begin(&data, root);
     }
+    else if (tree->wide && tree->wide->width == 8) {
+      dfs_find_nearest_wide<8>(&data, 0);
+    }
+    else if (tree->wide) {
+      dfs_find_nearest_wide<4>(&data, 0);
+    }
     else {
       dfs_find_nearest_begin(&data, root);
     }
@@ -1951,6 +2317,118 @@ static void dfs_raycast_all(BVHRayCastData *data, BVHNode *node)
   }
 }
 
+/**
+ * Distances along the ray to the bounds of all lanes of \a node, using the same slab test as
+ * #fast_ray_nearest_hit, with the bounds inflated by the ray radius.
+ * \return the mask of lanes hit closer than the current hit.
+ */
+template<int Width>
+static int wide_ray_lanes_scalar(const BVHRayCastData *data,
+                                 const BVHWideNode<Width> &node,
+                                 float r_dist[size_t(Width)])
+{
+  int mask = 0;
+  for (int lane = 0; lane < Width; lane++) {
+    float dist_near = data->dist_min;
+    float dist_far = FLT_MAX;
+    for (int i = 0; i < 3; i++) {
+      const float t_near = (node.bounds[data->index[2 * i]][lane] - data->origin_near[i]) *
+                           data->idot_axis[i];
+      const float t_far = (node.bounds[data->index[2 * i + 1]][lane] - data->origin_far[i]) *
+                          data->idot_axis[i];
+      dist_near = max_ff(dist_near, t_near);
+      dist_far = min_ff(dist_far, t_far);
+    }
+    r_dist[lane] = dist_near;
+    mask |= (dist_near <= dist_far && dist_far >= 0.0f && dist_near < data->hit.dist) << lane;
+  }
+  return mask;
+}
+
+static int wide_ray_lanes(const BVHRayCastData *data, const BVHWideNode<4> &node, float r_dist[4])
+{
+#if BLI_HAVE_SSE2
+  __m128 dist_near = _mm_set1_ps(data->dist_min);
+  __m128 dist_far = _mm_set1_ps(FLT_MAX);
+  for (int i = 0; i < 3; i++) {
+    const __m128 idot = _mm_set1_ps(data->idot_axis[i]);
+    const __m128 t_near = _mm_mul_ps(
+        _mm_sub_ps(_mm_load_ps(node.bounds[data->index[2 * i]]),
+                   _mm_set1_ps(data->origin_near[i])),
+        idot);
+    const __m128 t_far = _mm_mul_ps(
+        _mm_sub_ps(_mm_load_ps(node.bounds[data->index[2 * i + 1]]),
+                   _mm_set1_ps(data->origin_far[i])),
+        idot);
+    dist_near = _mm_max_ps(dist_near, t_near);
+    dist_far = _mm_min_ps(dist_far, t_far);
+  }
+  _mm_storeu_ps(r_dist, dist_near);
+  const __m128 is_hit = _mm_and_ps(
+      _mm_and_ps(_mm_cmple_ps(dist_near, dist_far), _mm_cmpge_ps(dist_far, _mm_setzero_ps())),
+      _mm_cmplt_ps(dist_near, _mm_set1_ps(data->hit.dist)));
+  return _mm_movemask_ps(is_hit);
+#else
+  return wide_ray_lanes_scalar(data, node, r_dist);
+#endif
+}
+
+static int wide_ray_lanes(const BVHRayCastData *data, const BVHWideNode<8> &node, float r_dist[8])
+{
+#ifdef WITH_BVH_AVX2_KERNELS
+  return blender::kdopbvh_wide_kernels::ray_lanes_avx2(node.bounds,
+                                                       data->index,
+                                                       data->origin_near,
+                                                       data->origin_far,
+                                                       data->idot_axis,
+                                                       data->dist_min,
+                                                       data->hit.dist,
+                                                       r_dist);
+#else
+  return wide_ray_lanes_scalar(data, node, r_dist);
+#endif
+}
+
+/**
+ * Version of #dfs_raycast and #dfs_raycast_all for the wide layout, visiting the closest
+ * children first.
+ */
+template<int Width>
+static void dfs_raycast_wide(BVHRayCastData *data, const int wide_index, const bool use_all)
+{
+  const BVHWideNode<Width> &node = data->tree->wide->nodes<Width>()[wide_index];
+  float dist[size_t(Width)];
+  int order[size_t(Width)];
+  const int mask = wide_ray_lanes(data, node, dist) & ((1 << node.children_num) - 1);
+  const int lanes_num = wide_lanes_sort<Width>(mask, dist, order);
+
+  for (int i = 0; i < lanes_num; i++) {
+    const int lane = order[i];
+    if (dist[lane] >= data->hit.dist) {
+      continue;
+    }
+    if (node.children[lane] != -1) {
+      dfs_raycast_wide<Width>(data, node.children[lane], use_all);
+      continue;
+    }
+    const BVHNode *leaf = &data->tree->nodearray[node.nodes[lane]];
+    if (use_all) {
+      const float hit_dist = data->hit.dist;
+      data->callback(data->userdata, leaf->index, &data->ray, &data->hit);
+      data->hit.index = -1;
+      data->hit.dist = hit_dist;
+    }
+    else if (data->callback) {
+      data->callback(data->userdata, leaf->index, &data->ray, &data->hit);
+    }
+    else {
+      data->hit.index = leaf->index;
+      data->hit.dist = dist[lane];
+      madd_v3_v3v3fl(data->hit.co, data->ray.origin, data->ray.direction, dist[lane]);
+    }
+  }
+}
+
 static void bvhtree_ray_cast_data_precalc(BVHRayCastData *data, int flag)
 {
   int i;
@@ -1971,7 +2449,13 @@ static void bvhtree_ray_cast_data_precalc(BVHRayCastData *data, int flag)
     data->index[2 * i + 1] = 1 - data->index[2 * i];
     data->index[2 * i] += 2 * i;
     data->index[2 * i + 1] += 2 * i;
+
+    /* The near plane is the minimum when `index[2 * i]` is even. */
+    const float radius_near = (data->index[2 * i] & 1) ? -data->ray.radius : data->ray.radius;
+    data->origin_near[i] = data->ray.origin[i] + radius_near;
+    data->origin_far[i] = data->ray.origin[i] - radius_near;
   }
+  data->dist_min = (data->ray.radius == 0.0f) ? -FLT_MAX : 0.0f;
 
 #ifdef USE_KDOPBVH_WATERTIGHT
   if (flag & BVH_RAYCAST_WATERTIGHT) {
@@ -2019,7 +2503,13 @@ int BLI_bvhtree_ray_cast_ex(const BVHTree *tree,
     data.hit.dist = BVH_RAYCAST_DIST_MAX;
   }
 
-  if (root) {
+  if (data.tree->wide && data.tree->wide->width == 8) {
+    dfs_raycast_wide<8>(&data, 0, false);
+  }
+  else if (data.tree->wide) {
+    dfs_raycast_wide<4>(&data, 0, false);
+  }
+  else if (root) {
     dfs_raycast(&data, root);
     //      iterative_raycast(&data, root);
   }
@@ -2099,7 +2589,13 @@ void BLI_bvhtree_ray_cast_all_ex(const BVHTree *tree,
   data.hit.index = -1;
   data.hit.dist = hit_dist;
 
-  if (root) {
+  if (data.tree->wide && data.tree->wide->width == 8) {
+    dfs_raycast_wide<8>(&data, 0, true);
+  }
+  else if (data.tree->wide) {
+    dfs_raycast_wide<4>(&data, 0, true);
+  }
+  else if (root) {
     dfs_raycast_all(&data, root);
   }
 }
@@ -2398,3 +2894,47 @@ int BLI_bvhtree_find_nearest_projected(const BVHTree *tree,
 }
 
 /** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Batched Queries
+ * \{ */
+
+namespace blender {
+
+void BLI_bvhtree_ray_cast_batch(const BVHTree &tree,
+                                const Span<float3> origins,
+                                const Span<float3> directions,
+                                const float radius,
+                                MutableSpan<BVHTreeRayHit> r_hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                const int flag)
+{
+  BLI_assert(origins.size() == directions.size());
+  BLI_assert(origins.size() == r_hits.size());
+  threading::parallel_for(origins.index_range(), 256, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      BLI_bvhtree_ray_cast_ex(
+          &tree, origins[i], directions[i], radius, &r_hits[i], callback, userdata, flag);
+    }
+  });
+}
+
+void BLI_bvhtree_find_nearest_batch(const BVHTree &tree,
+                                    const Span<float3> positions,
+                                    MutableSpan<BVHTreeNearest> r_nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    const int flag)
+{
+  BLI_assert(positions.size() == r_nearest.size());
+  threading::parallel_for(positions.index_range(), 256, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      BLI_bvhtree_find_nearest_ex(&tree, positions[i], &r_nearest[i], callback, userdata, flag);
+    }
+  });
+}
+
+}  // namespace blender
+
+/** \} */
@@ -542,6 +542,104 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Thread Local Caches
+ *
+ * Used by #blender::ThreadSafeMempool, elements in thread local caches are taken from the free
+ * list but stay marked as free, so iteration skips them. The number of used elements is counted
+ * per thread and added to the pool in batches as well.
+ * \{ */
+
+void *mempool_free_list_take(BLI_mempool *pool, const uint elem_num)
+{
+  BLI_assert(elem_num > 0);
+  BLI_freenode *head = NULL;
+  BLI_freenode *tail = NULL;
+  uint taken_num = 0;
+
+  while (taken_num < elem_num) {
+    if (UNLIKELY(pool->free == NULL)) {
+      BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
+      mempool_chunk_add(pool, mpchunk, NULL);
+    }
+    BLI_freenode *node = pool->free;
+    /* Elements in thread local caches are accessed without going through the pool. */
+    BLI_asan_unpoison(node, pool->esize - POISON_REDZONE_SIZE);
+    pool->free = node->next;
+
+    if (tail) {
+      tail->next = node;
+    }
+    else {
+      head = node;
+    }
+    tail = node;
+    taken_num++;
+  }
+  tail->next = NULL;
+  return head;
+}
+
+void mempool_free_list_return(BLI_mempool *pool, void *head, void *tail)
+{
+  BLI_freenode *tail_node = tail;
+  tail_node->next = pool->free;
+
+  if (POISON_REDZONE_SIZE > 0) {
+    BLI_freenode *node = head;
+    while (node != tail_node) {
+      BLI_freenode *next = node->next;
+      BLI_asan_poison(node, pool->esize);
+      node = next;
+    }
+    BLI_asan_poison(tail_node, pool->esize);
+  }
+
+  pool->free = head;
+}
+
+void mempool_elem_mark_used(BLI_mempool *pool, void *elem)
+{
+  BLI_freenode *node = elem;
+#ifdef WITH_MEM_VALGRIND
+  VALGRIND_MEMPOOL_ALLOC(pool, node, pool->esize - POISON_REDZONE_SIZE);
+#endif
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+    node->freeword = USEDWORD;
+  }
+}
+
+void mempool_elem_mark_free(BLI_mempool *pool, void *elem)
+{
+  BLI_freenode *node = elem;
+#ifndef NDEBUG
+  if (UNLIKELY(mempool_debug_memset)) {
+    memset(elem, 255, pool->esize - POISON_REDZONE_SIZE);
+  }
+#endif
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+    /* This will detect double free's. */
+    BLI_assert(node->freeword != FREEWORD);
+    node->freeword = FREEWORD;
+  }
+#ifdef WITH_MEM_VALGRIND
+  VALGRIND_MEMPOOL_FREE(pool, elem);
+#endif
+}
+
+void mempool_elem_clear(BLI_mempool *pool, void *elem)
+{
+  memset(elem, 0, (size_t)pool->esize - POISON_REDZONE_SIZE);
+}
+
+void mempool_used_num_add(BLI_mempool *pool, const int delta)
+{
+  BLI_assert((int)pool->totused + delta >= 0);
+  pool->totused = (uint)((int)pool->totused + delta);
+}
+
+/** \} */
+
 int BLI_mempool_len(const BLI_mempool *pool)
 {
   int ret = (int)pool->totused;
@@ -7,8 +7,8 @@
 /** \file
  * \ingroup bli
  *
- * Shared logic for #BLI_task_parallel_mempool to create a threaded iterator,
- * without exposing the these functions publicly.
+ * Shared logic for #BLI_task_parallel_mempool to create a threaded iterator and for the thread
+ * local caches of #blender::ThreadSafeMempool, without exposing the these functions publicly.
  */
 
 #include "BLI_compiler_attrs.h"
@@ -16,6 +16,10 @@
 #include "BLI_mempool.h"
 #include "BLI_task.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct BLI_mempool_threadsafe_iter {
   BLI_mempool_iter iter;
   struct BLI_mempool_chunk **curchunk_threaded_shared;
@@ -51,6 +55,37 @@ void mempool_iter_threadsafe_destroy(ParallelMempoolTaskData *iter_arr) ATTR_NON
  */
 void *mempool_iter_threadsafe_step(BLI_mempool_threadsafe_iter *ts_iter);
 
+/**
+ * Take \a elem_num elements from the free list of the pool for a thread local cache, allocating
+ * new chunks when needed. The elements stay marked as free, they are linked through their first
+ * pointer and the last one points to null.
+ *
+ * \return The first element.
+ */
+void *mempool_free_list_take(BLI_mempool *pool, uint elem_num) ATTR_WARN_UNUSED_RESULT
+    ATTR_RETURNS_NONNULL ATTR_NONNULL();
+/**
+ * Give a list of free elements taken with #mempool_free_list_take back to the pool.
+ */
+void mempool_free_list_return(BLI_mempool *pool, void *head, void *tail) ATTR_NONNULL();
+/**
+ * Mark an element of a thread local cache as used. Thread-safe, it doesn't change the number of
+ * used elements of the pool, see #mempool_used_num_add.
+ */
+void mempool_elem_mark_used(BLI_mempool *pool, void *elem) ATTR_NONNULL();
+/**
+ * Mark a used element as free before putting it into a thread local cache. Thread-safe.
+ */
+void mempool_elem_mark_free(BLI_mempool *pool, void *elem) ATTR_NONNULL();
+/**
+ * Clear a used element to zero, like #BLI_mempool_calloc.
+ */
+void mempool_elem_clear(BLI_mempool *pool, void *elem) ATTR_NONNULL();
+/**
+ * Add the change of used elements of a thread local cache to the pool.
+ */
+void mempool_used_num_add(BLI_mempool *pool, int delta) ATTR_NONNULL();
+
 #ifdef __cplusplus
 }
 #endif
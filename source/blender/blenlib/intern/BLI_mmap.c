@@ -218,6 +218,11 @@ size_t BLI_mmap_get_length(const BLI_mmap_file *file)
   return file->length;
 }
 
+bool BLI_mmap_has_io_error(const BLI_mmap_file *file)
+{
+  return file->io_error;
+}
+
 void BLI_mmap_free(BLI_mmap_file *file)
 {
 #ifndef WIN32
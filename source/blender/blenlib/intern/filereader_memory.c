@@ -62,6 +62,15 @@ static off64_t memory_seek(FileReader *reader, off64_t offset, int whence)
   return mem->reader.offset;
 }
 
+static const void *memory_peek_raw(FileReader *reader, off64_t offset, size_t size)
+{
+  MemoryReader *mem = (MemoryReader *)reader;
+  if (offset < 0 || (size_t)offset + size > mem->length) {
+    return NULL;
+  }
+  return mem->data + offset;
+}
+
 static void memory_close_raw(FileReader *reader)
 {
   MEM_freeN(reader);
@@ -77,6 +86,7 @@ FileReader *BLI_filereader_new_memory(const void *data, size_t len)
   mem->reader.read = memory_read_raw;
   mem->reader.seek = memory_seek;
   mem->reader.close = memory_close_raw;
+  mem->reader.peek = memory_peek_raw;
 
   return (FileReader *)mem;
 }
@@ -103,6 +113,26 @@ static int64_t memory_read_mmap(FileReader *reader, void *buffer, size_t size)
   return readsize;
 }
 
+#ifndef WIN32
+/* Direct access to the mapped memory is only safe where IO errors are handled by the SIGBUS
+ * handler in `BLI_mmap.c`, which replaces the mapping with zeroes and makes further reads fail.
+ * On Windows errors are only caught inside #BLI_mmap_read. */
+static const void *memory_peek_mmap(FileReader *reader, off64_t offset, size_t size)
+{
+  MemoryReader *mem = (MemoryReader *)reader;
+  if (offset < 0 || (size_t)offset + size > mem->length || BLI_mmap_has_io_error(mem->mmap)) {
+    return NULL;
+  }
+  return (const char *)BLI_mmap_get_pointer(mem->mmap) + offset;
+}
+
+static bool memory_peek_has_error_mmap(FileReader *reader)
+{
+  MemoryReader *mem = (MemoryReader *)reader;
+  return BLI_mmap_has_io_error(mem->mmap);
+}
+#endif
+
 static void memory_close_mmap(FileReader *reader)
 {
   MemoryReader *mem = (MemoryReader *)reader;
@@ -125,6 +155,10 @@ FileReader *BLI_filereader_new_mmap(int filedes)
   mem->reader.read = memory_read_mmap;
   mem->reader.seek = memory_seek;
   mem->reader.close = memory_close_mmap;
+#ifndef WIN32
+  mem->reader.peek = memory_peek_mmap;
+  mem->reader.peek_has_error = memory_peek_has_error_mmap;
+#endif
 
   return (FileReader *)mem;
 }
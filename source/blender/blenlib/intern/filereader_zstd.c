@@ -11,6 +11,8 @@
 
 #include "BLI_filereader.h"
 #include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #ifdef __BIG_ENDIAN__
 #  include "BLI_endian_switch.h"
@@ -18,6 +20,16 @@
 
 #include "MEM_guardedalloc.h"
 
+/** A frame decompressed by a worker thread of the read-ahead window. */
+typedef struct ZstdFrameSlot {
+  ZSTD_DCtx *ctx;
+  const char *compressed_data;
+  size_t compressed_size;
+  char *uncompressed_data;
+  size_t uncompressed_size;
+  bool valid;
+} ZstdFrameSlot;
+
 typedef struct {
   FileReader reader;
 
@@ -35,8 +47,37 @@ typedef struct {
     char *cached_content;
     int cached_frame;
   } seek;
+
+  /** Only used by the parallel reader, see #BLI_filereader_new_zstd_parallel. */
+  struct {
+    TaskPool *pool;
+    /** Number of frames decompressed together, each batch has this many slots. */
+    int batch_size;
+    /** Two batches of `batch_size` slots: one being consumed, one being decompressed. */
+    ZstdFrameSlot *slots;
+    /** Compressed input of each batch, read with a single call from the base reader. */
+    char *compressed_data[2];
+    /** Index of the batch that is ready for reading, the other one may be pending. */
+    int ready_batch;
+    int batch_first[2];
+    int batch_num[2];
+    /** The frame of the previous read, to detect sequential reads. */
+    int last_frame;
+    /** Number of frames read in order since the last seek to a different frame. */
+    int sequential_frames_num;
+  } readahead;
 } ZstdReader;
 
+/* Maximum number of frames per read-ahead batch, bounds the memory used by the window
+ * to roughly `2 * ZSTD_READAHEAD_BATCH_MAX` uncompressed frames (1 MB each when written by
+ * Blender). */
+#define ZSTD_READAHEAD_BATCH_MAX 16
+
+/* Number of frames that have to be read in order before frames are decompressed ahead of the
+ * read position. Reading a few blocks after seeking shouldn't decompress a whole window of frames
+ * that are never used. */
+#define ZSTD_READAHEAD_MIN_SEQUENTIAL_FRAMES 4
+
 static bool zstd_read_u32(FileReader *base, uint32_t *val)
 {
   if (base->read(base, val, sizeof(uint32_t)) != sizeof(uint32_t)) {
@@ -195,6 +236,154 @@ static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
   return uncompressed_data;
 }
 
+static void zstd_readahead_decompress_task(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  ZstdFrameSlot *slot = (ZstdFrameSlot *)taskdata;
+  size_t res = ZSTD_decompressDCtx(slot->ctx,
+                                   slot->uncompressed_data,
+                                   slot->uncompressed_size,
+                                   slot->compressed_data,
+                                   slot->compressed_size);
+  slot->valid = !ZSTD_isError(res) && res == slot->uncompressed_size;
+}
+
+static void zstd_readahead_batch_free(ZstdReader *zstd, int batch)
+{
+  ZstdFrameSlot *slots = zstd->readahead.slots + batch * zstd->readahead.batch_size;
+  for (int i = 0; i < zstd->readahead.batch_num[batch]; i++) {
+    MEM_SAFE_FREE(slots[i].uncompressed_data);
+    slots[i].valid = false;
+  }
+  MEM_SAFE_FREE(zstd->readahead.compressed_data[batch]);
+  zstd->readahead.batch_first[batch] = -1;
+  zstd->readahead.batch_num[batch] = 0;
+}
+
+static bool zstd_readahead_batch_contains(const ZstdReader *zstd, int batch, int frame)
+{
+  const int first = zstd->readahead.batch_first[batch];
+  return first != -1 && frame >= first && frame < first + zstd->readahead.batch_num[batch];
+}
+
+/**
+ * Read the compressed data of the frames starting at `first` and start decompressing them on
+ * the task scheduler. Reading from the base reader happens on the calling thread only, worker
+ * threads never access it.
+ */
+static void zstd_readahead_batch_start(ZstdReader *zstd, int batch, int first)
+{
+  zstd_readahead_batch_free(zstd, batch);
+
+  const int frames_num = min_ii(zstd->readahead.batch_size, zstd->seek.frames_num - first);
+  if (frames_num <= 0) {
+    return;
+  }
+
+  const size_t compressed_start = zstd->seek.compressed_ofs[first];
+  const size_t compressed_size = zstd->seek.compressed_ofs[first + frames_num] - compressed_start;
+  char *compressed_data = MEM_mallocN(compressed_size, __func__);
+  if (zstd->base->seek(zstd->base, compressed_start, SEEK_SET) < 0 ||
+      zstd->base->read(zstd->base, compressed_data, compressed_size) < compressed_size)
+  {
+    MEM_freeN(compressed_data);
+    return;
+  }
+
+  zstd->readahead.compressed_data[batch] = compressed_data;
+  zstd->readahead.batch_first[batch] = first;
+  zstd->readahead.batch_num[batch] = frames_num;
+
+  ZstdFrameSlot *slots = zstd->readahead.slots + batch * zstd->readahead.batch_size;
+  for (int i = 0; i < frames_num; i++) {
+    const int frame = first + i;
+    ZstdFrameSlot *slot = &slots[i];
+    slot->compressed_data = compressed_data + (zstd->seek.compressed_ofs[frame] -
+                                               compressed_start);
+    slot->compressed_size = zstd->seek.compressed_ofs[frame + 1] -
+                            zstd->seek.compressed_ofs[frame];
+    slot->uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
+                              zstd->seek.uncompressed_ofs[frame];
+    slot->uncompressed_data = MEM_mallocN(slot->uncompressed_size, __func__);
+    slot->valid = false;
+    BLI_task_pool_push(
+        zstd->readahead.pool, zstd_readahead_decompress_task, slot, false, NULL);
+  }
+}
+
+/**
+ * Parallel version of #zstd_ensure_cache: frames are decompressed in batches on the task
+ * scheduler, while the next batch is already being decompressed when the current one is read.
+ * The window is started at the requested frame when it doesn't contain it yet.
+ */
+static const char *zstd_readahead_ensure(ZstdReader *zstd, int frame)
+{
+  int ready = zstd->readahead.ready_batch;
+  int pending = 1 - ready;
+
+  if (!zstd_readahead_batch_contains(zstd, ready, frame)) {
+    /* All tasks belong to the pending batch, so this only waits for that. */
+    BLI_task_pool_work_and_wait(zstd->readahead.pool);
+
+    if (zstd_readahead_batch_contains(zstd, pending, frame)) {
+      zstd_readahead_batch_free(zstd, ready);
+    }
+    else {
+      /* Start the window at the requested frame. */
+      zstd_readahead_batch_free(zstd, ready);
+      zstd_readahead_batch_start(zstd, pending, frame);
+      BLI_task_pool_work_and_wait(zstd->readahead.pool);
+    }
+    ready = zstd->readahead.ready_batch = pending;
+    pending = 1 - ready;
+
+    /* Start decompressing the frames that follow while the current batch is consumed. */
+    if (zstd->readahead.batch_num[ready] > 0) {
+      zstd_readahead_batch_start(
+          zstd, pending, zstd->readahead.batch_first[ready] + zstd->readahead.batch_num[ready]);
+    }
+  }
+
+  if (!zstd_readahead_batch_contains(zstd, ready, frame)) {
+    return NULL;
+  }
+  const ZstdFrameSlot *slot = &zstd->readahead.slots[ready * zstd->readahead.batch_size +
+                                                     (frame - zstd->readahead.batch_first[ready])];
+  return slot->valid ? slot->uncompressed_data : NULL;
+}
+
+/** Wait for pending decompression and free the read-ahead window. */
+static void zstd_readahead_stop(ZstdReader *zstd)
+{
+  BLI_task_pool_work_and_wait(zstd->readahead.pool);
+  zstd_readahead_batch_free(zstd, 0);
+  zstd_readahead_batch_free(zstd, 1);
+  zstd->readahead.ready_batch = 0;
+}
+
+/**
+ * Get the uncompressed data of the frame for the parallel reader. Frames are only decompressed
+ * ahead once enough frames were read in order, and seeking to another frame stops that again, so
+ * that seek-driven access decompresses only the frames it reads.
+ */
+static const char *zstd_readahead_frame_get(ZstdReader *zstd, int frame)
+{
+  if (frame == zstd->readahead.last_frame + 1) {
+    zstd->readahead.sequential_frames_num++;
+  }
+  else if (frame != zstd->readahead.last_frame) {
+    zstd->readahead.sequential_frames_num = 0;
+    if (zstd->readahead.batch_first[zstd->readahead.ready_batch] != -1) {
+      zstd_readahead_stop(zstd);
+    }
+  }
+  zstd->readahead.last_frame = frame;
+
+  if (zstd->readahead.sequential_frames_num < ZSTD_READAHEAD_MIN_SEQUENTIAL_FRAMES) {
+    return zstd_ensure_cache(zstd, frame);
+  }
+  return zstd_readahead_ensure(zstd, frame);
+}
+
 static int64_t zstd_read_seekable(FileReader *reader, void *buffer, size_t size)
 {
   ZstdReader *zstd = (ZstdReader *)reader;
@@ -207,7 +396,8 @@ static int64_t zstd_read_seekable(FileReader *reader, void *buffer, size_t size)
       break;
     }
 
-    const char *framedata = zstd_ensure_cache(zstd, frame);
+    const char *framedata = zstd->readahead.pool ? zstd_readahead_frame_get(zstd, frame) :
+                                                   zstd_ensure_cache(zstd, frame);
     if (framedata == NULL) {
       /* Error while reading the frame, so return as much as we can. */
       break;
@@ -282,6 +472,14 @@ static void zstd_close(FileReader *reader)
   ZstdReader *zstd = (ZstdReader *)reader;
 
   ZSTD_freeDCtx(zstd->ctx);
+  if (zstd->readahead.pool) {
+    zstd_readahead_stop(zstd);
+    BLI_task_pool_free(zstd->readahead.pool);
+    for (int i = 0; i < 2 * zstd->readahead.batch_size; i++) {
+      ZSTD_freeDCtx(zstd->readahead.slots[i].ctx);
+    }
+    MEM_freeN(zstd->readahead.slots);
+  }
   if (zstd->reader.seek) {
     MEM_freeN(zstd->seek.uncompressed_ofs);
     MEM_freeN(zstd->seek.compressed_ofs);
@@ -327,3 +525,25 @@ FileReader *BLI_filereader_new_zstd(FileReader *base)
 
   return (FileReader *)zstd;
 }
+
+FileReader *BLI_filereader_new_zstd_parallel(FileReader *base)
+{
+  ZstdReader *zstd = (ZstdReader *)BLI_filereader_new_zstd(base);
+  if (zstd->reader.seek == NULL || zstd->seek.frames_num < 2) {
+    /* Without a seek table the frame boundaries are unknown, decompress serially. */
+    return (FileReader *)zstd;
+  }
+
+  const int batch_size = clamp_i(BLI_system_thread_count(), 2, ZSTD_READAHEAD_BATCH_MAX);
+  zstd->readahead.batch_size = batch_size;
+  zstd->readahead.slots = MEM_calloc_arrayN(2 * batch_size, sizeof(ZstdFrameSlot), __func__);
+  for (int i = 0; i < 2 * batch_size; i++) {
+    zstd->readahead.slots[i].ctx = ZSTD_createDCtx();
+  }
+  zstd->readahead.ready_batch = 0;
+  zstd->readahead.batch_first[0] = zstd->readahead.batch_first[1] = -1;
+  zstd->readahead.last_frame = -1;
+  zstd->readahead.pool = BLI_task_pool_create(zstd, TASK_PRIORITY_HIGH);
+
+  return (FileReader *)zstd;
+}
@@ -0,0 +1,68 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ *
+ * AVX2 versions of the wide BVH-tree kernels, testing eight children at once. This file is
+ * compiled with AVX2 enabled, so it must only use the kernels header and intrinsics, see
+ * `kdopbvh_wide_kernels.hh`.
+ */
+
+#include <cfloat>
+#include <immintrin.h>
+
+#include "kdopbvh_wide_kernels.hh"
+
+namespace blender::kdopbvh_wide_kernels {
+
+int nearest_lanes_avx2(const float co[3],
+                       const float (*bounds)[8],
+                       const float dist_sq_max,
+                       float r_dist_sq[8])
+{
+  const __m256 zero = _mm256_setzero_ps();
+  __m256 dist_sq = zero;
+  for (int i = 0; i < 3; i++) {
+    const __m256 co_axis = _mm256_set1_ps(co[i]);
+    const __m256 below = _mm256_sub_ps(_mm256_load_ps(bounds[2 * i]), co_axis);
+    const __m256 above = _mm256_sub_ps(co_axis, _mm256_load_ps(bounds[2 * i + 1]));
+    const __m256 delta = _mm256_max_ps(_mm256_max_ps(below, above), zero);
+    dist_sq = _mm256_add_ps(dist_sq, _mm256_mul_ps(delta, delta));
+  }
+  _mm256_storeu_ps(r_dist_sq, dist_sq);
+  return _mm256_movemask_ps(_mm256_cmp_ps(dist_sq, _mm256_set1_ps(dist_sq_max), _CMP_LT_OQ));
+}
+
+int ray_lanes_avx2(const float (*bounds)[8],
+                   const int index[6],
+                   const float origin_near[3],
+                   const float origin_far[3],
+                   const float idot_axis[3],
+                   const float dist_min,
+                   const float hit_dist,
+                   float r_dist[8])
+{
+  __m256 dist_near = _mm256_set1_ps(dist_min);
+  __m256 dist_far = _mm256_set1_ps(FLT_MAX);
+  for (int i = 0; i < 3; i++) {
+    const __m256 idot = _mm256_set1_ps(idot_axis[i]);
+    const __m256 t_near = _mm256_mul_ps(
+        _mm256_sub_ps(_mm256_load_ps(bounds[index[2 * i]]), _mm256_set1_ps(origin_near[i])),
+        idot);
+    const __m256 t_far = _mm256_mul_ps(
+        _mm256_sub_ps(_mm256_load_ps(bounds[index[2 * i + 1]]), _mm256_set1_ps(origin_far[i])),
+        idot);
+    dist_near = _mm256_max_ps(dist_near, t_near);
+    dist_far = _mm256_min_ps(dist_far, t_far);
+  }
+  _mm256_storeu_ps(r_dist, dist_near);
+  const __m256 is_hit = _mm256_and_ps(
+      _mm256_and_ps(_mm256_cmp_ps(dist_near, dist_far, _CMP_LE_OQ),
+                    _mm256_cmp_ps(dist_far, _mm256_setzero_ps(), _CMP_GE_OQ)),
+      _mm256_cmp_ps(dist_near, _mm256_set1_ps(hit_dist), _CMP_LT_OQ));
+  return _mm256_movemask_ps(is_hit);
+}
+
+}  // namespace blender::kdopbvh_wide_kernels
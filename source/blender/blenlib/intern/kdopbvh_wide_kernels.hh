@@ -0,0 +1,41 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Kernels that test a ray or point against all children of a node of the wide BVH-tree layout,
+ * see #BLI_bvhtree_build_wide. The bounds of the children are stored by lane: min/max X, min/max
+ * Y, min/max Z. The kernels return the mask of lanes that pass the test, lanes of unused children
+ * have to be masked out by the caller.
+ */
+
+namespace blender::kdopbvh_wide_kernels {
+
+#ifdef WITH_BVH_AVX2_KERNELS
+/* Defined in `kdopbvh_wide_avx2.cc`. Only call these when #BLI_cpu_support_avx2 is true. */
+
+/** Squared distances from \a co to the bounds, with the mask of lanes below \a dist_sq_max. */
+int nearest_lanes_avx2(const float co[3],
+                       const float (*bounds)[8],
+                       float dist_sq_max,
+                       float r_dist_sq[8]);
+
+/**
+ * Distances along a ray to the bounds, with the mask of lanes that are hit before \a hit_dist.
+ * The arguments are the precalculated values of #BVHRayCastData.
+ */
+int ray_lanes_avx2(const float (*bounds)[8],
+                   const int index[6],
+                   const float origin_near[3],
+                   const float origin_far[3],
+                   const float idot_axis[3],
+                   float dist_min,
+                   float hit_dist,
+                   float r_dist[8]);
+#endif
+
+}  // namespace blender::kdopbvh_wide_kernels
@@ -0,0 +1,219 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ *
+ * Batch transform functions. The kernels for the instruction set the file is compiled with (SSE
+ * on x86 and NEON through `sse2neon` on ARM) are defined here. When AVX2 kernels are compiled as
+ * well, they are used instead on CPUs that support them.
+ */
+
+#include <cmath>
+
+#include "BLI_math_matrix.hh"
+#include "BLI_simd.hh"
+#include "BLI_system.h"
+#include "BLI_task.hh"
+
+#include "math_matrix_batch_kernels.hh"
+
+namespace blender::math {
+
+namespace transform_kernels {
+namespace {
+
+#if BLI_HAVE_SSE2
+struct SimdSSE {
+  using V = __m128;
+  static constexpr int64_t width = 4;
+
+  static V set1(const float value)
+  {
+    return _mm_set1_ps(value);
+  }
+  static V add(const V a, const V b)
+  {
+    return _mm_add_ps(a, b);
+  }
+  static V mul(const V a, const V b)
+  {
+    return _mm_mul_ps(a, b);
+  }
+  static V div(const V a, const V b)
+  {
+    return _mm_div_ps(a, b);
+  }
+  /** `a * b + c` */
+  static V madd(const V a, const V b, const V c)
+  {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+  }
+  static V sqrt(const V a)
+  {
+    return _mm_sqrt_ps(a);
+  }
+  /** `a > b ? value : 0` */
+  static V select_greater(const V a, const V b, const V value)
+  {
+    return _mm_and_ps(_mm_cmpgt_ps(a, b), value);
+  }
+  template<int I0, int I1, int I2, int I3> static V shuffle(const V a, const V b)
+  {
+    return _mm_shuffle_ps(a, b, _MM_SHUFFLE(I3, I2, I1, I0));
+  }
+
+  static void load3(const float *src, V &r_a, V &r_b, V &r_c)
+  {
+    r_a = _mm_loadu_ps(src);
+    r_b = _mm_loadu_ps(src + 4);
+    r_c = _mm_loadu_ps(src + 8);
+  }
+
+  static void store3(float *dst, const V a, const V b, const V c)
+  {
+    _mm_storeu_ps(dst, a);
+    _mm_storeu_ps(dst + 4, b);
+    _mm_storeu_ps(dst + 8, c);
+  }
+};
+#endif
+
+template<bool UseTranslation, bool Normalize>
+int64_t transform_default(const float *src, float *dst, const int64_t num, const float *m)
+{
+#if BLI_HAVE_SSE2
+  return transform_simd<SimdSSE, UseTranslation, Normalize>(src, dst, num, m);
+#else
+  UNUSED_VARS(src, dst, num, m);
+  return 0;
+#endif
+}
+
+/** Transform the vectors that are not handled by the SIMD kernels. */
+template<bool UseTranslation, bool Normalize>
+void transform_scalar(const float *src, float *dst, const int64_t num, const float *m)
+{
+  for (int64_t i = 0; i < num; i++) {
+    const float x = src[i * 3 + 0];
+    const float y = src[i * 3 + 1];
+    const float z = src[i * 3 + 2];
+    float rx = m[0] * x + m[4] * y + m[8] * z;
+    float ry = m[1] * x + m[5] * y + m[9] * z;
+    float rz = m[2] * x + m[6] * y + m[10] * z;
+    if constexpr (UseTranslation) {
+      rx += m[12];
+      ry += m[13];
+      rz += m[14];
+    }
+    if constexpr (Normalize) {
+      const float length_squared = rx * rx + ry * ry + rz * rz;
+      const float factor = length_squared > normalize_threshold ?
+                               1.0f / std::sqrt(length_squared) :
+                               0.0f;
+      rx *= factor;
+      ry *= factor;
+      rz *= factor;
+    }
+    dst[i * 3 + 0] = rx;
+    dst[i * 3 + 1] = ry;
+    dst[i * 3 + 2] = rz;
+  }
+}
+
+using KernelFn = int64_t (*)(const float *src, float *dst, int64_t num, const float *m);
+
+struct Kernels {
+  KernelFn points;
+  KernelFn directions;
+  KernelFn normals;
+};
+
+const Kernels &get_kernels()
+{
+  static const Kernels kernels = []() -> Kernels {
+#ifdef WITH_MATH_AVX2_KERNELS
+    if (BLI_cpu_support_avx2()) {
+      return {transform_points_avx2, transform_directions_avx2, transform_normals_avx2};
+    }
+#endif
+    return {transform_default<true, false>,
+            transform_default<false, false>,
+            transform_default<false, true>};
+  }();
+  return kernels;
+}
+
+}  // namespace
+}  // namespace transform_kernels
+
+template<bool UseTranslation, bool Normalize>
+static void transform_batch(const transform_kernels::KernelFn kernel,
+                            const Span<float3> src,
+                            const float4x4 &mat,
+                            MutableSpan<float3> dst,
+                            const bool use_threading)
+{
+  BLI_assert(src.size() == dst.size());
+  const float *m = mat.base_ptr();
+  const auto transform_range = [&](const IndexRange range) {
+    const float *src_ptr = reinterpret_cast<const float *>(src.data() + range.start());
+    float *dst_ptr = reinterpret_cast<float *>(dst.data() + range.start());
+    const int64_t done = kernel(src_ptr, dst_ptr, range.size(), m);
+    transform_kernels::transform_scalar<UseTranslation, Normalize>(
+        src_ptr + done * 3, dst_ptr + done * 3, range.size() - done, m);
+  };
+  if (use_threading) {
+    threading::parallel_for(src.index_range(), 8192, transform_range);
+  }
+  else {
+    transform_range(src.index_range());
+  }
+}
+
+void transform_points(const Span<float3> src,
+                      const float4x4 &mat,
+                      MutableSpan<float3> dst,
+                      const bool use_threading)
+{
+  transform_batch<true, false>(
+      transform_kernels::get_kernels().points, src, mat, dst, use_threading);
+}
+
+void transform_points(MutableSpan<float3> points, const float4x4 &mat, const bool use_threading)
+{
+  transform_points(points, mat, points, use_threading);
+}
+
+void transform_directions(const Span<float3> src,
+                          const float3x3 &mat,
+                          MutableSpan<float3> dst,
+                          const bool use_threading)
+{
+  transform_batch<false, false>(
+      transform_kernels::get_kernels().directions, src, float4x4(mat), dst, use_threading);
+}
+
+void transform_directions(MutableSpan<float3> directions,
+                          const float3x3 &mat,
+                          const bool use_threading)
+{
+  transform_directions(directions, mat, directions, use_threading);
+}
+
+void transform_normals(const Span<float3> src,
+                       const float3x3 &mat,
+                       MutableSpan<float3> dst,
+                       const bool use_threading)
+{
+  transform_batch<false, true>(
+      transform_kernels::get_kernels().normals, src, float4x4(mat), dst, use_threading);
+}
+
+void transform_normals(MutableSpan<float3> normals, const float3x3 &mat, const bool use_threading)
+{
+  transform_normals(normals, mat, normals, use_threading);
+}
+
+}  // namespace blender::math
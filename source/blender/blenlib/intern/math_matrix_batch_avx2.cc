@@ -0,0 +1,101 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ *
+ * AVX2 versions of the batch transform kernels. This file is compiled with AVX2 and FMA enabled,
+ * so it must only use the kernels header and intrinsics, see `math_matrix_batch_kernels.hh`.
+ */
+
+#include <immintrin.h>
+
+#include "math_matrix_batch_kernels.hh"
+
+namespace blender::math::transform_kernels {
+
+namespace {
+
+struct SimdAVX2 {
+  using V = __m256;
+  static constexpr int64_t width = 8;
+
+  static V set1(const float value)
+  {
+    return _mm256_set1_ps(value);
+  }
+  static V add(const V a, const V b)
+  {
+    return _mm256_add_ps(a, b);
+  }
+  static V mul(const V a, const V b)
+  {
+    return _mm256_mul_ps(a, b);
+  }
+  static V div(const V a, const V b)
+  {
+    return _mm256_div_ps(a, b);
+  }
+  /** `a * b + c` */
+  static V madd(const V a, const V b, const V c)
+  {
+    return _mm256_fmadd_ps(a, b, c);
+  }
+  static V sqrt(const V a)
+  {
+    return _mm256_sqrt_ps(a);
+  }
+  /** `a > b ? value : 0` */
+  static V select_greater(const V a, const V b, const V value)
+  {
+    return _mm256_and_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ), value);
+  }
+  template<int I0, int I1, int I2, int I3> static V shuffle(const V a, const V b)
+  {
+    return _mm256_shuffle_ps(a, b, _MM_SHUFFLE(I3, I2, I1, I0));
+  }
+
+  static V load_lanes(const float *lower, const float *upper)
+  {
+    const __m256 result = _mm256_castps128_ps256(_mm_loadu_ps(lower));
+    return _mm256_insertf128_ps(result, _mm_loadu_ps(upper), 1);
+  }
+
+  /** The first four vectors are stored in the lower lanes, the next four in the upper lanes. */
+  static void load3(const float *src, V &r_a, V &r_b, V &r_c)
+  {
+    r_a = load_lanes(src, src + 12);
+    r_b = load_lanes(src + 4, src + 16);
+    r_c = load_lanes(src + 8, src + 20);
+  }
+
+  static void store3(float *dst, const V a, const V b, const V c)
+  {
+    _mm_storeu_ps(dst, _mm256_castps256_ps128(a));
+    _mm_storeu_ps(dst + 4, _mm256_castps256_ps128(b));
+    _mm_storeu_ps(dst + 8, _mm256_castps256_ps128(c));
+    _mm_storeu_ps(dst + 12, _mm256_extractf128_ps(a, 1));
+    _mm_storeu_ps(dst + 16, _mm256_extractf128_ps(b, 1));
+    _mm_storeu_ps(dst + 20, _mm256_extractf128_ps(c, 1));
+  }
+};
+
+}  // namespace
+
+int64_t transform_points_avx2(const float *src, float *dst, const int64_t num, const float *m)
+{
+  return transform_simd<SimdAVX2, true, false>(src, dst, num, m);
+}
+
+int64_t transform_directions_avx2(const float *src, float *dst, const int64_t num, const float *m)
+{
+  return transform_simd<SimdAVX2, false, false>(src, dst, num, m);
+}
+
+int64_t transform_normals_avx2(const float *src, float *dst, const int64_t num, const float *m)
+{
+  return transform_simd<SimdAVX2, false, true>(src, dst, num, m);
+}
+
+}  // namespace blender::math::transform_kernels
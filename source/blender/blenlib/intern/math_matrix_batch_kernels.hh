@@ -0,0 +1,122 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * Kernels for the batch transform functions in `BLI_math_matrix.hh`. This header is included by
+ * translation units that are compiled for different instruction sets, so it must not use any
+ * other BLI code. Everything is in an anonymous namespace, otherwise the linker could use a
+ * version of a function that contains instructions which are not supported by the CPU.
+ *
+ * The kernels work on raw float pointers. Vectors are tightly packed (x, y, z, x, y, z, ...) and
+ * the matrix is a column major 4x4 matrix. They only process full SIMD registers and return the
+ * number of processed vectors, the remaining vectors are handled by the caller.
+ *
+ * The SIMD kernels are generic over a `Simd` type that wraps the intrinsics of an instruction
+ * set. Every 128-bit lane of a register processes four vectors, which are loaded from three
+ * consecutive registers and transposed into one register per component.
+ */
+
+#include <cstdint>
+
+namespace blender::math::transform_kernels {
+namespace {
+
+/** Same threshold as #math::normalize. */
+constexpr float normalize_threshold = 1.0e-35f;
+
+/**
+ * `shuffle<i0, i1, i2, i3>(a, b)` returns `(a[i0], a[i1], b[i2], b[i3])` in every lane.
+ *
+ * Transpose the four vectors in every lane of `a`, `b` and `c` (xyzx, yzxy, zxyz) to one register
+ * per component.
+ */
+template<typename Simd, typename V = typename Simd::V>
+inline void deinterleave(const V a, const V b, const V c, V &r_x, V &r_y, V &r_z)
+{
+  const V t1 = Simd::template shuffle<2, 0, 1, 0>(b, c);
+  r_x = Simd::template shuffle<0, 3, 0, 2>(a, t1);
+  const V t2 = Simd::template shuffle<1, 0, 0, 0>(a, b);
+  const V t3 = Simd::template shuffle<3, 0, 2, 0>(b, c);
+  r_y = Simd::template shuffle<0, 2, 0, 2>(t2, t3);
+  const V t4 = Simd::template shuffle<2, 0, 1, 0>(a, b);
+  const V t5 = Simd::template shuffle<0, 0, 3, 0>(c, c);
+  r_z = Simd::template shuffle<0, 2, 0, 2>(t4, t5);
+}
+
+/** Inverse of #deinterleave. */
+template<typename Simd, typename V = typename Simd::V>
+inline void interleave(const V x, const V y, const V z, V &r_a, V &r_b, V &r_c)
+{
+  const V u1 = Simd::template shuffle<0, 0, 0, 0>(x, y);
+  const V u2 = Simd::template shuffle<0, 0, 1, 0>(z, x);
+  r_a = Simd::template shuffle<0, 2, 0, 2>(u1, u2);
+  const V v1 = Simd::template shuffle<1, 0, 1, 0>(y, z);
+  const V v2 = Simd::template shuffle<2, 0, 2, 0>(x, y);
+  r_b = Simd::template shuffle<0, 2, 0, 2>(v1, v2);
+  const V w1 = Simd::template shuffle<2, 0, 3, 0>(z, x);
+  const V w2 = Simd::template shuffle<3, 0, 3, 0>(y, z);
+  r_c = Simd::template shuffle<0, 2, 0, 2>(w1, w2);
+}
+
+template<typename Simd, bool UseTranslation, bool Normalize>
+int64_t transform_simd(const float *src, float *dst, const int64_t num, const float *m)
+{
+  using V = typename Simd::V;
+  const V m00 = Simd::set1(m[0]), m01 = Simd::set1(m[1]), m02 = Simd::set1(m[2]);
+  const V m10 = Simd::set1(m[4]), m11 = Simd::set1(m[5]), m12 = Simd::set1(m[6]);
+  const V m20 = Simd::set1(m[8]), m21 = Simd::set1(m[9]), m22 = Simd::set1(m[10]);
+  const V m30 = Simd::set1(m[12]), m31 = Simd::set1(m[13]), m32 = Simd::set1(m[14]);
+
+  int64_t i = 0;
+  for (; i + Simd::width <= num; i += Simd::width) {
+    V a, b, c;
+    Simd::load3(src + i * 3, a, b, c);
+    V x, y, z;
+    deinterleave<Simd>(a, b, c, x, y, z);
+
+    V rx = Simd::mul(m20, z);
+    V ry = Simd::mul(m21, z);
+    V rz = Simd::mul(m22, z);
+    if constexpr (UseTranslation) {
+      rx = Simd::add(rx, m30);
+      ry = Simd::add(ry, m31);
+      rz = Simd::add(rz, m32);
+    }
+    rx = Simd::madd(m10, y, rx);
+    ry = Simd::madd(m11, y, ry);
+    rz = Simd::madd(m12, y, rz);
+    rx = Simd::madd(m00, x, rx);
+    ry = Simd::madd(m01, x, ry);
+    rz = Simd::madd(m02, x, rz);
+
+    if constexpr (Normalize) {
+      const V length_squared = Simd::madd(rx, rx, Simd::madd(ry, ry, Simd::mul(rz, rz)));
+      const V inv_length = Simd::div(Simd::set1(1.0f), Simd::sqrt(length_squared));
+      const V factor = Simd::select_greater(
+          length_squared, Simd::set1(normalize_threshold), inv_length);
+      rx = Simd::mul(rx, factor);
+      ry = Simd::mul(ry, factor);
+      rz = Simd::mul(rz, factor);
+    }
+
+    interleave<Simd>(rx, ry, rz, a, b, c);
+    Simd::store3(dst + i * 3, a, b, c);
+  }
+  return i;
+}
+
+}  // namespace
+
+#ifdef WITH_MATH_AVX2_KERNELS
+/* Defined in `math_matrix_batch_avx2.cc`. Only call these when #BLI_cpu_support_avx2 is true. */
+int64_t transform_points_avx2(const float *src, float *dst, int64_t num, const float *m);
+int64_t transform_directions_avx2(const float *src, float *dst, int64_t num, const float *m);
+int64_t transform_normals_avx2(const float *src, float *dst, int64_t num, const float *m);
+#endif
+
+}  // namespace blender::math::transform_kernels
@@ -4,18 +4,46 @@
 
 /** \file
  * \ingroup bli
+ *
+ * The cache is split into shards by key hash, each with their own map, lock and statistics, so
+ * that threads adding values to the cache don't all wait on the same lock. Looking up a value that
+ * is cached already only takes a read lock on its entry in the concurrent map of the shard.
+ *
+ * When the cache is full, values are evicted based on the "Greedy Dual Size Frequency" (GDSF)
+ * policy: the priority of a value is `inflation + use_count * compute_cost / size`. Values with
+ * the lowest priority are freed first, and the inflation of the cache is raised to the priority
+ * of the last evicted value. That way, values that are expensive to recompute relative to their
+ * size and that are used often are kept longer, while values that have not been used in a while
+ * age out eventually because newly used values get a higher inflation.
  */
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <mutex>
 
 #include "BLI_concurrent_map.hh"
+#include "BLI_map.hh"
 #include "BLI_memory_cache.hh"
 #include "BLI_memory_counter.hh"
+#include "BLI_set.hh"
 #include "BLI_task.hh"
+#include "BLI_time.h"
 
 namespace blender::memory_cache {
 
+namespace {
+
+/** Statistics of a key type, updated concurrently. */
+struct KeyTypeStatisticsData {
+  std::string key_type;
+  std::atomic<int64_t> hits = 0;
+  std::atomic<int64_t> misses = 0;
+  std::atomic<int64_t> evictions = 0;
+  std::atomic<int64_t> values_num = 0;
+  std::atomic<int64_t> bytes = 0;
+};
+
 struct StoredValue {
   /**
    * The corresponding key. It's stored here, because only a reference to it is used as key in the
@@ -26,63 +54,125 @@ struct StoredValue {
   std::shared_ptr<const GenericKey> key;
   /** The user-provided value. */
   std::shared_ptr<CachedValue> value;
-  /** A logical time that indicates when the value was last used. Lower values are older. */
-  int64_t last_use_time = 0;
+  /** Statistics of the type of the key in the shard, they are never freed. */
+  KeyTypeStatisticsData *statistics = nullptr;
+  /** Time in seconds it took to compute the value. */
+  double compute_cost = 0.0;
+  /** Memory counted for the value when it was added to the cache. */
+  int64_t size_in_bytes = 0;
+  /** Number of times the value has been used. */
+  int64_t use_count = 0;
+  /** Inflation of the cache when the value was used last, see #Cache::inflation. */
+  double last_use_inflation = 0.0;
 };
 
 using CacheMap = ConcurrentMap<std::reference_wrapper<const GenericKey>, StoredValue>;
 
-struct Cache {
+struct CacheShard {
   CacheMap map;
 
-  std::atomic<int64_t> logical_time = 0;
+  std::mutex mutex;
+  /** Amount of memory currently used by the values in this shard. */
+  MemoryCount memory;
+  /**
+   * Keys currently cached. This is stored separately from the map, because the map does not allow
+   * thread-safe iteration.
+   */
+  Vector<const GenericKey *> keys;
+  /** Statistics of the values in this shard per key type, see #memory_cache::get_statistics. */
+  Map<std::string, std::unique_ptr<KeyTypeStatisticsData>> statistics;
+};
+
+/** Number of shards, a power of two that is large enough to make lock contention unlikely. */
+constexpr int64_t shards_num = 32;
+
+struct Cache {
+  std::array<CacheShard, shards_num> shards;
+
   std::atomic<int64_t> approximate_limit = 1024 * 1024 * 1024;
   /**
-   * This is derived from `memory` below, but is atomic for safe access when the global mutex is
-   * not locked.
+   * Sum of the memory of all shards. It's atomic for safe access when no shard mutex is locked.
    */
   std::atomic<int64_t> size_in_bytes = 0;
+  /**
+   * Priority of the last evicted value, it's the base priority of values when they are used.
+   */
+  std::atomic<double> inflation = 0.0;
 
-  std::mutex global_mutex;
-  /** Amount of memory currently used in the cache. */
-  MemoryCount memory;
   /**
-   * Keys currently cached. This is stored separately from the map, because the map does not allow
-   * thread-safe iteration.
+   * Only one thread evicts values at a time. Other threads that find the cache full while
+   * values are evicted just continue. Removing values is only done while this is locked, so
+   * that keys stay valid during eviction without keeping all shards locked.
    */
-  Vector<const GenericKey *> keys;
+  std::mutex eviction_mutex;
 };
 
+}  // namespace
+
 static Cache &get_cache()
 {
   static Cache cache;
   return cache;
 }
 
+static CacheShard &get_shard(Cache &cache, const GenericKey &key)
+{
+  return cache.shards[key.hash() % shards_num];
+}
+
+/** The mutex of the shard has to be locked. */
+static KeyTypeStatisticsData &get_statistics(CacheShard &shard, const GenericKey &key)
+{
+  const StringRef key_type = key.type_name();
+  return *shard.statistics.lookup_or_add_cb_as(key_type, [&]() {
+    auto statistics = std::make_unique<KeyTypeStatisticsData>();
+    statistics->key_type = key_type;
+    return statistics;
+  });
+}
+
 static void try_enforce_limit();
 
-static void set_new_logical_time(const StoredValue &stored_value, const int64_t new_time)
+/**
+ * Don't want to use `std::atomic` directly in the struct, because that makes it non-movable.
+ * Could also use a non-const accessor, but that may degrade performance more. It's not necessary
+ * for correctness that the values are exactly right.
+ */
+template<typename T> static std::atomic<T> &as_atomic(const T &value)
+{
+  static_assert(sizeof(T) == sizeof(std::atomic<T>));
+  return *reinterpret_cast<std::atomic<T> *>(const_cast<T *>(&value));
+}
+
+/** Mark the value as used, which makes it less likely that it is removed. */
+static void touch_stored_value(const StoredValue &stored_value, const double inflation)
 {
-  /* Don't want to use `std::atomic` directly in the struct, because that makes it
-   * non-movable. Could also use a non-const accessor, but that may degrade performance more.
-   * It's not necessary for correctness that the time is exactly the right value. */
-  reinterpret_cast<std::atomic<int64_t> *>(const_cast<int64_t *>(&stored_value.last_use_time))
-      ->store(new_time, std::memory_order_relaxed);
-  static_assert(sizeof(int64_t) == sizeof(std::atomic<int64_t>));
+  as_atomic(stored_value.use_count).fetch_add(1, std::memory_order_relaxed);
+  as_atomic(stored_value.last_use_inflation).store(inflation, std::memory_order_relaxed);
+}
+
+static double get_priority(const StoredValue &stored_value)
+{
+  const double use_count = double(
+      as_atomic(stored_value.use_count).load(std::memory_order_relaxed));
+  const double inflation = as_atomic(stored_value.last_use_inflation)
+                               .load(std::memory_order_relaxed);
+  const double size = double(std::max<int64_t>(stored_value.size_in_bytes, 1));
+  return inflation + use_count * stored_value.compute_cost / size;
 }
 
 std::shared_ptr<CachedValue> get_base(const GenericKey &key,
                                       const FunctionRef<std::unique_ptr<CachedValue>()> compute_fn)
 {
   Cache &cache = get_cache();
-  /* "Touch" the cached value so that we know that it is still used. This makes it less likely that
-   * it is removed. */
-  const int64_t new_time = cache.logical_time.fetch_add(1, std::memory_order_relaxed);
+  CacheShard &shard = get_shard(cache, key);
+  const double inflation = cache.inflation.load(std::memory_order_relaxed);
   {
     /* Fast path when the value is already cached. */
     CacheMap::ConstAccessor accessor;
-    if (cache.map.lookup(accessor, std::ref(key))) {
-      set_new_logical_time(accessor->second, new_time);
+    if (shard.map.lookup(accessor, std::ref(key))) {
+      touch_stored_value(accessor->second, inflation);
+      accessor->second.statistics->hits.fetch_add(1, std::memory_order_relaxed);
       return accessor->second.value;
     }
   }
@@ -90,38 +180,50 @@ std::shared_ptr<CachedValue> get_base(const GenericKey &key,
   /* Compute value while no locks are held to avoid potential for dead-locks. Not using a lock also
    * means that the value may be computed more than once, but that's still better than locking all
    * the time. It may be possible to implement something smarter in the future. */
+  const double compute_start = BLI_time_now_seconds();
   std::shared_ptr<CachedValue> result = compute_fn();
+  const double compute_cost = BLI_time_now_seconds() - compute_start;
   /* Result should be valid. Use exception to propagate error if necessary. */
   BLI_assert(result);
 
   {
     CacheMap::MutableAccessor accessor;
-    const bool newly_inserted = cache.map.add(accessor, std::ref(key));
+    const bool newly_inserted = shard.map.add(accessor, std::ref(key));
     if (!newly_inserted) {
       /* The value is available already. It was computed unnecessarily. Use the value created by
        * the other thread instead. */
+      accessor->second.statistics->misses.fetch_add(1, std::memory_order_relaxed);
       return accessor->second.value;
     }
+    StoredValue &stored_value = accessor->second;
     /* We want to store the key in the map, but the reference we got passed in may go out of scope.
      * So make a storable copy of it that we use in the map. */
-    accessor->second.key = key.to_storable();
+    stored_value.key = key.to_storable();
     /* Modifying the key should be fine because the new key is equal to the original key. */
     const_cast<std::reference_wrapper<const GenericKey> &>(accessor->first) = std::ref(
-        *accessor->second.key);
+        *stored_value.key);
 
     /* Store the value. Don't move, because we still want to return the value from the function. */
-    accessor->second.value = result;
-    /* Set initial logical time for the new cached entry. */
-    set_new_logical_time(accessor->second, new_time);
+    stored_value.value = result;
+    stored_value.compute_cost = compute_cost;
+    stored_value.use_count = 1;
+    stored_value.last_use_inflation = inflation;
 
     {
-      /* Update global data of the cache. */
-      std::lock_guard lock{cache.global_mutex};
-      memory_counter::MemoryCounter memory_counter{cache.memory};
-      accessor->second.value->count_memory(memory_counter);
-      cache.keys.append(&accessor->first.get());
-      cache.size_in_bytes = cache.memory.total_bytes;
+      /* Update data of the shard. */
+      std::lock_guard lock{shard.mutex};
+      stored_value.statistics = &get_statistics(shard, key);
+      const int64_t old_shard_size = shard.memory.total_bytes;
+      memory_counter::MemoryCounter memory_counter{shard.memory};
+      stored_value.value->count_memory(memory_counter);
+      stored_value.size_in_bytes = shard.memory.total_bytes - old_shard_size;
+      shard.keys.append(&accessor->first.get());
     }
+    cache.size_in_bytes.fetch_add(stored_value.size_in_bytes, std::memory_order_relaxed);
+    KeyTypeStatisticsData &statistics = *stored_value.statistics;
+    statistics.misses.fetch_add(1, std::memory_order_relaxed);
+    statistics.values_num.fetch_add(1, std::memory_order_relaxed);
+    statistics.bytes.fetch_add(stored_value.size_in_bytes, std::memory_order_relaxed);
   }
   /* Potentially free elements from the cache. Note, even if this would free the value we just
    * added, it would still work correctly, because we already have a shared_ptr to it. */
@@ -141,44 +243,75 @@ void clear()
   memory_cache::remove_if([](const GenericKey &) { return true; });
 }
 
-void remove_if(const FunctionRef<bool(const GenericKey &)> predicate)
+/**
+ * Remove the values for which the predicate returns true from the shard and recount the memory of
+ * the remaining ones. The predicate is called exactly once per key.
+ *
+ * \return The change of the memory used by the shard.
+ */
+static int64_t shard_remove_if(CacheShard &shard,
+                               const FunctionRef<bool(const GenericKey &)> predicate,
+                               const bool is_eviction)
 {
-  Cache &cache = get_cache();
-  std::lock_guard lock{cache.global_mutex};
+  std::lock_guard lock{shard.mutex};
+  const int64_t old_size = shard.memory.total_bytes;
 
   /* Store predicate results to avoid assuming that the predicate is cheap and without side effects
    * that must not happen more than once. */
-  Array<bool> predicate_results(cache.keys.size());
+  Array<bool> predicate_results(shard.keys.size());
 
   /* Recount memory of all elements that are not removed. */
-  cache.memory.reset();
-  MemoryCounter memory_counter{cache.memory};
+  shard.memory.reset();
+  MemoryCounter memory_counter{shard.memory};
 
-  for (const int64_t i : cache.keys.index_range()) {
-    const GenericKey &key = *cache.keys[i];
+  for (const int64_t i : shard.keys.index_range()) {
+    const GenericKey &key = *shard.keys[i];
     const bool ok_to_remove = predicate(key);
     predicate_results[i] = ok_to_remove;
 
-    if (!ok_to_remove) {
-      /* The value is kept, so count its memory. */
+    {
       CacheMap::ConstAccessor accessor;
-      if (cache.map.lookup(accessor, key)) {
-        accessor->second.value->count_memory(memory_counter);
+      if (!shard.map.lookup(accessor, key)) {
+        BLI_assert_unreachable();
+        continue;
+      }
+      const StoredValue &stored_value = accessor->second;
+      if (!ok_to_remove) {
+        /* The value is kept, so count its memory. */
+        stored_value.value->count_memory(memory_counter);
         continue;
       }
-      BLI_assert_unreachable();
+      KeyTypeStatisticsData &statistics = *stored_value.statistics;
+      statistics.values_num.fetch_sub(1, std::memory_order_relaxed);
+      statistics.bytes.fetch_sub(stored_value.size_in_bytes, std::memory_order_relaxed);
+      if (is_eviction) {
+        statistics.evictions.fetch_add(1, std::memory_order_relaxed);
+      }
     }
     /* The value should be removed. */
-    const bool success = cache.map.remove(key);
+    const bool success = shard.map.remove(key);
     BLI_assert(success);
     UNUSED_VARS_NDEBUG(success);
   }
   /* Remove all removed keys from the vector too. */
-  cache.keys.remove_if([&](const GenericKey *&key) {
-    const int64_t index = &key - &cache.keys[0];
+  shard.keys.remove_if([&](const GenericKey *&key) {
+    const int64_t index = &key - &shard.keys[0];
     return predicate_results[index];
   });
-  cache.size_in_bytes = cache.memory.total_bytes;
+  return shard.memory.total_bytes - old_size;
+}
+
+void remove_if(const FunctionRef<bool(const GenericKey &)> predicate)
+{
+  Cache &cache = get_cache();
+  std::lock_guard lock{cache.eviction_mutex};
+  /* Freeing values may use threading, see #try_enforce_limit for why this is isolated. */
+  threading::isolate_task([&]() {
+    for (CacheShard &shard : cache.shards) {
+      const int64_t size_change = shard_remove_if(shard, predicate, false);
+      cache.size_in_bytes.fetch_add(size_change, std::memory_order_relaxed);
+    }
+  });
 }
 
 static void try_enforce_limit()
@@ -191,89 +324,111 @@ static void try_enforce_limit()
     return;
   }
 
-  std::lock_guard lock{cache.global_mutex};
-
-  /* Gather all the keys with their latest usage times. */
-  Vector<std::pair<int64_t, const GenericKey *>> keys_with_time;
-  for (const GenericKey *key : cache.keys) {
-    CacheMap::ConstAccessor accessor;
-    if (!cache.map.lookup(accessor, *key)) {
-      continue;
-    }
-    keys_with_time.append({accessor->second.last_use_time, key});
+  std::unique_lock lock{cache.eviction_mutex, std::try_to_lock};
+  if (!lock.owns_lock()) {
+    /* Another thread is removing values already. */
+    return;
   }
-  /* Sort the items so that the newest keys come first. */
-  std::sort(keys_with_time.begin(), keys_with_time.end());
-  std::reverse(keys_with_time.begin(), keys_with_time.end());
-
-  /* Count used memory starting at the most recently touched element. Stop at the element when the
-   * amount became larger than the capacity. */
-  cache.memory.reset();
-  std::optional<int> first_bad_index;
-  {
-    MemoryCounter memory_counter{cache.memory};
-    for (const int i : keys_with_time.index_range()) {
-      const GenericKey &key = *keys_with_time[i].second;
+
+  struct EvictionCandidate {
+    double priority;
+    int64_t size_in_bytes;
+    int64_t shard_index;
+    const GenericKey *key;
+  };
+
+  /* Gather all the keys with their current priorities. */
+  Vector<EvictionCandidate> candidates;
+  for (const int64_t shard_index : IndexRange(shards_num)) {
+    CacheShard &shard = cache.shards[shard_index];
+    std::lock_guard shard_lock{shard.mutex};
+    for (const GenericKey *key : shard.keys) {
       CacheMap::ConstAccessor accessor;
-      if (!cache.map.lookup(accessor, key)) {
-        continue;
-      }
-      accessor->second.value->count_memory(memory_counter);
-      /* Undershoot a little bit. This typically results in more things being freed that have not
-       * been used in a while. The benefit is that we have to do the decision what to free less
-       * often than if we were always just freeing the minimum amount necessary. */
-      if (cache.memory.total_bytes <= approximate_limit * 0.75) {
+      if (!shard.map.lookup(accessor, *key)) {
         continue;
       }
-      first_bad_index = i;
-      break;
+      candidates.append(
+          {get_priority(accessor->second), accessor->second.size_in_bytes, shard_index, key});
     }
   }
-  if (!first_bad_index) {
-    return;
-  }
-
-  /* Avoid recounting memory if the last item is not way too large and the overshoot is still ok.
-   * The alternative would be to subtract the last item from the counted memory again, but removing
-   * from #MemoryCount is not implemented yet. */
-  bool need_memory_recount = false;
-  if (cache.memory.total_bytes < approximate_limit * 1.1) {
-    *first_bad_index += 1;
-    if (*first_bad_index == keys_with_time.size()) {
-      return;
+  /* Sort the items so that the values that should be kept longest come last. */
+  std::sort(candidates.begin(),
+            candidates.end(),
+            [](const EvictionCandidate &a, const EvictionCandidate &b) {
+              return a.priority < b.priority;
+            });
+
+  /* Undershoot a little bit. This typically results in more things being freed that have a low
+   * priority. The benefit is that we have to do the decision what to free less often than if we
+   * were always just freeing the minimum amount necessary. */
+  const int64_t target_size = int64_t(double(approximate_limit) * 0.75);
+  int64_t remaining_size = old_size;
+  /* Keys are removed per shard. Keys of other shards may be freed while a shard is processed, so
+   * only keys of the same shard are compared to avoid matching newly allocated keys. */
+  std::array<Set<const GenericKey *>, shards_num> keys_to_remove;
+  double max_evicted_priority = cache.inflation.load(std::memory_order_relaxed);
+  int64_t removed_num = 0;
+  for (const EvictionCandidate &candidate : candidates) {
+    if (remaining_size <= target_size) {
+      break;
     }
+    keys_to_remove[candidate.shard_index].add(candidate.key);
+    remaining_size -= candidate.size_in_bytes;
+    max_evicted_priority = std::max(max_evicted_priority, candidate.priority);
+    removed_num++;
   }
-  else {
-    need_memory_recount = true;
-  }
-
-  /* Remove elements that don't fit anymore. */
-  for (const int i : keys_with_time.index_range().drop_front(*first_bad_index)) {
-    const GenericKey &key = *keys_with_time[i].second;
-    cache.map.remove(key);
-  }
-
-  /* Update keys vector. */
-  cache.keys.clear();
-  for (const int i : keys_with_time.index_range().take_front(*first_bad_index)) {
-    cache.keys.append(keys_with_time[i].second);
+  if (removed_num == 0) {
+    return;
   }
 
-  if (need_memory_recount) {
-    /* Recount memory another time, because the last count does not accurately represent the actual
-     * value. */
-    cache.memory.reset();
-    MemoryCounter memory_counter{cache.memory};
-    for (const int i : keys_with_time.index_range().take_front(*first_bad_index)) {
-      const GenericKey &key = *keys_with_time[i].second;
-      CacheMap::ConstAccessor accessor;
-      if (!cache.map.lookup(accessor, key)) {
-        continue;
+  /* Values used from now on have a higher priority than the evicted ones. */
+  cache.inflation.store(max_evicted_priority, std::memory_order_relaxed);
+
+  /* Remove the values per shard, which also recounts the memory of the shards exactly, because
+   * the per-value sizes don't take into account data shared between values. The eviction mutex is
+   * locked, so isolate the loop: a stolen task that uses the cache as well (e.g. freeing a value
+   * can call #remove_if) must not run on this thread while it holds the mutex. */
+  threading::isolate_task([&]() {
+    threading::parallel_for(IndexRange(shards_num), 1, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        if (keys_to_remove[i].is_empty()) {
+          continue;
+        }
+        const int64_t size_change = shard_remove_if(
+            cache.shards[i],
+            [&](const GenericKey &key) { return keys_to_remove[i].contains(&key); },
+            true);
+        cache.size_in_bytes.fetch_add(size_change, std::memory_order_relaxed);
       }
-      accessor->second.value->count_memory(memory_counter);
+    });
+  });
+}
+
+Vector<KeyTypeStatistics> get_statistics()
+{
+  Cache &cache = get_cache();
+  /* Combine the statistics of all shards. */
+  Map<std::string, KeyTypeStatistics> statistics_by_type;
+  for (CacheShard &shard : cache.shards) {
+    std::lock_guard lock{shard.mutex};
+    for (const std::unique_ptr<KeyTypeStatisticsData> &data : shard.statistics.values()) {
+      KeyTypeStatistics &statistics = statistics_by_type.lookup_or_add_cb(data->key_type, [&]() {
+        KeyTypeStatistics statistics;
+        statistics.key_type = data->key_type;
+        return statistics;
+      });
+      statistics.hits += data->hits.load(std::memory_order_relaxed);
+      statistics.misses += data->misses.load(std::memory_order_relaxed);
+      statistics.evictions += data->evictions.load(std::memory_order_relaxed);
+      statistics.values_num += data->values_num.load(std::memory_order_relaxed);
+      statistics.bytes += data->bytes.load(std::memory_order_relaxed);
     }
   }
-  cache.size_in_bytes = cache.memory.total_bytes;
+  Vector<KeyTypeStatistics> result;
+  for (KeyTypeStatistics &statistics : statistics_by_type.values()) {
+    result.append(std::move(statistics));
+  }
+  return result;
 }
 
 }  // namespace blender::memory_cache
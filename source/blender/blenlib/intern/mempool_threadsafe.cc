@@ -0,0 +1,127 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include "BLI_mempool_threadsafe.hh"
+
+#include "BLI_mempool_private.h"
+
+namespace blender {
+
+/** Next element of a free list, stored in the first pointer of the free element. */
+static void *&free_elem_next(void *elem)
+{
+  return *static_cast<void **>(elem);
+}
+
+ThreadSafeMempool::ThreadSafeMempool(const uint element_size,
+                                     const uint elements_num,
+                                     const uint elements_per_chunk,
+                                     const uint flag,
+                                     const int64_t batch_size)
+    : batch_size_(batch_size)
+{
+  BLI_assert(batch_size > 0);
+  pool_ = BLI_mempool_create(element_size, elements_num, elements_per_chunk, flag);
+}
+
+ThreadSafeMempool::~ThreadSafeMempool()
+{
+  BLI_mempool_destroy(pool_);
+}
+
+void *ThreadSafeMempool::alloc()
+{
+  LocalCache &cache = local_caches_.local();
+  if (UNLIKELY(cache.free == nullptr)) {
+    this->refill(cache);
+  }
+  void *elem = cache.free;
+  cache.free = free_elem_next(elem);
+  cache.free_num--;
+  cache.used_num_delta++;
+  mempool_elem_mark_used(pool_, elem);
+  return elem;
+}
+
+void *ThreadSafeMempool::calloc()
+{
+  void *elem = this->alloc();
+  mempool_elem_clear(pool_, elem);
+  return elem;
+}
+
+void ThreadSafeMempool::free(void *elem)
+{
+  LocalCache &cache = local_caches_.local();
+  mempool_elem_mark_free(pool_, elem);
+  free_elem_next(elem) = cache.free;
+  cache.free = elem;
+  cache.free_num++;
+  cache.used_num_delta--;
+  if (UNLIKELY(cache.free_num >= batch_size_ * 2)) {
+    this->return_batch(cache);
+  }
+}
+
+void ThreadSafeMempool::refill(LocalCache &cache)
+{
+  BLI_assert(cache.free == nullptr);
+  std::lock_guard lock{mutex_};
+  cache.free = mempool_free_list_take(pool_, uint(batch_size_));
+  cache.free_num = batch_size_;
+  mempool_used_num_add(pool_, int(cache.used_num_delta));
+  cache.used_num_delta = 0;
+}
+
+void ThreadSafeMempool::return_batch(LocalCache &cache)
+{
+  /* Keep the most recently freed elements in the cache, they are more likely to be in the CPU
+   * cache still. */
+  void *keep_tail = cache.free;
+  for (int64_t i = 1; i < batch_size_; i++) {
+    keep_tail = free_elem_next(keep_tail);
+  }
+  void *return_head = free_elem_next(keep_tail);
+  void *return_tail = return_head;
+  while (free_elem_next(return_tail) != nullptr) {
+    return_tail = free_elem_next(return_tail);
+  }
+  free_elem_next(keep_tail) = nullptr;
+
+  std::lock_guard lock{mutex_};
+  mempool_free_list_return(pool_, return_head, return_tail);
+  cache.free_num = batch_size_;
+  mempool_used_num_add(pool_, int(cache.used_num_delta));
+  cache.used_num_delta = 0;
+}
+
+void ThreadSafeMempool::flush()
+{
+  std::lock_guard lock{mutex_};
+  for (LocalCache &cache : local_caches_) {
+    if (cache.free) {
+      void *tail = cache.free;
+      while (free_elem_next(tail) != nullptr) {
+        tail = free_elem_next(tail);
+      }
+      mempool_free_list_return(pool_, cache.free, tail);
+    }
+    mempool_used_num_add(pool_, int(cache.used_num_delta));
+    cache = {};
+  }
+}
+
+void ThreadSafeMempool::clear()
+{
+  for (LocalCache &cache : local_caches_) {
+    cache = {};
+  }
+  BLI_mempool_clear(pool_);
+}
+
+}  // namespace blender
@@ -0,0 +1,266 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <fmt/format.h>
+
+#include "BLI_array.hh"
+#include "BLI_fileops.hh"
+#include "BLI_profile_trace.hh"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "BLI_vector.hh"
+
+namespace blender::profile_trace {
+
+namespace detail {
+std::atomic<bool> is_recording = false;
+}
+
+static constexpr int64_t event_name_size = 64;
+
+struct Event {
+  const char *category;
+  int64_t start_ns;
+  int64_t duration_ns;
+  char name[event_name_size];
+};
+
+struct ThreadBuffer {
+  std::string thread_name;
+  Array<Event> events;
+  /** Total number of events added to the buffer. Only the last #events.size() are kept. */
+  std::atomic<int64_t> added_num = 0;
+  /**
+   * True while the owning thread writes an event. The events are only reallocated or freed when
+   * recording is stopped and this is false.
+   */
+  std::atomic<bool> is_writing = false;
+};
+
+struct Recorder {
+  std::mutex mutex;
+  /**
+   * Buffers are never freed, because threads keep a pointer to their own buffer. Only the event
+   * arrays are freed when clearing.
+   */
+  Vector<std::unique_ptr<ThreadBuffer>> buffers;
+  int64_t events_per_thread = 0;
+  TimePoint start_time;
+};
+
+static Recorder &get_recorder()
+{
+  static Recorder recorder;
+  return recorder;
+}
+
+static thread_local ThreadBuffer *thread_buffer = nullptr;
+
+static ThreadBuffer &ensure_thread_buffer(Recorder &recorder)
+{
+  if (thread_buffer != nullptr) {
+    return *thread_buffer;
+  }
+  std::lock_guard lock{recorder.mutex};
+  std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+  buffer->thread_name = BLI_thread_is_main() ?
+                            "Main Thread" :
+                            fmt::format("Worker {}", recorder.buffers.size());
+  buffer->events.reinitialize(recorder.events_per_thread);
+  thread_buffer = buffer.get();
+  recorder.buffers.append(std::move(buffer));
+  return *thread_buffer;
+}
+
+/**
+ * Stop recording and wait until no thread writes into its buffer anymore, so that the buffers can
+ * be changed safely. Writers set #ThreadBuffer::is_writing before they check whether recording is
+ * still enabled, so after this they either see that recording stopped or have finished.
+ */
+static void stop_and_wait_for_writers_locked(Recorder &recorder)
+{
+  detail::is_recording.store(false, std::memory_order_seq_cst);
+  for (const std::unique_ptr<ThreadBuffer> &buffer : recorder.buffers) {
+    while (buffer->is_writing.load(std::memory_order_seq_cst)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+static void reset_buffers_locked(Recorder &recorder, const int64_t events_per_thread)
+{
+  stop_and_wait_for_writers_locked(recorder);
+  recorder.events_per_thread = events_per_thread;
+  for (const std::unique_ptr<ThreadBuffer> &buffer : recorder.buffers) {
+    buffer->events.reinitialize(events_per_thread);
+    buffer->added_num.store(0, std::memory_order_relaxed);
+  }
+}
+
+void start_recording(const int64_t events_per_thread)
+{
+  Recorder &recorder = get_recorder();
+  std::lock_guard lock{recorder.mutex};
+  reset_buffers_locked(recorder, std::max<int64_t>(events_per_thread, 1));
+  recorder.start_time = Clock::now();
+  detail::is_recording.store(true, std::memory_order_seq_cst);
+}
+
+void stop_recording()
+{
+  detail::is_recording.store(false, std::memory_order_seq_cst);
+}
+
+void clear()
+{
+  Recorder &recorder = get_recorder();
+  std::lock_guard lock{recorder.mutex};
+  reset_buffers_locked(recorder, 0);
+}
+
+int64_t recorded_events_num(const char *category)
+{
+  Recorder &recorder = get_recorder();
+  std::lock_guard lock{recorder.mutex};
+  int64_t num = 0;
+  for (const std::unique_ptr<ThreadBuffer> &buffer : recorder.buffers) {
+    const int64_t added_num = buffer->added_num.load(std::memory_order_acquire);
+    const int64_t events_num = std::min(added_num, buffer->events.size());
+    if (category == nullptr) {
+      num += events_num;
+      continue;
+    }
+    for (const int64_t i : IndexRange(added_num - events_num, events_num)) {
+      if (STREQ(buffer->events[i % buffer->events.size()].category, category)) {
+        num++;
+      }
+    }
+  }
+  return num;
+}
+
+static void copy_name_truncated(const StringRef name, char (&dst)[event_name_size])
+{
+  int64_t size = std::min<int64_t>(name.size(), event_name_size - 1);
+  /* Don't cut a multi-byte UTF-8 character in half. */
+  while (size < name.size() && size > 0 && (uint8_t(name[size]) & 0xC0) == 0x80) {
+    size--;
+  }
+  memcpy(dst, name.data(), size_t(size));
+  dst[size] = '\0';
+}
+
+void record_event(const char *category,
+                  const StringRef name,
+                  const TimePoint start,
+                  const TimePoint end)
+{
+  if (!is_recording()) {
+    return;
+  }
+  Recorder &recorder = get_recorder();
+  ThreadBuffer &buffer = ensure_thread_buffer(recorder);
+  /* Check again after announcing the write, recording may have been stopped to clear the buffers
+   * in the meantime. See #stop_and_wait_for_writers_locked. */
+  buffer.is_writing.store(true, std::memory_order_seq_cst);
+  if (!detail::is_recording.load(std::memory_order_seq_cst)) {
+    buffer.is_writing.store(false, std::memory_order_release);
+    return;
+  }
+  const int64_t index = buffer.added_num.load(std::memory_order_relaxed);
+  Event &event = buffer.events[index % buffer.events.size()];
+  event.category = category;
+  event.start_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(start - recorder.start_time).count();
+  event.duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  copy_name_truncated(name, event.name);
+  /* Only the recording thread writes to the buffer, the release store publishes the event for
+   * writing the file after recording has stopped. */
+  buffer.added_num.store(index + 1, std::memory_order_release);
+  buffer.is_writing.store(false, std::memory_order_release);
+}
+
+static void append_json_string(fmt::memory_buffer &json, const StringRef str)
+{
+  json.push_back('"');
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        fmt::format_to(fmt::appender(json), "\\\"");
+        break;
+      case '\\':
+        fmt::format_to(fmt::appender(json), "\\\\");
+        break;
+      default:
+        if (uint8_t(c) < 0x20) {
+          fmt::format_to(fmt::appender(json), "\\u{:04x}", int(c));
+        }
+        else {
+          json.push_back(c);
+        }
+        break;
+    }
+  }
+  json.push_back('"');
+}
+
+bool write_json(const StringRefNull filepath)
+{
+  Recorder &recorder = get_recorder();
+  std::lock_guard lock{recorder.mutex};
+  stop_and_wait_for_writers_locked(recorder);
+
+  fmt::memory_buffer json;
+  fmt::format_to(fmt::appender(json), "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  bool is_first_event = true;
+  for (const int64_t thread_index : recorder.buffers.index_range()) {
+    const ThreadBuffer &buffer = *recorder.buffers[thread_index];
+    if (!is_first_event) {
+      json.push_back(',');
+    }
+    is_first_event = false;
+    fmt::format_to(fmt::appender(json),
+                   "\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                   "\"args\":{{\"name\":",
+                   thread_index);
+    append_json_string(json, buffer.thread_name);
+    fmt::format_to(fmt::appender(json), "}}}}");
+
+    const int64_t added_num = buffer.added_num.load(std::memory_order_acquire);
+    const int64_t events_num = std::min(added_num, buffer.events.size());
+    for (const int64_t i : IndexRange(added_num - events_num, events_num)) {
+      const Event &event = buffer.events[i % buffer.events.size()];
+      fmt::format_to(fmt::appender(json), ",\n{{\"name\":");
+      append_json_string(json, event.name);
+      fmt::format_to(fmt::appender(json), ",\"cat\":");
+      append_json_string(json, event.category);
+      /* Timestamps are in microseconds. */
+      fmt::format_to(fmt::appender(json),
+                     ",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":1,\"tid\":{}}}",
+                     double(event.start_ns) / 1000.0,
+                     double(event.duration_ns) / 1000.0,
+                     thread_index);
+    }
+  }
+  fmt::format_to(fmt::appender(json), "\n]}}\n");
+
+  fstream file(filepath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return false;
+  }
+  file.write(json.data(), std::streamsize(json.size()));
+  return bool(file);
+}
+
+}  // namespace blender::profile_trace
@@ -0,0 +1,283 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ *
+ * Least significant digit radix sort. Every pass distributes the elements into 256 buckets by one
+ * byte of the key. The elements are split into chunks that are processed in parallel; the bucket
+ * histograms of all chunks are combined so that every chunk knows where to write each of its
+ * elements, which keeps the sort stable.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "BLI_array.hh"
+#include "BLI_math_base.h"
+#include "BLI_sort.hh"
+#include "BLI_task.hh"
+#include "BLI_threads.h"
+
+namespace blender {
+
+static constexpr int radix_bits = 8;
+static constexpr int radix_buckets = 1 << radix_bits;
+/** Below this size, a comparison sort is faster than the radix passes. */
+static constexpr int64_t radix_sort_min_size = 256;
+/** Minimum number of elements processed by one task in every pass. */
+static constexpr int64_t radix_chunk_min_size = 1 << 14;
+
+/* -------------------------------------------------------------------- */
+/** \name Key Conversion
+ *
+ * Keys are converted to unsigned integers that have the same order.
+ * \{ */
+
+template<typename T> struct RadixKey;
+
+template<> struct RadixKey<uint32_t> {
+  using Type = uint32_t;
+  static uint32_t encode(const uint32_t value)
+  {
+    return value;
+  }
+  static uint32_t decode(const uint32_t key)
+  {
+    return key;
+  }
+};
+
+template<> struct RadixKey<uint64_t> {
+  using Type = uint64_t;
+  static uint64_t encode(const uint64_t value)
+  {
+    return value;
+  }
+  static uint64_t decode(const uint64_t key)
+  {
+    return key;
+  }
+};
+
+template<> struct RadixKey<int32_t> {
+  using Type = uint32_t;
+  static uint32_t encode(const int32_t value)
+  {
+    return uint32_t(value) ^ (uint32_t(1) << 31);
+  }
+  static int32_t decode(const uint32_t key)
+  {
+    return int32_t(key ^ (uint32_t(1) << 31));
+  }
+};
+
+template<> struct RadixKey<int64_t> {
+  using Type = uint64_t;
+  static uint64_t encode(const int64_t value)
+  {
+    return uint64_t(value) ^ (uint64_t(1) << 63);
+  }
+  static int64_t decode(const uint64_t key)
+  {
+    return int64_t(key ^ (uint64_t(1) << 63));
+  }
+};
+
+/**
+ * Flip all bits of negative numbers and only the sign bit of positive numbers, so that the
+ * unsigned integer order matches the floating point order.
+ */
+template<typename Float, typename UInt> struct RadixKeyFloat {
+  using Type = UInt;
+  static constexpr UInt sign_bit = UInt(1) << (sizeof(UInt) * 8 - 1);
+  static UInt encode(const Float value)
+  {
+    UInt bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & sign_bit) ? ~bits : (bits | sign_bit);
+  }
+  static Float decode(const UInt key)
+  {
+    const UInt bits = (key & sign_bit) ? (key ^ sign_bit) : ~key;
+    Float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+  /** Like #encode, but negative zero compares equal to positive zero, as in a comparison sort. */
+  static UInt encode_for_indices(const Float value)
+  {
+    return encode(value == Float(0) ? Float(0) : value);
+  }
+};
+
+template<> struct RadixKey<float> : RadixKeyFloat<float, uint32_t> {};
+template<> struct RadixKey<double> : RadixKeyFloat<double, uint64_t> {};
+
+template<typename T> static typename RadixKey<T>::Type encode_for_indices(const T value)
+{
+  if constexpr (std::is_floating_point_v<T>) {
+    return RadixKey<T>::encode_for_indices(value);
+  }
+  else {
+    return RadixKey<T>::encode(value);
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Sorting
+ * \{ */
+
+/**
+ * Sort \a keys and reorder \a indices (if not empty) in the same way.
+ * \a keys_buffer and \a indices_buffer are used as temporary storage of the same size.
+ * \return True if the sorted result ended up in the buffers.
+ */
+template<typename UInt>
+static bool radix_sort_keys(MutableSpan<UInt> keys,
+                            MutableSpan<int> indices,
+                            MutableSpan<UInt> keys_buffer,
+                            MutableSpan<int> indices_buffer)
+{
+  const int64_t size = keys.size();
+  const bool use_indices = !indices.is_empty();
+  bool result_in_buffer = false;
+  const int64_t chunk_size = std::max<int64_t>(
+      radix_chunk_min_size,
+      int64_t(divide_ceil_ul(uint64_t(size), uint64_t(BLI_system_thread_count()) * 4)));
+  const int64_t chunks_num = int64_t(divide_ceil_ul(uint64_t(size), uint64_t(chunk_size)));
+  const auto chunk_range = [&](const int64_t chunk) {
+    return IndexRange::from_begin_end(chunk * chunk_size,
+                                      std::min(size, (chunk + 1) * chunk_size));
+  };
+
+  /* Bucket offsets for every chunk, bucket-major so that every chunk writes its elements after the
+   * elements of the same bucket from previous chunks. */
+  Array<int64_t> offsets(chunks_num * radix_buckets);
+
+  for (int shift = 0; shift < int(sizeof(UInt) * 8); shift += radix_bits) {
+    threading::parallel_for(IndexRange(chunks_num), 1, [&](const IndexRange range) {
+      for (const int64_t chunk : range) {
+        int64_t counts[radix_buckets] = {0};
+        for (const UInt key : keys.slice(chunk_range(chunk))) {
+          counts[(key >> shift) & (radix_buckets - 1)]++;
+        }
+        for (const int bucket : IndexRange(radix_buckets)) {
+          offsets[bucket * chunks_num + chunk] = counts[bucket];
+        }
+      }
+    });
+
+    /* The pass doesn't change the order when all keys are in the same bucket. */
+    bool is_single_bucket = false;
+    int64_t offset = 0;
+    for (const int bucket : IndexRange(radix_buckets)) {
+      const int64_t bucket_start = offset;
+      for (int64_t &value : offsets.as_mutable_span().slice(bucket * chunks_num, chunks_num)) {
+        const int64_t count = value;
+        value = offset;
+        offset += count;
+      }
+      is_single_bucket |= offset - bucket_start == size;
+    }
+    if (is_single_bucket) {
+      continue;
+    }
+
+    threading::parallel_for(IndexRange(chunks_num), 1, [&](const IndexRange range) {
+      for (const int64_t chunk : range) {
+        int64_t chunk_offsets[radix_buckets];
+        for (const int bucket : IndexRange(radix_buckets)) {
+          chunk_offsets[bucket] = offsets[bucket * chunks_num + chunk];
+        }
+        for (const int64_t i : chunk_range(chunk)) {
+          const UInt key = keys[i];
+          const int64_t dst = chunk_offsets[(key >> shift) & (radix_buckets - 1)]++;
+          keys_buffer[dst] = key;
+          if (use_indices) {
+            indices_buffer[dst] = indices[i];
+          }
+        }
+      }
+    });
+    std::swap(keys, keys_buffer);
+    std::swap(indices, indices_buffer);
+    result_in_buffer = !result_in_buffer;
+  }
+  return result_in_buffer;
+}
+
+template<typename T> void radix_sort(MutableSpan<T> values)
+{
+  using Key = RadixKey<T>;
+  using UInt = typename Key::Type;
+  if (values.size() < radix_sort_min_size) {
+    std::stable_sort(values.begin(), values.end(), [](const T a, const T b) {
+      return Key::encode(a) < Key::encode(b);
+    });
+    return;
+  }
+
+  Array<UInt> keys(values.size() * 2, NoInitialization());
+  MutableSpan<UInt> keys_a = keys.as_mutable_span().take_front(values.size());
+  MutableSpan<UInt> keys_b = keys.as_mutable_span().take_back(values.size());
+  threading::parallel_for(values.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      keys_a[i] = Key::encode(values[i]);
+    }
+  });
+
+  const Span<UInt> sorted = radix_sort_keys<UInt>(keys_a, {}, keys_b, {}) ? keys_b : keys_a;
+  threading::parallel_for(values.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      values[i] = Key::decode(sorted[i]);
+    }
+  });
+}
+
+template<typename T> void radix_sort_indices(const Span<T> keys, MutableSpan<int> indices)
+{
+  using UInt = typename RadixKey<T>::Type;
+  if (indices.size() < radix_sort_min_size) {
+    std::stable_sort(indices.begin(), indices.end(), [&](const int a, const int b) {
+      return encode_for_indices(keys[a]) < encode_for_indices(keys[b]);
+    });
+    return;
+  }
+
+  const int64_t size = indices.size();
+  Array<UInt> sort_keys(size * 2, NoInitialization());
+  Array<int> indices_buffer(size, NoInitialization());
+  MutableSpan<UInt> keys_a = sort_keys.as_mutable_span().take_front(size);
+  MutableSpan<UInt> keys_b = sort_keys.as_mutable_span().take_back(size);
+  threading::parallel_for(indices.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      keys_a[i] = encode_for_indices(keys[indices[i]]);
+    }
+  });
+
+  if (radix_sort_keys<UInt>(keys_a, indices, keys_b, indices_buffer)) {
+    indices.copy_from(indices_buffer);
+  }
+}
+
+template void radix_sort(MutableSpan<int32_t> values);
+template void radix_sort(MutableSpan<uint32_t> values);
+template void radix_sort(MutableSpan<int64_t> values);
+template void radix_sort(MutableSpan<uint64_t> values);
+template void radix_sort(MutableSpan<float> values);
+template void radix_sort(MutableSpan<double> values);
+
+template void radix_sort_indices(Span<int32_t> keys, MutableSpan<int> indices);
+template void radix_sort_indices(Span<uint32_t> keys, MutableSpan<int> indices);
+template void radix_sort_indices(Span<int64_t> keys, MutableSpan<int> indices);
+template void radix_sort_indices(Span<uint64_t> keys, MutableSpan<int> indices);
+template void radix_sort_indices(Span<float> keys, MutableSpan<int> indices);
+template void radix_sort_indices(Span<double> keys, MutableSpan<int> indices);
+
+/** \} */
+
+}  // namespace blender
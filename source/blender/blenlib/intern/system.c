@@ -177,6 +177,36 @@ int BLI_cpu_support_sse42(void)
   return 0;
 }
 
+int BLI_cpu_support_avx2(void)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int result[4];
+  __cpuid(result, 0);
+  if (result[0] < 7) {
+    return 0;
+  }
+  __cpuid(result, 0x00000001);
+  const int fma = (result[2] & ((int)1 << 12)) != 0;
+  const int osxsave = (result[2] & ((int)1 << 27)) != 0;
+  const int avx = (result[2] & ((int)1 << 28)) != 0;
+  if (!(fma && osxsave && avx)) {
+    return 0;
+  }
+  /* The operating system has to save the YMM registers on context switches. */
+  if ((_xgetbv(0) & 6) != 6) {
+    return 0;
+  }
+  __cpuidex(result, 0x00000007, 0);
+  return (result[1] & ((int)1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  /* Also checks that the operating system supports the YMM registers. */
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+  return 0;
+#endif
+}
+
 void BLI_hostname_get(char *buffer, size_t bufsize)
 {
 #ifndef WIN32
@@ -17,6 +17,7 @@
 #include "DNA_listBase.h"
 
 #include "BLI_mempool.h"
+#include "BLI_profile_trace.hh"
 #include "BLI_task.h"
 #include "BLI_threads.h"
 
@@ -168,6 +169,7 @@ struct TaskPool {
 /* Execute task. */
 void Task::operator()() const
 {
+  PROFILE_TRACE_SCOPE("task", "task_pool");
   run(pool, taskdata);
 }
 
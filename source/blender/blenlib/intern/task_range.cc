@@ -15,6 +15,7 @@
 #include "BLI_array.hh"
 #include "BLI_lazy_threading.hh"
 #include "BLI_offset_indices.hh"
+#include "BLI_profile_trace.hh"
 #include "BLI_task.h"
 #include "BLI_task.hh"
 #include "BLI_threads.h"
@@ -81,6 +82,7 @@ struct RangeTask {
 
   void operator()(const tbb::blocked_range<int> &r) const
   {
+    PROFILE_TRACE_SCOPE("task", "BLI_task_parallel_range");
     TaskParallelTLS tls;
     tls.userdata_chunk = userdata_chunk;
     for (int i = r.begin(); i != r.end(); ++i) {
@@ -168,6 +170,7 @@ static void parallel_for_impl_static_size(const IndexRange range,
 {
   tbb::parallel_for(tbb::blocked_range<int64_t>(range.first(), range.one_after_last(), grain_size),
                     [function](const tbb::blocked_range<int64_t> &subrange) {
+                      PROFILE_TRACE_SCOPE("task", "parallel_for");
                       function(IndexRange(subrange.begin(), subrange.size()));
                     });
 }
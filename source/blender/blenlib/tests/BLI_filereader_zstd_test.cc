@@ -0,0 +1,131 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <zstd.h>
+
+#include "BLI_filereader.h"
+#include "BLI_rand.hh"
+#include "BLI_vector.hh"
+
+namespace blender::tests {
+
+static void append_u32_le(Vector<char> &data, const uint32_t value)
+{
+  for (int i = 0; i < 4; i++) {
+    data.append(char((value >> (i * 8)) & 0xff));
+  }
+}
+
+class FileReaderZstdTest : public testing::Test {
+ protected:
+  Vector<char> uncompressed_;
+  Vector<char> compressed_;
+
+  /**
+   * Compress data in frames of varying sizes and append a seek table in the format written by
+   * `writefile.cc`, so that the reader can seek and decompress frames in parallel.
+   */
+  void SetUp() override
+  {
+    RandomNumberGenerator rng(42);
+    Vector<std::pair<uint32_t, uint32_t>> frame_sizes;
+    for (const int frame : IndexRange(100)) {
+      const int frame_size = 1000 + rng.get_int32(4000);
+      const int64_t frame_start = uncompressed_.size();
+      for (const int i : IndexRange(frame_size)) {
+        /* Compressible, but different in every frame. */
+        uncompressed_.append(char((i / 7 + frame * 13 + rng.get_int32(3)) & 0xff));
+      }
+      const Span<char> frame_data = uncompressed_.as_span().drop_front(frame_start);
+
+      const int64_t compressed_start = compressed_.size();
+      compressed_.resize(compressed_start + ZSTD_compressBound(frame_data.size()));
+      const size_t compressed_size = ZSTD_compress(compressed_.data() + compressed_start,
+                                                   compressed_.size() - compressed_start,
+                                                   frame_data.data(),
+                                                   frame_data.size(),
+                                                   1);
+      ASSERT_FALSE(ZSTD_isError(compressed_size));
+      compressed_.resize(compressed_start + compressed_size);
+      frame_sizes.append({uint32_t(compressed_size), uint32_t(frame_data.size())});
+    }
+
+    append_u32_le(compressed_, 0x184D2A5E);
+    append_u32_le(compressed_, frame_sizes.size() * 8 + 9);
+    for (const auto &[compressed_size, uncompressed_size] : frame_sizes) {
+      append_u32_le(compressed_, compressed_size);
+      append_u32_le(compressed_, uncompressed_size);
+    }
+    append_u32_le(compressed_, frame_sizes.size());
+    compressed_.append(0);
+    append_u32_le(compressed_, 0x8F92EAB1);
+  }
+
+  FileReader *open()
+  {
+    FileReader *reader = BLI_filereader_new_zstd_parallel(
+        BLI_filereader_new_memory(compressed_.data(), compressed_.size()));
+    EXPECT_NE(reader->seek, nullptr);
+    return reader;
+  }
+
+  /** Read at the current position and compare with the uncompressed data. */
+  void expect_read(FileReader *reader, const int64_t size)
+  {
+    const int64_t offset = reader->offset;
+    const int64_t expected_size = std::min(size, uncompressed_.size() - offset);
+    Vector<char> buffer(size);
+    ASSERT_EQ(reader->read(reader, buffer.data(), size), expected_size);
+    EXPECT_TRUE(buffer.as_span().take_front(expected_size) ==
+                uncompressed_.as_span().slice(offset, expected_size));
+    EXPECT_EQ(reader->offset, offset + expected_size);
+  }
+};
+
+TEST_F(FileReaderZstdTest, SequentialRead)
+{
+  FileReader *reader = this->open();
+  while (reader->offset < uncompressed_.size()) {
+    /* Reads that are smaller and larger than frames. */
+    this->expect_read(reader, reader->offset % 3 == 0 ? 333 : 7777);
+  }
+  reader->close(reader);
+}
+
+TEST_F(FileReaderZstdTest, RandomSeeks)
+{
+  RandomNumberGenerator rng(7);
+  FileReader *reader = this->open();
+  for ([[maybe_unused]] const int i : IndexRange(200)) {
+    const int64_t offset = rng.get_int32(uncompressed_.size());
+    ASSERT_EQ(reader->seek(reader, offset, SEEK_SET), offset);
+    this->expect_read(reader, 1 + rng.get_int32(6000));
+  }
+  reader->close(reader);
+}
+
+TEST_F(FileReaderZstdTest, SeeksBetweenSequentialReads)
+{
+  RandomNumberGenerator rng(3);
+  FileReader *reader = this->open();
+  for ([[maybe_unused]] const int i : IndexRange(20)) {
+    const int64_t offset = rng.get_int32(uncompressed_.size());
+    ASSERT_EQ(reader->seek(reader, offset, SEEK_SET), offset);
+    /* Often enough frames in order to start decompressing ahead, then seek while frames are still
+     * being decompressed. */
+    const int reads_num = rng.get_int32(40);
+    for ([[maybe_unused]] const int j : IndexRange(reads_num)) {
+      this->expect_read(reader, 2000);
+    }
+    /* Seek back to somewhere in the frames that were just read. */
+    const int64_t back_offset = std::max<int64_t>(reader->offset - rng.get_int32(5000), 0);
+    ASSERT_EQ(reader->seek(reader, back_offset, SEEK_SET), back_offset);
+    this->expect_read(reader, 100);
+  }
+  reader->close(reader);
+}
+
+}  // namespace blender::tests
@@ -134,3 +134,204 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+/* -------------------------------------------------------------------- */
+/* Wide Layout */
+
+static BVHTree *random_boxes_tree_new(const float (*boxes)[2][3], int boxes_len, char tree_type)
+{
+  BVHTree *tree = BLI_bvhtree_new(boxes_len, 0.0, tree_type, 6);
+  for (int i = 0; i < boxes_len; i++) {
+    BLI_bvhtree_insert(tree, i, boxes[i][0], 2);
+  }
+  BLI_bvhtree_balance(tree);
+  return tree;
+}
+
+static void random_boxes(float (*boxes)[2][3], int boxes_len, RNG *rng)
+{
+  for (int i = 0; i < boxes_len; i++) {
+    rng_v3_round(boxes[i][0], 3, rng, 1000, 1.0f);
+    rng_v3_round(boxes[i][1], 3, rng, 1000, 0.05f);
+    add_v3_v3(boxes[i][1], boxes[i][0]);
+  }
+}
+
+static void ray_cast_count_cb(void *userdata,
+                              int /*index*/,
+                              const BVHTreeRay * /*ray*/,
+                              BVHTreeRayHit * /*hit*/)
+{
+  (*static_cast<int *>(userdata))++;
+}
+
+static void wide_compare_queries(const BVHTree *tree, const BVHTree *tree_wide, RNG *rng)
+{
+  for (int i = 0; i < 200; i++) {
+    float co[3], target[3], dir[3];
+    /* Cast from outside of the boxes towards a random target. */
+    rng_v3_round(co, 3, rng, 1000, 1.0f);
+    normalize_v3_length(co, 3.0f);
+    rng_v3_round(target, 3, rng, 1000, 1.0f);
+    sub_v3_v3v3(dir, target, co);
+    normalize_v3(dir);
+
+    for (const float radius : {0.0f, 0.02f}) {
+      BVHTreeRayHit hit, hit_wide;
+      hit.index = hit_wide.index = -1;
+      hit.dist = hit_wide.dist = BVH_RAYCAST_DIST_MAX;
+      BLI_bvhtree_ray_cast(tree, co, dir, radius, &hit, nullptr, nullptr);
+      BLI_bvhtree_ray_cast(tree_wide, co, dir, radius, &hit_wide, nullptr, nullptr);
+      EXPECT_EQ(hit.index == -1, hit_wide.index == -1);
+      EXPECT_FLOAT_EQ(hit.dist, hit_wide.dist);
+
+      int hits_num = 0, hits_num_wide = 0;
+      BLI_bvhtree_ray_cast_all(
+          tree, co, dir, radius, BVH_RAYCAST_DIST_MAX, ray_cast_count_cb, &hits_num);
+      BLI_bvhtree_ray_cast_all(
+          tree_wide, co, dir, radius, BVH_RAYCAST_DIST_MAX, ray_cast_count_cb, &hits_num_wide);
+      EXPECT_EQ(hits_num, hits_num_wide);
+    }
+
+    BVHTreeNearest nearest, nearest_wide;
+    nearest.index = nearest_wide.index = -1;
+    nearest.dist_sq = nearest_wide.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, target, &nearest, nullptr, nullptr);
+    BLI_bvhtree_find_nearest(tree_wide, target, &nearest_wide, nullptr, nullptr);
+    EXPECT_NE(nearest_wide.index, -1);
+    EXPECT_FLOAT_EQ(nearest.dist_sq, nearest_wide.dist_sq);
+  }
+}
+
+static void wide_compare_test(int boxes_len, char tree_type, int width)
+{
+  RNG *rng = BLI_rng_new(boxes_len);
+  float(*boxes)[2][3] = static_cast<float(*)[2][3]>(
+      MEM_malloc_arrayN(size_t(boxes_len), sizeof(*boxes), __func__));
+  random_boxes(boxes, boxes_len, rng);
+
+  BVHTree *tree = random_boxes_tree_new(boxes, boxes_len, tree_type);
+  BVHTree *tree_wide = random_boxes_tree_new(boxes, boxes_len, tree_type);
+  if (!BLI_bvhtree_build_wide(tree_wide, width)) {
+    BLI_bvhtree_free(tree);
+    BLI_bvhtree_free(tree_wide);
+    BLI_rng_free(rng);
+    MEM_freeN(boxes);
+    GTEST_SKIP() << "Wide layout with " << width << " children is not supported";
+  }
+  wide_compare_queries(tree, tree_wide, rng);
+
+  /* Move the boxes and refit both trees. */
+  random_boxes(boxes, boxes_len, rng);
+  for (int i = 0; i < boxes_len; i++) {
+    BLI_bvhtree_update_node(tree, i, boxes[i][0], nullptr, 2);
+    BLI_bvhtree_update_node(tree_wide, i, boxes[i][0], nullptr, 2);
+  }
+  BLI_bvhtree_update_tree(tree);
+  BLI_bvhtree_update_tree(tree_wide);
+  wide_compare_queries(tree, tree_wide, rng);
+
+  BLI_bvhtree_free(tree);
+  BLI_bvhtree_free(tree_wide);
+  BLI_rng_free(rng);
+  MEM_freeN(boxes);
+}
+
+TEST(kdopbvh, WideBinary_1)
+{
+  wide_compare_test(1, 2, 4);
+}
+TEST(kdopbvh, WideBinary_1000)
+{
+  wide_compare_test(1000, 2, 4);
+}
+TEST(kdopbvh, WideQuad_1000)
+{
+  wide_compare_test(1000, 4, 4);
+}
+TEST(kdopbvh, Wide8Binary_1)
+{
+  wide_compare_test(1, 2, 8);
+}
+TEST(kdopbvh, Wide8Binary_1000)
+{
+  wide_compare_test(1000, 2, 8);
+}
+TEST(kdopbvh, Wide8Quad_1000)
+{
+  wide_compare_test(1000, 4, 8);
+}
+TEST(kdopbvh, Wide8Oct_1000)
+{
+  wide_compare_test(1000, 8, 8);
+}
+
+TEST(kdopbvh, WideUnsupported)
+{
+  /* The 18-DOP doesn't include the X, Y and Z axes. */
+  BVHTree *tree = BLI_bvhtree_new(2, 0.0, 2, 18);
+  const float co[3] = {0.0f, 0.0f, 0.0f};
+  BLI_bvhtree_insert(tree, 0, co, 1);
+  BLI_bvhtree_insert(tree, 1, co, 1);
+  BLI_bvhtree_balance(tree);
+  EXPECT_FALSE(BLI_bvhtree_build_wide(tree));
+  BLI_bvhtree_free(tree);
+
+  /* More children per node than the wide layout has. */
+  tree = BLI_bvhtree_new(16, 0.0, 8, 6);
+  for (int i = 0; i < 16; i++) {
+    const float co[3] = {float(i), 0.0f, 0.0f};
+    BLI_bvhtree_insert(tree, i, co, 1);
+  }
+  BLI_bvhtree_balance(tree);
+  EXPECT_FALSE(BLI_bvhtree_build_wide(tree, 4));
+  EXPECT_FALSE(BLI_bvhtree_build_wide(tree, 5));
+  BLI_bvhtree_free(tree);
+}
+
+/* -------------------------------------------------------------------- */
+/* Refit */
+
+static void refit_compare_test(int boxes_len, char tree_type)
+{
+  RNG *rng = BLI_rng_new(boxes_len);
+  float(*boxes)[2][3] = static_cast<float(*)[2][3]>(
+      MEM_malloc_arrayN(size_t(boxes_len), sizeof(*boxes), __func__));
+  random_boxes(boxes, boxes_len, rng);
+
+  BVHTree *tree = random_boxes_tree_new(boxes, boxes_len, tree_type);
+  const float build_cost = BLI_bvhtree_surface_area_cost(tree);
+  EXPECT_GT(build_cost, 0.0f);
+
+  /* Refitting to the same boxes doesn't change the tree. */
+  for (int i = 0; i < boxes_len; i++) {
+    BLI_bvhtree_update_node(tree, i, boxes[i][0], nullptr, 2);
+  }
+  BLI_bvhtree_update_tree(tree);
+  EXPECT_FLOAT_EQ(BLI_bvhtree_surface_area_cost(tree), build_cost);
+
+  /* Queries on a refit tree find the same elements as on a new tree, the tree just has a worse
+   * structure for the new boxes. */
+  random_boxes(boxes, boxes_len, rng);
+  for (int i = 0; i < boxes_len; i++) {
+    BLI_bvhtree_update_node(tree, i, boxes[i][0], nullptr, 2);
+  }
+  BLI_bvhtree_update_tree(tree);
+  BVHTree *tree_new = random_boxes_tree_new(boxes, boxes_len, tree_type);
+  wide_compare_queries(tree_new, tree, rng);
+  EXPECT_GT(BLI_bvhtree_surface_area_cost(tree), BLI_bvhtree_surface_area_cost(tree_new));
+
+  BLI_bvhtree_free(tree);
+  BLI_bvhtree_free(tree_new);
+  BLI_rng_free(rng);
+  MEM_freeN(boxes);
+}
+
+TEST(kdopbvh, RefitBinary_5000)
+{
+  refit_compare_test(5000, 2);
+}
+TEST(kdopbvh, RefitQuad_5000)
+{
+  refit_compare_test(5000, 4);
+}
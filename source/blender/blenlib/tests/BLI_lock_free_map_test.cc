@@ -0,0 +1,128 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <atomic>
+#include <string>
+
+#include "BLI_array.hh"
+#include "BLI_lock_free_map.hh"
+#include "BLI_map.hh"
+#include "BLI_task.hh"
+
+namespace blender::tests {
+
+TEST(lock_free_map, AddLookup)
+{
+  LockFreeMap<int, int> map(100);
+  EXPECT_FALSE(map.contains(5));
+  EXPECT_EQ(map.lookup_ptr(5), nullptr);
+  {
+    LockFreeMap<int, int>::MutableAccessor accessor;
+    EXPECT_TRUE(map.add(accessor, 5));
+    EXPECT_EQ(accessor->first, 5);
+    EXPECT_EQ(accessor->second, 0);
+    accessor->second = 10;
+  }
+  {
+    LockFreeMap<int, int>::MutableAccessor accessor;
+    EXPECT_FALSE(map.add(accessor, 5));
+    EXPECT_EQ(accessor->second, 10);
+  }
+  {
+    LockFreeMap<int, int>::ConstAccessor accessor;
+    const LockFreeMap<int, int> &const_map = map;
+    EXPECT_TRUE(const_map.lookup(accessor, 5));
+    EXPECT_EQ(accessor->second, 10);
+    EXPECT_FALSE(const_map.lookup(accessor, 6));
+  }
+  EXPECT_TRUE(map.contains(5));
+  EXPECT_EQ(*map.lookup_ptr(5), 10);
+  EXPECT_EQ(map.count(), 1);
+}
+
+TEST(lock_free_map, LookupOrAdd)
+{
+  LockFreeMap<int, int> map(1000);
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(map.lookup_or_add(i, i * 2), i * 2);
+  }
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(map.lookup_or_add(i, -1), i * 2);
+  }
+  EXPECT_EQ(map.count(), 1000);
+  EXPECT_GE(map.capacity(), 1000);
+}
+
+TEST(lock_free_map, TryLookupOrAddWhenFull)
+{
+  LockFreeMap<int, int> map(3);
+  EXPECT_NE(map.try_lookup_or_add(1, 10), nullptr);
+  EXPECT_NE(map.try_lookup_or_add(2, 20), nullptr);
+  EXPECT_NE(map.try_lookup_or_add(3, 30), nullptr);
+  EXPECT_EQ(map.try_lookup_or_add(4, 40), nullptr);
+  /* Existing keys can still be found. */
+  EXPECT_EQ(*map.try_lookup_or_add(2, -1), 20);
+  EXPECT_FALSE(map.contains(4));
+  EXPECT_EQ(map.count(), 3);
+}
+
+TEST(lock_free_map, ForeachItem)
+{
+  LockFreeMap<int, int> map(10);
+  map.lookup_or_add(1, 2);
+  map.lookup_or_add(3, 4);
+  map.lookup_or_add(5, 6);
+  Map<int, int> items;
+  map.foreach_item([&](const int key, const int value) { items.add_new(key, value); });
+  EXPECT_EQ(items.size(), 3);
+  EXPECT_EQ(items.lookup(1), 2);
+  EXPECT_EQ(items.lookup(3), 4);
+  EXPECT_EQ(items.lookup(5), 6);
+}
+
+TEST(lock_free_map, NonTrivialTypes)
+{
+  LockFreeMap<std::string, std::string> map(10);
+  map.lookup_or_add("a", "b");
+  map.lookup_or_add("a long string that does not fit into the inline buffer", "c");
+  EXPECT_EQ(*map.lookup_ptr("a"), "b");
+  EXPECT_EQ(*map.lookup_ptr("a long string that does not fit into the inline buffer"), "c");
+  EXPECT_EQ(map.lookup_ptr("d"), nullptr);
+}
+
+TEST(lock_free_map, ThreadedAdd)
+{
+  const int keys_num = 10000;
+  const int threads_num = 16;
+  LockFreeMap<int, std::atomic<int>> map(keys_num);
+
+  /* Every thread adds all keys, so that most keys are added by multiple threads at once. */
+  Array<int> added_num_by_thread(threads_num, 0);
+  threading::parallel_for(IndexRange(threads_num), 1, [&](const IndexRange range) {
+    for (const int64_t thread : range) {
+      for (int i = 0; i < keys_num; i++) {
+        const int key = int((i * 7 + thread * 13) % keys_num);
+        LockFreeMap<int, std::atomic<int>>::MutableAccessor accessor;
+        if (map.add(accessor, key)) {
+          added_num_by_thread[thread]++;
+        }
+        accessor->second.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  });
+
+  int added_num = 0;
+  for (const int num : added_num_by_thread) {
+    added_num += num;
+  }
+  EXPECT_EQ(added_num, keys_num);
+  EXPECT_EQ(map.count(), keys_num);
+  for (int i = 0; i < keys_num; i++) {
+    EXPECT_EQ(map.lookup_ptr(i)->load(), threads_num);
+  }
+}
+
+}  // namespace blender::tests
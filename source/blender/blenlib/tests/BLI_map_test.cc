@@ -763,6 +763,78 @@ TEST(map, Equality)
   EXPECT_NE(a, b);
 }
 
+TEST(map, GroupProbing)
+{
+  Map<int, int, 4, GroupProbingStrategy> map;
+  std::unordered_map<int, int> std_map;
+  EXPECT_FALSE(map.contains(0));
+  RNG *rng = BLI_rng_new(0);
+  for (int i = 0; i < 100000; i++) {
+    const int key = BLI_rng_get_int(rng) % 20000;
+    switch (BLI_rng_get_int(rng) % 4) {
+      case 0:
+        EXPECT_EQ(map.remove(key), std_map.erase(key) == 1);
+        break;
+      case 1:
+        EXPECT_EQ(map.add(key, i), std_map.insert({key, i}).second);
+        break;
+      case 2:
+        map.add_overwrite(key, i);
+        std_map[key] = i;
+        break;
+      case 3:
+        map.lookup_or_add(key, i) += 1;
+        std_map.insert({key, i}).first->second += 1;
+        break;
+    }
+  }
+  BLI_rng_free(rng);
+  EXPECT_EQ(map.size(), int64_t(std_map.size()));
+  for (int key = 0; key < 20000; key++) {
+    const int *value = map.lookup_ptr(key);
+    const auto it = std_map.find(key);
+    EXPECT_EQ(value == nullptr, it == std_map.end());
+    if (value) {
+      EXPECT_EQ(*value, it->second);
+    }
+  }
+
+  map.remove_if([](const auto item) { return item.key % 2 == 0; });
+  for (const auto &[key, value] : std_map) {
+    EXPECT_EQ(map.contains(key), key % 2 == 1);
+  }
+  for (const auto item : map.items()) {
+    EXPECT_EQ(item.value, std_map[item.key]);
+  }
+
+  Map<int, int, 4, GroupProbingStrategy> map_copy = map;
+  Map<int, int, 4, GroupProbingStrategy> map_moved = std::move(map);
+  EXPECT_EQ(map_copy, map_moved);
+  EXPECT_TRUE(map.is_empty());
+  EXPECT_FALSE(map.contains(1));
+
+  map_moved.clear_and_keep_capacity();
+  EXPECT_TRUE(map_moved.is_empty());
+  EXPECT_FALSE(map_moved.contains(1));
+  map_moved.add_new(1, 2);
+  EXPECT_EQ(map_moved.pop(1), 2);
+  EXPECT_FALSE(map_moved.contains(1));
+}
+
+TEST(map, GroupProbingStrings)
+{
+  Map<std::string, int, 4, GroupProbingStrategy> map;
+  for (int i = 0; i < 1000; i++) {
+    map.add_new(std::to_string(i), i);
+  }
+  EXPECT_EQ(map.lookup_as("123"), 123);
+  EXPECT_EQ(map.lookup_as(StringRef("999")), 999);
+  EXPECT_EQ(map.lookup_ptr_as("1000"), nullptr);
+  EXPECT_EQ(map.pop_as("42"), 42);
+  EXPECT_FALSE(map.contains_as("42"));
+  EXPECT_EQ(map.size(), 999);
+}
+
 /**
  * Set this to 1 to activate the benchmark. It is disabled by default, because it prints a lot.
  */
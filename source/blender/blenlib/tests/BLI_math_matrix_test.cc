@@ -4,10 +4,12 @@
 
 #include "testing/testing.h"
 
+#include "BLI_array.hh"
 #include "BLI_math_matrix.h"
 #include "BLI_math_matrix.hh"
 #include "BLI_math_rotation.h"
 #include "BLI_math_rotation.hh"
+#include "BLI_rand.hh"
 
 TEST(math_matrix, interp_m4_m4m4_regular)
 {
@@ -569,6 +571,44 @@ TEST(math_matrix, MatrixTransform)
   EXPECT_V2_NEAR(result2, expect2, 1e-5);
 }
 
+TEST(math_matrix, MatrixTransformBatch)
+{
+  /* Use sizes that are not a multiple of the SIMD width to test the remaining elements. */
+  for (const int size : {0, 1, 7, 8, 13, 1000, 10007}) {
+    Array<float3> src(size);
+    RandomNumberGenerator rng(size);
+    for (float3 &value : src) {
+      value = float3(rng.get_float(), rng.get_float(), rng.get_float()) * 10.0f - 5.0f;
+    }
+    if (size > 0) {
+      /* Too short to be normalized. */
+      src.last() = float3(0.0f);
+    }
+    const float4x4 m4 = from_loc_rot_scale<float4x4>(
+        {10, -2, 3}, EulerXYZ(0.3f, 1.0f, -2.0f), float3(0.5f, 2.0f, 3.0f));
+    const float3x3 m3 = from_rotation<float3x3>(to_quaternion(EulerXYZ(0.3f, 1.0f, -2.0f)));
+
+    Array<float3> points(size);
+    transform_points(src, m4, points);
+    Array<float3> directions(size);
+    transform_directions(src, m3, directions);
+    Array<float3> normals(size);
+    transform_normals(src, m3, normals);
+    for (const int i : src.index_range()) {
+      EXPECT_V3_NEAR(points[i], transform_point(m4, src[i]), 1e-5f);
+      EXPECT_V3_NEAR(directions[i], transform_direction(m3, src[i]), 1e-5f);
+      EXPECT_V3_NEAR(normals[i], normalize(transform_direction(m3, src[i])), 1e-5f);
+    }
+
+    /* Transform in place. */
+    Array<float3> values = src;
+    transform_points(values.as_mutable_span(), m4, false);
+    for (const int i : src.index_range()) {
+      EXPECT_V3_NEAR(values[i], points[i], 1e-5f);
+    }
+  }
+}
+
 TEST(math_matrix, MatrixTransform2D)
 {
   const float2 sample_point = float2(2.0f, 3.0f);
@@ -37,6 +37,11 @@ class GenericIntKey : public GenericKey {
     return std::make_unique<GenericIntKey>(*this);
   }
 
+  const char *type_name() const override
+  {
+    return "Test Int";
+  }
+
  public:
   int value() const
   {
@@ -105,4 +110,57 @@ TEST(memory_cache, RemoveIf)
                })->value);
 }
 
+static KeyTypeStatistics get_int_key_statistics()
+{
+  for (const KeyTypeStatistics &statistics : memory_cache::get_statistics()) {
+    if (statistics.key_type == "Test Int") {
+      return statistics;
+    }
+  }
+  return {};
+}
+
+TEST(memory_cache, Statistics)
+{
+  memory_cache::clear();
+  const KeyTypeStatistics old_statistics = get_int_key_statistics();
+  EXPECT_EQ(old_statistics.values_num, 0);
+
+  for ([[maybe_unused]] const int i : IndexRange(3)) {
+    memory_cache::get<CachedInt>(GenericIntKey(1),
+                                 []() { return std::make_unique<CachedInt>(1); });
+  }
+  memory_cache::get<CachedInt>(GenericIntKey(2), []() { return std::make_unique<CachedInt>(2); });
+
+  const KeyTypeStatistics statistics = get_int_key_statistics();
+  EXPECT_EQ(statistics.hits - old_statistics.hits, 2);
+  EXPECT_EQ(statistics.misses - old_statistics.misses, 2);
+  EXPECT_EQ(statistics.values_num, 2);
+  EXPECT_EQ(statistics.bytes, 2 * int64_t(sizeof(int)));
+
+  memory_cache::clear();
+  EXPECT_EQ(get_int_key_statistics().values_num, 0);
+  EXPECT_EQ(get_int_key_statistics().bytes, 0);
+}
+
+TEST(memory_cache, Eviction)
+{
+  memory_cache::clear();
+  const KeyTypeStatistics old_statistics = get_int_key_statistics();
+
+  const int64_t limit = 100 * sizeof(int);
+  memory_cache::set_approximate_size_limit(limit);
+  for (const int i : IndexRange(1000)) {
+    memory_cache::get<CachedInt>(GenericIntKey(i),
+                                 [&]() { return std::make_unique<CachedInt>(i); });
+  }
+  const KeyTypeStatistics statistics = get_int_key_statistics();
+  EXPECT_GT(statistics.evictions, old_statistics.evictions);
+  EXPECT_LE(statistics.bytes, limit);
+  EXPECT_EQ(statistics.values_num + statistics.evictions - old_statistics.evictions, 1000);
+
+  memory_cache::set_approximate_size_limit(1024 * 1024 * 1024);
+  memory_cache::clear();
+}
+
 }  // namespace blender::memory_cache::tests
@@ -0,0 +1,103 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_mempool_threadsafe.hh"
+#include "BLI_set.hh"
+#include "BLI_task.hh"
+#include "BLI_vector.hh"
+
+namespace blender::tests {
+
+struct TestElem {
+  void *next;
+  int value;
+  int thread_index;
+};
+
+TEST(mempool_threadsafe, AllocFree)
+{
+  ThreadSafeMempool mempool(sizeof(TestElem), 0, 64, BLI_MEMPOOL_ALLOW_ITER, 8);
+  Vector<TestElem *> elems;
+  for (const int i : IndexRange(100)) {
+    TestElem *elem = static_cast<TestElem *>(mempool.calloc());
+    EXPECT_EQ(elem->value, 0);
+    elem->value = i;
+    elems.append(elem);
+  }
+  mempool.flush();
+  EXPECT_EQ(BLI_mempool_len(mempool.pool()), 100);
+
+  for (const int i : IndexRange(50)) {
+    mempool.free(elems[i * 2]);
+  }
+  mempool.flush();
+  EXPECT_EQ(BLI_mempool_len(mempool.pool()), 50);
+
+  /* Freed elements and elements in the (now empty) local caches are skipped by iteration. */
+  int iter_num = 0;
+  BLI_mempool_iter iter;
+  BLI_mempool_iternew(mempool.pool(), &iter);
+  while (TestElem *elem = static_cast<TestElem *>(BLI_mempool_iterstep(&iter))) {
+    EXPECT_EQ(elem->value % 2, 1);
+    iter_num++;
+  }
+  EXPECT_EQ(iter_num, 50);
+}
+
+TEST(mempool_threadsafe, Threaded)
+{
+  ThreadSafeMempool mempool(sizeof(TestElem), 0, 512, BLI_MEMPOOL_ALLOW_ITER);
+  const int threads_num = 16;
+  const int elems_per_thread = 10000;
+
+  Array<Vector<TestElem *>> elems_by_thread(threads_num);
+  threading::parallel_for(IndexRange(threads_num), 1, [&](const IndexRange range) {
+    for (const int thread : range) {
+      for (const int i : IndexRange(elems_per_thread)) {
+        TestElem *elem = static_cast<TestElem *>(mempool.alloc());
+        elem->value = i;
+        elem->thread_index = thread;
+        elems_by_thread[thread].append(elem);
+      }
+    }
+  });
+
+  Set<TestElem *> unique_elems;
+  for (const Vector<TestElem *> &elems : elems_by_thread) {
+    for (TestElem *elem : elems) {
+      EXPECT_TRUE(unique_elems.add(elem));
+    }
+  }
+  EXPECT_EQ(unique_elems.size(), threads_num * elems_per_thread);
+
+  threading::parallel_for(IndexRange(threads_num), 1, [&](const IndexRange range) {
+    for (const int thread : range) {
+      for (TestElem *elem : elems_by_thread[thread]) {
+        EXPECT_EQ(elem->thread_index, thread);
+        if (elem->value % 2 == 0) {
+          mempool.free(elem);
+        }
+      }
+    }
+  });
+  mempool.flush();
+  EXPECT_EQ(BLI_mempool_len(mempool.pool()), threads_num * elems_per_thread / 2);
+
+  int iter_num = 0;
+  BLI_mempool_iter iter;
+  BLI_mempool_iternew(mempool.pool(), &iter);
+  while (TestElem *elem = static_cast<TestElem *>(BLI_mempool_iterstep(&iter))) {
+    EXPECT_EQ(elem->value % 2, 1);
+    iter_num++;
+  }
+  EXPECT_EQ(iter_num, threads_num * elems_per_thread / 2);
+
+  mempool.clear();
+  EXPECT_EQ(BLI_mempool_len(mempool.pool()), 0);
+}
+
+}  // namespace blender::tests
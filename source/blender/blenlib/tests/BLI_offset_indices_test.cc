@@ -4,8 +4,10 @@
 
 #include "testing/testing.h"
 
+#include "BLI_array.hh"
 #include "BLI_index_mask.hh"
 #include "BLI_offset_indices.hh"
+#include "BLI_rand.hh"
 #include "BLI_vector.hh"
 
 #include "BLI_strict_flags.h" /* Keep last. */
@@ -24,4 +26,72 @@ TEST(offset_indices, SumSizes)
   EXPECT_EQ(sum_group_sizes(offsets, IndexMask(1)), 3);
 }
 
+TEST(offset_indices, AccumulateLarge)
+{
+  /* Large enough to use the parallel prefix sum. */
+  RandomNumberGenerator rng(0);
+  for (const int size : {100, 65536, 200001}) {
+    Array<int> counts(size + 1);
+    for (int &count : counts) {
+      count = rng.get_int32(10);
+    }
+    Array<int> expected(size + 1);
+    int offset = 5;
+    for (const int i : IndexRange(size)) {
+      expected[i] = offset;
+      offset += counts[i];
+    }
+    expected.last() = offset;
+
+    Array<int> offsets = counts;
+    accumulate_counts_to_offsets(offsets, 5);
+    EXPECT_EQ(offsets.as_span(), expected.as_span());
+
+    offsets = counts;
+    EXPECT_TRUE(accumulate_counts_to_offsets_with_overflow_check(offsets, 5).has_value());
+    EXPECT_EQ(offsets.as_span(), expected.as_span());
+  }
+}
+
+TEST(offset_indices, AccumulateOverflow)
+{
+  Array<int> counts(200001, 20000);
+  EXPECT_FALSE(accumulate_counts_to_offsets_with_overflow_check(counts).has_value());
+}
+
+TEST(offset_indices, ReverseIndices)
+{
+  const Array<int> indices = {3, 0, 3, 1, 0, 3};
+  Array<int> offsets(5, 0);
+  build_reverse_offsets(indices, offsets);
+  EXPECT_EQ(offsets.as_span(), Span<int>({0, 2, 3, 3, 6}));
+
+  Array<int> reverse_indices(indices.size());
+  build_reverse_indices(indices, OffsetIndices<int>(offsets), reverse_indices);
+  EXPECT_EQ(reverse_indices.as_span(), Span<int>({1, 4, 3, 0, 2, 5}));
+}
+
+TEST(offset_indices, ReverseIndicesLarge)
+{
+  RandomNumberGenerator rng(0);
+  const int groups_num = 1000;
+  Array<int> indices(100000);
+  for (int &index : indices) {
+    index = rng.get_int32(groups_num);
+  }
+  Array<int> offsets(groups_num + 1, 0);
+  build_reverse_offsets(indices, offsets);
+  const OffsetIndices<int> groups(offsets);
+
+  Array<int> reverse_indices(indices.size());
+  build_reverse_indices(indices, groups, reverse_indices);
+  for (const int group : groups.index_range()) {
+    const Span<int> group_indices = reverse_indices.as_span().slice(groups[group]);
+    EXPECT_TRUE(std::is_sorted(group_indices.begin(), group_indices.end()));
+    for (const int i : group_indices) {
+      EXPECT_EQ(indices[i], group);
+    }
+  }
+}
+
 }  // namespace blender::offset_indices::tests
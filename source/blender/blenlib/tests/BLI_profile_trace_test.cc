@@ -0,0 +1,121 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "BLI_fileops.h"
+#include "BLI_path_utils.hh"
+#include "BLI_profile_trace.hh"
+#include "BLI_task.hh"
+#include "BLI_tempfile.h"
+
+namespace blender::tests {
+
+static std::string read_file(const char *filepath)
+{
+  std::ifstream file(filepath);
+  std::stringstream stream;
+  stream << file.rdbuf();
+  return stream.str();
+}
+
+TEST(profile_trace, NotRecording)
+{
+  profile_trace::stop_recording();
+  profile_trace::clear();
+  {
+    const profile_trace::ScopedEvent event("test", "Not Recorded");
+  }
+  EXPECT_EQ(profile_trace::recorded_events_num(), 0);
+}
+
+TEST(profile_trace, RingBuffer)
+{
+  profile_trace::start_recording(8);
+  for (int i = 0; i < 20; i++) {
+    const profile_trace::ScopedEvent event("test", "Event");
+  }
+  profile_trace::stop_recording();
+  /* Only the newest events of the thread are kept. */
+  EXPECT_EQ(profile_trace::recorded_events_num(), 8);
+  {
+    const profile_trace::ScopedEvent event("test", "Not Recorded");
+  }
+  EXPECT_EQ(profile_trace::recorded_events_num(), 8);
+  profile_trace::clear();
+  EXPECT_EQ(profile_trace::recorded_events_num(), 0);
+}
+
+TEST(profile_trace, DynamicName)
+{
+  profile_trace::stop_recording();
+  bool name_created = false;
+  {
+    const profile_trace::ScopedEventDynamic event("test", [&]() {
+      name_created = true;
+      return std::string("Name");
+    });
+  }
+  EXPECT_FALSE(name_created);
+
+  profile_trace::start_recording();
+  {
+    const profile_trace::ScopedEventDynamic event("test", [&]() {
+      name_created = true;
+      return std::string("Name");
+    });
+  }
+  EXPECT_TRUE(name_created);
+  EXPECT_EQ(profile_trace::recorded_events_num(), 1);
+  profile_trace::stop_recording();
+  profile_trace::clear();
+}
+
+TEST(profile_trace, Threaded)
+{
+  profile_trace::start_recording();
+  threading::parallel_for(IndexRange(1000), 1, [&](const IndexRange range) {
+    for ([[maybe_unused]] const int64_t i : range) {
+      const profile_trace::ScopedEvent event("test", "Task");
+    }
+  });
+  profile_trace::stop_recording();
+  /* The parallel loop may record events for its own tasks too. */
+  EXPECT_EQ(profile_trace::recorded_events_num("test"), 1000);
+  profile_trace::clear();
+}
+
+TEST(profile_trace, WriteJson)
+{
+  char temp_dir[FILE_MAX];
+  BLI_temp_directory_path_get(temp_dir, sizeof(temp_dir));
+  char filepath[FILE_MAX];
+  BLI_path_join(filepath, sizeof(filepath), temp_dir, "blender_profile_trace_test.json");
+
+  profile_trace::start_recording();
+  {
+    const profile_trace::ScopedEvent event("test", "Outer");
+    profile_trace::record_event("test",
+                                "Quote \" and \\ backslash",
+                                profile_trace::Clock::now(),
+                                profile_trace::Clock::now());
+  }
+  EXPECT_TRUE(profile_trace::write_json(filepath));
+  EXPECT_FALSE(profile_trace::is_recording());
+
+  const std::string json = read_file(filepath);
+  BLI_delete(filepath, false, false);
+  profile_trace::clear();
+
+  EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0);
+  EXPECT_NE(json.find("\"name\":\"thread_name\",\"ph\":\"M\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"Outer\",\"cat\":\"test\",\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(json.find("\"name\":\"Quote \\\" and \\\\ backslash\""), std::string::npos);
+  EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+}
+
+}  // namespace blender::tests
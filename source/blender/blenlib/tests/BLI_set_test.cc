@@ -626,6 +626,81 @@ TEST(set, Equality)
   EXPECT_NE(f, a);
 }
 
+TEST(set, GroupProbing)
+{
+  Set<int, 4, GroupProbingStrategy> set;
+  std::set<int> std_set;
+  EXPECT_FALSE(set.contains(0));
+  RNG *rng = BLI_rng_new(0);
+  for (int i = 0; i < 100000; i++) {
+    const int value = BLI_rng_get_int(rng) % 20000;
+    if (BLI_rng_get_int(rng) % 3 == 0) {
+      EXPECT_EQ(set.remove(value), std_set.erase(value) == 1);
+    }
+    else {
+      EXPECT_EQ(set.add(value), std_set.insert(value).second);
+    }
+  }
+  BLI_rng_free(rng);
+  EXPECT_EQ(set.size(), int64_t(std_set.size()));
+  for (int value = 0; value < 20000; value++) {
+    EXPECT_EQ(set.contains(value), std_set.count(value) == 1);
+  }
+  int64_t count = 0;
+  for (const int value : set) {
+    EXPECT_TRUE(std_set.count(value) == 1);
+    count++;
+  }
+  EXPECT_EQ(count, set.size());
+
+  set.remove_if([](const int value) { return value % 2 == 0; });
+  for (int value = 0; value < 20000; value++) {
+    EXPECT_EQ(set.contains(value), value % 2 == 1 && std_set.count(value) == 1);
+  }
+
+  Set<int, 4, GroupProbingStrategy> set_copy = set;
+  Set<int, 4, GroupProbingStrategy> set_moved = std::move(set);
+  EXPECT_EQ(set_copy, set_moved);
+  EXPECT_TRUE(set.is_empty());
+  EXPECT_FALSE(set.contains(1));
+
+  set_moved.clear_and_keep_capacity();
+  EXPECT_TRUE(set_moved.is_empty());
+  EXPECT_FALSE(set_moved.contains(1));
+  set_moved.add_new(1);
+  EXPECT_TRUE(set_moved.contains(1));
+}
+
+TEST(set, GroupProbingCollisions)
+{
+  /* All keys have one of ten hashes, so that groups overflow. */
+  Set<uint, 0, GroupProbingStrategy, HashIntModN<10>> set;
+  for (uint i = 0; i < 1000; i++) {
+    EXPECT_TRUE(set.add(i));
+  }
+  for (uint i = 0; i < 1000; i += 2) {
+    set.remove_contained(i);
+  }
+  for (uint i = 0; i < 2000; i++) {
+    EXPECT_EQ(set.contains(i), i < 1000 && i % 2 == 1);
+  }
+}
+
+TEST(set, GroupProbingStrings)
+{
+  Set<std::string, 4, GroupProbingStrategy> set;
+  for (int i = 0; i < 1000; i++) {
+    set.add(std::to_string(i));
+  }
+  EXPECT_TRUE(set.contains_as("123"));
+  EXPECT_TRUE(set.contains_as(StringRef("999")));
+  EXPECT_FALSE(set.contains_as("1000"));
+  EXPECT_EQ(set.lookup_key_as("42"), "42");
+  EXPECT_TRUE(set.remove_as("42"));
+  EXPECT_FALSE(set.contains_as("42"));
+  EXPECT_EQ(set.size(), 999);
+}
+
 /**
  * Set this to 1 to activate the benchmark. It is disabled by default, because it prints a lot.
  */
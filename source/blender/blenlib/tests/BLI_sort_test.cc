@@ -0,0 +1,130 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "BLI_array.hh"
+#include "BLI_array_utils.hh"
+#include "BLI_rand.hh"
+#include "BLI_sort.hh"
+
+namespace blender::tests {
+
+template<typename T> static Array<T> random_values(const int64_t size, const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  Array<T> values(size);
+  for (T &value : values) {
+    if constexpr (std::is_floating_point_v<T>) {
+      value = T(rng.get_float() * 2000.0f - 1000.0f);
+    }
+    else if constexpr (std::is_signed_v<T>) {
+      value = T(int64_t(rng.get_uint64()));
+    }
+    else {
+      value = T(rng.get_uint64());
+    }
+  }
+  return values;
+}
+
+template<typename T> static void test_radix_sort(const int64_t size)
+{
+  Array<T> values = random_values<T>(size, uint32_t(size));
+  Array<T> expected = values;
+  std::sort(expected.begin(), expected.end());
+  radix_sort<T>(values);
+  EXPECT_EQ(values.as_span(), expected.as_span());
+}
+
+template<typename T> static void test_radix_sort_indices(const int64_t size)
+{
+  Array<T> keys = random_values<T>(size, uint32_t(size));
+  /* Add duplicate keys to check that the sort is stable. */
+  for (int64_t i = 1; i < size; i += 3) {
+    keys[i] = keys[i - 1];
+  }
+  Array<int> indices(size);
+  array_utils::fill_index_range<int>(indices);
+  Array<int> expected = indices;
+  std::stable_sort(expected.begin(), expected.end(), [&](const int a, const int b) {
+    return keys[a] < keys[b];
+  });
+  radix_sort_indices<T>(keys, indices);
+  EXPECT_EQ(indices.as_span(), expected.as_span());
+}
+
+TEST(radix_sort, Values)
+{
+  for (const int64_t size : {0, 1, 100, 1000, 100000}) {
+    test_radix_sort<int32_t>(size);
+    test_radix_sort<uint32_t>(size);
+    test_radix_sort<int64_t>(size);
+    test_radix_sort<uint64_t>(size);
+    test_radix_sort<float>(size);
+    test_radix_sort<double>(size);
+  }
+}
+
+TEST(radix_sort, Indices)
+{
+  for (const int64_t size : {0, 1, 100, 1000, 100000}) {
+    test_radix_sort_indices<int32_t>(size);
+    test_radix_sort_indices<uint32_t>(size);
+    test_radix_sort_indices<int64_t>(size);
+    test_radix_sort_indices<uint64_t>(size);
+    test_radix_sort_indices<float>(size);
+    test_radix_sort_indices<double>(size);
+  }
+}
+
+TEST(radix_sort, FloatSpecialValues)
+{
+  Array<float> values(1000);
+  for (const int i : values.index_range()) {
+    values[i] = float(i % 7) - 3.0f;
+  }
+  values[10] = std::numeric_limits<float>::infinity();
+  values[20] = -std::numeric_limits<float>::infinity();
+  values[30] = std::numeric_limits<float>::denorm_min();
+  values[40] = -std::numeric_limits<float>::denorm_min();
+  Array<float> expected = values;
+  std::sort(expected.begin(), expected.end());
+  radix_sort<float>(values);
+  EXPECT_EQ(values.as_span(), expected.as_span());
+}
+
+TEST(radix_sort, IndicesSignedZero)
+{
+  /* Negative and positive zero are equal, so their order must not change. */
+  Array<float> keys(1000);
+  for (const int i : keys.index_range()) {
+    keys[i] = (i % 2) ? 0.0f : -0.0f;
+  }
+  Array<int> indices(keys.size());
+  array_utils::fill_index_range<int>(indices);
+  radix_sort_indices<float>(keys, indices);
+  for (const int i : indices.index_range()) {
+    EXPECT_EQ(indices[i], i);
+  }
+}
+
+TEST(radix_sort, IndicesSubset)
+{
+  const Array<int> keys = random_values<int>(1000, 0);
+  Array<int> indices(300);
+  for (const int i : indices.index_range()) {
+    indices[i] = i * 3;
+  }
+  radix_sort_indices<int>(keys, indices);
+  for (const int i : indices.index_range().drop_back(1)) {
+    EXPECT_LE(keys[indices[i]], keys[indices[i + 1]]);
+    EXPECT_EQ(indices[i] % 3, 0);
+  }
+}
+
+}  // namespace blender::tests
@@ -0,0 +1,180 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <string>
+
+#include "BLI_array.hh"
+#include "BLI_kdopbvh.hh"
+#include "BLI_math_geom.h"
+#include "BLI_math_vector.hh"
+#include "BLI_rand.hh"
+#include "BLI_task.hh"
+#include "BLI_timeit.hh"
+
+using namespace blender;
+
+/* Run the longest tests! */
+// #define USE_BIG_TESTS
+
+#ifdef USE_BIG_TESTS
+static constexpr int GRID_SIZE = 2237; /* About 10M triangles. */
+#else
+static constexpr int GRID_SIZE = 708; /* About 1M triangles. */
+#endif
+static constexpr int QUERIES_NUM = 200000;
+
+struct TestMesh {
+  Array<float3> positions;
+  Array<int3> tris;
+};
+
+/** A wavy height-field, so that the triangles don't all lie in one plane. */
+static TestMesh grid_mesh_create(const int size)
+{
+  TestMesh mesh;
+  mesh.positions.reinitialize(size * size);
+  mesh.tris.reinitialize((size - 1) * (size - 1) * 2);
+  threading::parallel_for(IndexRange(size), 64, [&](const IndexRange range) {
+    for (const int y : range) {
+      for (const int x : IndexRange(size)) {
+        const float u = float(x) / float(size - 1);
+        const float v = float(y) / float(size - 1);
+        mesh.positions[y * size + x] = float3(
+            u, v, 0.05f * std::sin(u * 40.0f) * std::cos(v * 30.0f));
+      }
+    }
+  });
+  threading::parallel_for(IndexRange(size - 1), 64, [&](const IndexRange range) {
+    for (const int y : range) {
+      for (const int x : IndexRange(size - 1)) {
+        const int v0 = y * size + x;
+        const int tri = (y * (size - 1) + x) * 2;
+        mesh.tris[tri] = int3(v0, v0 + 1, v0 + size);
+        mesh.tris[tri + 1] = int3(v0 + 1, v0 + size + 1, v0 + size);
+      }
+    }
+  });
+  return mesh;
+}
+
+static std::string timer_name(const char *name, const int width)
+{
+  return width == 0 ? std::string(name) : std::string(name) + "_wide" + std::to_string(width);
+}
+
+/** Create a tree of the mesh triangles, with a wide layout of the given width if not zero. */
+static BVHTree *mesh_tree_create(const TestMesh &mesh, const int width)
+{
+  SCOPED_TIMER(timer_name("build", width));
+  BVHTree *tree = BLI_bvhtree_new(int(mesh.tris.size()), 0.0f, 2, 6);
+  for (const int tri : mesh.tris.index_range()) {
+    float co[3][3];
+    copy_v3_v3(co[0], mesh.positions[mesh.tris[tri][0]]);
+    copy_v3_v3(co[1], mesh.positions[mesh.tris[tri][1]]);
+    copy_v3_v3(co[2], mesh.positions[mesh.tris[tri][2]]);
+    BLI_bvhtree_insert(tree, tri, co[0], 3);
+  }
+  BLI_bvhtree_balance(tree);
+  if (width != 0 && !BLI_bvhtree_build_wide(tree, width)) {
+    printf("Wide layout with width %d is not supported\n", width);
+  }
+  return tree;
+}
+
+static void mesh_ray_cast_cb(void *userdata,
+                             int index,
+                             const BVHTreeRay *ray,
+                             BVHTreeRayHit *hit)
+{
+  const TestMesh &mesh = *static_cast<const TestMesh *>(userdata);
+  const int3 &tri = mesh.tris[index];
+  float dist;
+  if (isect_ray_tri_v3(ray->origin,
+                       ray->direction,
+                       mesh.positions[tri[0]],
+                       mesh.positions[tri[1]],
+                       mesh.positions[tri[2]],
+                       &dist,
+                       nullptr) &&
+      dist < hit->dist)
+  {
+    hit->index = index;
+    hit->dist = dist;
+  }
+}
+
+static void mesh_nearest_cb(void *userdata, int index, const float co[3], BVHTreeNearest *nearest)
+{
+  const TestMesh &mesh = *static_cast<const TestMesh *>(userdata);
+  const int3 &tri = mesh.tris[index];
+  float3 closest;
+  closest_on_tri_to_point_v3(
+      closest, co, mesh.positions[tri[0]], mesh.positions[tri[1]], mesh.positions[tri[2]]);
+  const float dist_sq = math::distance_squared(closest, float3(co));
+  if (dist_sq < nearest->dist_sq) {
+    nearest->index = index;
+    nearest->dist_sq = dist_sq;
+    copy_v3_v3(nearest->co, closest);
+  }
+}
+
+static void queries_benchmark(const TestMesh &mesh, const BVHTree *tree, const int width)
+{
+  RandomNumberGenerator rng(0);
+  Array<float3> origins(QUERIES_NUM);
+  Array<float3> directions(QUERIES_NUM);
+  Array<float3> positions(QUERIES_NUM);
+  for (const int i : IndexRange(QUERIES_NUM)) {
+    origins[i] = float3(rng.get_float(), rng.get_float(), 1.0f);
+    directions[i] = math::normalize(
+        float3(rng.get_float() - 0.5f, rng.get_float() - 0.5f, -1.0f));
+    positions[i] = float3(rng.get_float(), rng.get_float(), rng.get_float() * 0.2f - 0.1f);
+  }
+
+  Array<BVHTreeRayHit> hits(QUERIES_NUM);
+  for (BVHTreeRayHit &hit : hits) {
+    hit.index = -1;
+    hit.dist = BVH_RAYCAST_DIST_MAX;
+  }
+  {
+    SCOPED_TIMER(timer_name("ray_cast", width));
+    BLI_bvhtree_ray_cast_batch(*tree,
+                               origins,
+                               directions,
+                               0.0f,
+                               hits,
+                               mesh_ray_cast_cb,
+                               const_cast<TestMesh *>(&mesh));
+  }
+
+  Array<BVHTreeNearest> nearest(QUERIES_NUM);
+  for (BVHTreeNearest &item : nearest) {
+    item.index = -1;
+    item.dist_sq = FLT_MAX;
+  }
+  {
+    SCOPED_TIMER(timer_name("find_nearest", width));
+    BLI_bvhtree_find_nearest_batch(
+        *tree, positions, nearest, mesh_nearest_cb, const_cast<TestMesh *>(&mesh));
+  }
+
+  int hits_num = 0;
+  for (const BVHTreeRayHit &hit : hits) {
+    hits_num += hit.index != -1;
+  }
+  printf("%d of %d rays hit\n", hits_num, QUERIES_NUM);
+}
+
+TEST(kdopbvh, MeshQueries)
+{
+  const TestMesh mesh = grid_mesh_create(GRID_SIZE);
+  printf("%d triangles\n", int(mesh.tris.size()));
+  for (const int width : {0, 4, 8}) {
+    BVHTree *tree = mesh_tree_create(mesh, width);
+    queries_benchmark(mesh, tree, width);
+    BLI_bvhtree_free(tree);
+  }
+}
@@ -9,6 +9,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_fileops.h"
 #include "BLI_ghash.h"
 #include "BLI_map.hh"
@@ -756,3 +757,77 @@ TEST(ghash, MultiRandIntMurmur2a200000)
 
   multi_small_ghash_tests(ghash, "MultiSmall RandIntGHash - Murmur2a - 200000", 200000);
 }
+
+/* Group probing: compare the default layout with #GroupProbingStrategy for large hash tables. */
+
+#ifdef USE_BIG_TESTS
+static constexpr int GROUP_PROBING_KEYS_NUM = 20000000;
+#else
+static constexpr int GROUP_PROBING_KEYS_NUM = 2000000;
+#endif
+
+template<typename MapT, typename Key>
+static void map_benchmark(const char *name, const Span<Key> keys, const Span<Key> missing_keys)
+{
+  printf("\n========== STARTING %s ==========\n", name);
+  MapT map;
+  {
+    SCOPED_TIMER("add");
+    for (const int64_t i : keys.index_range()) {
+      map.add(keys[i], int(i));
+    }
+  }
+  int64_t found = 0;
+  {
+    SCOPED_TIMER("lookup_hit");
+    for (const Key &key : keys) {
+      found += map.contains(key);
+    }
+  }
+  {
+    SCOPED_TIMER("lookup_miss");
+    for (const Key &key : missing_keys) {
+      found += map.contains(key);
+    }
+  }
+  {
+    SCOPED_TIMER("remove");
+    for (const Key &key : keys) {
+      found += map.remove(key);
+    }
+  }
+  printf("%lld\n", (long long)found);
+  printf("========== ENDED %s ==========\n\n", name);
+}
+
+template<typename Key, typename KeyFn> static void group_probing_benchmark(const KeyFn &key_fn)
+{
+  RNG *rng = BLI_rng_new(0);
+  Array<Key> keys(GROUP_PROBING_KEYS_NUM);
+  Array<Key> missing_keys(GROUP_PROBING_KEYS_NUM);
+  for (const int64_t i : keys.index_range()) {
+    keys[i] = key_fn(int(BLI_rng_get_uint(rng) >> 1));
+    missing_keys[i] = key_fn(-int(BLI_rng_get_uint(rng) >> 1) - 1);
+  }
+  BLI_rng_free(rng);
+
+  map_benchmark<Map<Key, int>>("Map - Default", keys.as_span(), missing_keys.as_span());
+  map_benchmark<Map<Key, int, 4, GroupProbingStrategy>>(
+      "Map - GroupProbing", keys.as_span(), missing_keys.as_span());
+}
+
+TEST(map, GroupProbingInt)
+{
+  group_probing_benchmark<int>([](const int value) { return value; });
+}
+
+TEST(map, GroupProbingInt2)
+{
+  /* Similar to the edge hash in mesh edge calculation. */
+  group_probing_benchmark<int2>([](const int value) { return int2(value, value / 3 + 1); });
+}
+
+TEST(map, GroupProbingString)
+{
+  group_probing_benchmark<std::string>([](const int value) { return std::to_string(value); });
+}
@@ -0,0 +1,82 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_math_matrix.hh"
+#include "BLI_math_rotation.hh"
+#include "BLI_rand.hh"
+#include "BLI_task.hh"
+#include "BLI_timeit.hh"
+
+using namespace blender;
+
+static constexpr int64_t VALUES_NUM = 50000000;
+
+static Array<float3> random_vectors(const int64_t size)
+{
+  RandomNumberGenerator rng(0);
+  Array<float3> values(size);
+  for (float3 &value : values) {
+    value = rng.get_unit_float3() * rng.get_float();
+  }
+  return values;
+}
+
+TEST(math_matrix_batch_performance, transform_points)
+{
+  const Array<float3> src = random_vectors(VALUES_NUM);
+  Array<float3> dst(VALUES_NUM, float3(0.0f));
+  const float4x4 transform = math::from_loc_rot_scale<float4x4>(
+      float3(1.0f, 2.0f, 3.0f), math::EulerXYZ(0.1f, 0.2f, 0.3f), float3(0.5f));
+  {
+    SCOPED_TIMER("transform_point_loop");
+    threading::parallel_for(src.index_range(), 1024, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        dst[i] = math::transform_point(transform, src[i]);
+      }
+    });
+  }
+  {
+    SCOPED_TIMER("transform_points");
+    math::transform_points(src, transform, dst);
+  }
+  {
+    SCOPED_TIMER("transform_points_single_thread");
+    math::transform_points(src, transform, dst, false);
+  }
+}
+
+TEST(math_matrix_batch_performance, transform_normals)
+{
+  const Array<float3> src = random_vectors(VALUES_NUM);
+  Array<float3> dst(VALUES_NUM, float3(0.0f));
+  const float3x3 transform = math::from_rotation<float3x3>(
+      math::to_quaternion(math::EulerXYZ(0.1f, 0.2f, 0.3f)));
+  {
+    SCOPED_TIMER("transform_direction_loop");
+    threading::parallel_for(src.index_range(), 1024, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        dst[i] = math::transform_direction(transform, src[i]);
+      }
+    });
+  }
+  {
+    SCOPED_TIMER("transform_directions");
+    math::transform_directions(src, transform, dst);
+  }
+  {
+    SCOPED_TIMER("normalize_loop");
+    threading::parallel_for(src.index_range(), 1024, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        dst[i] = math::normalize(transform * src[i]);
+      }
+    });
+  }
+  {
+    SCOPED_TIMER("transform_normals");
+    math::transform_normals(src, transform, dst);
+  }
+}
@@ -0,0 +1,106 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <mutex>
+
+#include "BLI_array.hh"
+#include "BLI_mempool.h"
+#include "BLI_mempool_threadsafe.hh"
+#include "BLI_task.hh"
+#include "BLI_timeit.hh"
+
+using namespace blender;
+
+/* Roughly the size of a #BMVert. */
+struct TestElem {
+  void *next;
+  float data[14];
+};
+
+static constexpr int64_t ELEMS_NUM = 4000000;
+static constexpr int ROUNDS_NUM = 4;
+
+/**
+ * Allocate and free elements from many threads at once, similar to parallel topology changes in
+ * BMesh. Half of the elements are freed again and allocated again to exercise the free lists.
+ */
+template<typename AllocFn, typename FreeFn>
+static void run_alloc_free(const AllocFn &alloc_fn, const FreeFn &free_fn)
+{
+  Array<TestElem *> elems(ELEMS_NUM);
+  for ([[maybe_unused]] const int round : IndexRange(ROUNDS_NUM)) {
+    threading::parallel_for(elems.index_range(), 4096, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        elems[i] = static_cast<TestElem *>(alloc_fn());
+      }
+    });
+    threading::parallel_for(elems.index_range(), 4096, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        if (i % 2 == 0) {
+          free_fn(elems[i]);
+          elems[i] = static_cast<TestElem *>(alloc_fn());
+        }
+      }
+    });
+    threading::parallel_for(elems.index_range(), 4096, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        free_fn(elems[i]);
+      }
+    });
+  }
+}
+
+TEST(mempool, ThreadedLocked)
+{
+  BLI_mempool *pool = BLI_mempool_create(sizeof(TestElem), 0, 512, BLI_MEMPOOL_NOP);
+  std::mutex mutex;
+  {
+    SCOPED_TIMER("threaded_locked");
+    run_alloc_free(
+        [&]() {
+          std::lock_guard lock{mutex};
+          return BLI_mempool_alloc(pool);
+        },
+        [&](void *elem) {
+          std::lock_guard lock{mutex};
+          BLI_mempool_free(pool, elem);
+        });
+  }
+  BLI_mempool_destroy(pool);
+}
+
+TEST(mempool, ThreadedLocalCache)
+{
+  ThreadSafeMempool pool(sizeof(TestElem), 0, 512, BLI_MEMPOOL_NOP);
+  {
+    SCOPED_TIMER("threaded_local_cache");
+    run_alloc_free([&]() { return pool.alloc(); }, [&](void *elem) { pool.free(elem); });
+  }
+}
+
+TEST(mempool, SingleThreaded)
+{
+  BLI_mempool *pool = BLI_mempool_create(sizeof(TestElem), 0, 512, BLI_MEMPOOL_NOP);
+  {
+    SCOPED_TIMER("single_threaded");
+    Array<TestElem *> elems(ELEMS_NUM);
+    for ([[maybe_unused]] const int round : IndexRange(ROUNDS_NUM)) {
+      for (const int64_t i : elems.index_range()) {
+        elems[i] = static_cast<TestElem *>(BLI_mempool_alloc(pool));
+      }
+      for (const int64_t i : elems.index_range()) {
+        if (i % 2 == 0) {
+          BLI_mempool_free(pool, elems[i]);
+          elems[i] = static_cast<TestElem *>(BLI_mempool_alloc(pool));
+        }
+      }
+      for (const int64_t i : elems.index_range()) {
+        BLI_mempool_free(pool, elems[i]);
+      }
+    }
+  }
+  BLI_mempool_destroy(pool);
+}
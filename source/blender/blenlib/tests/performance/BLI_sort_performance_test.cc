@@ -0,0 +1,88 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_array.hh"
+#include "BLI_array_utils.hh"
+#include "BLI_rand.hh"
+#include "BLI_sort.hh"
+#include "BLI_timeit.hh"
+
+using namespace blender;
+
+static constexpr int64_t VALUES_NUM = 10000000;
+
+template<typename T> static Array<T> random_values(const int64_t size)
+{
+  RandomNumberGenerator rng(0);
+  Array<T> values(size);
+  for (T &value : values) {
+    if constexpr (std::is_floating_point_v<T>) {
+      value = T(rng.get_float());
+    }
+    else {
+      value = T(rng.get_uint64());
+    }
+  }
+  return values;
+}
+
+template<typename T> static void sort_values_benchmark(const char *name)
+{
+  const Array<T> values = random_values<T>(VALUES_NUM);
+  {
+    Array<T> values_copy = values;
+    SCOPED_TIMER(std::string(name) + "_parallel_sort");
+    parallel_sort(values_copy.begin(), values_copy.end());
+  }
+  {
+    Array<T> values_copy = values;
+    SCOPED_TIMER(std::string(name) + "_radix_sort");
+    radix_sort<T>(values_copy);
+  }
+}
+
+template<typename T> static void sort_indices_benchmark(const char *name)
+{
+  const Array<T> keys = random_values<T>(VALUES_NUM);
+  Array<int> indices(VALUES_NUM);
+  {
+    array_utils::fill_index_range<int>(indices);
+    SCOPED_TIMER(std::string(name) + "_parallel_sort_indices");
+    parallel_sort(indices.begin(), indices.end(), [&](const int a, const int b) {
+      return keys[a] < keys[b] || (keys[a] == keys[b] && a < b);
+    });
+  }
+  {
+    array_utils::fill_index_range<int>(indices);
+    SCOPED_TIMER(std::string(name) + "_radix_sort_indices");
+    radix_sort_indices<T>(keys, indices);
+  }
+}
+
+TEST(sort, Int32)
+{
+  sort_values_benchmark<int32_t>("int32");
+}
+
+TEST(sort, Int64)
+{
+  sort_values_benchmark<int64_t>("int64");
+}
+
+TEST(sort, Float)
+{
+  sort_values_benchmark<float>("float");
+}
+
+TEST(sort, Int32Indices)
+{
+  sort_indices_benchmark<int32_t>("int32");
+}
+
+TEST(sort, FloatIndices)
+{
+  sort_indices_benchmark<float>("float");
+}
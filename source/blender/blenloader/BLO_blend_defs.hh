@@ -8,6 +8,8 @@
  * \brief defines for blend-file codes.
  */
 
+#include <cstdint>
+
 /* INTEGER CODES */
 #ifdef __BIG_ENDIAN__
 /* Big Endian */
@@ -52,6 +54,11 @@ enum {
    * (written to #BLENDER_STARTUP_FILE & #BLENDER_USERPREF_FILE).
    */
   BLO_CODE_USER = BLEND_MAKE_ID('U', 'S', 'E', 'R'),
+  /**
+   * Optional index of the local ID blocks in the file, see #BLOIDIndexHeader.
+   * Written right before #BLO_CODE_ENDB.
+   */
+  BLO_CODE_INDX = BLEND_MAKE_ID('I', 'N', 'D', 'X'),
   /**
    * Terminate reading (no data).
    */
@@ -59,3 +66,58 @@ enum {
 };
 
 #define BLEN_THUMB_MEMSIZE_FILE(_x, _y) (sizeof(int) * (2 + (size_t)(_x) * (size_t)(_y)))
+
+/* -------------------------------------------------------------------- */
+/** \name ID Index
+ *
+ * The data of the #BLO_CODE_INDX block allows finding ID blocks without parsing every #BHead of
+ * the file. It is stored in the byte order of the file and laid out as:
+ * - #BLOIDIndexHeader
+ * - #BLOIDIndexEntry array (`entries_num` items, in file order).
+ * - Null terminated full ID names (including the ID code prefix), `names_size` bytes.
+ * - #BLOIDIndexFooter
+ *
+ * The footer is at a fixed offset from the end of the file (right before the #BLO_CODE_ENDB
+ * #BHead), so readers of seekable files can find the index without reading anything else, and
+ * from there the #BLO_CODE_DNA1 block and the blocks of the IDs they need.
+ * \{ */
+
+#define BLO_ID_INDEX_VERSION 1
+#define BLO_ID_INDEX_MAGIC BLEND_MAKE_ID('B', 'I', 'D', 'X')
+
+enum {
+  /** The ID has asset meta-data. */
+  BLO_ID_INDEX_IS_ASSET = 1 << 0,
+};
+
+struct BLOIDIndexHeader {
+  uint32_t version;
+  uint32_t entries_num;
+  uint32_t names_size;
+  uint32_t _pad;
+  /** Offset of the #BLO_CODE_DNA1 #BHead in the (uncompressed) file. */
+  uint64_t dna_offset;
+};
+
+struct BLOIDIndexEntry {
+  /** Offset of the ID #BHead in the (uncompressed) file. */
+  uint64_t bhead_offset;
+  /** Old address of the ID (same as #BHead.old of the ID block). */
+  uint64_t old;
+  /** The ID code (same as #BHead.code of the ID block). */
+  int32_t code;
+  /** #BLO_ID_INDEX_IS_ASSET. */
+  uint32_t flag;
+  /** Offset of the full ID name in the names section. */
+  uint32_t name_offset;
+  uint32_t _pad;
+};
+
+struct BLOIDIndexFooter {
+  /** Size of the whole #BLO_CODE_INDX block data, including this footer. */
+  uint64_t data_size;
+  int32_t magic;
+  uint32_t version;
+};
+
+/** \} */
@@ -0,0 +1,215 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup blenloader
+ * Timing of the phases of reading and writing blend files.
+ *
+ * Enabled with `--debug-io-profile` (#G_DEBUG_IO_PROFILE). Only the top level file read or write
+ * is profiled (see #BLO_io_profile_begin), phases of linked libraries are accumulated into the
+ * ones of the file that is being read. Phases can be nested, e.g. the time spent in
+ * `Read & Decompress` is also part of the `Read Data` phase of an ID type.
+ *
+ * The results of the last profiled file are kept until the next one starts, so that they can be
+ * inspected from Python (`bpy.app.io_profile()`).
+ *
+ * The files and the phases measured with #BLOIOProfileScope are also recorded as events in the
+ * `io` category of the Chrome trace (see #BLI_profile_trace.hh), independent of this profile.
+ */
+
+#include <cstdint>
+#include <string>
+
+#include "BLI_profile_trace.hh"
+#include "BLI_time.h"
+#include "BLI_vector.hh"
+
+struct BLOIOProfilePhase {
+  std::string name;
+  /** Accumulated time in seconds. */
+  double duration;
+  /** Accumulated amount of processed data, zero for phases where it isn't meaningful. */
+  int64_t bytes;
+  /** Number of times the phase was entered. */
+  int64_t calls;
+};
+
+/** True while a file read or write is being profiled. */
+bool BLO_io_profile_is_active();
+
+/**
+ * Start profiling the read or write of a file, clearing the previous results.
+ * Does nothing when profiling is disabled or another file is already profiled.
+ *
+ * \return True when profiling was started, #BLO_io_profile_end must be called then.
+ */
+bool BLO_io_profile_begin(const char *filepath, bool is_write);
+/**
+ * Stop profiling the current file and print the results.
+ */
+void BLO_io_profile_end();
+
+/**
+ * Add time and data to a phase, \a subname is optional (e.g. the ID type).
+ * Thread-safe, but meant to be called for whole phases rather than for individual items, use
+ * #BLOIOProfileCounter for those.
+ */
+void BLO_io_profile_add(
+    const char *name, const char *subname, double duration, int64_t bytes, int64_t calls = 1);
+
+/**
+ * Record a trace event for a phase that started at \a start and ends now, \a subname is optional.
+ * Only called while the Chrome trace is recorded.
+ */
+void BLO_io_profile_trace_event(const char *name,
+                                const char *subname,
+                                blender::profile_trace::TimePoint start);
+
+/** Phases of the last profiled file, in the order they were first entered. */
+blender::Vector<BLOIOProfilePhase> BLO_io_profile_phases();
+/** File path of the last profiled file. */
+std::string BLO_io_profile_filepath();
+/** Whether the last profiled file was written (or read). */
+bool BLO_io_profile_is_write();
+
+/**
+ * Profile the read or write of a file until the end of the current scope. When a file is already
+ * profiled (e.g. by a caller that also wants to include setting up the read data), this does
+ * nothing and the phases are added to that profile.
+ */
+class BLOIOProfileFileScope {
+  bool is_started_;
+  bool is_write_;
+  bool is_traced_ = false;
+  blender::profile_trace::TimePoint trace_start_;
+
+ public:
+  BLOIOProfileFileScope(const char *filepath, bool is_write);
+  ~BLOIOProfileFileScope();
+
+  BLOIOProfileFileScope(const BLOIOProfileFileScope &other) = delete;
+  BLOIOProfileFileScope &operator=(const BLOIOProfileFileScope &other) = delete;
+};
+
+/**
+ * Record the time spent in the current scope for a phase, when profiling is active.
+ */
+class BLOIOProfileScope {
+  const char *name_;
+  const char *subname_;
+  bool is_active_;
+  double start_;
+  int64_t bytes_ = 0;
+  bool is_traced_ = false;
+  blender::profile_trace::TimePoint trace_start_;
+
+ public:
+  BLOIOProfileScope(const char *name, const char *subname = nullptr)
+      : name_(name), subname_(subname), is_active_(name && BLO_io_profile_is_active())
+  {
+    start_ = is_active_ ? BLI_time_now_seconds() : 0.0;
+#ifdef WITH_PROFILE_TRACE
+    if (name && blender::profile_trace::is_recording()) {
+      is_traced_ = true;
+      trace_start_ = blender::profile_trace::Clock::now();
+    }
+#endif
+  }
+
+  ~BLOIOProfileScope()
+  {
+    this->finish();
+  }
+
+  BLOIOProfileScope(const BLOIOProfileScope &other) = delete;
+  BLOIOProfileScope &operator=(const BLOIOProfileScope &other) = delete;
+
+  void add_bytes(const int64_t bytes)
+  {
+    bytes_ += bytes;
+  }
+
+  /** Record the phase before the end of the scope. */
+  void finish()
+  {
+    if (is_active_) {
+      BLO_io_profile_add(name_, subname_, BLI_time_now_seconds() - start_, bytes_);
+      is_active_ = false;
+    }
+    if (is_traced_) {
+      BLO_io_profile_trace_event(name_, subname_, trace_start_);
+      is_traced_ = false;
+    }
+  }
+};
+
+/**
+ * Accumulates a phase that is entered very often, e.g. for every block, and adds it to the profile
+ * only once when it is flushed or destructed. Not thread-safe, the owner of the counter must make
+ * sure that it's only used by one thread at a time.
+ */
+class BLOIOProfileCounter {
+  const char *name_;
+  double duration_ = 0.0;
+  int64_t bytes_ = 0;
+  int64_t calls_ = 0;
+
+ public:
+  /** Add the time spent in the current scope to a counter, when profiling is active. */
+  class Scope {
+    BLOIOProfileCounter *counter_;
+    double start_;
+    int64_t bytes_ = 0;
+
+   public:
+    Scope(BLOIOProfileCounter &counter)
+        : counter_(BLO_io_profile_is_active() ? &counter : nullptr),
+          start_(counter_ ? BLI_time_now_seconds() : 0.0)
+    {
+    }
+
+    ~Scope()
+    {
+      if (counter_) {
+        counter_->duration_ += BLI_time_now_seconds() - start_;
+        counter_->bytes_ += bytes_;
+        counter_->calls_++;
+      }
+    }
+
+    Scope(const Scope &other) = delete;
+    Scope &operator=(const Scope &other) = delete;
+
+    void add_bytes(const int64_t bytes)
+    {
+      bytes_ += bytes;
+    }
+  };
+
+  BLOIOProfileCounter(const char *name) : name_(name) {}
+
+  ~BLOIOProfileCounter()
+  {
+    this->flush();
+  }
+
+  BLOIOProfileCounter(const BLOIOProfileCounter &other) = delete;
+  BLOIOProfileCounter &operator=(const BLOIOProfileCounter &other) = delete;
+
+  /** Add the accumulated phase to the profile and reset the counter. */
+  void flush()
+  {
+    if (calls_ == 0) {
+      return;
+    }
+    if (BLO_io_profile_is_active()) {
+      BLO_io_profile_add(name_, nullptr, duration_, bytes_, calls_);
+    }
+    duration_ = 0.0;
+    bytes_ = 0;
+    calls_ = 0;
+  }
+};
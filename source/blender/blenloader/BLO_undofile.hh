@@ -12,6 +12,7 @@
 #include "BLI_filereader.h"
 #include "BLI_listbase.h"
 #include "BLI_map.hh"
+#include "BLI_span.hh"
 
 namespace blender {
 class ImplicitSharingInfo;
@@ -28,12 +29,42 @@ struct MemFileSharedStorage {
   ~MemFileSharedStorage();
 };
 
+/**
+ * Compressed data of a #MemFileChunk, see #BLO_memfile_compress.
+ */
+struct MemFileChunkPacked {
+  /** Zstd compressed chunk data, null when it has been moved to the temporary spill file. */
+  void *data;
+  /** Size of the compressed data in bytes. */
+  size_t data_size;
+  /** Offset of the compressed data in the spill file, only used when #data is null. */
+  int64_t file_offset;
+};
+
+/**
+ * Data of a #MemFileChunk. Chunks with the same content anywhere in the undo history share it,
+ * they are found by content hash in a global chunk store and are reference counted.
+ */
+struct MemFileChunkData {
+  /** Uncompressed data, null when the data is packed. */
+  const char *buf;
+  /** Compressed data, only set when #buf is null. */
+  MemFileChunkPacked *packed;
+  /** Size in bytes of the uncompressed data. */
+  size_t size;
+  /** Hash of the uncompressed data. */
+  uint64_t hash;
+  /** Number of #MemFileChunk using the data. */
+  int users;
+};
+
 struct MemFileChunk {
   void *next, *prev;
-  const char *buf;
+  MemFileChunkData *data;
   /** Size in bytes. */
   size_t size;
-  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
+  /** When true, this chunk is identical to the matching one in the previous step (used by undo
+   * code to detect unchanged IDs). */
   bool is_identical;
   /** When true, this chunk is also identical to the one in the next step (used by undo code to
    * detect unchanged IDs).
@@ -46,6 +77,7 @@ struct MemFileChunk {
 
 struct MemFile {
   ListBase chunks;
+  /** Size of the chunk data that was not already stored by previous steps. */
   size_t size;
   /**
    * Some data is not serialized into a new buffer because the undo-step can take ownership of it
@@ -79,6 +111,11 @@ struct UndoReader {
   int undo_direction;
 
   bool memchunk_identical;
+
+  /** Decompressed data of #unpacked_chunk, when reading packed chunks. */
+  char *unpacked_buf;
+  size_t unpacked_buf_size;
+  const MemFileChunk *unpacked_chunk;
 };
 
 /* Actually only used `writefile.cc`. */
@@ -108,6 +145,26 @@ void BLO_memfile_merge(MemFile *first, MemFile *second);
  */
 void BLO_memfile_clear_future(MemFile *memfile);
 
+/**
+ * Compress the chunks of older undo steps in the background, to reduce the memory usage of a
+ * long undo history. Shared chunk data is compressed once for all steps using it.
+ *
+ * \param memfiles: All memfiles of the undo stack, ordered from oldest to newest.
+ * \param keep_memfiles: Memfiles that are kept uncompressed, typically the active and the last
+ * step, which are read or compared against when writing the next step. Their packed chunks are
+ * decompressed again.
+ * \param memory_budget: Compressed data exceeding this amount of bytes is moved to a temporary
+ * file, starting with the data only used by the oldest steps. Zero keeps everything in memory.
+ */
+void BLO_memfile_compress(blender::Span<MemFile *> memfiles,
+                          blender::Span<const MemFile *> keep_memfiles,
+                          size_t memory_budget);
+/**
+ * Wait until the background compression started by #BLO_memfile_compress is done.
+ * All other memfile functions do this before accessing chunks.
+ */
+void BLO_memfile_compress_wait();
+
 /* Utilities. */
 
 Main *BLO_memfile_main_get(MemFile *memfile, Main *bmain, Scene **r_scene);
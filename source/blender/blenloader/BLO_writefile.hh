@@ -42,6 +42,11 @@ struct BlendFileWriteParams {
   /** On write, restore paths after editing them (see #BLO_WRITE_PATH_REMAP_RELATIVE). */
   uint use_save_as_copy : 1;
   uint use_userdef : 1;
+  /**
+   * Copy compressed data that didn't change from the existing file at the destination, instead of
+   * compressing it again. Only used for compressed files.
+   */
+  uint use_delta : 1;
   const BlendThumbnail *thumb;
 };
 
@@ -0,0 +1,176 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup blenloader
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+#include "BLI_map.hh"
+
+#include "BKE_global.hh"
+
+#include "BLO_io_profile.hh"
+
+namespace {
+
+struct IOProfile {
+  std::mutex mutex;
+  std::string filepath;
+  bool is_write = false;
+  blender::Vector<BLOIOProfilePhase> phases;
+  blender::Map<std::string, int64_t> phase_index_by_name;
+  double start = 0.0;
+};
+
+}  // namespace
+
+static std::atomic<bool> io_profile_active = false;
+/** Only the outermost file scope of a thread is traced, see #BLOIOProfileFileScope. */
+static thread_local bool io_profile_file_traced = false;
+
+static IOProfile &io_profile_get()
+{
+  static IOProfile profile;
+  return profile;
+}
+
+bool BLO_io_profile_is_active()
+{
+  return io_profile_active.load(std::memory_order_relaxed);
+}
+
+bool BLO_io_profile_begin(const char *filepath, const bool is_write)
+{
+  if ((G.debug & G_DEBUG_IO_PROFILE) == 0) {
+    return false;
+  }
+  /* Claim the profile before touching it, files may be read on several threads at once. */
+  bool expected = false;
+  if (!io_profile_active.compare_exchange_strong(expected, true)) {
+    return false;
+  }
+  IOProfile &profile = io_profile_get();
+  {
+    std::lock_guard lock{profile.mutex};
+    profile.filepath = filepath;
+    profile.is_write = is_write;
+    profile.phases.clear();
+    profile.phase_index_by_name.clear();
+    profile.start = BLI_time_now_seconds();
+  }
+  return true;
+}
+
+void BLO_io_profile_end()
+{
+  if (!BLO_io_profile_is_active()) {
+    return;
+  }
+  io_profile_active.store(false);
+
+  IOProfile &profile = io_profile_get();
+  std::lock_guard lock{profile.mutex};
+  const double duration = BLI_time_now_seconds() - profile.start;
+
+  printf("%s profile: \"%s\" (%.3f s)\n",
+         profile.is_write ? "Write blend" : "Read blend",
+         profile.filepath.c_str(),
+         duration);
+  for (const BLOIOProfilePhase &phase : profile.phases) {
+    printf("  %-48s %10.3f ms %8.1f%% %8lld calls",
+           phase.name.c_str(),
+           phase.duration * 1000.0,
+           duration > 0.0 ? phase.duration / duration * 100.0 : 0.0,
+           (long long)phase.calls);
+    if (phase.bytes > 0) {
+      printf(" %10.2f MB %8.1f MB/s",
+             double(phase.bytes) / (1024.0 * 1024.0),
+             phase.duration > 0.0 ? double(phase.bytes) / (1024.0 * 1024.0) / phase.duration :
+                                    0.0);
+    }
+    printf("\n");
+  }
+}
+
+void BLO_io_profile_add(const char *name,
+                        const char *subname,
+                        const double duration,
+                        const int64_t bytes,
+                        const int64_t calls)
+{
+  std::string full_name = subname ? std::string(name) + ": " + subname : std::string(name);
+
+  IOProfile &profile = io_profile_get();
+  std::lock_guard lock{profile.mutex};
+  const int64_t index = profile.phase_index_by_name.lookup_or_add_cb(full_name, [&]() {
+    profile.phases.append({full_name, 0.0, 0, 0});
+    return profile.phases.size() - 1;
+  });
+  BLOIOProfilePhase &phase = profile.phases[index];
+  phase.duration += duration;
+  phase.bytes += bytes;
+  phase.calls += calls;
+}
+
+void BLO_io_profile_trace_event(const char *name,
+                                const char *subname,
+                                const blender::profile_trace::TimePoint start)
+{
+  const blender::profile_trace::TimePoint end = blender::profile_trace::Clock::now();
+  if (subname) {
+    blender::profile_trace::record_event("io", std::string(name) + ": " + subname, start, end);
+  }
+  else {
+    blender::profile_trace::record_event("io", name, start, end);
+  }
+}
+
+BLOIOProfileFileScope::BLOIOProfileFileScope(const char *filepath, const bool is_write)
+    : is_started_(BLO_io_profile_begin(filepath, is_write)), is_write_(is_write)
+{
+#ifdef WITH_PROFILE_TRACE
+  if (blender::profile_trace::is_recording() && !io_profile_file_traced) {
+    io_profile_file_traced = true;
+    is_traced_ = true;
+    trace_start_ = blender::profile_trace::Clock::now();
+  }
+#endif
+}
+
+BLOIOProfileFileScope::~BLOIOProfileFileScope()
+{
+  if (is_traced_) {
+    BLO_io_profile_trace_event(
+        is_write_ ? "Write Blend File" : "Read Blend File", nullptr, trace_start_);
+    io_profile_file_traced = false;
+  }
+  if (is_started_) {
+    BLO_io_profile_end();
+  }
+}
+
+blender::Vector<BLOIOProfilePhase> BLO_io_profile_phases()
+{
+  IOProfile &profile = io_profile_get();
+  std::lock_guard lock{profile.mutex};
+  return profile.phases;
+}
+
+std::string BLO_io_profile_filepath()
+{
+  IOProfile &profile = io_profile_get();
+  std::lock_guard lock{profile.mutex};
+  return profile.filepath;
+}
+
+bool BLO_io_profile_is_write()
+{
+  IOProfile &profile = io_profile_get();
+  std::lock_guard lock{profile.mutex};
+  return profile.is_write;
+}
@@ -89,6 +89,21 @@ LinkNode *BLO_blendhandle_get_datablock_names(BlendHandle *bh,
   BHead *bhead;
   int tot = 0;
 
+  if (const BLOIDIndex *index = blo_filedata_id_index_ensure(fd)) {
+    for (const BLOIDIndexEntry &entry : index->entries) {
+      if (entry.code != ofblocktype) {
+        continue;
+      }
+      if (use_assets_only && (entry.flag & BLO_ID_INDEX_IS_ASSET) == 0) {
+        continue;
+      }
+      BLI_linklist_prepend(&names, BLI_strdup(index->idname(entry) + 2));
+      tot++;
+    }
+    *r_tot_names = tot;
+    return names;
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == ofblocktype) {
       const char *idname = blo_bhead_id_name(fd, bhead);
@@ -263,6 +278,19 @@ LinkNode *BLO_blendhandle_get_linkable_groups(BlendHandle *bh)
   LinkNode *names = nullptr;
   BHead *bhead;
 
+  if (const BLOIDIndex *index = blo_filedata_id_index_ensure(fd)) {
+    for (const BLOIDIndexEntry &entry : index->entries) {
+      if (BKE_idtype_idcode_is_valid(entry.code) && BKE_idtype_idcode_is_linkable(entry.code)) {
+        const char *str = BKE_idtype_idcode_to_name(entry.code);
+        if (BLI_gset_add(gathered, (void *)str)) {
+          BLI_linklist_prepend(&names, BLI_strdup(str));
+        }
+      }
+    }
+    BLI_gset_free(gathered, nullptr);
+    return names;
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == BLO_CODE_ENDB) {
       break;
@@ -305,6 +333,7 @@ BlendFileData *BLO_read_from_file(const char *filepath,
 {
   BLI_assert(!BLI_path_is_rel(filepath));
   BLI_assert(BLI_path_is_abs_from_cwd(filepath));
+  BLOIOProfileFileScope profile_file(filepath, false);
 
   BlendFileData *bfd = nullptr;
   FileData *fd;
@@ -345,6 +374,7 @@ BlendFileData *BLO_read_from_memfile(Main *oldmain,
                                      const BlendFileReadParams *params,
                                      ReportList *reports)
 {
+  BLOIOProfileScope profile("Read Undo Memfile");
   BlendFileData *bfd = nullptr;
   FileData *fd;
   ListBase old_mainlist;
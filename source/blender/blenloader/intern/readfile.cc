@@ -58,8 +58,10 @@
 #include "BLI_map.hh"
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 #include "BLI_time.h"
+#include "BLI_vector.hh"
 
 #include "BLT_translation.hh"
 
@@ -99,6 +101,7 @@
 
 #include "BLO_blend_defs.hh"
 #include "BLO_blend_validate.hh"
+#include "BLO_io_profile.hh"
 #include "BLO_read_write.hh"
 #include "BLO_readfile.hh"
 #include "BLO_undofile.hh"
@@ -196,6 +199,11 @@ struct BHeadN {
   bool has_data;
 #endif
   bool is_memchunk_identical;
+  /**
+   * Offset of the following block for blocks read out of file order by #blo_bhead_read_at,
+   * zero for blocks in #FileData.bhead_list.
+   */
+  off64_t next_bhead_offset;
   BHead bhead;
 };
 
@@ -469,9 +477,11 @@ static void read_file_version(FileData *fd, Main *main)
         main->is_asset_edit_file = (fg->fileflags & G_FILE_ASSET_EDIT_FILE) != 0;
         MEM_freeN(fg);
       }
-      else if (bhead->code == BLO_CODE_ENDB) {
-        break;
-      }
+      /* There is only one global block, don't read the rest of the file. */
+      break;
+    }
+    if (bhead->code == BLO_CODE_ENDB) {
+      break;
     }
   }
   if (main->curlib) {
@@ -699,7 +709,8 @@ static void bh8_from_bh4(BHead *bhead, BHead4 *bhead4)
   }
 }
 
-static BHeadN *get_bhead(FileData *fd)
+/** Read the block at the current file offset, without adding it to #FileData.bhead_list. */
+static BHeadN *read_bhead(FileData *fd)
 {
   BHeadN *new_bhead = nullptr;
   int64_t readsize;
@@ -786,6 +797,7 @@ static BHeadN *get_bhead(FileData *fd)
           new_bhead->file_offset = fd->file->offset;
           new_bhead->has_data = false;
           new_bhead->is_memchunk_identical = false;
+          new_bhead->next_bhead_offset = 0;
           new_bhead->bhead = bhead;
           const off64_t seek_new = fd->file->seek(fd->file, bhead.len, SEEK_CUR);
           if (UNLIKELY(seek_new == -1)) {
@@ -812,6 +824,7 @@ static BHeadN *get_bhead(FileData *fd)
           new_bhead->has_data = true;
 #endif
           new_bhead->is_memchunk_identical = false;
+          new_bhead->next_bhead_offset = 0;
           new_bhead->bhead = bhead;
 
           readsize = fd->file->read(fd->file, new_bhead + 1, size_t(bhead.len));
@@ -833,6 +846,13 @@ static BHeadN *get_bhead(FileData *fd)
     }
   }
 
+  return new_bhead;
+}
+
+static BHeadN *get_bhead(FileData *fd)
+{
+  BHeadN *new_bhead = read_bhead(fd);
+
   /* We've read a new block. Now add it to the list
    * of blocks.
    */
@@ -843,6 +863,38 @@ static BHeadN *get_bhead(FileData *fd)
   return new_bhead;
 }
 
+/**
+ * Read the block at the given offset, e.g. from the ID index, without reading the blocks before
+ * it. Blocks read this way are kept in #FileData.bhead_by_offset, separate from the blocks read
+ * in file order, and the file offset is left unchanged.
+ */
+static BHeadN *blo_bhead_read_at(FileData *fd, const off64_t offset)
+{
+  if (BHeadN **bheadn = fd->bhead_by_offset.lookup_ptr(offset)) {
+    return *bheadn;
+  }
+
+  FileReader *file = fd->file;
+  const off64_t offset_backup = file->offset;
+  const bool is_eof_backup = fd->is_eof;
+  BHeadN *new_bhead = nullptr;
+
+  fd->is_eof = false;
+  if (file->seek(file, offset, SEEK_SET) != -1) {
+    new_bhead = read_bhead(fd);
+    if (new_bhead) {
+      new_bhead->next_bhead_offset = file->offset;
+      fd->bhead_by_offset.add_new(offset, new_bhead);
+    }
+  }
+  fd->is_eof = is_eof_backup;
+  if (file->seek(file, offset_backup, SEEK_SET) == -1) {
+    fd->is_eof = true;
+  }
+
+  return new_bhead;
+}
+
 BHead *blo_bhead_first(FileData *fd)
 {
   BHeadN *new_bhead;
@@ -882,9 +934,22 @@ BHead *blo_bhead_next(FileData *fd, BHead *thisblock)
     new_bhead = BHEADN_FROM_BHEAD(thisblock);
 
     /* get the next BHeadN. If it doesn't exist we read in the next one */
+    BHeadN *prev_bhead = new_bhead;
     new_bhead = new_bhead->next;
     if (new_bhead == nullptr) {
-      new_bhead = get_bhead(fd);
+      if (prev_bhead->next_bhead_offset != 0) {
+        /* Continue reading after a block that was read out of file order. */
+        new_bhead = blo_bhead_read_at(fd, prev_bhead->next_bhead_offset);
+        if (new_bhead) {
+          prev_bhead->next = new_bhead;
+          if (new_bhead->prev == nullptr) {
+            new_bhead->prev = prev_bhead;
+          }
+        }
+      }
+      else {
+        new_bhead = get_bhead(fd);
+      }
     }
   }
 
@@ -921,6 +986,29 @@ static bool blo_bhead_read_data(FileData *fd, BHead *thisblock, void *buf)
   return success;
 }
 
+/**
+ * Access the data of a block that was not read yet without copying it, only possible when the
+ * file is available in memory (e.g. memory-mapped uncompressed files).
+ */
+static const void *blo_bhead_peek_data(FileData *fd, BHead *thisblock)
+{
+  BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
+  BLI_assert(new_bhead->has_data == false && new_bhead->file_offset != 0);
+  if (fd->file->peek == nullptr) {
+    return nullptr;
+  }
+  return fd->file->peek(fd->file, new_bhead->file_offset, size_t(new_bhead->bhead.len));
+}
+
+/**
+ * Whether data returned by #blo_bhead_peek_data may have been invalid when it was used, e.g.
+ * because of an IO error while accessing a memory-mapped file. Check after using the data.
+ */
+static bool blo_bhead_peek_has_error(FileData *fd)
+{
+  return fd->file->peek_has_error != nullptr && fd->file->peek_has_error(fd->file);
+}
+
 static BHead *blo_bhead_read_full(FileData *fd, BHead *thisblock)
 {
   BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
@@ -930,6 +1018,7 @@ static BHead *blo_bhead_read_full(FileData *fd, BHead *thisblock)
   new_bhead_data->file_offset = new_bhead->file_offset;
   new_bhead_data->has_data = true;
   new_bhead_data->is_memchunk_identical = false;
+  new_bhead_data->next_bhead_offset = 0;
   if (!blo_bhead_read_data(fd, thisblock, new_bhead_data + 1)) {
     MEM_freeN(new_bhead_data);
     return nullptr;
@@ -1038,6 +1127,35 @@ static void read_blender_header(FileData *fd)
   fd->fileversion = header.file_version;
 }
 
+static bool read_file_dna_block(FileData *fd,
+                                const BHead *bhead,
+                                const int subversion,
+                                const char **r_error_message)
+{
+  const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
+  const bool do_alias = false; /* Postpone until after #blo_do_versions_dna runs. */
+  fd->filesdna = DNA_sdna_from_data(
+      &bhead[1], bhead->len, do_endian_swap, true, do_alias, r_error_message);
+  if (fd->filesdna) {
+    blo_do_versions_dna(fd->filesdna, fd->fileversion, subversion);
+    /* Allow aliased lookups (must be after version patching DNA). */
+    DNA_sdna_alias_data_ensure_structs_map(fd->filesdna);
+
+    fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
+    fd->reconstruct_info = DNA_reconstruct_info_create(fd->filesdna, fd->memsdna, fd->compflags);
+    /* used to retrieve ID names from (bhead+1) */
+    fd->id_name_offset = DNA_struct_member_offset_by_name_with_alias(
+        fd->filesdna, "ID", "char", "name[]");
+    BLI_assert(fd->id_name_offset != -1);
+    fd->id_asset_data_offset = DNA_struct_member_offset_by_name_with_alias(
+        fd->filesdna, "ID", "AssetMetaData", "*asset_data");
+
+    return true;
+  }
+
+  return false;
+}
+
 /**
  * \return Success if the file is read correctly, else set \a r_error_message.
  */
@@ -1046,6 +1164,15 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
   BHead *bhead;
   int subversion = 0;
 
+  /* With an ID index, the DNA block at the end of the file is read directly. Only the blocks up
+   * to the global block (at the start of the file) are needed for the subversion. */
+  const BLOIDIndex *index = blo_filedata_id_index_ensure(fd);
+  const BHeadN *dna_bhead = index ? blo_bhead_read_at(fd, off64_t(index->dna_offset)) : nullptr;
+  if (dna_bhead && dna_bhead->bhead.code != BLO_CODE_DNA1) {
+    /* Outdated index, look for the DNA block in the whole file. */
+    dna_bhead = nullptr;
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == BLO_CODE_GLOB) {
       /* Before this, the subversion didn't exist in 'FileGlobal' so the subversion
@@ -1061,31 +1188,12 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
       memcpy(num, fg->subvstr, 4);
       num[4] = 0;
       subversion = atoi(num);
+      if (dna_bhead) {
+        return read_file_dna_block(fd, &dna_bhead->bhead, subversion, r_error_message);
+      }
     }
     else if (bhead->code == BLO_CODE_DNA1) {
-      const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-      const bool do_alias = false; /* Postpone until after #blo_do_versions_dna runs. */
-      fd->filesdna = DNA_sdna_from_data(
-          &bhead[1], bhead->len, do_endian_swap, true, do_alias, r_error_message);
-      if (fd->filesdna) {
-        blo_do_versions_dna(fd->filesdna, fd->fileversion, subversion);
-        /* Allow aliased lookups (must be after version patching DNA). */
-        DNA_sdna_alias_data_ensure_structs_map(fd->filesdna);
-
-        fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
-        fd->reconstruct_info = DNA_reconstruct_info_create(
-            fd->filesdna, fd->memsdna, fd->compflags);
-        /* used to retrieve ID names from (bhead+1) */
-        fd->id_name_offset = DNA_struct_member_offset_by_name_with_alias(
-            fd->filesdna, "ID", "char", "name[]");
-        BLI_assert(fd->id_name_offset != -1);
-        fd->id_asset_data_offset = DNA_struct_member_offset_by_name_with_alias(
-            fd->filesdna, "ID", "AssetMetaData", "*asset_data");
-
-        return true;
-      }
-
-      return false;
+      return read_file_dna_block(fd, bhead, subversion, r_error_message);
     }
     else if (bhead->code == BLO_CODE_ENDB) {
       break;
@@ -1245,6 +1353,68 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
   return fd;
 }
 
+/**
+ * Wraps the #FileReader of a profiled file, to measure the time spent reading and decompressing
+ * the file separately from the processing of its data, see #BLO_io_profile_begin.
+ */
+struct ProfileFileReader {
+  FileReader reader = {};
+  FileReader *base = nullptr;
+  BLOIOProfileCounter read_profile{"Read & Decompress"};
+};
+
+static int64_t profile_file_read(FileReader *reader, void *buffer, size_t size)
+{
+  ProfileFileReader *profile_reader = reinterpret_cast<ProfileFileReader *>(reader);
+  FileReader *base = profile_reader->base;
+  BLOIOProfileCounter::Scope profile(profile_reader->read_profile);
+  const int64_t read_size = base->read(base, buffer, size);
+  profile.add_bytes(std::max<int64_t>(read_size, 0));
+  reader->offset = base->offset;
+  return read_size;
+}
+
+static off64_t profile_file_seek(FileReader *reader, off64_t offset, int whence)
+{
+  FileReader *base = reinterpret_cast<ProfileFileReader *>(reader)->base;
+  const off64_t result = base->seek(base, offset, whence);
+  reader->offset = base->offset;
+  return result;
+}
+
+static const void *profile_file_peek(FileReader *reader, off64_t offset, size_t size)
+{
+  FileReader *base = reinterpret_cast<ProfileFileReader *>(reader)->base;
+  return base->peek(base, offset, size);
+}
+
+static bool profile_file_peek_has_error(FileReader *reader)
+{
+  FileReader *base = reinterpret_cast<ProfileFileReader *>(reader)->base;
+  return base->peek_has_error(base);
+}
+
+static void profile_file_close(FileReader *reader)
+{
+  ProfileFileReader *profile_reader = reinterpret_cast<ProfileFileReader *>(reader);
+  profile_reader->base->close(profile_reader->base);
+  MEM_delete(profile_reader);
+}
+
+static FileReader *profile_file_reader_new(FileReader *base)
+{
+  ProfileFileReader *profile_reader = MEM_new<ProfileFileReader>(__func__);
+  profile_reader->base = base;
+  profile_reader->reader.read = profile_file_read;
+  profile_reader->reader.seek = base->seek ? profile_file_seek : nullptr;
+  profile_reader->reader.close = profile_file_close;
+  profile_reader->reader.peek = base->peek ? profile_file_peek : nullptr;
+  profile_reader->reader.peek_has_error = base->peek_has_error ? profile_file_peek_has_error :
+                                                                 nullptr;
+  profile_reader->reader.offset = base->offset;
+  return &profile_reader->reader;
+}
+
 static FileData *blo_filedata_from_file_descriptor(const char *filepath,
                                                    BlendFileReadReport *reports,
                                                    const int filedes)
@@ -1290,7 +1460,9 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
     }
   }
   else if (BLI_file_magic_is_zstd(header)) {
-    file = BLI_filereader_new_zstd(rawfile);
+    /* Decompress frames ahead of the #BHead parsing on the task scheduler, files written by
+     * Blender consist of many small independent frames. */
+    file = BLI_filereader_new_zstd_parallel(rawfile);
     if (file != nullptr) {
       rawfile = nullptr; /* The `Zstd` #FileReader takes ownership of `rawfile`. */
     }
@@ -1305,6 +1477,10 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
     return nullptr;
   }
 
+  if (BLO_io_profile_is_active()) {
+    file = profile_file_reader_new(file);
+  }
+
   FileData *fd = filedata_new(reports);
   fd->file = file;
 
@@ -1421,6 +1597,9 @@ void blo_filedata_free(FileData *fd)
     MEM_freeN(new_bhead);
   }
 #endif
+  for (BHeadN *new_bhead : fd->bhead_by_offset.values()) {
+    MEM_freeN(new_bhead);
+  }
   fd->file->close(fd->file);
 
   if (fd->filesdna) {
@@ -1459,11 +1638,115 @@ void blo_filedata_free(FileData *fd)
   }
 #endif
 
+  if (fd->id_index) {
+    MEM_freeN(fd->id_index->data);
+    MEM_delete(fd->id_index);
+  }
+
   MEM_delete(fd);
 }
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Read ID Index
+ * \{ */
+
+static bool blo_id_index_validate(const BLOIDIndex &index,
+                                  const uint32_t names_size,
+                                  const off64_t file_size)
+{
+  if (index.dna_offset < SIZEOFBLENDERHEADER || index.dna_offset >= uint64_t(file_size)) {
+    return false;
+  }
+  for (const BLOIDIndexEntry &entry : index.entries) {
+    if (entry.bhead_offset < SIZEOFBLENDERHEADER || entry.bhead_offset >= uint64_t(file_size) ||
+        entry.name_offset >= names_size)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static BLOIDIndex *blo_id_index_read(FileData *fd)
+{
+  FileReader *file = fd->file;
+  if (file->seek == nullptr || (fd->flags & (FD_FLAGS_SWITCH_ENDIAN | FD_FLAGS_IS_MEMFILE))) {
+    return nullptr;
+  }
+
+  /* The index block is the last one before the #BLO_CODE_ENDB #BHead at the end of the file. */
+  const off64_t bhead_size = (fd->flags & FD_FLAGS_FILE_POINTSIZE_IS_4) ? sizeof(BHead4) :
+                                                                          sizeof(BHead8);
+  const off64_t offset_backup = file->offset;
+  const off64_t file_size = file->seek(file, 0, SEEK_END);
+  BLOIDIndex *index = nullptr;
+  void *data = nullptr;
+
+  BLOIDIndexFooter footer;
+  const off64_t footer_offset = file_size - bhead_size - off64_t(sizeof(footer));
+  if (footer_offset < SIZEOFBLENDERHEADER || file->seek(file, footer_offset, SEEK_SET) == -1 ||
+      file->read(file, &footer, sizeof(footer)) != sizeof(footer) ||
+      footer.magic != BLO_ID_INDEX_MAGIC || footer.version != BLO_ID_INDEX_VERSION ||
+      footer.data_size > INT_MAX || footer.data_size < sizeof(BLOIDIndexHeader) + sizeof(footer))
+  {
+    file->seek(file, offset_backup, SEEK_SET);
+    return nullptr;
+  }
+
+  /* The code and length are the first members of both #BHead4 and #BHead8. */
+  int bhead_code_len[2];
+  const off64_t data_offset = footer_offset + off64_t(sizeof(footer)) - off64_t(footer.data_size);
+  if (data_offset - bhead_size >= SIZEOFBLENDERHEADER &&
+      file->seek(file, data_offset - bhead_size, SEEK_SET) != -1 &&
+      file->read(file, bhead_code_len, sizeof(bhead_code_len)) == sizeof(bhead_code_len) &&
+      bhead_code_len[0] == BLO_CODE_INDX && bhead_code_len[1] == int(footer.data_size) &&
+      file->seek(file, data_offset, SEEK_SET) != -1)
+  {
+    data = MEM_mallocN(size_t(footer.data_size), __func__);
+    if (file->read(file, data, size_t(footer.data_size)) == int64_t(footer.data_size)) {
+      const BLOIDIndexHeader *header = static_cast<const BLOIDIndexHeader *>(data);
+      const uint64_t expected_size = sizeof(BLOIDIndexHeader) +
+                                     uint64_t(header->entries_num) * sizeof(BLOIDIndexEntry) +
+                                     header->names_size + sizeof(BLOIDIndexFooter);
+      const char *entries_data = static_cast<const char *>(data) + sizeof(BLOIDIndexHeader);
+      const char *names = entries_data + size_t(header->entries_num) * sizeof(BLOIDIndexEntry);
+      if (header->version == BLO_ID_INDEX_VERSION && expected_size == footer.data_size &&
+          header->names_size > 0 && names[header->names_size - 1] == '\0')
+      {
+        index = MEM_new<BLOIDIndex>(__func__);
+        index->data = data;
+        index->entries = {reinterpret_cast<const BLOIDIndexEntry *>(entries_data),
+                          int64_t(header->entries_num)};
+        index->names = names;
+        index->dna_offset = header->dna_offset;
+        if (!blo_id_index_validate(*index, header->names_size, file_size)) {
+          MEM_delete(index);
+          index = nullptr;
+        }
+      }
+    }
+  }
+
+  if (index == nullptr) {
+    MEM_SAFE_FREE(data);
+  }
+  file->seek(file, offset_backup, SEEK_SET);
+  return index;
+}
+
+const BLOIDIndex *blo_filedata_id_index_ensure(FileData *fd)
+{
+  if (!fd->id_index_checked) {
+    fd->id_index_checked = true;
+    fd->id_index = blo_id_index_read(fd);
+  }
+  return fd->id_index;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Read Thumbnail from Blend File
  * \{ */
@@ -1887,17 +2170,34 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname, const i
     if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
       const char *alloc_name = get_alloc_name(fd, bh, blockname, id_type_index);
       if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
+        const void *old_data = bh + 1;
+        bool is_peeked = false;
 #ifdef USE_BHEAD_READ_ON_DEMAND
         if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
-          bh = blo_bhead_read_full(fd, bh);
-          if (UNLIKELY(bh == nullptr)) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
-            return nullptr;
+          /* Reconstruct straight from the file in memory when possible,
+           * instead of copying the whole block into a temporary #BHeadN first. */
+          old_data = blo_bhead_peek_data(fd, bh);
+          is_peeked = old_data != nullptr;
+          if (old_data == nullptr) {
+            bh = blo_bhead_read_full(fd, bh);
+            if (UNLIKELY(bh == nullptr)) {
+              fd->flags &= ~FD_FLAGS_FILE_OK;
+              return nullptr;
+            }
+            old_data = bh + 1;
           }
         }
 #endif
+        BLOIOProfileCounter::Scope profile(fd->reconstruct_profile);
+        profile.add_bytes(bh->len);
         temp = DNA_struct_reconstruct(
-            fd->reconstruct_info, bh->SDNAnr, bh->nr, (bh + 1), alloc_name);
+            fd->reconstruct_info, bh->SDNAnr, bh->nr, old_data, alloc_name);
+        if (UNLIKELY(is_peeked && blo_bhead_peek_has_error(fd))) {
+          /* Reading the file failed, same as when #blo_bhead_read_full fails. */
+          fd->flags &= ~FD_FLAGS_FILE_OK;
+          MEM_freeN(temp);
+          temp = nullptr;
+        }
       }
       else {
         /* SDNA_CMP_EQUAL */
@@ -2573,6 +2873,7 @@ static bool direct_link_id(FileData *fd,
 
   const IDTypeInfo *id_type = BKE_idtype_get_info_from_id(id);
   if (id_type->blend_read_data != nullptr) {
+    BLOIOProfileScope profile("Read Data", id_type->name);
     id_type->blend_read_data(&reader, id);
   }
 
@@ -2602,6 +2903,162 @@ static bool direct_link_id(FileData *fd,
 }
 
 /* Read all data associated with a datablock into datamap. */
+/**
+ * A data block of an ID being read, see #read_data_into_datamap.
+ *
+ * Blocks which need DNA reconstruction are only allocated when gathered, their conversion is done
+ * for all blocks of the ID at once on multiple threads. Everything touching the #FileData
+ * (reading, allocation names, the old-new map) stays on the calling thread.
+ */
+struct ReadDataBlock {
+  BHead *bhead;
+  void *new_data;
+  /** Data in the file layout, when reconstruction is still pending. */
+  const void *old_data;
+  /** Temporary copy of the block read from the file, freed once it has been reconstructed. */
+  BHead *bhead_temp;
+  /** The old data is accessed directly in the file, see #blo_bhead_peek_data. */
+  bool is_peeked;
+  int old_struct_size;
+  int new_struct_size;
+};
+
+/** Approximate amount of file data converted at once by a single thread. */
+static constexpr int64_t READ_DATA_RECONSTRUCT_GRAIN_SIZE = 64 * 1024;
+/** Limit for temporary block copies kept around before they are reconstructed. */
+static constexpr int64_t READ_DATA_RECONSTRUCT_TEMP_SIZE_MAX = 64 * 1024 * 1024;
+
+/**
+ * Prepare the reconstruction of a block without doing it yet.
+ *
+ * \return false when the block has to be read with #read_struct instead.
+ */
+static bool read_data_block_prepare_reconstruct(FileData *fd,
+                                                BHead *bh,
+                                                const char *blockname,
+                                                const int id_type_index,
+                                                ReadDataBlock &r_block)
+{
+  if (bh->len == 0 || (fd->flags & FD_FLAGS_SWITCH_ENDIAN) ||
+      fd->compflags[bh->SDNAnr] != SDNA_CMP_NOT_EQUAL)
+  {
+    return false;
+  }
+  const int new_struct_index = DNA_reconstruct_info_new_struct_index(fd->reconstruct_info,
+                                                                     bh->SDNAnr);
+  if (new_struct_index == -1) {
+    return false;
+  }
+
+  const void *old_data = bh + 1;
+  BHead *bhead_temp = nullptr;
+#ifdef USE_BHEAD_READ_ON_DEMAND
+  if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
+    old_data = blo_bhead_peek_data(fd, bh);
+    if (old_data == nullptr) {
+      bhead_temp = blo_bhead_read_full(fd, bh);
+      if (UNLIKELY(bhead_temp == nullptr)) {
+        fd->flags &= ~FD_FLAGS_FILE_OK;
+        return true;
+      }
+      old_data = bhead_temp + 1;
+    }
+  }
+#endif
+
+  const char *alloc_name = get_alloc_name(fd, bh, blockname, id_type_index);
+  r_block.old_struct_size = DNA_struct_size(fd->filesdna, bh->SDNAnr);
+  r_block.new_struct_size = DNA_struct_size(fd->memsdna, new_struct_index);
+  r_block.new_data = MEM_calloc_arrayN_aligned(r_block.new_struct_size,
+                                               bh->nr,
+                                               DNA_struct_alignment(fd->memsdna, new_struct_index),
+                                               alloc_name);
+  r_block.old_data = old_data;
+  r_block.bhead_temp = bhead_temp;
+  r_block.is_peeked = old_data != bh + 1 && bhead_temp == nullptr;
+  return true;
+}
+
+/**
+ * Run the pending reconstructions and add all blocks to the old-new map, in file order.
+ */
+static void read_data_blocks_finish(FileData *fd, const blender::Span<ReadDataBlock> blocks)
+{
+  using namespace blender;
+
+  /* Split large arrays too, a single mesh can easily contain most of the data of the file. */
+  struct Chunk {
+    const ReadDataBlock *block;
+    int start;
+    int size;
+  };
+  Vector<Chunk> chunks;
+  int64_t total_size = 0;
+  bool has_peeked_data = false;
+  for (const ReadDataBlock &block : blocks) {
+    if (block.old_data == nullptr) {
+      continue;
+    }
+    has_peeked_data |= block.is_peeked;
+    const int chunk_size = int(
+        std::max<int64_t>(1, READ_DATA_RECONSTRUCT_GRAIN_SIZE / block.old_struct_size));
+    for (int start = 0; start < block.bhead->nr; start += chunk_size) {
+      chunks.append({&block, start, std::min(chunk_size, block.bhead->nr - start)});
+    }
+    total_size += int64_t(block.bhead->nr) * block.old_struct_size;
+  }
+
+  BLOIOProfileScope profile(chunks.is_empty() ? nullptr : "DNA Reconstruct");
+  profile.add_bytes(total_size);
+  threading::parallel_for(
+      chunks.index_range(),
+      READ_DATA_RECONSTRUCT_GRAIN_SIZE,
+      [&](const IndexRange range) {
+        for (const Chunk &chunk : chunks.as_span().slice(range)) {
+          const ReadDataBlock &block = *chunk.block;
+          DNA_struct_reconstruct_into(
+              fd->reconstruct_info,
+              block.bhead->SDNAnr,
+              chunk.size,
+              POINTER_OFFSET(block.old_data, int64_t(chunk.start) * block.old_struct_size),
+              POINTER_OFFSET(block.new_data, int64_t(chunk.start) * block.new_struct_size));
+        }
+      },
+      threading::individual_task_sizes(
+          [&](const int64_t i) {
+            return int64_t(chunks[i].size) * chunks[i].block->old_struct_size;
+          },
+          total_size));
+
+  /* Reconstructed data is invalid when accessing the file in memory failed in the meantime. The
+   * blocks are dropped then, same as when reading them fails. */
+  const bool peek_failed = has_peeked_data && blo_bhead_peek_has_error(fd);
+  if (UNLIKELY(peek_failed)) {
+    fd->flags &= ~FD_FLAGS_FILE_OK;
+  }
+
+  for (const ReadDataBlock &block : blocks) {
+#ifdef USE_BHEAD_READ_ON_DEMAND
+    if (block.bhead_temp) {
+      MEM_freeN(BHEADN_FROM_BHEAD(block.bhead_temp));
+    }
+#endif
+    if (UNLIKELY(peek_failed && block.is_peeked)) {
+      MEM_freeN(block.new_data);
+      continue;
+    }
+    if (block.new_data) {
+      const bool is_new = oldnewmap_insert(fd->datamap, block.bhead->old, block.new_data, 0);
+      if (!is_new) {
+        CLOG_ERROR(&LOG,
+                   "Blendfile corruption: Invalid, or multiple `bhead` with same old address "
+                   "value (%p) for a given ID.",
+                   block.bhead->old);
+      }
+    }
+  }
+}
+
 static BHead *read_data_into_datamap(FileData *fd,
                                      BHead *bhead,
                                      const char *allocname,
@@ -2609,21 +3066,30 @@ static BHead *read_data_into_datamap(FileData *fd,
 {
   bhead = blo_bhead_next(fd, bhead);
 
+  blender::Vector<ReadDataBlock> blocks;
+  int64_t temp_size = 0;
   while (bhead && bhead->code == BLO_CODE_DATA) {
-    void *data = read_struct(fd, bhead, allocname, id_type_index);
-    if (data) {
-      const bool is_new = oldnewmap_insert(fd->datamap, bhead->old, data, 0);
-      if (!is_new) {
-        CLOG_ERROR(&LOG,
-                   "Blendfile corruption: Invalid, or multiple `bhead` with same old address "
-                   "value (%p) for a given ID.",
-                   bhead->old);
+    ReadDataBlock block{};
+    block.bhead = bhead;
+    if (!read_data_block_prepare_reconstruct(fd, bhead, allocname, id_type_index, block)) {
+      block.new_data = read_struct(fd, bhead, allocname, id_type_index);
+    }
+    blocks.append(block);
+
+    if (block.bhead_temp) {
+      temp_size += block.bhead_temp->len;
+      if (temp_size > READ_DATA_RECONSTRUCT_TEMP_SIZE_MAX) {
+        read_data_blocks_finish(fd, blocks);
+        blocks.clear();
+        temp_size = 0;
       }
     }
 
     bhead = blo_bhead_next(fd, bhead);
   }
 
+  read_data_blocks_finish(fd, blocks);
+
   return bhead;
 }
 
@@ -3241,6 +3707,7 @@ static void do_versions_userdef(FileData * /*fd*/, BlendFileData *bfd)
     return;
   }
 
+  BLOIOProfileScope profile("Versioning", "blo_do_versions_userdef");
   blo_do_versions_userdef(user);
 }
 
@@ -3273,27 +3740,35 @@ static void do_versions(FileData *fd, Library *lib, Main *main)
   }
 
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "blo_do_versions_pre250");
     blo_do_versions_pre250(fd, lib, main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "blo_do_versions_250");
     blo_do_versions_250(fd, lib, main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "blo_do_versions_260");
     blo_do_versions_260(fd, lib, main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "blo_do_versions_270");
     blo_do_versions_270(fd, lib, main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "blo_do_versions_280");
     blo_do_versions_280(fd, lib, main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "blo_do_versions_290");
     blo_do_versions_290(fd, lib, main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "blo_do_versions_300");
     blo_do_versions_300(fd, lib, main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "blo_do_versions_400");
     blo_do_versions_400(fd, lib, main);
   }
 
@@ -3321,24 +3796,31 @@ static void do_versions_after_linking(FileData *fd, Main *main)
   main->is_locked_for_linking = true;
 
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "do_versions_after_linking_250");
     do_versions_after_linking_250(main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "do_versions_after_linking_260");
     do_versions_after_linking_260(main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "do_versions_after_linking_270");
     do_versions_after_linking_270(main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "do_versions_after_linking_280");
     do_versions_after_linking_280(fd, main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "do_versions_after_linking_290");
     do_versions_after_linking_290(fd, main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "do_versions_after_linking_300");
     do_versions_after_linking_300(fd, main);
   }
   if (!main->is_read_invalid) {
+    BLOIOProfileScope profile("Versioning", "do_versions_after_linking_400");
     do_versions_after_linking_400(fd, main);
   }
 
@@ -3381,6 +3863,7 @@ static int lib_link_cb(LibraryIDLinkCallbackData *cb_data)
 
 static void lib_link_all(FileData *fd, Main *bmain)
 {
+  BLOIOProfileScope profile("Lib Link");
   BlendLibReader reader = {fd, bmain};
 
   ID *id;
@@ -3722,12 +4205,14 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     read_undo_reuse_noundo_local_ids(fd);
   }
 
+  BLOIOProfileScope profile_blocks("Read Blocks");
   while (bhead) {
     switch (bhead->code) {
       case BLO_CODE_DATA:
       case BLO_CODE_DNA1:
       case BLO_CODE_TEST: /* used as preview since 2.5x */
       case BLO_CODE_REND:
+      case BLO_CODE_INDX:
         bhead = blo_bhead_next(fd, bhead);
         break;
       case BLO_CODE_GLOB:
@@ -3785,6 +4270,8 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
       return bfd;
     }
   }
+  fd->reconstruct_profile.flush();
+  profile_blocks.finish();
 
   if (is_undo) {
     /* Move the remaining Library IDs and their linked data to the new main.
@@ -4047,6 +4534,73 @@ static BHead *find_previous_lib(FileData *fd, BHead *bhead)
   return bhead;
 }
 
+/**
+ * Read the block of an ID listed in the ID index, without reading the blocks before it.
+ * Returns null if the block doesn't match the index, e.g. because the file was modified.
+ */
+static BHead *read_bhead_from_id_index(FileData *fd, const BLOIDIndexEntry &entry)
+{
+  BHeadN *bheadn = blo_bhead_read_at(fd, off64_t(entry.bhead_offset));
+  if (bheadn == nullptr || bheadn->bhead.code != entry.code ||
+      uint64_t(uintptr_t(bheadn->bhead.old)) != entry.old)
+  {
+    return nullptr;
+  }
+  return &bheadn->bhead;
+}
+
+/**
+ * Find a local ID block through the ID index of the file. Returns null when the file has no
+ * index or the ID is not listed in it (e.g. IDs linked from other libraries), in which case the
+ * whole file has to be searched.
+ */
+static BHead *find_bhead_from_old_in_id_index(FileData *fd, const void *old)
+{
+  if (blo_filedata_id_index_ensure(fd) == nullptr) {
+    return nullptr;
+  }
+  BLOIDIndex &index = *fd->id_index;
+  if (index.entry_by_old.is_empty()) {
+    index.entry_by_old.reserve(index.entries.size());
+    for (const BLOIDIndexEntry &entry : index.entries) {
+      index.entry_by_old.add(entry.old, &entry);
+    }
+  }
+  const BLOIDIndexEntry *const *entry = index.entry_by_old.lookup_ptr(uint64_t(uintptr_t(old)));
+  return entry ? read_bhead_from_id_index(fd, **entry) : nullptr;
+}
+
+/** Same as #find_bhead_from_old_in_id_index, using the full ID name. */
+static BHead *find_bhead_from_idname_in_id_index(FileData *fd, const char *idname)
+{
+  if (blo_filedata_id_index_ensure(fd) == nullptr) {
+    return nullptr;
+  }
+  BLOIDIndex &index = *fd->id_index;
+  if (index.entry_by_idname.is_empty()) {
+    index.entry_by_idname.reserve(index.entries.size());
+    for (const BLOIDIndexEntry &entry : index.entries) {
+      index.entry_by_idname.add(index.idname(entry), &entry);
+    }
+  }
+  const BLOIDIndexEntry *const *entry = index.entry_by_idname.lookup_ptr(idname);
+  return entry ? read_bhead_from_id_index(fd, **entry) : nullptr;
+}
+
+#ifdef USE_GHASH_BHEAD
+static BHead *find_bhead_from_idname_in_hash(FileData *fd, const char *idname)
+{
+  if (BHead *bhead = find_bhead_from_idname_in_id_index(fd, idname)) {
+    return bhead;
+  }
+  /* Only read the whole file when the ID index can't be used. */
+  if (fd->bhead_idname_hash == nullptr) {
+    read_file_bhead_idname_map_create(fd);
+  }
+  return static_cast<BHead *>(BLI_ghash_lookup(fd->bhead_idname_hash, idname));
+}
+#endif
+
 static BHead *find_bhead(FileData *fd, void *old)
 {
 #if 0
@@ -4058,6 +4612,10 @@ static BHead *find_bhead(FileData *fd, void *old)
     return nullptr;
   }
 
+  if (BHead *bhead = find_bhead_from_old_in_id_index(fd, old)) {
+    return bhead;
+  }
+
   if (fd->bheadmap == nullptr) {
     sort_bhead_old_map(fd);
   }
@@ -4090,10 +4648,18 @@ static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const
   *((short *)idname_full) = idcode;
   BLI_strncpy(idname_full + 2, name, sizeof(idname_full) - 2);
 
-  return static_cast<BHead *>(BLI_ghash_lookup(fd->bhead_idname_hash, idname_full));
+  return find_bhead_from_idname_in_hash(fd, idname_full);
 
 #else
-  BHead *bhead;
+  char idname_full[MAX_ID_NAME];
+
+  *((short *)idname_full) = idcode;
+  BLI_strncpy(idname_full + 2, name, sizeof(idname_full) - 2);
+
+  BHead *bhead = find_bhead_from_idname_in_id_index(fd, idname_full);
+  if (bhead) {
+    return bhead;
+  }
 
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == idcode) {
@@ -4114,7 +4680,7 @@ static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname)
 {
 #ifdef USE_GHASH_BHEAD
-  BHead *bhead = static_cast<BHead *>(BLI_ghash_lookup(fd->bhead_idname_hash, idname));
+  BHead *bhead = find_bhead_from_idname_in_hash(fd, idname);
 #else
   BHead *bhead = find_bhead_from_code_name(fd, GS(idname), idname + 2);
 #endif
@@ -4132,7 +4698,7 @@ static BHead *find_bhead_from_idname(FileData *fd, const char *idname)
   char id_name_old[MAX_ID_NAME];
   STRNCPY(id_name_old, idname);
   *reinterpret_cast<short *>(id_name_old) = id_code_old;
-  return static_cast<BHead *>(BLI_ghash_lookup(fd->bhead_idname_hash, id_name_old));
+  return find_bhead_from_idname_in_hash(fd, id_name_old);
 #else
   return find_bhead_from_code_name(fd, id_code_old, idname + 2);
 #endif
@@ -4312,6 +4878,7 @@ void BLO_expand_main(void *fdhandle, Main *mainvar, BLOExpandDoitCallback callba
 {
   FileData *fd = static_cast<FileData *>(fdhandle);
   BlendExpander expander = {fd, mainvar, callback};
+  BLOIOProfileScope profile("Expand");
 
   for (bool do_it = true; do_it;) {
     do_it = false;
@@ -4446,9 +5013,6 @@ static Main *library_link_begin(Main *mainvar,
   /* needed for do_version */
   mainl->versionfile = short(fd->fileversion);
   read_file_version(fd, mainl);
-#ifdef USE_GHASH_BHEAD
-  read_file_bhead_idname_map_create(fd);
-#endif
 
   return mainl;
 }
@@ -4891,9 +5455,6 @@ static FileData *read_library_file_data(FileData *basefd,
 
     /* subversion */
     read_file_version(fd, mainptr);
-#ifdef USE_GHASH_BHEAD
-    read_file_bhead_idname_map_create(fd);
-#endif
   }
   else {
     mainptr->curlib->runtime.filedata = nullptr;
@@ -4916,6 +5477,7 @@ static FileData *read_library_file_data(FileData *basefd,
 
 static void read_libraries(FileData *basefd, ListBase *mainlist)
 {
+  BLOIOProfileScope profile("Read Libraries");
   Main *mainl = static_cast<Main *>(mainlist->first);
   bool do_it = true;
 
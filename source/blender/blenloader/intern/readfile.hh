@@ -16,10 +16,15 @@
 #endif
 
 #include "BLI_filereader.h"
+#include "BLI_map.hh"
+#include "BLI_span.hh"
+#include "BLI_string_ref.hh"
 #include "DNA_sdna_types.h"
 #include "DNA_space_types.h"
 #include "DNA_windowmanager_types.h" /* for eReportType */
 
+#include "BLO_blend_defs.hh"
+#include "BLO_io_profile.hh"
 #include "BLO_readfile.hh"
 
 struct BlendFileData;
@@ -27,6 +32,7 @@ struct BlendfileLinkAppendContext;
 struct BlendFileReadParams;
 struct BlendFileReadReport;
 struct BLOCacheStorage;
+struct BHeadN;
 struct BHeadSort;
 struct DNA_ReconstructInfo;
 struct IDNameLib_Map;
@@ -51,6 +57,26 @@ enum eFileDataFlag {
 };
 ENUM_OPERATORS(eFileDataFlag, FD_FLAGS_IS_MEMFILE)
 
+/**
+ * Content of the optional #BLO_CODE_INDX block, see #blo_filedata_id_index_ensure.
+ * All spans point into #data.
+ */
+struct BLOIDIndex {
+  void *data = nullptr;
+  blender::Span<BLOIDIndexEntry> entries;
+  const char *names = nullptr;
+  uint64_t dna_offset = 0;
+  /** Lookups of the entries, built on demand by #find_bhead and #find_bhead_from_idname. */
+  blender::Map<uint64_t, const BLOIDIndexEntry *> entry_by_old;
+  blender::Map<blender::StringRef, const BLOIDIndexEntry *> entry_by_idname;
+
+  /** Full ID name (including the ID code prefix) of the given entry. */
+  const char *idname(const BLOIDIndexEntry &entry) const
+  {
+    return names + entry.name_offset;
+  }
+};
+
 /* Disallow since it's 32bit on ms-windows. */
 #ifdef __GNUC__
 #  pragma GCC poison off_t
@@ -92,6 +118,8 @@ struct FileData {
   /** Array of #eSDNA_StructCompare. */
   const char *compflags = nullptr;
   DNA_ReconstructInfo *reconstruct_info = nullptr;
+  /** Time spent reconstructing individual blocks in #read_struct. */
+  BLOIOProfileCounter reconstruct_profile{"DNA Reconstruct"};
 
   int fileversion = 0;
   /** Used to retrieve ID names from (bhead+1). */
@@ -132,6 +160,15 @@ struct FileData {
   /** See: #USE_GHASH_BHEAD. */
   GHash *bhead_idname_hash = nullptr;
 
+  /** See #blo_filedata_id_index_ensure. */
+  BLOIDIndex *id_index = nullptr;
+  bool id_index_checked = false;
+  /**
+   * Blocks read at offsets from the ID index, outside of #bhead_list (which is read in file
+   * order). Their following blocks are read and linked on demand by #blo_bhead_next.
+   */
+  blender::Map<off64_t, BHeadN *> bhead_by_offset;
+
   ListBase *mainlist = nullptr;
   /** Used for undo. */
   ListBase *old_mainlist = nullptr;
@@ -190,6 +227,15 @@ void blo_cache_storage_end(FileData *fd) ATTR_NONNULL(1);
 
 void blo_filedata_free(FileData *fd) ATTR_NONNULL(1);
 
+/**
+ * Read the ID index stored at the end of files written by recent Blender versions, allowing to
+ * list and locate ID blocks without parsing every #BHead of the file.
+ *
+ * \return The index, or null when the file has none or it cannot be read without scanning the
+ * file (non-seekable compressed files, undo memfiles, files of different endianness).
+ */
+const BLOIDIndex *blo_filedata_id_index_ensure(FileData *fd) ATTR_NONNULL(1);
+
 BHead *blo_bhead_first(FileData *fd) ATTR_NONNULL(1);
 BHead *blo_bhead_next(FileData *fd, BHead *thisblock) ATTR_NONNULL(1);
 BHead *blo_bhead_prev(FileData *fd, BHead *thisblock) ATTR_NONNULL(1, 2);
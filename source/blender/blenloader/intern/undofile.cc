@@ -20,30 +20,473 @@
 #  include <io.h>
 #endif
 
+#include <mutex>
+
+#include <xxhash.h>
+#include <zstd.h>
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_implicit_sharing.hh"
+#include "BLI_set.hh"
+#include "BLI_sort.hh"
+#include "BLI_task.h"
+#include "BLI_task.hh"
+#include "BLI_vector.hh"
 
 #include "BLO_readfile.hh"
 #include "BLO_undofile.hh"
 
+#include "BKE_appdir.hh"
 #include "BKE_lib_id.hh"
 #include "BKE_main.hh"
 #include "BKE_undo_system.hh"
 
 #include "BLI_strict_flags.h" /* Keep last. */
 
+/* -------------------------------------------------------------------- */
+/** \name Spill File
+ *
+ * Compressed chunks exceeding the memory budget of #BLO_memfile_compress are moved to a single
+ * temporary file in the session temporary directory. Space of freed chunks is reused, the file is
+ * removed once it doesn't contain any chunk anymore.
+ * \{ */
+
+namespace {
+
+struct MemFileSpillRange {
+  int64_t offset;
+  int64_t size;
+};
+
+struct MemFileSpill {
+  std::mutex mutex;
+  int file = -1;
+  char filepath[FILE_MAX];
+  /** End of the used part of the file. */
+  int64_t end = 0;
+  /** Number of bytes used by chunks. */
+  int64_t used = 0;
+  blender::Vector<MemFileSpillRange> free_ranges;
+};
+
+}  // namespace
+
+static MemFileSpill &memfile_spill_get()
+{
+  static MemFileSpill spill;
+  return spill;
+}
+
+/** \return The offset of the written data in the spill file, or -1 on failure. */
+static int64_t memfile_spill_write(const void *data, const size_t size)
+{
+  MemFileSpill &spill = memfile_spill_get();
+  std::lock_guard lock{spill.mutex};
+
+  if (spill.file == -1) {
+    BLI_path_join(spill.filepath, sizeof(spill.filepath), BKE_tempdir_session(), "undo.spill");
+    spill.file = BLI_open(spill.filepath, O_BINARY | O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (spill.file == -1) {
+      return -1;
+    }
+  }
+
+  /* First fit in the space of freed chunks, otherwise append. */
+  int64_t offset = spill.end;
+  for (const int64_t i : spill.free_ranges.index_range()) {
+    MemFileSpillRange &range = spill.free_ranges[i];
+    if (range.size >= int64_t(size)) {
+      offset = range.offset;
+      range.offset += int64_t(size);
+      range.size -= int64_t(size);
+      if (range.size == 0) {
+        spill.free_ranges.remove_and_reorder(i);
+      }
+      break;
+    }
+  }
+
+  if (BLI_lseek(spill.file, offset, SEEK_SET) != offset ||
+      write(spill.file, data, uint(size)) != int64_t(size))
+  {
+    if (offset != spill.end) {
+      spill.free_ranges.append({offset, int64_t(size)});
+    }
+    return -1;
+  }
+
+  spill.end = std::max(spill.end, offset + int64_t(size));
+  spill.used += int64_t(size);
+  return offset;
+}
+
+static bool memfile_spill_read(const int64_t offset, void *data, const size_t size)
+{
+  MemFileSpill &spill = memfile_spill_get();
+  std::lock_guard lock{spill.mutex};
+  if (spill.file == -1 || BLI_lseek(spill.file, offset, SEEK_SET) != offset) {
+    return false;
+  }
+  return BLI_read(spill.file, data, size) == int64_t(size);
+}
+
+static void memfile_spill_free(const int64_t offset, const size_t size)
+{
+  MemFileSpill &spill = memfile_spill_get();
+  std::lock_guard lock{spill.mutex};
+
+  spill.used -= int64_t(size);
+  if (spill.used == 0) {
+    close(spill.file);
+    BLI_delete(spill.filepath, false, false);
+    spill.file = -1;
+    spill.end = 0;
+    spill.free_ranges.clear();
+    return;
+  }
+  if (offset + int64_t(size) == spill.end) {
+    spill.end = offset;
+  }
+  else {
+    spill.free_ranges.append({offset, int64_t(size)});
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Chunk Store
+ *
+ * Chunk data of all undo steps, deduplicated by content hash, so that identical data anywhere in
+ * the undo history (e.g. an ID that moved, or data that was reverted) is only stored once.
+ * \{ */
+
+namespace {
+
+struct MemFileChunkStore {
+  /** Data by content hash, multiple data can have the same hash in case of collisions. */
+  blender::Map<uint64_t, blender::Vector<MemFileChunkData *, 1>> data_by_hash;
+};
+
+}  // namespace
+
+static MemFileChunkStore &memfile_chunk_store_get()
+{
+  static MemFileChunkStore store;
+  return store;
+}
+
+static void memfile_chunk_packed_free(MemFileChunkPacked *packed);
+static bool memfile_chunk_data_unpack(const MemFileChunkData *data, char *r_buf);
+
+/** Compare the content of chunk data with a buffer of the same size. */
+static bool memfile_chunk_data_equals(const MemFileChunkData *data, const char *buf)
+{
+  if (data->buf) {
+    return memcmp(data->buf, buf, data->size) == 0;
+  }
+  /* Data of older steps may be compressed, this should rarely happen since the data of the latest
+   * steps is kept uncompressed. */
+  char *unpacked_buf = static_cast<char *>(MEM_mallocN(data->size, __func__));
+  const bool equals = memfile_chunk_data_unpack(data, unpacked_buf) &&
+                      memcmp(unpacked_buf, buf, data->size) == 0;
+  MEM_freeN(unpacked_buf);
+  return equals;
+}
+
+static MemFileChunkData *memfile_chunk_store_lookup(const char *buf,
+                                                    const size_t size,
+                                                    const uint64_t hash)
+{
+  MemFileChunkStore &store = memfile_chunk_store_get();
+  const blender::Vector<MemFileChunkData *, 1> *datas = store.data_by_hash.lookup_ptr(hash);
+  if (datas == nullptr) {
+    return nullptr;
+  }
+  for (MemFileChunkData *data : *datas) {
+    if (data->size == size && memfile_chunk_data_equals(data, buf)) {
+      return data;
+    }
+  }
+  return nullptr;
+}
+
+static MemFileChunkData *memfile_chunk_store_add(const char *buf,
+                                                 const size_t size,
+                                                 const uint64_t hash)
+{
+  char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
+  memcpy(buf_new, buf, size);
+
+  MemFileChunkData *data = MEM_cnew<MemFileChunkData>(__func__);
+  data->buf = buf_new;
+  data->size = size;
+  data->hash = hash;
+
+  memfile_chunk_store_get().data_by_hash.lookup_or_add_default(hash).append(data);
+  return data;
+}
+
+static void memfile_chunk_data_add_user(MemFileChunkData *data)
+{
+  data->users++;
+}
+
+static void memfile_chunk_data_remove_user(MemFileChunkData *data)
+{
+  BLI_assert(data->users > 0);
+  if (--data->users > 0) {
+    return;
+  }
+
+  MemFileChunkStore &store = memfile_chunk_store_get();
+  blender::Vector<MemFileChunkData *, 1> &datas = store.data_by_hash.lookup(data->hash);
+  datas.remove_first_occurrence_and_reorder(data);
+  if (datas.is_empty()) {
+    store.data_by_hash.remove(data->hash);
+    if (store.data_by_hash.is_empty()) {
+      /* Don't keep the memory of the store around when there is no undo history. */
+      store.data_by_hash.clear();
+    }
+  }
+
+  if (data->buf) {
+    MEM_freeN((void *)data->buf);
+  }
+  else {
+    memfile_chunk_packed_free(data->packed);
+  }
+  MEM_freeN(data);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Chunk Compression
+ * \{ */
+
+/** Compression is meant to run in the background with little CPU usage, favor speed. */
+#define MEMFILE_COMPRESSION_LEVEL 1
+/** Chunks smaller than this are not worth compressing. */
+#define MEMFILE_COMPRESSION_MIN_SIZE 256
+
+static TaskPool *memfile_compress_pool = nullptr;
+
+static void memfile_chunk_packed_free(MemFileChunkPacked *packed)
+{
+  if (packed->data) {
+    MEM_freeN(packed->data);
+  }
+  else {
+    memfile_spill_free(packed->file_offset, packed->data_size);
+  }
+  MEM_freeN(packed);
+}
+
+/**
+ * Decompress packed chunk data, reading it back from the spill file when needed.
+ * \param r_buf: Buffer of at least the size of the data.
+ */
+static bool memfile_chunk_data_unpack(const MemFileChunkData *data, char *r_buf)
+{
+  const MemFileChunkPacked *packed = data->packed;
+  void *spilled_data = nullptr;
+  const void *packed_data = packed->data;
+  if (packed_data == nullptr) {
+    spilled_data = MEM_mallocN(packed->data_size, __func__);
+    if (!memfile_spill_read(packed->file_offset, spilled_data, packed->data_size)) {
+      MEM_freeN(spilled_data);
+      return false;
+    }
+    packed_data = spilled_data;
+  }
+  const size_t size = ZSTD_decompress(r_buf, data->size, packed_data, packed->data_size);
+  MEM_SAFE_FREE(spilled_data);
+  return !ZSTD_isError(size) && size == data->size;
+}
+
+namespace {
+
+struct MemFileChunkDataUsage {
+  /** Index of the newest memfile using the data. */
+  int64_t last_memfile_index;
+  /** The data is used by a memfile that should stay uncompressed. */
+  bool keep;
+};
+
+struct MemFileCompressData {
+  blender::Vector<MemFile *> memfiles;
+  blender::Set<const MemFile *> keep_memfiles;
+  size_t memory_budget;
+};
+
+}  // namespace
+
+static void memfile_chunk_data_pack(MemFileChunkData *data)
+{
+  if (data->buf == nullptr || data->size < MEMFILE_COMPRESSION_MIN_SIZE) {
+    return;
+  }
+  const size_t bound = ZSTD_compressBound(data->size);
+  void *packed_data = MEM_mallocN(bound, __func__);
+  const size_t packed_size = ZSTD_compress(
+      packed_data, bound, data->buf, data->size, MEMFILE_COMPRESSION_LEVEL);
+  if (ZSTD_isError(packed_size) || packed_size >= data->size) {
+    MEM_freeN(packed_data);
+    return;
+  }
+  MemFileChunkPacked *packed = MEM_cnew<MemFileChunkPacked>(__func__);
+  packed->data = MEM_reallocN(packed_data, packed_size);
+  packed->data_size = packed_size;
+  packed->file_offset = -1;
+
+  MEM_freeN((void *)data->buf);
+  data->buf = nullptr;
+  data->packed = packed;
+}
+
+static void memfile_chunk_data_unpack_in_place(MemFileChunkData *data)
+{
+  if (data->packed == nullptr) {
+    return;
+  }
+  char *buf = static_cast<char *>(MEM_mallocN(data->size, "Chunk buffer"));
+  if (!memfile_chunk_data_unpack(data, buf)) {
+    MEM_freeN(buf);
+    return;
+  }
+  memfile_chunk_packed_free(data->packed);
+  data->packed = nullptr;
+  data->buf = buf;
+}
+
+static void memfile_chunk_data_spill(MemFileChunkData *data)
+{
+  MemFileChunkPacked *packed = data->packed;
+  const int64_t offset = memfile_spill_write(packed->data, packed->data_size);
+  if (offset == -1) {
+    return;
+  }
+  MEM_freeN(packed->data);
+  packed->data = nullptr;
+  packed->file_offset = offset;
+}
+
+static void memfile_compress_task(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  using namespace blender;
+  const MemFileCompressData &compress_data = *static_cast<MemFileCompressData *>(taskdata);
+
+  Map<MemFileChunkData *, MemFileChunkDataUsage> usage_by_data;
+  for (const int64_t memfile_index : compress_data.memfiles.index_range()) {
+    MemFile *memfile = compress_data.memfiles[memfile_index];
+    const bool keep = compress_data.keep_memfiles.contains(memfile);
+    LISTBASE_FOREACH (MemFileChunk *, chunk, &memfile->chunks) {
+      MemFileChunkDataUsage &usage = usage_by_data.lookup_or_add(chunk->data, {0, false});
+      usage.last_memfile_index = memfile_index;
+      usage.keep |= keep;
+    }
+  }
+
+  Vector<std::pair<MemFileChunkData *, MemFileChunkDataUsage>> datas;
+  datas.reserve(usage_by_data.size());
+  for (const auto item : usage_by_data.items()) {
+    datas.append({item.key, item.value});
+  }
+
+  threading::parallel_for(datas.index_range(), 64, [&](const IndexRange range) {
+    for (const auto &[data, usage] : datas.as_span().slice(range)) {
+      if (usage.keep) {
+        memfile_chunk_data_unpack_in_place(data);
+      }
+      else {
+        memfile_chunk_data_pack(data);
+      }
+    }
+  });
+
+  if (compress_data.memory_budget == 0) {
+    return;
+  }
+
+  /* Move data that is only used by the oldest steps to disk first. */
+  Vector<std::pair<MemFileChunkData *, MemFileChunkDataUsage>> packed_datas;
+  size_t packed_size = 0;
+  for (const auto &item : datas) {
+    const MemFileChunkPacked *packed = item.first->packed;
+    if (packed && packed->data) {
+      packed_datas.append(item);
+      packed_size += packed->data_size;
+    }
+  }
+  if (packed_size <= compress_data.memory_budget) {
+    return;
+  }
+  parallel_sort(packed_datas.begin(), packed_datas.end(), [](const auto &a, const auto &b) {
+    return a.second.last_memfile_index < b.second.last_memfile_index;
+  });
+  for (const auto &[data, usage] : packed_datas) {
+    if (packed_size <= compress_data.memory_budget) {
+      break;
+    }
+    const size_t data_size = data->packed->data_size;
+    memfile_chunk_data_spill(data);
+    if (data->packed->data == nullptr) {
+      packed_size -= data_size;
+    }
+  }
+}
+
+static void memfile_compress_data_free(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  MEM_delete(static_cast<MemFileCompressData *>(taskdata));
+}
+
+void BLO_memfile_compress(blender::Span<MemFile *> memfiles,
+                          blender::Span<const MemFile *> keep_memfiles,
+                          const size_t memory_budget)
+{
+  BLO_memfile_compress_wait();
+
+  MemFileCompressData *compress_data = MEM_new<MemFileCompressData>(__func__);
+  compress_data->memfiles.extend(memfiles);
+  for (const MemFile *memfile : keep_memfiles) {
+    compress_data->keep_memfiles.add(memfile);
+  }
+  compress_data->memory_budget = memory_budget;
+
+  memfile_compress_pool = BLI_task_pool_create_background(nullptr, TASK_PRIORITY_LOW);
+  BLI_task_pool_push(memfile_compress_pool,
+                     memfile_compress_task,
+                     compress_data,
+                     false,
+                     memfile_compress_data_free);
+}
+
+void BLO_memfile_compress_wait()
+{
+  if (memfile_compress_pool == nullptr) {
+    return;
+  }
+  BLI_task_pool_work_and_wait(memfile_compress_pool);
+  BLI_task_pool_free(memfile_compress_pool);
+  memfile_compress_pool = nullptr;
+}
+
+/** \} */
+
 /* **************** support for memory-write, for undo buffers *************** */
 
 void BLO_memfile_free(MemFile *memfile)
 {
+  BLO_memfile_compress_wait();
+
   while (MemFileChunk *chunk = static_cast<MemFileChunk *>(BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
-      MEM_freeN((void *)chunk->buf);
-    }
+    memfile_chunk_data_remove_user(chunk->data);
     MEM_freeN(chunk);
   }
   MEM_delete(memfile->shared_storage);
@@ -61,37 +504,15 @@ MemFileSharedStorage::~MemFileSharedStorage()
 
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
-  /* We use this mapping to store the memory buffers from second memfile chunks which are not owned
-   * by it (i.e. shared with some previous memory steps). */
-  blender::Map<const char *, MemFileChunk *> buffer_to_second_memchunk;
-
-  /* First, detect all memchunks in second memfile that are not owned by it. */
-  LISTBASE_FOREACH (MemFileChunk *, sc, &second->chunks) {
-    if (sc->is_identical) {
-      buffer_to_second_memchunk.add(sc->buf, sc);
-    }
-  }
-
-  /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
-   * it is also used by the second memfile, transfer the ownership. */
-  LISTBASE_FOREACH (MemFileChunk *, fc, &first->chunks) {
-    if (!fc->is_identical) {
-      if (MemFileChunk *sc = buffer_to_second_memchunk.lookup_default(fc->buf, nullptr)) {
-        BLI_assert(sc->is_identical);
-        sc->is_identical = false;
-        fc->is_identical = true;
-      }
-      /* Note that if the second memfile does not use that chunk, we assume that the first one
-       * fully owns it without sharing it with any other memfile, and hence it should be freed with
-       * it. */
-    }
-  }
-
+  /* Chunk data is reference counted, data still used by the second memfile is kept alive by it. */
+  UNUSED_VARS(second);
   BLO_memfile_free(first);
 }
 
 void BLO_memfile_clear_future(MemFile *memfile)
 {
+  BLO_memfile_compress_wait();
+
   LISTBASE_FOREACH (MemFileChunk *, chunk, &memfile->chunks) {
     chunk->is_identical_future = false;
   }
@@ -101,6 +522,9 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
                             MemFile *written_memfile,
                             MemFile *reference_memfile)
 {
+  /* Reference chunks may be (un)packed in the background otherwise. */
+  BLO_memfile_compress_wait();
+
   mem_data->written_memfile = written_memfile;
   mem_data->reference_memfile = reference_memfile;
   mem_data->reference_current_chunk = reference_memfile ? static_cast<MemFileChunk *>(
@@ -136,7 +560,7 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   MemFileChunk *curchunk = static_cast<MemFileChunk *>(
       MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk"));
   curchunk->size = size;
-  curchunk->buf = nullptr;
+  curchunk->data = nullptr;
   curchunk->is_identical = false;
   /* This is unsafe in the sense that an app handler or other code that does not
    * perform an undo push may make changes after the last undo push that
@@ -145,26 +569,33 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
   curchunk->id_session_uid = mem_data->current_id_session_uid;
   BLI_addtail(&memfile->chunks, curchunk);
 
+  const uint64_t hash = XXH3_64bits(buf, size);
+
   /* we compare compchunk with buf */
   if (*compchunk_step != nullptr) {
     MemFileChunk *compchunk = *compchunk_step;
-    if (compchunk->size == curchunk->size) {
-      if (memcmp(compchunk->buf, buf, size) == 0) {
-        curchunk->buf = compchunk->buf;
-        curchunk->is_identical = true;
-        compchunk->is_identical_future = true;
-      }
+    if (compchunk->size == curchunk->size && compchunk->data->hash == hash &&
+        memfile_chunk_data_equals(compchunk->data, buf))
+    {
+      curchunk->data = compchunk->data;
+      curchunk->is_identical = true;
+      compchunk->is_identical_future = true;
     }
     *compchunk_step = static_cast<MemFileChunk *>(compchunk->next);
   }
 
+  /* Not equal to the matching chunk, but the same data may still exist elsewhere in the undo
+   * history. This doesn't make the chunk identical, since it is not the same data of the ID. */
+  if (curchunk->data == nullptr) {
+    curchunk->data = memfile_chunk_store_lookup(buf, size, hash);
+  }
+
   /* not equal... */
-  if (curchunk->buf == nullptr) {
-    char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
-    memcpy(buf_new, buf, size);
-    curchunk->buf = buf_new;
+  if (curchunk->data == nullptr) {
+    curchunk->data = memfile_chunk_store_add(buf, size, hash);
     memfile->size += size;
   }
+  memfile_chunk_data_add_user(curchunk->data);
 }
 
 Main *BLO_memfile_main_get(MemFile *memfile, Main *bmain, Scene **r_scene)
@@ -242,7 +673,26 @@ static int64_t undo_read(FileReader *reader, void *buffer, size_t size)
         readsize = chunk->size - chunkoffset;
       }
 
-      memcpy(POINTER_OFFSET(buffer, totread), chunk->buf + chunkoffset, readsize);
+      const char *chunk_buf = chunk->data->buf;
+      if (chunk_buf == nullptr) {
+        /* Packed chunks are decompressed as a whole, keep them for the following reads. */
+        if (undo->unpacked_chunk != chunk) {
+          if (undo->unpacked_buf_size < chunk->size) {
+            MEM_SAFE_FREE(undo->unpacked_buf);
+            undo->unpacked_buf = static_cast<char *>(MEM_mallocN(chunk->size, __func__));
+            undo->unpacked_buf_size = chunk->size;
+          }
+          if (!memfile_chunk_data_unpack(chunk->data, undo->unpacked_buf)) {
+            printf("illegal read, chunk could not be decompressed\n");
+            undo->unpacked_chunk = nullptr;
+            return 0;
+          }
+          undo->unpacked_chunk = chunk;
+        }
+        chunk_buf = undo->unpacked_buf;
+      }
+
+      memcpy(POINTER_OFFSET(buffer, totread), chunk_buf + chunkoffset, readsize);
       totread += readsize;
       undo->reader.offset += (off64_t)readsize;
       seek += readsize;
@@ -263,11 +713,15 @@ static int64_t undo_read(FileReader *reader, void *buffer, size_t size)
 
 static void undo_close(FileReader *reader)
 {
+  UndoReader *undo = (UndoReader *)reader;
+  MEM_SAFE_FREE(undo->unpacked_buf);
   MEM_freeN(reader);
 }
 
 FileReader *BLO_memfile_new_filereader(MemFile *memfile, int undo_direction)
 {
+  BLO_memfile_compress_wait();
+
   UndoReader *undo = static_cast<UndoReader *>(MEM_callocN(sizeof(UndoReader), __func__));
 
   undo->memfile = memfile;
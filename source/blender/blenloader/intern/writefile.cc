@@ -87,6 +87,7 @@
 #include "DNA_key_types.h"
 #include "DNA_sdna_types.h"
 
+#include "BLI_array.hh"
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
@@ -94,6 +95,7 @@
 #include "BLI_implicit_sharing.hh"
 #include "BLI_link_utils.h"
 #include "BLI_linklist.h"
+#include "BLI_map.hh"
 #include "BLI_math_base.h"
 #include "BLI_mempool.h"
 #include "BLI_multi_value_map.hh"
@@ -124,6 +126,7 @@
 
 #include "BLO_blend_defs.hh"
 #include "BLO_blend_validate.hh"
+#include "BLO_io_profile.hh"
 #include "BLO_read_write.hh"
 #include "BLO_readfile.hh"
 #include "BLO_undofile.hh"
@@ -131,6 +134,7 @@
 
 #include "readfile.hh"
 
+#include <xxhash.h>
 #include <zstd.h>
 
 /* Make preferences read-only. */
@@ -147,10 +151,23 @@
 
 #define ZSTD_COMPRESSION_LEVEL 3
 
-static CLG_LogRef LOG = {"blo.writefile"};
+/**
+ * With #WriteWrap::use_flush_per_id, the data of consecutive IDs shares a frame until it is at
+ * least this large, because small frames compress poorly.
+ */
+#define ZSTD_ID_FRAME_MIN_SIZE (1 << 14) /* 16kb */
+/** Frames with the data of several IDs are always ended once they are this large. */
+#define ZSTD_ID_FRAME_MAX_SIZE (1 << 17) /* 128kb */
+
+/**
+ * Skippable frame (the zstd magic number for those) storing a hash of the uncompressed content of
+ * every frame, see #ZstdWriteWrap::use_delta.
+ */
+#define ZSTD_DELTA_FRAME_MAGIC 0x184D2A50
+#define ZSTD_DELTA_FRAME_ID BLEND_MAKE_ID('B', 'D', 'L', 'T')
+#define ZSTD_DELTA_FRAME_VERSION 1
 
-/** Use if we want to store how many bytes have been written to the file. */
-// #define USE_WRITE_DATA_LEN
+static CLG_LogRef LOG = {"blo.writefile"};
 
 /* -------------------------------------------------------------------- */
 /** \name Internal Write Wrapper's (Abstracts Compression)
@@ -161,6 +178,8 @@ struct ZstdFrame {
 
   uint32_t compressed_size;
   uint32_t uncompressed_size;
+  /** Hash of the uncompressed content, only used for delta saving. */
+  XXH128_hash_t hash;
 };
 
 class WriteWrap {
@@ -171,6 +190,11 @@ class WriteWrap {
 
   /** Buffer output (we only want when output isn't already buffered). */
   bool use_buf = true;
+  /**
+   * Flush the buffer between IDs, so that the data of IDs that didn't change is written with the
+   * same #write calls as before. Small IDs are grouped, see #mywrite_id_end.
+   */
+  bool use_flush_per_id = false;
 };
 
 class RawWriteWrap : public WriteWrap {
@@ -219,6 +243,21 @@ class ZstdWriteWrap : public WriteWrap {
 
   bool write_error = false;
 
+  /** Write a hash of every frame, and reuse frames of #delta_reference. */
+  bool use_delta = false;
+  struct DeltaReferenceFrame {
+    uint64_t compressed_offset;
+    uint32_t compressed_size;
+    uint32_t uncompressed_size;
+  };
+  struct {
+    /** File handle of the previous version of the file, -1 when there is none. */
+    int file = -1;
+    blender::Map<std::pair<uint64_t, uint64_t>, DeltaReferenceFrame> frame_by_hash;
+    int64_t reused_frames = 0;
+    int64_t reused_size = 0;
+  } delta_reference;
+
  public:
   ZstdWriteWrap(WriteWrap &base_wrap) : base_wrap(base_wrap) {}
 
@@ -226,17 +265,39 @@ class ZstdWriteWrap : public WriteWrap {
   bool close() override;
   bool write(const void *buf, size_t buf_len) override;
 
+  /**
+   * Enable delta saving: frames whose content is identical to a frame of the previous version of
+   * the file (\a reference_filepath) are copied from it as-is, instead of being compressed again.
+   * This only works when the previous file was written with delta saving too, otherwise hashes of
+   * the frames are only written for the next save.
+   */
+  void enable_delta(const char *reference_filepath);
+
  private:
   struct ZstdWriteBlockTask;
   void write_task(ZstdWriteBlockTask *task);
   void write_u32_le(uint32_t val);
   void write_seekable_frames();
+  void write_delta_frame();
+  bool delta_reference_load(int file);
+  void *delta_reference_frame_read(size_t buf_len, const XXH128_hash_t &hash, size_t *r_size);
+  static bool delta_reference_frame_matches(const void *frame,
+                                            size_t frame_size,
+                                            const void *buf,
+                                            size_t buf_len);
 };
 
 struct ZstdWriteWrap::ZstdWriteBlockTask {
   ZstdWriteBlockTask *next, *prev;
   void *data;
   size_t size;
+  /**
+   * Compressed frame from the delta reference file whose hash matches the data. It is only used
+   * after checking that it really contains the data.
+   */
+  void *reference_frame;
+  size_t reference_frame_size;
+  XXH128_hash_t hash;
   int frame_number;
   ZstdWriteWrap *ww;
 
@@ -250,11 +311,38 @@ struct ZstdWriteWrap::ZstdWriteBlockTask {
 
 void ZstdWriteWrap::write_task(ZstdWriteBlockTask *task)
 {
-  size_t out_buf_len = ZSTD_compressBound(task->size);
-  void *out_buf = MEM_mallocN(out_buf_len, "Zstd out buffer");
-  size_t out_size = ZSTD_compress(
-      out_buf, out_buf_len, task->data, task->size, ZSTD_COMPRESSION_LEVEL);
-
+  void *out_buf = nullptr;
+  size_t out_size = 0;
+  bool is_reused = false;
+  if (task->reference_frame) {
+    if (delta_reference_frame_matches(
+            task->reference_frame, task->reference_frame_size, task->data, task->size))
+    {
+      out_buf = task->reference_frame;
+      out_size = task->reference_frame_size;
+      is_reused = true;
+    }
+    else {
+      MEM_freeN(task->reference_frame);
+    }
+  }
+  if (!is_reused) {
+    size_t out_buf_len = ZSTD_compressBound(task->size);
+    out_buf = MEM_mallocN(out_buf_len, "Zstd out buffer");
+    if (use_delta) {
+      /* Store a checksum in frames that may be reused by the next delta save, so that they are
+       * validated when they are decompressed to check their content. */
+      ZSTD_CCtx *ctx = ZSTD_createCCtx();
+      ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, ZSTD_COMPRESSION_LEVEL);
+      ZSTD_CCtx_setParameter(ctx, ZSTD_c_checksumFlag, 1);
+      out_size = ZSTD_compress2(ctx, out_buf, out_buf_len, task->data, task->size);
+      ZSTD_freeCCtx(ctx);
+    }
+    else {
+      out_size = ZSTD_compress(
+          out_buf, out_buf_len, task->data, task->size, ZSTD_COMPRESSION_LEVEL);
+    }
+  }
   MEM_freeN(task->data);
 
   BLI_mutex_lock(&mutex);
@@ -272,7 +360,12 @@ void ZstdWriteWrap::write_task(ZstdWriteBlockTask *task)
           MEM_mallocN(sizeof(ZstdFrame), "zstd frameinfo"));
       frameinfo->uncompressed_size = task->size;
       frameinfo->compressed_size = out_size;
+      frameinfo->hash = task->hash;
       BLI_addtail(&frames, frameinfo);
+      if (is_reused) {
+        delta_reference.reused_frames++;
+        delta_reference.reused_size += int64_t(task->size);
+      }
     }
     else {
       write_error = true;
@@ -343,6 +436,208 @@ void ZstdWriteWrap::write_seekable_frames()
   write_u32_le(0x8F92EAB1);
 }
 
+/**
+ * The hashes are written as a skippable frame that is part of the seek table (with an
+ * uncompressed size of zero), so that readers which don't know about it can still use the seek
+ * table.
+ */
+void ZstdWriteWrap::write_delta_frame()
+{
+  const uint32_t num_frames = BLI_listbase_count(&frames);
+  const uint32_t frame_size = 3 * sizeof(uint32_t) + num_frames * 2 * sizeof(uint64_t);
+
+  blender::Vector<uint8_t> data;
+  data.reserve(2 * sizeof(uint32_t) + frame_size);
+  auto append_u32_le = [&](uint32_t val) {
+#ifdef __BIG_ENDIAN__
+    BLI_endian_switch_uint32(&val);
+#endif
+    data.extend({reinterpret_cast<const uint8_t *>(&val), sizeof(val)});
+  };
+  auto append_u64_le = [&](uint64_t val) {
+#ifdef __BIG_ENDIAN__
+    BLI_endian_switch_uint64(&val);
+#endif
+    data.extend({reinterpret_cast<const uint8_t *>(&val), sizeof(val)});
+  };
+
+  append_u32_le(ZSTD_DELTA_FRAME_MAGIC);
+  append_u32_le(frame_size);
+  append_u32_le(ZSTD_DELTA_FRAME_ID);
+  append_u32_le(ZSTD_DELTA_FRAME_VERSION);
+  append_u32_le(num_frames);
+  LISTBASE_FOREACH (ZstdFrame *, frame, &frames) {
+    append_u64_le(frame->hash.low64);
+    append_u64_le(frame->hash.high64);
+  }
+
+  if (!base_wrap.write(data.data(), data.size())) {
+    write_error = true;
+    return;
+  }
+  ZstdFrame *frameinfo = MEM_cnew<ZstdFrame>("zstd frameinfo");
+  frameinfo->compressed_size = uint32_t(data.size());
+  frameinfo->uncompressed_size = 0;
+  BLI_addtail(&frames, frameinfo);
+}
+
+/**
+ * Read the seek table and the frame hashes from the end of a file written with delta saving.
+ */
+bool ZstdWriteWrap::delta_reference_load(const int file)
+{
+  auto read_at = [&](const int64_t offset, void *r_data, const size_t size) {
+    return BLI_lseek(file, offset, SEEK_SET) == offset &&
+           ::read(file, r_data, size) == int64_t(size);
+  };
+  auto u32_le = [](uint32_t val) {
+#ifdef __BIG_ENDIAN__
+    BLI_endian_switch_uint32(&val);
+#endif
+    return val;
+  };
+  auto u64_le = [](uint64_t val) {
+#ifdef __BIG_ENDIAN__
+    BLI_endian_switch_uint64(&val);
+#endif
+    return val;
+  };
+
+  /* Seek table footer: number of frames, flags and magic number. */
+  const int64_t file_size = BLI_lseek(file, 0, SEEK_END);
+  uint8_t footer[9];
+  if (file_size < int64_t(sizeof(footer)) ||
+      !read_at(file_size - int64_t(sizeof(footer)), footer, sizeof(footer)))
+  {
+    return false;
+  }
+  uint32_t footer_frames_num, footer_magic;
+  memcpy(&footer_frames_num, footer, sizeof(uint32_t));
+  memcpy(&footer_magic, footer + 5, sizeof(uint32_t));
+  const uint32_t frames_num = u32_le(footer_frames_num);
+  if (u32_le(footer_magic) != 0x8F92EAB1 || footer[4] != 0 || frames_num == 0) {
+    return false;
+  }
+
+  /* Seek table entries. */
+  const int64_t table_size = int64_t(frames_num) * 8;
+  const int64_t table_offset = file_size - int64_t(sizeof(footer)) - table_size;
+  if (table_offset < 8) {
+    return false;
+  }
+  blender::Array<uint32_t> table(frames_num * 2);
+  if (!read_at(table_offset, table.data(), size_t(table_size))) {
+    return false;
+  }
+  blender::Array<uint64_t> compressed_offsets(frames_num + 1);
+  compressed_offsets[0] = 0;
+  for (const int64_t i : blender::IndexRange(frames_num)) {
+    compressed_offsets[i + 1] = compressed_offsets[i] + u32_le(table[i * 2]);
+  }
+  if (compressed_offsets[frames_num] != uint64_t(table_offset - 8)) {
+    return false;
+  }
+
+  /* The last frame has the hashes of all frames before it. */
+  const uint32_t hashes_frame_size = u32_le(table[(frames_num - 1) * 2]);
+  const uint32_t hashes_num = frames_num - 1;
+  if (u32_le(table[(frames_num - 1) * 2 + 1]) != 0 ||
+      hashes_frame_size != 5 * sizeof(uint32_t) + hashes_num * 2 * sizeof(uint64_t))
+  {
+    return false;
+  }
+  blender::Array<uint8_t> hashes_frame(hashes_frame_size);
+  if (!read_at(int64_t(compressed_offsets[hashes_num]), hashes_frame.data(), hashes_frame_size)) {
+    return false;
+  }
+  uint32_t header[5];
+  memcpy(header, hashes_frame.data(), sizeof(header));
+  if (u32_le(header[0]) != ZSTD_DELTA_FRAME_MAGIC ||
+      u32_le(header[1]) != hashes_frame_size - 2 * sizeof(uint32_t) ||
+      u32_le(header[2]) != uint32_t(ZSTD_DELTA_FRAME_ID) ||
+      u32_le(header[3]) != ZSTD_DELTA_FRAME_VERSION || u32_le(header[4]) != hashes_num)
+  {
+    return false;
+  }
+
+  for (const int64_t i : blender::IndexRange(hashes_num)) {
+    const uint32_t uncompressed_size = u32_le(table[i * 2 + 1]);
+    if (uncompressed_size == 0) {
+      continue;
+    }
+    uint64_t hash[2];
+    memcpy(hash, hashes_frame.data() + sizeof(header) + i * sizeof(hash), sizeof(hash));
+    delta_reference.frame_by_hash.add(
+        {u64_le(hash[0]), u64_le(hash[1])},
+        {compressed_offsets[i], u32_le(table[i * 2]), uncompressed_size});
+  }
+  return true;
+}
+
+void ZstdWriteWrap::enable_delta(const char *reference_filepath)
+{
+  use_delta = true;
+  use_flush_per_id = true;
+
+  const int file = BLI_open(reference_filepath, O_BINARY | O_RDONLY, 0);
+  if (file == -1) {
+    return;
+  }
+  if (!delta_reference_load(file)) {
+    ::close(file);
+    delta_reference.frame_by_hash.clear();
+    return;
+  }
+  delta_reference.file = file;
+}
+
+/**
+ * \return The compressed frame with the given hash from the reference file, or null. Its content
+ * still has to be checked with #delta_reference_frame_matches.
+ */
+void *ZstdWriteWrap::delta_reference_frame_read(const size_t buf_len,
+                                                const XXH128_hash_t &hash,
+                                                size_t *r_size)
+{
+  const DeltaReferenceFrame *frame = delta_reference.frame_by_hash.lookup_ptr(
+      {hash.low64, hash.high64});
+  if (frame == nullptr || frame->uncompressed_size != buf_len) {
+    return nullptr;
+  }
+  void *data = MEM_mallocN(frame->compressed_size, __func__);
+  const int64_t offset = int64_t(frame->compressed_offset);
+  if (BLI_lseek(delta_reference.file, offset, SEEK_SET) != offset ||
+      ::read(delta_reference.file, data, frame->compressed_size) != frame->compressed_size ||
+      ZSTD_getFrameContentSize(data, frame->compressed_size) != buf_len)
+  {
+    MEM_freeN(data);
+    return nullptr;
+  }
+  *r_size = frame->compressed_size;
+  return data;
+}
+
+/**
+ * Check that a frame from the delta reference file decompresses to exactly the given data, so
+ * that a hash collision or a modified reference file can't put wrong data into the new file.
+ * The frame must have a checksum, which is verified while decompressing.
+ */
+bool ZstdWriteWrap::delta_reference_frame_matches(const void *frame,
+                                                  const size_t frame_size,
+                                                  const void *buf,
+                                                  const size_t buf_len)
+{
+  /* The frame header descriptor follows the 4 byte magic number, bit 2 is the checksum flag. */
+  if (frame_size < 5 || (static_cast<const uint8_t *>(frame)[4] & (1 << 2)) == 0) {
+    return false;
+  }
+  void *decompressed = MEM_mallocN(buf_len, __func__);
+  const size_t decompressed_size = ZSTD_decompress(decompressed, buf_len, frame, frame_size);
+  const bool matches = decompressed_size == buf_len && memcmp(decompressed, buf, buf_len) == 0;
+  MEM_freeN(decompressed);
+  return matches;
+}
+
 bool ZstdWriteWrap::close()
 {
   BLI_threadpool_end(&threadpool);
@@ -351,6 +646,21 @@ bool ZstdWriteWrap::close()
   BLI_mutex_end(&mutex);
   BLI_condition_end(&condition);
 
+  if (use_delta) {
+    if (delta_reference.file != -1) {
+      ::close(delta_reference.file);
+      delta_reference.file = -1;
+      CLOG_INFO(&LOG,
+                1,
+                "Delta save reused %lld frames (%lld bytes uncompressed)",
+                (long long)delta_reference.reused_frames,
+                (long long)delta_reference.reused_size);
+    }
+    if (!write_error) {
+      write_delta_frame();
+    }
+  }
+
   write_seekable_frames();
   BLI_freelistN(&frames);
 
@@ -368,6 +678,16 @@ bool ZstdWriteWrap::write(const void *buf, const size_t buf_len)
   task->data = MEM_mallocN(buf_len, __func__);
   memcpy(task->data, buf, buf_len);
   task->size = buf_len;
+  task->reference_frame = nullptr;
+  task->reference_frame_size = 0;
+  task->hash = {};
+  if (use_delta) {
+    task->hash = XXH3_128bits(buf, buf_len);
+    if (delta_reference.file != -1) {
+      task->reference_frame = delta_reference_frame_read(
+          buf_len, task->hash, &task->reference_frame_size);
+    }
+  }
   task->frame_number = num_frames++;
   task->ww = this;
 
@@ -415,10 +735,16 @@ struct WriteData {
     size_t chunk_size;
   } buffer;
 
-#ifdef USE_WRITE_DATA_LEN
-  /** Total number of bytes written. */
+  /** Total number of bytes written, i.e. the offset in the uncompressed file. */
   size_t write_len;
-#endif
+
+  /**
+   * Entries and names of the #BLO_CODE_INDX block, for the local IDs written to the file so far.
+   * They are taken from the ID struct as it is written, not from the ID in #Main. Not used when
+   * writing undo steps.
+   */
+  blender::Vector<BLOIDIndexEntry> id_index_entries;
+  blender::Vector<char> id_index_names;
 
   /** Whether writefile code is currently writing an ID. */
   bool is_writing_id;
@@ -454,6 +780,8 @@ struct WriteData {
    * Will be nullptr for UNDO.
    */
   WriteWrap *ww;
+  /** Time spent in writes of individual buffers to #ww. */
+  BLOIOProfileCounter write_profile{"Write & Compress"};
 };
 
 struct BlendWriter {
@@ -503,6 +831,8 @@ static void writedata_do_write(WriteData *wd, const void *mem, const size_t meml
     BLO_memfile_chunk_add(&wd->mem, static_cast<const char *>(mem), memlen);
   }
   else {
+    BLOIOProfileCounter::Scope profile(wd->write_profile);
+    profile.add_bytes(int64_t(memlen));
     if (!wd->ww->write(mem, memlen)) {
       wd->validation_data.critical_error = true;
     }
@@ -551,9 +881,7 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
     return;
   }
 
-#ifdef USE_WRITE_DATA_LEN
   wd->write_len += len;
-#endif
 
   if (wd->buffer.buf == nullptr) {
     writedata_do_write(wd, adr, len);
@@ -669,11 +997,11 @@ static void mywrite_id_begin(WriteData *wd, ID *id)
 }
 
 /**
- * Start writing of data related to a single ID.
+ * End writing of data related to a single ID.
  *
- * Only does something when storing an undo step.
+ * Only does something when storing an undo step, or with #WriteWrap::use_flush_per_id.
  */
-static void mywrite_id_end(WriteData *wd, ID * /*id*/)
+static void mywrite_id_end(WriteData *wd, ID *id)
 {
   if (wd->use_memfile) {
     /* Very important to do it after every ID write now, otherwise we cannot know whether a
@@ -681,6 +1009,17 @@ static void mywrite_id_end(WriteData *wd, ID * /*id*/)
     mywrite_flush(wd);
     wd->mem.current_id_session_uid = MAIN_ID_SESSION_UID_UNSET;
   }
+  else if (wd->ww->use_flush_per_id) {
+    /* Group the data of small IDs, ending the group after IDs selected by their name rather than
+     * only by the size of the group. That way, when an ID changes size, the following groups
+     * still end after the same IDs as before and can be reused. */
+    const size_t used_len = wd->buffer.used_len;
+    if (used_len >= ZSTD_ID_FRAME_MAX_SIZE ||
+        (used_len >= ZSTD_ID_FRAME_MIN_SIZE && XXH3_64bits(id->name, strlen(id->name)) % 4 == 0))
+    {
+      mywrite_flush(wd);
+    }
+  }
 
   wd->validation_data.per_id_addresses_set.clear();
   wd->per_id_written_shared_addresses.clear();
@@ -1282,6 +1621,7 @@ static int write_id_direct_linked_data_process_cb(LibraryIDLinkCallbackData *cb_
 static void write_id(WriteData *wd, ID *id)
 {
   const IDTypeInfo *id_type = BKE_idtype_get_info_from_id(id);
+  BLOIOProfileScope profile("Write Data", id_type->name);
   mywrite_id_begin(wd, id);
   if (id_type->blend_write != nullptr) {
     BlendWriter writer = {wd};
@@ -1303,6 +1643,47 @@ static void write_blend_file_header(WriteData *wd)
   mywrite(wd, buf, 12);
 }
 
+/**
+ * Write the #BLO_CODE_INDX block, listing the local IDs written so far with their offsets and old
+ * addresses, so that readers can find them without parsing the whole file.
+ */
+static void write_id_index(WriteData *wd, const uint64_t dna_offset)
+{
+  using namespace blender;
+  if (wd->id_index_entries.is_empty()) {
+    return;
+  }
+  const Span<BLOIDIndexEntry> entries = wd->id_index_entries;
+  const Span<char> names = wd->id_index_names;
+
+  BLOIDIndexHeader header{};
+  header.version = BLO_ID_INDEX_VERSION;
+  header.entries_num = uint32_t(entries.size());
+  header.names_size = uint32_t(names.size());
+  header.dna_offset = dna_offset;
+
+  BLOIDIndexFooter footer{};
+  footer.data_size = sizeof(header) + entries.size_in_bytes() + names.size() + sizeof(footer);
+  footer.magic = BLO_ID_INDEX_MAGIC;
+  footer.version = BLO_ID_INDEX_VERSION;
+
+  if (footer.data_size > INT_MAX) {
+    return;
+  }
+
+  BHead bh{};
+  bh.code = BLO_CODE_INDX;
+  bh.old = nullptr;
+  bh.nr = 1;
+  bh.SDNAnr = SDNA_RAW_DATA_STRUCT_INDEX;
+  bh.len = int(footer.data_size);
+  write_bhead(wd, bh);
+  mywrite(wd, &header, sizeof(header));
+  mywrite(wd, entries.data(), entries.size_in_bytes());
+  mywrite(wd, names.data(), names.size());
+  mywrite(wd, &footer, sizeof(footer));
+}
+
 /**
  * Gathers all local IDs that should be written to the file.
  */
@@ -1484,8 +1865,15 @@ static bool write_file_handle(Main *mainvar,
    *
    * Note that we *borrow* the pointer to 'DNAstr',
    * so writing each time uses the same address and doesn't cause unnecessary undo overhead. */
+  const uint64_t dna_offset = wd->write_len;
   writedata(wd, BLO_CODE_DNA1, size_t(wd->sdna->data_size), wd->sdna->data);
 
+  /* The index has to be the last block before #BLO_CODE_ENDB, so that it can be found from the
+   * end of the file. */
+  if (!wd->use_memfile) {
+    write_id_index(wd, dna_offset);
+  }
+
   /* End of file. */
   BHead bhead{};
   bhead.code = BLO_CODE_ENDB;
@@ -1608,7 +1996,10 @@ static bool BLO_write_file_impl(Main *mainvar,
   const eBPathForeachFlag path_list_flag = (BKE_BPATH_FOREACH_PATH_SKIP_LINKED |
                                             BKE_BPATH_FOREACH_PATH_SKIP_MULTIFILE);
 
-  write_file_main_validate_pre(mainvar, reports);
+  {
+    BLOIOProfileScope profile("Validate");
+    write_file_main_validate_pre(mainvar, reports);
+  }
 
   /* Open temporary file, so we preserve the original in case we crash. */
   SNPRINTF(tempname, "%s@", filepath);
@@ -1703,10 +2094,16 @@ static bool BLO_write_file_impl(Main *mainvar,
   }
 
   /* Actual file writing. */
+  BLOIOProfileScope profile_write("Write File");
   const bool err = write_file_handle(
       mainvar, &ww, nullptr, nullptr, write_flags, use_userdef, thumb);
 
-  ww.close();
+  {
+    /* Waits for the remaining compression tasks. */
+    BLOIOProfileScope profile("Write & Compress");
+    ww.close();
+  }
+  profile_write.finish();
 
   if (UNLIKELY(path_list_backup)) {
     BKE_bpath_list_restore(mainvar, path_list_flag, path_list_backup);
@@ -1734,6 +2131,7 @@ static bool BLO_write_file_impl(Main *mainvar,
     return false;
   }
 
+  BLOIOProfileScope profile("Validate");
   write_file_main_validate_post(mainvar, reports);
 
   return true;
@@ -1751,14 +2149,22 @@ bool BLO_write_file(Main *mainvar,
                     const BlendFileWriteParams *params,
                     ReportList *reports)
 {
+  BLOIOProfileFileScope profile_file(filepath, true);
   RawWriteWrap raw_wrap;
+  bool success;
 
   if (write_flags & G_FILE_COMPRESS) {
     ZstdWriteWrap zstd_wrap(raw_wrap);
-    return BLO_write_file_impl(mainvar, filepath, write_flags, params, reports, zstd_wrap);
+    if (params->use_delta) {
+      zstd_wrap.enable_delta(filepath);
+    }
+    success = BLO_write_file_impl(mainvar, filepath, write_flags, params, reports, zstd_wrap);
+  }
+  else {
+    success = BLO_write_file_impl(mainvar, filepath, write_flags, params, reports, raw_wrap);
   }
 
-  return BLO_write_file_impl(mainvar, filepath, write_flags, params, reports, raw_wrap);
+  return success;
 }
 
 bool BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, const int write_flags)
@@ -1858,7 +2264,18 @@ void blo_write_id_struct(BlendWriter *writer,
                          const void *id_address,
                          const ID *id)
 {
-  writestruct_at_address_nr(writer->wd, GS(id->name), struct_id, 1, id_address, id);
+  WriteData *wd = writer->wd;
+  if (!wd->use_memfile && wd->is_writing_id) {
+    BLOIDIndexEntry entry{};
+    entry.bhead_offset = wd->write_len;
+    entry.old = uint64_t(uintptr_t(id_address));
+    entry.code = GS(id->name);
+    entry.flag = id->asset_data ? BLO_ID_INDEX_IS_ASSET : 0;
+    entry.name_offset = uint32_t(wd->id_index_names.size());
+    wd->id_index_names.extend(blender::Span(id->name, strlen(id->name) + 1));
+    wd->id_index_entries.append(entry);
+  }
+  writestruct_at_address_nr(wd, GS(id->name), struct_id, 1, id_address, id);
 }
 
 int BLO_get_struct_id_by_name(const BlendWriter *writer, const char *struct_name)
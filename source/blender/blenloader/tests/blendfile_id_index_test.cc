@@ -0,0 +1,184 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "BKE_asset.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+#include "BKE_material.h"
+
+#include "BLI_fileops.h"
+#include "BLI_linklist.h"
+#include "BLI_path_utils.hh"
+#include "BLI_string.h"
+#include "BLI_tempfile.h"
+
+#include "BLO_blend_defs.hh"
+#include "BLO_readfile.hh"
+#include "BLO_writefile.hh"
+
+#include "DNA_material_types.h"
+#include "DNA_sdna_types.h"
+
+#include "intern/readfile.hh"
+
+namespace blender::blenloader::tests {
+
+class BlendfileIDIndexTest : public BlendfileLoadingBaseTest {
+ protected:
+  char filepath_[FILE_MAX];
+  char corrupt_filepath_[FILE_MAX];
+
+  void SetUp() override
+  {
+    BlendfileLoadingBaseTest::SetUp();
+    char temp_dir[FILE_MAX];
+    BLI_temp_directory_path_get(temp_dir, sizeof(temp_dir));
+    BLI_path_join(filepath_, sizeof(filepath_), temp_dir, "blendfile_id_index_test.blend");
+    BLI_path_join(corrupt_filepath_,
+                  sizeof(corrupt_filepath_),
+                  temp_dir,
+                  "blendfile_id_index_test_corrupt.blend");
+
+    /* The red component of every material is distinct, to check that linking by name reads the
+     * block of the right ID. */
+    Main *bmain = BKE_main_new();
+    const std::pair<const char *, float> materials[] = {{"Red", 0.1f}, {"Green", 0.2f}};
+    for (const auto &[name, value] : materials) {
+      Material *material = BKE_material_add(bmain, name);
+      material->r = value;
+      id_fake_user_set(&material->id);
+    }
+    Material *asset = BKE_material_add(bmain, "Asset");
+    asset->r = 0.3f;
+    asset->id.asset_data = BKE_asset_metadata_create();
+    id_fake_user_set(&asset->id);
+
+    BlendFileWriteParams params{};
+    ASSERT_TRUE(BLO_write_file(bmain, filepath_, 0, &params, nullptr));
+    BKE_main_free(bmain);
+  }
+
+  void TearDown() override
+  {
+    BLI_delete(filepath_, false, false);
+    BLI_delete(corrupt_filepath_, false, false);
+    BlendfileLoadingBaseTest::TearDown();
+  }
+
+  /** Copy the test file, changing its bytes with the given function. */
+  template<typename Fn> void write_corrupt_file(const Fn &fn)
+  {
+    std::ifstream src(filepath_, std::ios::binary);
+    std::vector<char> data{std::istreambuf_iterator<char>(src), std::istreambuf_iterator<char>()};
+    fn(data);
+    std::ofstream dst(corrupt_filepath_, std::ios::binary | std::ios::trunc);
+    dst.write(data.data(), std::streamsize(data.size()));
+  }
+
+  /** Offset of the footer of the ID index, right before the #BLO_CODE_ENDB #BHead. */
+  static size_t footer_offset(const std::vector<char> &data)
+  {
+    return data.size() - sizeof(BHead8) - sizeof(BLOIDIndexFooter);
+  }
+
+  /**
+   * Link the material with the given name and return its red component, or -1 if it was not
+   * found. \a r_used_id_index is set to whether the ID was found without reading the whole file.
+   */
+  static float link_material_red(const char *filepath, const char *name, bool &r_used_id_index)
+  {
+    BlendFileReadReport bf_reports{};
+    BlendHandle *bh = BLO_blendhandle_from_file(filepath, &bf_reports);
+    EXPECT_NE(bh, nullptr);
+    if (bh == nullptr) {
+      return -1.0f;
+    }
+    Main *bmain = BKE_main_new();
+    LibraryLink_Params params;
+    BLO_library_link_params_init(&params, bmain, 0, 0);
+    Main *mainl = BLO_library_link_begin(&bh, filepath, &params);
+    const Material *material = reinterpret_cast<const Material *>(
+        BLO_library_link_named_part(mainl, &bh, ID_MA, name, &params));
+    const float red = material ? material->r : -1.0f;
+    const FileData *fd = reinterpret_cast<const FileData *>(bh);
+    r_used_id_index = fd->id_index != nullptr && fd->bhead_idname_hash == nullptr;
+    BLO_library_link_end(mainl, &bh, &params);
+    BLO_blendhandle_close(bh);
+    BKE_main_free(bmain);
+    return red;
+  }
+};
+
+TEST_F(BlendfileIDIndexTest, IndexIsWritten)
+{
+  BlendFileReadReport bf_reports{};
+  BlendHandle *bh = BLO_blendhandle_from_file(filepath_, &bf_reports);
+  ASSERT_NE(bh, nullptr);
+  const BLOIDIndex *index = blo_filedata_id_index_ensure(reinterpret_cast<FileData *>(bh));
+  ASSERT_NE(index, nullptr);
+
+  int materials_num = 0;
+  for (const BLOIDIndexEntry &entry : index->entries) {
+    if (entry.code != ID_MA) {
+      continue;
+    }
+    materials_num++;
+    const bool is_asset = STREQ(index->idname(entry), "MAAsset");
+    EXPECT_EQ((entry.flag & BLO_ID_INDEX_IS_ASSET) != 0, is_asset);
+  }
+  EXPECT_EQ(materials_num, 3);
+
+  int assets_num = 0;
+  LinkNode *names = BLO_blendhandle_get_datablock_names(bh, ID_MA, true, &assets_num);
+  ASSERT_EQ(assets_num, 1);
+  EXPECT_STREQ(static_cast<const char *>(names->link), "Asset");
+  BLI_linklist_freeN(names);
+
+  BLO_blendhandle_close(bh);
+}
+
+TEST_F(BlendfileIDIndexTest, LinkByName)
+{
+  bool used_id_index = false;
+  EXPECT_EQ(link_material_red(filepath_, "Green", used_id_index), 0.2f);
+  EXPECT_TRUE(used_id_index);
+  EXPECT_EQ(link_material_red(filepath_, "Red", used_id_index), 0.1f);
+  EXPECT_TRUE(used_id_index);
+  EXPECT_EQ(link_material_red(filepath_, "Missing", used_id_index), -1.0f);
+}
+
+TEST_F(BlendfileIDIndexTest, TruncatedIndexFallsBackToScan)
+{
+  /* The footer claims a shorter block than the one in the file. */
+  write_corrupt_file([&](std::vector<char> &data) {
+    BLOIDIndexFooter footer;
+    memcpy(&footer, &data[footer_offset(data)], sizeof(footer));
+    footer.data_size -= sizeof(BLOIDIndexEntry);
+    memcpy(&data[footer_offset(data)], &footer, sizeof(footer));
+  });
+  bool used_id_index = true;
+  EXPECT_EQ(link_material_red(corrupt_filepath_, "Green", used_id_index), 0.2f);
+  EXPECT_FALSE(used_id_index);
+}
+
+TEST_F(BlendfileIDIndexTest, GarbageIndexFallsBackToScan)
+{
+  /* Overwrite everything in the index block before the footer. */
+  write_corrupt_file([&](std::vector<char> &data) {
+    BLOIDIndexFooter footer;
+    memcpy(&footer, &data[footer_offset(data)], sizeof(footer));
+    const size_t data_offset = footer_offset(data) + sizeof(footer) - size_t(footer.data_size);
+    std::fill(&data[data_offset], &data[footer_offset(data)], char(0xff));
+  });
+  bool used_id_index = true;
+  EXPECT_EQ(link_material_red(corrupt_filepath_, "Green", used_id_index), 0.2f);
+  EXPECT_FALSE(used_id_index);
+}
+
+}  // namespace blender::blenloader::tests
@@ -13,6 +13,7 @@
 #include "BLI_compiler_attrs.h"
 #include "BLI_function_ref.hh"
 #include "BLI_gsqueue.h"
+#include "BLI_profile_trace.hh"
 #include "BLI_task.h"
 #include "BLI_time.h"
 #include "BLI_utildefines.h"
@@ -91,6 +92,7 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
 
   /* Sanity checks. */
   BLI_assert_msg(!operation_node->is_noop(), "NOOP nodes should not actually be scheduled");
+  PROFILE_TRACE_SCOPE_DYNAMIC("depsgraph", operation_node->full_identifier());
   /* Perform operation. */
   if (state->do_stats) {
     const double start_time = BLI_time_now_seconds();
@@ -388,6 +390,7 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
 
   graph->update_count++;
 
+  PROFILE_TRACE_SCOPE("depsgraph", "Evaluate Depsgraph");
   graph->debug.begin_graph_evaluation();
 
 #ifdef WITH_PYTHON
@@ -13,6 +13,7 @@
 #include "DNA_scene_types.h"
 
 #include "BLI_array.hh"
+#include "BLI_profile_trace.hh"
 #include "BLI_task.h"
 #include "BLI_vector.hh"
 
@@ -42,6 +43,7 @@ struct MeshRenderDataUpdateTaskData {
 
 static void mesh_extract_render_data_node_exec(void *__restrict task_data)
 {
+  PROFILE_TRACE_SCOPE("draw", "Mesh Render Data");
   auto *update_task_data = static_cast<MeshRenderDataUpdateTaskData *>(task_data);
   MeshRenderData &mr = *update_task_data->mr;
   MeshBufferList &buffers = update_task_data->cache.buff;
@@ -202,6 +204,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_positions");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_positions(data.mr, *data.mbc.buff.vbo.pos);
         },
@@ -217,6 +220,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_face_dots_position");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_face_dots_position(data.mr, *data.mbc.buff.vbo.fdots_pos);
         },
@@ -233,6 +237,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_normals");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_normals(data.mr, data.do_hq_normals, *data.mbc.buff.vbo.nor);
         },
@@ -248,6 +253,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_vert_normals");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_vert_normals(data.mr, *data.buffers.vbo.vnor);
         },
@@ -264,6 +270,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_face_dot_normals");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_face_dot_normals(data.mr, data.do_hq_normals, *data.mbc.buff.vbo.fdots_nor);
         },
@@ -279,6 +286,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_edge_factor");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_edge_factor(data.mr, *data.mbc.buff.vbo.edge_fac);
         },
@@ -295,6 +303,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_tris");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           const SortedFaceData &face_sorted = mesh_render_data_faces_sorted_ensure(data.mr,
                                                                                    data.mbc);
@@ -313,6 +322,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_lines");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_lines(data.mr,
                         data.buffers.ibo.lines,
@@ -331,6 +341,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_points");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_points(data.mr, *data.buffers.ibo.points);
         },
@@ -346,6 +357,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_face_dots");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_face_dots(data.mr, *data.buffers.ibo.fdots);
         },
@@ -361,6 +373,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_edit_data");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_edit_data(data.mr, *data.buffers.vbo.edit_data);
         },
@@ -378,6 +391,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_tangents");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_tangents(data.mr, data.cache, data.do_hq_normals, *data.buffers.vbo.tan);
         },
@@ -395,6 +409,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_vert_index");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           if (DRW_vbo_requested(data.buffers.vbo.vert_idx)) {
             extract_vert_index(data.mr, *data.buffers.vbo.vert_idx);
@@ -422,6 +437,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_weights");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_weights(data.mr, data.cache, *data.buffers.vbo.weights);
         },
@@ -437,6 +453,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_face_dots_uv");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_face_dots_uv(data.mr, *data.buffers.vbo.fdots_uv);
         },
@@ -452,6 +469,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_face_dots_edituv_data");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_face_dots_edituv_data(data.mr, *data.buffers.vbo.fdots_edituv_data);
         },
@@ -468,6 +486,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_uv_maps");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_uv_maps(data.mr, data.cache, *data.buffers.vbo.uv);
         },
@@ -484,6 +503,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_edituv_stretch_area");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_edituv_stretch_area(data.mr,
                                       *data.buffers.vbo.edituv_stretch_area,
@@ -502,6 +522,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_edituv_stretch_angle");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_edituv_stretch_angle(data.mr, *data.buffers.vbo.edituv_stretch_angle);
         },
@@ -517,6 +538,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_edituv_data");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_edituv_data(data.mr, *data.buffers.vbo.edituv_data);
         },
@@ -532,6 +554,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_edituv_tris");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_edituv_tris(data.mr, *data.buffers.ibo.edituv_tris);
         },
@@ -547,6 +570,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_edituv_lines");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_edituv_lines(data.mr, *data.buffers.ibo.edituv_lines);
         },
@@ -562,6 +586,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_edituv_points");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_edituv_points(data.mr, *data.buffers.ibo.edituv_points);
         },
@@ -577,6 +602,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_edituv_face_dots");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_edituv_face_dots(data.mr, *data.buffers.ibo.edituv_fdots);
         },
@@ -592,6 +618,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_lines_paint_mask");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_lines_paint_mask(data.mr, *data.buffers.ibo.lines_paint_mask);
         },
@@ -608,6 +635,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_lines_adjacency");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_lines_adjacency(
               data.mr, *data.buffers.ibo.lines_adjacency, data.cache.is_manifold);
@@ -624,6 +652,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_skin_roots");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_skin_roots(data.mr, *data.buffers.vbo.skin_roots);
         },
@@ -639,6 +668,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_sculpt_data");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_sculpt_data(data.mr, *data.buffers.vbo.sculpt_data);
         },
@@ -654,6 +684,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_orco");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_orco(data.mr, *data.buffers.vbo.orco);
         },
@@ -669,6 +700,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_mesh_analysis");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_mesh_analysis(data.mr, *data.buffers.vbo.mesh_analysis);
         },
@@ -685,6 +717,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_attributes");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_attributes(data.mr,
                              {data.cache.attr_used.requests, GPU_MAX_ATTR},
@@ -702,6 +735,7 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
     TaskNode *task_node = BLI_task_graph_node_create(
         &task_graph,
         [](void *__restrict task_data) {
+          PROFILE_TRACE_SCOPE("draw", "extract_attr_viewer");
           const TaskData &data = *static_cast<TaskData *>(task_data);
           extract_attr_viewer(data.mr, *data.buffers.vbo.attr_viewer);
         },
@@ -748,6 +782,7 @@ void mesh_buffer_cache_create_requested_subdiv(MeshBatchCache &cache,
                                                DRWSubdivCache &subdiv_cache,
                                                MeshRenderData &mr)
 {
+  PROFILE_TRACE_SCOPE("draw", "Extract Subdivision Mesh");
   MeshBufferList &buffers = mbc.buff;
   const bool attrs_requested = any_attr_requested(buffers);
   if (!DRW_ibo_requested(buffers.ibo.lines) && !DRW_ibo_requested(buffers.ibo.lines_loose) &&
@@ -13,6 +13,7 @@
 
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
+#include "BLI_vector.hh"
 
 #include "DNA_ID.h"
 #include "DNA_collection_types.h"
@@ -20,6 +21,7 @@
 #include "DNA_object_enums.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
 
 #include "BKE_blender_undo.hh"
 #include "BKE_context.hh"
@@ -54,6 +56,43 @@ struct MemFileUndoStep {
   MemFileUndoData *data;
 };
 
+/**
+ * Compress older steps in the background when enabled in the preferences, keeping \a us_active
+ * and the step before it uncompressed for quick undo and comparison when writing the next step.
+ *
+ * \param us_active: The active step, which may not be in the undo stack yet.
+ */
+static void memfile_undosys_compress(UndoStack *ustack, MemFileUndoStep *us_active)
+{
+  if (U.undo_memory_mode != USER_UNDO_MEMORY_COMPRESSED) {
+    return;
+  }
+
+  blender::Vector<MemFile *> memfiles;
+  blender::Vector<const MemFile *> keep_memfiles = {&us_active->data->memfile};
+  bool is_active_in_stack = false;
+  LISTBASE_FOREACH (UndoStep *, us_iter, &ustack->steps) {
+    if (us_iter->type != BKE_UNDOSYS_TYPE_MEMFILE) {
+      continue;
+    }
+    MemFileUndoStep *us = (MemFileUndoStep *)us_iter;
+    memfiles.append(&us->data->memfile);
+    if (us == us_active) {
+      is_active_in_stack = true;
+    }
+  }
+  if (!is_active_in_stack) {
+    memfiles.append(&us_active->data->memfile);
+  }
+
+  const int64_t active_index = memfiles.first_index_of(&us_active->data->memfile);
+  if (active_index > 0) {
+    keep_memfiles.append(memfiles[active_index - 1]);
+  }
+
+  BLO_memfile_compress(memfiles, keep_memfiles, size_t(U.undo_compressed_memory) * 1024 * 1024);
+}
+
 static bool memfile_undosys_poll(bContext *C)
 {
   /* other poll functions must run first, this is a catch-all. */
@@ -87,6 +126,8 @@ static bool memfile_undosys_step_encode(bContext * /*C*/, Main *bmain, UndoStep
   us->data = BKE_memfile_undo_encode(bmain, us_prev ? us_prev->data : nullptr);
   us->step.data_size = us->data->undo_size;
 
+  memfile_undosys_compress(ustack, us);
+
   /* Store the fact that we should not re-use old data with that undo step, and reset the Main
    * flag. */
   us->step.use_old_bmain_data = !bmain->use_memfile_full_barrier;
@@ -155,7 +196,7 @@ static void memfile_undosys_unfinished_id_previews_restart(ID *id)
 }
 
 static void memfile_undosys_step_decode(
-    bContext *C, Main *bmain, UndoStep *us_p, const eUndoStepDir undo_direction, bool /*is_final*/)
+    bContext *C, Main *bmain, UndoStep *us_p, const eUndoStepDir undo_direction, bool is_final)
 {
   BLI_assert(undo_direction != STEP_INVALID);
 
@@ -204,6 +245,10 @@ static void memfile_undosys_step_decode(
   MemFileUndoStep *us = (MemFileUndoStep *)us_p;
   BKE_memfile_undo_decode(us->data, undo_direction, use_old_bmain_data, C);
 
+  if (is_final) {
+    memfile_undosys_compress(ED_undo_stack_get(), us);
+  }
+
   for (UndoStep *us_iter = us_p->next; us_iter; us_iter = us_iter->next) {
     if (BKE_UNDOSYS_TYPE_IS_MEMFILE_SKIP(us_iter->type)) {
       continue;
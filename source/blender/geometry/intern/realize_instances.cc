@@ -370,23 +370,10 @@ static void copy_transformed_positions(const Span<float3> src,
     dst.copy_from(src);
   }
   else {
-    threading::parallel_for(src.index_range(), 1024, [&](const IndexRange range) {
-      for (const int i : range) {
-        dst[i] = math::transform_point(transform, src[i]);
-      }
-    });
+    math::transform_points(src, transform, dst);
   }
 }
 
-static void transform_positions(const float4x4 &transform, MutableSpan<float3> positions)
-{
-  threading::parallel_for(positions.index_range(), 1024, [&](const IndexRange range) {
-    for (const int i : range) {
-      positions[i] = math::transform_point(transform, positions[i]);
-    }
-  });
-}
-
 static void copy_transformed_normals(const Span<float3> src,
                                      const float4x4 &transform,
                                      MutableSpan<float3> dst)
@@ -396,11 +383,7 @@ static void copy_transformed_normals(const Span<float3> src,
     dst.copy_from(src);
   }
   else {
-    threading::parallel_for(src.index_range(), 1024, [&](const IndexRange range) {
-      for (const int i : range) {
-        dst[i] = normal_transform * src[i];
-      }
-    });
+    math::transform_directions(src, normal_transform, dst);
   }
 }
 
@@ -1210,7 +1193,7 @@ static void execute_realize_pointcloud_tasks(const RealizeInstancesOptions &opti
     const RealizePointCloudTask &task = tasks.first();
     PointCloud *new_points = BKE_pointcloud_copy_for_eval(task.pointcloud_info->pointcloud);
     if (!skip_transform(task.transform)) {
-      transform_positions(task.transform, new_points->positions_for_write());
+      math::transform_points(new_points->positions_for_write(), task.transform);
       new_points->tag_positions_changed();
     }
     add_instance_attributes_to_single_geometry(
@@ -1566,7 +1549,7 @@ static void execute_realize_mesh_tasks(const RealizeInstancesOptions &options,
     const RealizeMeshTask &task = tasks.first();
     Mesh *new_mesh = BKE_mesh_copy_for_eval(*task.mesh_info->mesh);
     if (!skip_transform(task.transform)) {
-      transform_positions(task.transform, new_mesh->vert_positions_for_write());
+      math::transform_points(new_mesh->vert_positions_for_write(), task.transform);
       new_mesh->tag_positions_changed();
     }
     add_instance_attributes_to_single_geometry(
@@ -6,10 +6,16 @@
  * \ingroup stl
  */
 
+#include <atomic>
+#include <memory>
+
 #include "BKE_mesh.hh"
 
 #include "BLI_array_utils.hh"
+#include "BLI_index_mask.hh"
+#include "BLI_lock_free_map.hh"
 #include "BLI_span.hh"
+#include "BLI_task.hh"
 
 #include "DNA_mesh_types.h"
 
@@ -24,57 +30,135 @@ namespace blender::io::stl {
 STLMeshHelper::STLMeshHelper(int tris_num, bool use_custom_normals)
     : use_custom_normals_(use_custom_normals)
 {
-  degenerate_tris_num_ = 0;
-  duplicate_tris_num_ = 0;
-  tris_.reserve(tris_num);
-  /* Upper bound (all vertices are unique). */
-  verts_.reserve(tris_num * 3);
+  corner_positions_.reserve(tris_num * 3);
   if (use_custom_normals) {
-    loop_normals_.reserve(tris_num * 3);
+    tri_normals_.reserve(tris_num);
   }
 }
 
-bool STLMeshHelper::add_triangle(const PackedTriangle &data)
+void STLMeshHelper::add_triangle(const PackedTriangle &data)
 {
-  int v1_id = verts_.index_of_or_add(data.vertices[0]);
-  int v2_id = verts_.index_of_or_add(data.vertices[1]);
-  int v3_id = verts_.index_of_or_add(data.vertices[2]);
-  if ((v1_id == v2_id) || (v1_id == v3_id) || (v2_id == v3_id)) {
-    degenerate_tris_num_++;
-    return false;
-  }
-  if (!tris_.add({v1_id, v2_id, v3_id})) {
-    duplicate_tris_num_++;
-    return false;
+  corner_positions_.extend({data.vertices[0], data.vertices[1], data.vertices[2]});
+  if (use_custom_normals_) {
+    tri_normals_.append(data.normal);
   }
+}
 
-  if (use_custom_normals_) {
-    loop_normals_.append_n_times(data.normal, 3);
+/**
+ * Merge corners with the same position into vertices in parallel. Every position is mapped to
+ * the first corner that uses it, so the vertices are in the same order as when the corners are
+ * merged one after another.
+ */
+static Array<int> weld_corner_positions(const Span<float3> corner_positions,
+                                        Array<float3> &r_vert_positions)
+{
+  using FirstCornerMap = LockFreeMap<float3, std::atomic<int>>;
+  Array<const std::atomic<int> *> first_corner_by_corner(corner_positions.size());
+  auto try_find_first_corners = [&](FirstCornerMap &first_corners) {
+    std::atomic<bool> is_full = false;
+    threading::parallel_for(corner_positions.index_range(), 2048, [&](const IndexRange range) {
+      for (const int corner : range) {
+        std::atomic<int> *first_corner = first_corners.try_lookup_or_add(
+            corner_positions[corner], corner);
+        if (first_corner == nullptr) {
+          is_full.store(true, std::memory_order_relaxed);
+          return;
+        }
+        int current = first_corner->load(std::memory_order_relaxed);
+        while (corner < current &&
+               !first_corner->compare_exchange_weak(current, corner, std::memory_order_relaxed))
+        {
+        }
+        first_corner_by_corner[corner] = first_corner;
+      }
+    });
+    return !is_full.load(std::memory_order_relaxed);
+  };
+
+  /* A closed triangle mesh has about half as many vertices as triangles, so a sixth of the number
+   * of corners. Only when the estimate (with some margin) is exceeded, start over with a map that
+   * has room for every corner, which would take more than a gigabyte for ten million triangles. */
+  std::unique_ptr<FirstCornerMap> first_corners = std::make_unique<FirstCornerMap>(
+      corner_positions.size() / 4);
+  if (!try_find_first_corners(*first_corners)) {
+    first_corners.reset();
+    first_corners = std::make_unique<FirstCornerMap>(corner_positions.size());
+    try_find_first_corners(*first_corners);
   }
-  return true;
+
+  Array<int> corner_verts(corner_positions.size());
+  threading::parallel_for(corner_positions.index_range(), 4096, [&](const IndexRange range) {
+    for (const int corner : range) {
+      corner_verts[corner] = first_corner_by_corner[corner]->load(std::memory_order_relaxed);
+    }
+  });
+
+  IndexMaskMemory memory;
+  const IndexMask vert_first_corners = IndexMask::from_predicate(
+      corner_positions.index_range(), GrainSize(4096), memory, [&](const int corner) {
+        return corner_verts[corner] == corner;
+      });
+
+  Array<int> vert_by_first_corner(corner_positions.size());
+  r_vert_positions.reinitialize(vert_first_corners.size());
+  vert_first_corners.foreach_index(GrainSize(4096), [&](const int corner, const int vert) {
+    vert_by_first_corner[corner] = vert;
+    r_vert_positions[vert] = corner_positions[corner];
+  });
+  threading::parallel_for(corner_positions.index_range(), 4096, [&](const IndexRange range) {
+    for (const int corner : range) {
+      corner_verts[corner] = vert_by_first_corner[corner_verts[corner]];
+    }
+  });
+  return corner_verts;
 }
 
 Mesh *STLMeshHelper::to_mesh()
 {
-  if (degenerate_tris_num_ > 0) {
-    CLOG_WARN(&LOG, "Removed %d degenerate triangles during import", degenerate_tris_num_);
+  Array<float3> vert_positions;
+  const Array<int> corner_verts = weld_corner_positions(corner_positions_, vert_positions);
+
+  VectorSet<Triangle> tris;
+  tris.reserve(corner_verts.size() / 3);
+  Vector<float3> loop_normals;
+  int degenerate_tris_num = 0;
+  int duplicate_tris_num = 0;
+  for (const int tri_index : IndexRange(corner_verts.size() / 3)) {
+    const int v1_id = corner_verts[tri_index * 3];
+    const int v2_id = corner_verts[tri_index * 3 + 1];
+    const int v3_id = corner_verts[tri_index * 3 + 2];
+    if ((v1_id == v2_id) || (v1_id == v3_id) || (v2_id == v3_id)) {
+      degenerate_tris_num++;
+      continue;
+    }
+    if (!tris.add({v1_id, v2_id, v3_id})) {
+      duplicate_tris_num++;
+      continue;
+    }
+    if (use_custom_normals_) {
+      loop_normals.append_n_times(tri_normals_[tri_index], 3);
+    }
+  }
+
+  if (degenerate_tris_num > 0) {
+    CLOG_WARN(&LOG, "Removed %d degenerate triangles during import", degenerate_tris_num);
   }
-  if (duplicate_tris_num_ > 0) {
-    CLOG_WARN(&LOG, "Removed %d duplicate triangles during import", duplicate_tris_num_);
+  if (duplicate_tris_num > 0) {
+    CLOG_WARN(&LOG, "Removed %d duplicate triangles during import", duplicate_tris_num);
   }
 
-  Mesh *mesh = BKE_mesh_new_nomain(verts_.size(), 0, tris_.size(), tris_.size() * 3);
-  mesh->vert_positions_for_write().copy_from(verts_);
+  Mesh *mesh = BKE_mesh_new_nomain(vert_positions.size(), 0, tris.size(), tris.size() * 3);
+  mesh->vert_positions_for_write().copy_from(vert_positions);
   offset_indices::fill_constant_group_size(3, 0, mesh->face_offsets_for_write());
-  array_utils::copy(tris_.as_span().cast<int>(), mesh->corner_verts_for_write());
+  array_utils::copy(tris.as_span().cast<int>(), mesh->corner_verts_for_write());
 
   bke::mesh_smooth_set(*mesh, false);
 
   /* NOTE: edges must be calculated first before setting custom normals. */
   bke::mesh_calc_edges(*mesh, false, false);
 
-  if (use_custom_normals_ && loop_normals_.size() == mesh->corners_num) {
-    bke::mesh_set_custom_normals(*mesh, loop_normals_);
+  if (use_custom_normals_ && loop_normals.size() == mesh->corners_num) {
+    bke::mesh_set_custom_normals(*mesh, loop_normals);
   }
 
   return mesh;
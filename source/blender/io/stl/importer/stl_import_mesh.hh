@@ -49,20 +49,18 @@ class Triangle {
 
 class STLMeshHelper {
  private:
-  VectorSet<float3> verts_;
-  VectorSet<Triangle> tris_;
-  Vector<float3> loop_normals_;
-  int degenerate_tris_num_;
-  int duplicate_tris_num_;
+  /* Vertex locations of every triangle corner in file order. */
+  Vector<float3> corner_positions_;
+  Vector<float3> tri_normals_;
   const bool use_custom_normals_;
 
  public:
   STLMeshHelper(int tris_num, bool use_custom_normals);
 
-  /* Creates a new triangle from specified vertex locations,
-   * duplicate vertices and triangles are merged.
+  /* Adds a new triangle from specified vertex locations,
+   * duplicate vertices and triangles are merged in #to_mesh.
    */
-  bool add_triangle(const PackedTriangle &data);
+  void add_triangle(const PackedTriangle &data);
 
   Mesh *to_mesh();
 };
@@ -167,6 +167,24 @@ void *DNA_struct_reconstruct(const struct DNA_ReconstructInfo *reconstruct_info,
                              int blocks,
                              const void *old_blocks,
                              const char *alloc_name);
+/**
+ * \return The index of the struct in the new SDNA that an old struct is converted to, or -1 when
+ * the struct doesn't exist anymore.
+ */
+int DNA_reconstruct_info_new_struct_index(const struct DNA_ReconstructInfo *reconstruct_info,
+                                          int old_struct_index);
+/**
+ * Same as #DNA_struct_reconstruct, but writes into an existing zero-initialized buffer.
+ * This allows converting parts of a large array independently (e.g. on multiple threads),
+ * the reconstruct info is only read.
+ *
+ * \note The struct must exist in the new SDNA, see #DNA_reconstruct_info_new_struct_index.
+ */
+void DNA_struct_reconstruct_into(const struct DNA_ReconstructInfo *reconstruct_info,
+                                 int old_struct_index,
+                                 int blocks,
+                                 const void *old_blocks,
+                                 void *new_blocks);
 
 /**
  * A version of #DNA_struct_member_offset_by_name_with_alias that uses the non-aliased name.
@@ -18,6 +18,15 @@
 struct AnimData;
 struct Ipo;
 
+#ifdef __cplusplus
+namespace blender::bke {
+struct KeyRuntime;
+}  // namespace blender::bke
+using KeyRuntimeHandle = blender::bke::KeyRuntime;
+#else
+typedef struct KeyRuntimeHandle KeyRuntimeHandle;
+#endif
+
 typedef struct KeyBlock {
   struct KeyBlock *next, *prev;
 
@@ -100,6 +109,8 @@ typedef struct Key {
    * current free UID for key-blocks.
    */
   int uidgen;
+
+  KeyRuntimeHandle *runtime;
 } Key;
 
 /* **************** KEY ********************* */
@@ -18,6 +18,7 @@
 
 #  include <optional>
 
+#  include "BLI_index_mask_fwd.hh"
 #  include "BLI_math_vector_types.hh"
 #  include "BLI_memory_counter_fwd.hh"
 
@@ -413,6 +414,11 @@ typedef struct Mesh {
 
   /** Call after changing vertex positions to tag lazily calculated caches for recomputation. */
   void tag_positions_changed();
+  /**
+   * Call after changing the positions of some vertices. Normals that are already calculated are
+   * only recalculated around the changed vertices, unless a large part of the mesh changed.
+   */
+  void tag_positions_changed(const blender::IndexMask &changed_verts);
   /** Call after moving every mesh vertex by the same translation. */
   void tag_positions_changed_uniformly();
   /** Like #tag_positions_changed but doesn't tag normals; they must be updated separately. */
@@ -751,6 +751,7 @@ typedef struct UserDef_Experimental {
   char use_all_linked_data_direct;
   char use_extensions_debug;
   char use_recompute_usercount_on_save_debug;
+  char use_delta_save;
   char SANITIZE_AFTER_HERE;
   /* The following options are automatically sanitized (set to 0)
    * when the release cycle is not alpha. */
@@ -762,7 +763,7 @@ typedef struct UserDef_Experimental {
   char use_new_volume_nodes;
   char use_new_file_import_nodes;
   char use_shader_node_previews;
-  char _pad[5];
+  char _pad[4];
 } UserDef_Experimental;
 
 #define USER_EXPERIMENTAL_TEST(userdef, member) \
@@ -949,7 +950,9 @@ typedef struct UserDef {
   /** Maximum number of simulations connection limit for online operations. */
   uint8_t network_connection_limit;
 
-  char _pad14[3];
+  /** #eUserpref_UndoMemoryMode. */
+  char undo_memory_mode;
+  char _pad14[2];
 
   short undosteps;
   int undomemory;
@@ -957,7 +960,8 @@ typedef struct UserDef {
   short gp_manhattandist, gp_euclideandist, gp_eraser;
   /** #eGP_UserdefSettings. */
   short gp_settings;
-  char _pad13[4];
+  /** Megabytes of compressed global undo steps kept in memory before moving them to disk. */
+  int undo_compressed_memory;
   struct SolidLight light_param[4];
   float light_ambient[3];
   char gizmo_flag;
@@ -1596,6 +1600,12 @@ typedef enum eUserpref_DiskCacheCompression {
   USER_SEQ_DISK_CACHE_COMPRESSION_HIGH = 2,
 } eUserpref_DiskCacheCompression;
 
+/** #UserDef.undo_memory_mode */
+typedef enum eUserpref_UndoMemoryMode {
+  USER_UNDO_MEMORY_UNCOMPRESSED = 0,
+  USER_UNDO_MEMORY_COMPRESSED = 1,
+} eUserpref_UndoMemoryMode;
+
 typedef enum eUserpref_SeqProxySetup {
   USER_SEQ_PROXY_SETUP_MANUAL = 0,
   USER_SEQ_PROXY_SETUP_AUTOMATIC = 1,
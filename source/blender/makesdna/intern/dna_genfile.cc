@@ -1218,6 +1218,8 @@ struct DNA_ReconstructInfo {
 
   int *step_counts;
   ReconstructStep **steps;
+  /** Index of the matching struct in `newsdna` for every struct in `oldsdna` (or -1). */
+  int *new_struct_index_by_old;
 };
 
 static void reconstruct_structs(const DNA_ReconstructInfo *reconstruct_info,
@@ -1309,18 +1311,36 @@ static void reconstruct_structs(const DNA_ReconstructInfo *reconstruct_info,
   }
 }
 
+int DNA_reconstruct_info_new_struct_index(const DNA_ReconstructInfo *reconstruct_info,
+                                          const int old_struct_index)
+{
+  return reconstruct_info->new_struct_index_by_old[old_struct_index];
+}
+
+void DNA_struct_reconstruct_into(const DNA_ReconstructInfo *reconstruct_info,
+                                 const int old_struct_index,
+                                 const int blocks,
+                                 const void *old_blocks,
+                                 void *new_blocks)
+{
+  const int new_struct_index = reconstruct_info->new_struct_index_by_old[old_struct_index];
+  BLI_assert(new_struct_index != -1);
+  reconstruct_structs(reconstruct_info,
+                      blocks,
+                      old_struct_index,
+                      new_struct_index,
+                      static_cast<const char *>(old_blocks),
+                      static_cast<char *>(new_blocks));
+}
+
 void *DNA_struct_reconstruct(const DNA_ReconstructInfo *reconstruct_info,
                              int old_struct_index,
                              int blocks,
                              const void *old_blocks,
                              const char *alloc_name)
 {
-  const SDNA *oldsdna = reconstruct_info->oldsdna;
   const SDNA *newsdna = reconstruct_info->newsdna;
-
-  const SDNA_Struct *old_struct = oldsdna->structs[old_struct_index];
-  const char *type_name = oldsdna->types[old_struct->type_index];
-  const int new_struct_index = DNA_struct_find_index_without_alias(newsdna, type_name);
+  const int new_struct_index = reconstruct_info->new_struct_index_by_old[old_struct_index];
 
   if (new_struct_index == -1) {
     return nullptr;
@@ -1632,6 +1652,10 @@ DNA_ReconstructInfo *DNA_reconstruct_info_create(const SDNA *oldsdna,
       MEM_malloc_arrayN(newsdna->structs_num, sizeof(int), __func__));
   reconstruct_info->steps = static_cast<ReconstructStep **>(
       MEM_malloc_arrayN(newsdna->structs_num, sizeof(ReconstructStep *), __func__));
+  /* Look up struct names only once, instead of for every reconstructed block. */
+  reconstruct_info->new_struct_index_by_old = static_cast<int *>(
+      MEM_malloc_arrayN(oldsdna->structs_num, sizeof(int), __func__));
+  std::fill_n(reconstruct_info->new_struct_index_by_old, oldsdna->structs_num, -1);
 
   /* Generate reconstruct steps for all structs. */
   for (int new_struct_index = 0; new_struct_index < newsdna->structs_num; new_struct_index++) {
@@ -1643,6 +1667,7 @@ DNA_ReconstructInfo *DNA_reconstruct_info_create(const SDNA *oldsdna,
       reconstruct_info->step_counts[new_struct_index] = 0;
       continue;
     }
+    reconstruct_info->new_struct_index_by_old[old_struct_index] = new_struct_index;
     const SDNA_Struct *old_struct = oldsdna->structs[old_struct_index];
     ReconstructStep *steps = create_reconstruct_steps_for_struct(
         oldsdna, newsdna, compare_flags, old_struct, new_struct);
@@ -1678,6 +1703,7 @@ void DNA_reconstruct_info_free(DNA_ReconstructInfo *reconstruct_info)
   }
   MEM_freeN(reconstruct_info->steps);
   MEM_freeN(reconstruct_info->step_counts);
+  MEM_freeN(reconstruct_info->new_struct_index_by_old);
   MEM_freeN(reconstruct_info);
 }
 
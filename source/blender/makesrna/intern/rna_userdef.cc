@@ -5695,6 +5695,35 @@ static void rna_def_userdef_edit(BlenderRNA *brna)
   RNA_def_property_ui_text(
       prop, "Undo Memory Size", "Maximum memory usage in megabytes (0 means unlimited)");
 
+  static const EnumPropertyItem undo_memory_mode_items[] = {
+      {USER_UNDO_MEMORY_UNCOMPRESSED,
+       "UNCOMPRESSED",
+       0,
+       "Uncompressed",
+       "Keep all global undo steps uncompressed in memory"},
+      {USER_UNDO_MEMORY_COMPRESSED,
+       "COMPRESSED",
+       0,
+       "Compressed",
+       "Compress older global undo steps in the background, and move them to a temporary file "
+       "once they exceed the compressed memory limit"},
+      {0, nullptr, 0, nullptr, nullptr},
+  };
+
+  prop = RNA_def_property(srna, "undo_memory_mode", PROP_ENUM, PROP_NONE);
+  RNA_def_property_enum_items(prop, undo_memory_mode_items);
+  RNA_def_property_enum_sdna(prop, nullptr, "undo_memory_mode");
+  RNA_def_property_ui_text(
+      prop, "Undo Memory Mode", "How the memory of older global undo steps is stored");
+
+  prop = RNA_def_property(srna, "undo_compressed_memory_limit", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, nullptr, "undo_compressed_memory");
+  RNA_def_property_range(prop, 0, max_memory_in_megabytes_int());
+  RNA_def_property_ui_text(prop,
+                           "Compressed Undo Memory Limit",
+                           "Maximum memory usage of compressed undo steps in megabytes, older "
+                           "steps are moved to a temporary file past it (0 means unlimited)");
+
   prop = RNA_def_property(srna, "use_global_undo", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, nullptr, "uiflag", USER_GLOBALUNDO);
   RNA_def_property_ui_text(
@@ -7613,6 +7642,13 @@ static void rna_def_userdef_experimental(BlenderRNA *brna)
                            "Recompute all ID usercounts before saving to a blendfile. Allows to "
                            "work around invalid usercount handling in code that may lead to loss "
                            "of data due to wrongly detected unused data-blocks");
+
+  prop = RNA_def_property(srna, "use_delta_save", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_ui_text(prop,
+                           "Delta Save",
+                           "When saving a compressed file, reuse the compressed data of the "
+                           "previously saved version of the file for data-blocks that did not "
+                           "change, instead of compressing them again");
 }
 
 static void rna_def_userdef_addon_collection(BlenderRNA *brna, PropertyRNA *cprop)
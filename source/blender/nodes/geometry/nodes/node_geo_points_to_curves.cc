@@ -42,20 +42,11 @@ static void grouped_sort(const OffsetIndices<int> offsets,
                          const Span<float> weights,
                          MutableSpan<int> indices)
 {
-  const auto comparator = [&](const int index_a, const int index_b) {
-    const float weight_a = weights[index_a];
-    const float weight_b = weights[index_b];
-    if (UNLIKELY(weight_a == weight_b)) {
-      /* Approach to make it stable. */
-      return index_a < index_b;
-    }
-    return weight_a < weight_b;
-  };
-
+  /* The indices in every group are in ascending order already, so the stable sort keeps the
+   * original order of elements with equal weights. */
   threading::parallel_for(offsets.index_range(), 250, [&](const IndexRange range) {
     for (const int group_index : range) {
-      MutableSpan<int> group = indices.slice(offsets[group_index]);
-      parallel_sort(group.begin(), group.end(), comparator);
+      radix_sort_indices(weights, indices.slice(offsets[group_index]));
     }
   });
 }
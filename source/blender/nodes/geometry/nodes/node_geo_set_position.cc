@@ -52,6 +52,26 @@ static void set_points_position(bke::MutableAttributeAccessor attributes,
                                      position_field);
 }
 
+static void set_mesh_position(Mesh &mesh,
+                              const Field<bool> &selection_field,
+                              const Field<float3> &position_field)
+{
+  const bke::MeshFieldContext context(mesh, bke::AttrDomain::Point);
+  fn::FieldEvaluator evaluator(context, mesh.verts_num);
+  evaluator.set_selection(selection_field);
+  evaluator.add(position_field);
+  evaluator.evaluate();
+  const IndexMask selection = evaluator.get_evaluated_selection_as_mask();
+  if (selection.is_empty()) {
+    return;
+  }
+  const VArray<float3> new_positions = evaluator.get_evaluated<float3>(0);
+  new_positions.materialize(selection, mesh.vert_positions_for_write());
+  /* Tag only the selected vertices so that normals don't have to be recalculated for the whole
+   * mesh when a small part of it is moved. */
+  mesh.tag_positions_changed(selection);
+}
+
 static void set_curves_position(bke::CurvesGeometry &curves,
                                 const fn::FieldContext &field_context,
                                 const Field<bool> &selection_field,
@@ -130,10 +150,7 @@ static void node_geo_exec(GeoNodeExecParams params)
                                   params.extract_input<Field<float3>>("Offset")}));
 
   if (Mesh *mesh = geometry.get_mesh_for_write()) {
-    set_points_position(mesh->attributes_for_write(),
-                        bke::MeshFieldContext(*mesh, bke::AttrDomain::Point),
-                        selection_field,
-                        position_field);
+    set_mesh_position(*mesh, selection_field, position_field);
   }
   if (PointCloud *point_cloud = geometry.get_pointcloud_for_write()) {
     set_points_position(point_cloud->attributes_for_write(),
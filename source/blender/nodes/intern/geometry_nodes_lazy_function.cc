@@ -34,6 +34,7 @@
 #include "BLI_hash_md5.hh"
 #include "BLI_lazy_threading.hh"
 #include "BLI_map.hh"
+#include "BLI_profile_trace.hh"
 
 #include "DNA_ID.h"
 
@@ -255,6 +256,7 @@ class LazyFunctionForGeometryNode : public LazyFunction {
         own_lf_graph_info_.mapping.lf_input_index_for_reference_set_for_output,
         get_anonymous_attribute_name};
 
+    PROFILE_TRACE_SCOPE_DYNAMIC("geometry_nodes", node_.name);
     node_.typeinfo->geometry_node_execute(geo_params);
   }
 
@@ -35,6 +35,7 @@
 #include "bpy_app_icons.hh"
 #include "bpy_app_timers.hh"
 
+#include "BLI_memory_cache.hh"
 #include "BLI_utildefines.h"
 
 #include "BKE_appdir.hh"
@@ -42,6 +43,8 @@
 #include "BKE_global.hh"
 #include "BKE_main.hh"
 
+#include "BLO_io_profile.hh"
+
 #include "DNA_ID.h"
 
 #include "UI_interface_icons.hh"
@@ -481,6 +484,11 @@ static PyGetSetDef bpy_app_getsets[] = {
      bpy_app_debug_doc,
      (void *)G_DEBUG_SIMDATA},
     {"debug_io", bpy_app_debug_get, bpy_app_debug_set, bpy_app_debug_doc, (void *)G_DEBUG_IO},
+    {"debug_io_profile",
+     bpy_app_debug_get,
+     bpy_app_debug_set,
+     bpy_app_debug_doc,
+     (void *)G_DEBUG_IO_PROFILE},
 
     {"use_event_simulate",
      bpy_app_global_flag_get,
@@ -584,6 +592,94 @@ static PyObject *bpy_app_is_job_running(PyObject * /*self*/, PyObject *args, PyO
   return PyBool_FromLong(WM_jobs_has_running_type(wm, job_type_enum.value));
 }
 
+PyDoc_STRVAR(
+    /* Wrap. */
+    bpy_app_io_profile_doc,
+    ".. staticmethod:: io_profile()\n"
+    "\n"
+    "   Timing of the phases of the last blend file read or written while "
+    "``bpy.app.debug_io_profile`` was enabled (started with ``--debug-io-profile``).\n"
+    "\n"
+    "   :return: A dictionary with the ``filepath``, whether the file was written "
+    "(``is_write``) and the ``phases``, a list of dictionaries with the ``name``, "
+    "``duration`` (in seconds), ``bytes`` and ``calls`` of each phase.\n"
+    "   :rtype: dict[str, Any]\n");
+static PyObject *bpy_app_io_profile(PyObject * /*self*/, PyObject * /*args*/)
+{
+  const blender::Vector<BLOIOProfilePhase> phases = BLO_io_profile_phases();
+  PyObject *item;
+
+  PyObject *phases_list = PyList_New(phases.size());
+  for (const int64_t i : phases.index_range()) {
+    const BLOIOProfilePhase &phase = phases[i];
+    PyObject *phase_dict = PyDict_New();
+    PyDict_SetItemString(phase_dict, "name", item = PyC_UnicodeFromStdStr(phase.name));
+    Py_DECREF(item);
+    PyDict_SetItemString(phase_dict, "duration", item = PyFloat_FromDouble(phase.duration));
+    Py_DECREF(item);
+    PyDict_SetItemString(phase_dict, "bytes", item = PyLong_FromLongLong(phase.bytes));
+    Py_DECREF(item);
+    PyDict_SetItemString(phase_dict, "calls", item = PyLong_FromLongLong(phase.calls));
+    Py_DECREF(item);
+    PyList_SET_ITEM(phases_list, i, phase_dict);
+  }
+
+  PyObject *result = PyDict_New();
+  PyDict_SetItemString(
+      result, "filepath", item = PyC_UnicodeFromStdStr(BLO_io_profile_filepath()));
+  Py_DECREF(item);
+  PyDict_SetItemString(result, "is_write", item = PyBool_FromLong(BLO_io_profile_is_write()));
+  Py_DECREF(item);
+  PyDict_SetItemString(result, "phases", phases_list);
+  Py_DECREF(phases_list);
+  return result;
+}
+
+PyDoc_STRVAR(
+    /* Wrap. */
+    bpy_app_memory_cache_statistics_doc,
+    ".. staticmethod:: memory_cache_statistics()\n"
+    "\n"
+    "   Usage of the global memory cache (used e.g. for volume grids loaded from files).\n"
+    "\n"
+    "   :return: A list of dictionaries, one per kind of cached data (``key_type``), with the "
+    "number of ``hits``, ``misses`` and ``evictions``, and the number of cached values "
+    "(``values_num``) and their approximate memory usage (``bytes``).\n"
+    "   :rtype: list[dict[str, Any]]\n");
+static PyObject *bpy_app_memory_cache_statistics(PyObject * /*self*/, PyObject * /*args*/)
+{
+  using namespace blender;
+  const Vector<memory_cache::KeyTypeStatistics> statistics = memory_cache::get_statistics();
+  PyObject *item;
+
+  PyObject *result = PyList_New(statistics.size());
+  for (const int64_t i : statistics.index_range()) {
+    const memory_cache::KeyTypeStatistics &key_type_statistics = statistics[i];
+    PyObject *statistics_dict = PyDict_New();
+    PyDict_SetItemString(
+        statistics_dict, "key_type", item = PyC_UnicodeFromStdStr(key_type_statistics.key_type));
+    Py_DECREF(item);
+    PyDict_SetItemString(
+        statistics_dict, "hits", item = PyLong_FromLongLong(key_type_statistics.hits));
+    Py_DECREF(item);
+    PyDict_SetItemString(
+        statistics_dict, "misses", item = PyLong_FromLongLong(key_type_statistics.misses));
+    Py_DECREF(item);
+    PyDict_SetItemString(
+        statistics_dict, "evictions", item = PyLong_FromLongLong(key_type_statistics.evictions));
+    Py_DECREF(item);
+    PyDict_SetItemString(statistics_dict,
+                         "values_num",
+                         item = PyLong_FromLongLong(key_type_statistics.values_num));
+    Py_DECREF(item);
+    PyDict_SetItemString(
+        statistics_dict, "bytes", item = PyLong_FromLongLong(key_type_statistics.bytes));
+    Py_DECREF(item);
+    PyList_SET_ITEM(result, i, statistics_dict);
+  }
+  return result;
+}
+
 char *(*BPY_python_app_help_text_fn)(bool all) = nullptr;
 
 PyDoc_STRVAR(
@@ -618,6 +714,41 @@ static PyObject *bpy_app_help_text(PyObject * /*self*/, PyObject *args, PyObject
   return result;
 }
 
+PyDoc_STRVAR(
+    /* Wrap. */
+    bpy_app_memory_profile_doc,
+    ".. staticmethod:: memory_profile()\n"
+    "\n"
+    "   Estimated memory usage per allocation name, based on the allocations that have been "
+    "sampled since Blender was started with ``--debug-memory-profile``.\n"
+    "\n"
+    "   :return: A list of dictionaries with the ``name``, the estimated ``bytes`` and number of "
+    "``blocks`` in use, and the number of ``samples`` the estimate is based on, sorted by the "
+    "memory usage.\n"
+    "   :rtype: list[dict[str, Any]]\n");
+static void bpy_app_memory_profile_append(const MEMSamplingStats *stats, void *user_data)
+{
+  PyObject *result = static_cast<PyObject *>(user_data);
+  PyObject *item;
+  PyObject *stats_dict = PyDict_New();
+  PyDict_SetItemString(stats_dict, "name", item = PyUnicode_FromString(stats->name));
+  Py_DECREF(item);
+  PyDict_SetItemString(stats_dict, "bytes", item = PyLong_FromSize_t(stats->bytes));
+  Py_DECREF(item);
+  PyDict_SetItemString(stats_dict, "blocks", item = PyLong_FromSize_t(stats->blocks));
+  Py_DECREF(item);
+  PyDict_SetItemString(stats_dict, "samples", item = PyLong_FromSize_t(stats->samples));
+  Py_DECREF(item);
+  PyList_Append(result, stats_dict);
+  Py_DECREF(stats_dict);
+}
+static PyObject *bpy_app_memory_profile(PyObject * /*self*/, PyObject * /*args*/)
+{
+  PyObject *result = PyList_New(0);
+  MEM_sampling_profiler_foreach_name(bpy_app_memory_profile_append, result);
+  return result;
+}
+
 #if (defined(__GNUC__) && !defined(__clang__))
 #  pragma GCC diagnostic push
 #  pragma GCC diagnostic ignored "-Wcast-function-type"
@@ -632,6 +763,18 @@ static PyMethodDef bpy_app_methods[] = {
      (PyCFunction)bpy_app_help_text,
      METH_VARARGS | METH_KEYWORDS | METH_STATIC,
      bpy_app_help_text_doc},
+    {"io_profile",
+     (PyCFunction)bpy_app_io_profile,
+     METH_NOARGS | METH_STATIC,
+     bpy_app_io_profile_doc},
+    {"memory_cache_statistics",
+     (PyCFunction)bpy_app_memory_cache_statistics,
+     METH_NOARGS | METH_STATIC,
+     bpy_app_memory_cache_statistics_doc},
+    {"memory_profile",
+     (PyCFunction)bpy_app_memory_profile,
+     METH_NOARGS | METH_STATIC,
+     bpy_app_memory_profile_doc},
     {nullptr, nullptr, 0, nullptr},
 };
 
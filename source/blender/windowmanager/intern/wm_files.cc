@@ -46,6 +46,7 @@
 #include "BLI_utildefines.h"
 #include BLI_SYSTEM_PID_H
 
+#include "BLO_io_profile.hh"
 #include "BLO_readfile.hh"
 #include "BLT_translation.hh"
 
@@ -1067,6 +1068,9 @@ bool WM_file_read(bContext *C, const char *filepath, ReportList *reports)
 
   /* We didn't succeed, now try to read Blender file. */
   if (retval == BKE_READ_EXOTIC_OK_BLEND) {
+    /* Also include setting up the read data in the profile started by #BKE_blendfile_read. */
+    BLOIOProfileFileScope profile_file(filepath, false);
+
     BlendFileReadParams params{};
     params.is_startup = false;
     /* Loading preferences when the user intended to load a regular file is a security
@@ -2211,6 +2215,7 @@ static bool wm_file_write(bContext *C,
   blend_write_params.remap_mode = remap_mode;
   blend_write_params.use_save_versions = true;
   blend_write_params.use_save_as_copy = use_save_as_copy;
+  blend_write_params.use_delta = USER_EXPERIMENTAL_TEST(&U, use_delta_save);
   blend_write_params.thumb = thumb;
 
   const bool success = BLO_write_file(bmain, filepath, fileflags, &blend_write_params, reports);
@@ -352,6 +352,16 @@ int main(int argc,
    */
   {
     int i;
+    /* Start sampling early as well, so that allocations done on startup are known. */
+    for (i = 0; i < argc; i++) {
+      if (STREQ(argv[i], "--debug-memory-profile")) {
+        MEM_sampling_profiler_enable(MEM_SAMPLING_PROFILER_DEFAULT_INTERVAL);
+        break;
+      }
+      if (STR_ELEM(argv[i], "--", "-c", "--command")) {
+        break;
+      }
+    }
     for (i = 0; i < argc; i++) {
       if (STR_ELEM(argv[i], "-d", "--debug", "--debug-memory", "--debug-all")) {
         printf("Switching to fully guarded memory allocator.\n");
@@ -25,6 +25,7 @@
 #  include "BLI_fileops.h"
 #  include "BLI_listbase.h"
 #  include "BLI_path_utils.hh"
+#  include "BLI_profile_trace.hh"
 #  include "BLI_string.h"
 #  include "BLI_string_utf8.h"
 #  include "BLI_system.h"
@@ -35,6 +36,7 @@
 #  endif
 
 #  include "BKE_appdir.hh"
+#  include "BKE_blender.hh"
 #  include "BKE_blender_cli_command.hh"
 #  include "BKE_blender_version.h"
 #  include "BKE_blendfile.hh"
@@ -91,6 +93,7 @@ struct BuildDefs {
   bool with_freestyle;
   bool with_libmv;
   bool with_ocio;
+  bool with_profile_trace;
   bool with_renderdoc;
   bool with_xr_openxr;
 };
@@ -128,6 +131,9 @@ static void build_defs_init(BuildDefs *build_defs, bool force_all)
 #  ifdef WITH_OCIO
   build_defs->with_ocio = true;
 #  endif
+#  ifdef WITH_PROFILE_TRACE
+  build_defs->with_profile_trace = true;
+#  endif
 #  ifdef WITH_RENDERDOC
   build_defs->with_renderdoc = true;
 #  endif
@@ -738,6 +744,7 @@ static void print_help(bArgs *ba, bool all)
     BLI_args_print_arg_doc(ba, "--debug-cycles");
   }
   BLI_args_print_arg_doc(ba, "--debug-memory");
+  BLI_args_print_arg_doc(ba, "--debug-memory-profile");
   BLI_args_print_arg_doc(ba, "--debug-jobs");
   BLI_args_print_arg_doc(ba, "--debug-python");
   BLI_args_print_arg_doc(ba, "--debug-depsgraph");
@@ -764,6 +771,10 @@ static void print_help(bArgs *ba, bool all)
   }
   BLI_args_print_arg_doc(ba, "--debug-all");
   BLI_args_print_arg_doc(ba, "--debug-io");
+  BLI_args_print_arg_doc(ba, "--debug-io-profile");
+  if (defs.with_profile_trace) {
+    BLI_args_print_arg_doc(ba, "--profile-trace");
+  }
 
   PRINT("\n");
   BLI_args_print_arg_doc(ba, "--debug-fpe");
@@ -790,6 +801,7 @@ static void print_help(bArgs *ba, bool all)
   BLI_args_print_arg_doc(ba, "--app-template");
   BLI_args_print_arg_doc(ba, "--factory-startup");
   BLI_args_print_arg_doc(ba, "--enable-event-simulate");
+  BLI_args_print_arg_doc(ba, "--enable-memory-thread-cache");
   PRINT("\n");
   BLI_args_print_arg_doc(ba, "--env-system-datafiles");
   BLI_args_print_arg_doc(ba, "--env-system-scripts");
@@ -1217,6 +1229,36 @@ static int arg_handle_log_file_set(int argc, const char **argv, void * /*data*/)
   return 0;
 }
 
+static const char arg_handle_profile_trace_set_doc[] =
+    "<filepath>\n"
+    "\tRecord the time spent in threaded tasks, depsgraph evaluation, geometry nodes,\n"
+    "\tdraw cache extraction and blend file I/O, and write it to a JSON file on exit.\n"
+    "\tThe file can be opened in 'chrome://tracing' or 'https://ui.perfetto.dev'.";
+static char profile_trace_filepath[FILE_MAX];
+static void profile_trace_write_atexit(void * /*user_data*/)
+{
+  if (!blender::profile_trace::write_json(profile_trace_filepath)) {
+    fprintf(stderr, "Error: could not write profile trace '%s'.\n", profile_trace_filepath);
+  }
+  blender::profile_trace::clear();
+}
+static int arg_handle_profile_trace_set(int argc, const char **argv, void * /*data*/)
+{
+  const char *arg_id = "--profile-trace";
+  if (argc > 1) {
+    const bool is_recording = profile_trace_filepath[0] != '\0';
+    STRNCPY(profile_trace_filepath, argv[1]);
+    BLI_path_abs_from_cwd(profile_trace_filepath, sizeof(profile_trace_filepath));
+    if (!is_recording) {
+      blender::profile_trace::start_recording();
+      BKE_blender_atexit_register(profile_trace_write_atexit, nullptr);
+    }
+    return 1;
+  }
+  fprintf(stderr, "\nError: '%s' no args given.\n", arg_id);
+  return 0;
+}
+
 static const char arg_handle_log_set_doc[] =
     "<match>\n"
     "\tEnable logging categories, taking a single comma separated argument.\n"
@@ -1344,6 +1386,9 @@ static const char arg_handle_debug_mode_generic_set_doc_depsgraph_pretty[] =
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_uid[] =
     "\n\t"
     "Verify validness of session-wide identifiers assigned to ID data-blocks.";
+static const char arg_handle_debug_mode_generic_set_doc_io_profile[] =
+    "\n\t"
+    "Enable timing of the phases of reading and writing blend files.";
 static const char arg_handle_debug_mode_generic_set_doc_gpu_force_workarounds[] =
     "\n\t"
     "Enable workarounds for typical GPU issues and disable all GPU extensions.";
@@ -1409,6 +1454,28 @@ static int arg_handle_debug_mode_memory_set(int /*argc*/, const char ** /*argv*/
   return 0;
 }
 
+static const char arg_handle_debug_mode_memory_profile_set_doc[] =
+    "\n\t"
+    "Sample allocations of the default memory allocator and print the estimated memory usage\n"
+    "\tper allocation name with the backtraces that use most memory on exit.\n"
+    "\tThe report is also available from 'bpy.app.memory_profile()'.\n"
+    "\tHas no effect together with '--debug-memory'.";
+static void memory_profile_print_atexit(void * /*user_data*/)
+{
+  MEM_sampling_profiler_print_report();
+}
+static int arg_handle_debug_mode_memory_profile_set(int /*argc*/,
+                                                    const char ** /*argv*/,
+                                                    void * /*data*/)
+{
+  /* Sampling has been enabled already in `main`, before any allocation happened. */
+  if (!MEM_sampling_profiler_is_enabled()) {
+    MEM_sampling_profiler_enable(MEM_SAMPLING_PROFILER_DEFAULT_INTERVAL);
+  }
+  BKE_blender_atexit_register(memory_profile_print_atexit, nullptr);
+  return 0;
+}
+
 static const char arg_handle_debug_value_set_doc[] =
     "<value>\n"
     "\tSet debug value of <value> on startup.";
@@ -1625,6 +1692,18 @@ static int arg_handle_enable_event_simulate(int /*argc*/, const char ** /*argv*/
   return 0;
 }
 
+static const char arg_handle_enable_memory_thread_cache_doc[] =
+    "\n\t"
+    "Reuse small memory blocks from a per-thread cache instead of the system allocator.\n"
+    "\tThis can speed up operations that allocate many small objects on many threads.";
+static int arg_handle_enable_memory_thread_cache(int /*argc*/,
+                                                 const char ** /*argv*/,
+                                                 void * /*data*/)
+{
+  MEM_use_thread_cache(true);
+  return 0;
+}
+
 static const char arg_handle_env_system_set_doc_datafiles[] =
     "\n\t"
     "Set the " STRINGIFY_ARG(BLENDER_SYSTEM_DATAFILES) " environment variable.";
@@ -2660,6 +2739,9 @@ void main_args_setup(bContext *C, bArgs *ba, bool all)
   BLI_args_add(ba, nullptr, "--log-show-backtrace", CB(arg_handle_log_show_backtrace_set), ba);
   BLI_args_add(ba, nullptr, "--log-show-timestamp", CB(arg_handle_log_show_timestamp_set), ba);
   BLI_args_add(ba, nullptr, "--log-file", CB(arg_handle_log_file_set), ba);
+  if (defs.with_profile_trace) {
+    BLI_args_add(ba, nullptr, "--profile-trace", CB(arg_handle_profile_trace_set), nullptr);
+  }
 
   /* GPU backend selection should be part of #ARG_PASS_ENVIRONMENT for correct GPU context
    * selection for animation player. */
@@ -2774,6 +2856,11 @@ void main_args_setup(bContext *C, bArgs *ba, bool all)
   BLI_args_add(ba, nullptr, "--debug-all", CB(arg_handle_debug_mode_all), nullptr);
 
   BLI_args_add(ba, nullptr, "--debug-io", CB(arg_handle_debug_mode_io), nullptr);
+  BLI_args_add(ba,
+               nullptr,
+               "--debug-io-profile",
+               CB_EX(arg_handle_debug_mode_generic_set, io_profile),
+               (void *)G_DEBUG_IO_PROFILE);
 
   BLI_args_add(ba, nullptr, "--debug-fpe", CB(arg_handle_debug_fpe_set), nullptr);
 
@@ -2784,6 +2871,11 @@ void main_args_setup(bContext *C, bArgs *ba, bool all)
     BLI_args_add(ba, nullptr, "--debug-cycles", CB(arg_handle_debug_mode_cycles), nullptr);
   }
   BLI_args_add(ba, nullptr, "--debug-memory", CB(arg_handle_debug_mode_memory_set), nullptr);
+  BLI_args_add(ba,
+               nullptr,
+               "--debug-memory-profile",
+               CB(arg_handle_debug_mode_memory_profile_set),
+               nullptr);
 
   BLI_args_add(ba, nullptr, "--debug-value", CB(arg_handle_debug_value_set), nullptr);
   BLI_args_add(ba,
@@ -2861,6 +2953,11 @@ void main_args_setup(bContext *C, bArgs *ba, bool all)
   BLI_args_add(ba, nullptr, "--factory-startup", CB(arg_handle_factory_startup_set), nullptr);
   BLI_args_add(
       ba, nullptr, "--enable-event-simulate", CB(arg_handle_enable_event_simulate), nullptr);
+  BLI_args_add(ba,
+               nullptr,
+               "--enable-memory-thread-cache",
+               CB(arg_handle_enable_memory_thread_cache),
+               nullptr);
 
   /* Pass: Custom Window Stuff. */
   BLI_args_pass_set(ba, ARG_PASS_SETTINGS_GUI);
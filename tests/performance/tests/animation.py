@@ -27,6 +27,137 @@ def _run(args):
     return result
 
 
+def _create_skinned_grid(use_quaternion):
+    import bpy
+    import bmesh
+
+    scene = bpy.context.scene
+
+    # Grid with a quarter million vertices, deformed by a chain of bones along the X axis.
+    mesh = bpy.data.meshes.new("Skin")
+    bm = bmesh.new()
+    bmesh.ops.create_grid(bm, x_segments=500, y_segments=500, size=10.0)
+    bm.to_mesh(mesh)
+    bm.free()
+    skin = bpy.data.objects.new("Skin", mesh)
+
+    armature = bpy.data.armatures.new("Rig")
+    rig = bpy.data.objects.new("Rig", armature)
+    scene.collection.objects.link(rig)
+    scene.collection.objects.link(skin)
+
+    bones_num = 20
+    bone_length = 20.0 / bones_num
+    bpy.context.view_layer.objects.active = rig
+    bpy.ops.object.mode_set(mode='EDIT')
+    for i in range(bones_num):
+        bone = armature.edit_bones.new("Bone{:d}".format(i))
+        bone.head = (-10.0 + i * bone_length, 0.0, 0.0)
+        bone.tail = (-10.0 + (i + 1) * bone_length, 0.0, 0.0)
+    bpy.ops.object.mode_set(mode='OBJECT')
+
+    # Blend every vertex between the closest bones, with weights quantized to a few levels so
+    # that they can be assigned with few API calls.
+    levels = 8
+    groups = [skin.vertex_groups.new(name="Bone{:d}".format(i)) for i in range(bones_num)]
+    indices = {}
+    for vert in mesh.vertices:
+        position = (vert.co.x + 10.0) / bone_length - 0.5
+        for bone in range(int(position) - 1, int(position) + 3):
+            if 0 <= bone < bones_num:
+                weight = max(0.0, 1.0 - abs(position - bone) / 2.0)
+                level = round(weight * levels)
+                if level > 0:
+                    indices.setdefault((bone, level), []).append(vert.index)
+    for (bone, level), vert_indices in indices.items():
+        groups[bone].add(vert_indices, level / levels, 'REPLACE')
+
+    modifier = skin.modifiers.new("Armature", 'ARMATURE')
+    modifier.object = rig
+    modifier.use_vertex_groups = True
+    modifier.use_bone_envelopes = False
+    modifier.use_deform_preserve_volume = use_quaternion
+
+    scene.frame_start = 1
+    scene.frame_end = 50
+    for i, pose_bone in enumerate(rig.pose.bones):
+        pose_bone.rotation_mode = 'XYZ'
+        for frame, angle in ((1, 0.0), (25, 0.2 + 0.01 * i), (50, 0.0)):
+            pose_bone.rotation_euler = (angle, 0.0, angle)
+            pose_bone.keyframe_insert("rotation_euler", frame=frame)
+
+
+def _run_skinning(args):
+    _create_skinned_grid(args['use_quaternion'])
+    return _run(args)
+
+
+class ArmatureSkinningTest(api.Test):
+    def __init__(self, use_quaternion):
+        self.use_quaternion = use_quaternion
+
+    def name(self):
+        return "armature_skinning_" + ("dual_quaternion" if self.use_quaternion else "linear")
+
+    def category(self):
+        return "animation"
+
+    def run(self, env, device_id):
+        args = {'use_quaternion': self.use_quaternion}
+        result, _ = env.run_in_blender(_run_skinning, args, ['--factory-startup'])
+        return result
+
+
+def _create_shape_key_grid():
+    import bpy
+    import bmesh
+
+    scene = bpy.context.scene
+
+    # Many corrective shapes that each move a small patch of a dense mesh, like a facial rig.
+    mesh = bpy.data.meshes.new("Face")
+    bm = bmesh.new()
+    bmesh.ops.create_grid(bm, x_segments=300, y_segments=300, size=10.0)
+    bm.to_mesh(mesh)
+    bm.free()
+    face = bpy.data.objects.new("Face", mesh)
+    scene.collection.objects.link(face)
+
+    face.shape_key_add(name="Basis")
+    side = 301
+    patch = 16
+    keys_num = 300
+    scene.frame_start = 1
+    scene.frame_end = 50
+    for i in range(keys_num):
+        key_block = face.shape_key_add(name="Shape{:d}".format(i), from_mix=False)
+        x0 = (i * 37) % (side - patch)
+        y0 = (i * 61) % (side - patch)
+        for y in range(y0, y0 + patch):
+            for x in range(x0, x0 + patch):
+                key_block.data[y * side + x].co.z += 0.1
+        for frame, value in ((1, 0.0), (10 + i % 30, 1.0), (50, 0.0)):
+            key_block.value = value
+            key_block.keyframe_insert("value", frame=frame)
+
+
+def _run_shape_keys(args):
+    _create_shape_key_grid()
+    return _run(args)
+
+
+class ShapeKeysTest(api.Test):
+    def name(self):
+        return "shape_keys_sparse"
+
+    def category(self):
+        return "animation"
+
+    def run(self, env, device_id):
+        result, _ = env.run_in_blender(_run_shape_keys, {}, ['--factory-startup'])
+        return result
+
+
 class AnimationTest(api.Test):
     def __init__(self, filepath):
         self.filepath = filepath
@@ -45,4 +176,7 @@ class AnimationTest(api.Test):
 
 def generate(env):
     filepaths = env.find_blend_files('animation/*')
-    return [AnimationTest(filepath) for filepath in filepaths]
+    tests = [AnimationTest(filepath) for filepath in filepaths]
+    tests += [ArmatureSkinningTest(use_quaternion) for use_quaternion in (False, True)]
+    tests += [ShapeKeysTest()]
+    return tests
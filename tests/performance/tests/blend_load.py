@@ -19,6 +19,17 @@ def _run(filepath):
     elapsed_time = time.time() - start_time
 
     result = {'time': elapsed_time}
+
+    # Load once more with profiling, to see which phase of loading changed.
+    # Done separately to keep the profiling overhead out of the total time.
+    if hasattr(bpy.app, "io_profile"):
+        bpy.ops.wm.read_homefile(use_empty=True, use_factory_startup=True)
+        bpy.app.debug_io_profile = True
+        bpy.ops.wm.open_mainfile(filepath=filepath)
+        bpy.app.debug_io_profile = False
+        for phase in bpy.app.io_profile()['phases']:
+            result['time ' + phase['name']] = phase['duration']
+
     return result
 
 
@@ -0,0 +1,101 @@
+# SPDX-FileCopyrightText: 2024 Blender Authors
+#
+# SPDX-License-Identifier: Apache-2.0
+
+import api
+
+
+def _timed_loop(function):
+    import time
+
+    start_time = time.time()
+    elapsed_time = 0.0
+    num_iterations = 0
+
+    while elapsed_time < 10.0:
+        function()
+        num_iterations += 1
+        elapsed_time = time.time() - start_time
+
+    return {'time': elapsed_time / num_iterations}
+
+
+def _run_depsgraph_build(args):
+    import bpy
+
+    scene = bpy.context.scene
+    view_layer = bpy.context.view_layer
+
+    # Many objects with a few modifiers each, so that building the depsgraph creates many small
+    # nodes and relations on all threads.
+    bpy.ops.mesh.primitive_uv_sphere_add(segments=16, ring_count=8)
+    mesh = bpy.context.object.data
+    collection = bpy.data.collections.new("Objects")
+    scene.collection.children.link(collection)
+    for i in range(2000):
+        ob = bpy.data.objects.new("Object{:d}".format(i), mesh)
+        ob.location = (i % 50, i // 50, 0.0)
+        ob.modifiers.new("Displace", 'DISPLACE')
+        ob.modifiers.new("Smooth", 'SMOOTH')
+        collection.objects.link(ob)
+    view_layer.update()
+
+    # Linking and unlinking an object tags the relations for update, so that every update rebuilds
+    # the depsgraph.
+    helper = bpy.data.objects.new("Helper", None)
+
+    def rebuild():
+        scene.collection.objects.link(helper)
+        view_layer.update()
+        scene.collection.objects.unlink(helper)
+        view_layer.update()
+
+    return _timed_loop(rebuild)
+
+
+def _run_bmesh_operators(args):
+    import bmesh
+
+    def operators():
+        bm = bmesh.new()
+        bmesh.ops.create_grid(bm, x_segments=200, y_segments=200, size=10.0)
+        bmesh.ops.subdivide_edges(bm, edges=bm.edges, cuts=1, use_grid_fill=True)
+        bmesh.ops.bevel(bm, geom=bm.verts[:] + bm.edges[:], offset=0.01, segments=2, affect='EDGES')
+        bmesh.ops.triangulate(bm, faces=bm.faces)
+        bmesh.ops.remove_doubles(bm, verts=bm.verts, dist=0.001)
+        bm.free()
+
+    return _timed_loop(operators)
+
+
+class MemoryAllocatorTest(api.Test):
+    """
+    Workloads that allocate many small blocks, run with and without the per-thread cache of the
+    allocator (`--enable-memory-thread-cache`) to compare both.
+    """
+
+    def __init__(self, name, function, use_thread_cache):
+        self.name_ = name
+        self.function = function
+        self.use_thread_cache = use_thread_cache
+
+    def name(self):
+        return self.name_ + ("_thread_cache" if self.use_thread_cache else "")
+
+    def category(self):
+        return "memory_allocator"
+
+    def run(self, env, device_id):
+        blender_args = ['--factory-startup']
+        if self.use_thread_cache:
+            blender_args.append('--enable-memory-thread-cache')
+        result, _ = env.run_in_blender(self.function, {}, blender_args)
+        return result
+
+
+def generate(env):
+    tests = []
+    for use_thread_cache in (False, True):
+        tests += [MemoryAllocatorTest("depsgraph_build", _run_depsgraph_build, use_thread_cache),
+                  MemoryAllocatorTest("bmesh_operators", _run_bmesh_operators, use_thread_cache)]
+    return tests